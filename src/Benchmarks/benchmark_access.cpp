@@ -0,0 +1,106 @@
+#include "Benchmarks/benchmarks.hpp"
+
+#include <iostream>
+#include <iomanip>   // setw(), setprecision(), fixed
+#include <string>
+
+#include "Matrix/Matrix.hpp"
+#include "Matrix/Matrix3D.hpp"
+#include "Matrix/MatrixN.hpp"
+
+
+/*!
+ * \brief Writes a line of the result table on stdout.
+ * \param method the name of the accessor.
+ * \param t the time taken, in seconds.
+ * \param n the number of elements accessed.
+ * \param sum the sum of the elements, to check that all
+ * the accessors read the same values.
+ */
+void print_access_result(const std::string& method, double t, size_t n, double sum)
+{   std::cout << std::setw(12) << method
+              << std::setw(12) << std::fixed << std::setprecision(4) << t
+              << std::setw(12) << std::fixed << std::setprecision(3) << t / n * 1e9
+              << std::setw(20) << std::fixed << std::setprecision(1) << sum
+              << std::endl ;
+}
+
+void benchmark_access(size_t size)
+{   Matrix3D<double> m3(size, size, size) ;
+    for(size_t i=0; i<m3.get_data_size(); i++)
+    {   m3.set(i, static_cast<double>(i % 1000)) ; }
+    const Matrix<double>& m = m3 ;
+    MatrixN<double,3> mn(m3) ;
+    const double* ptr = m3.get_data_ptr() ;
+    size_t n = m3.get_data_size() ;
+    size_t n_repeat = 3 ;
+
+    std::cout << "element access, " << size << "x" << size << "x" << size << " matrix" << std::endl ;
+    std::cout << std::setw(12) << "accessor"
+              << std::setw(12) << "time (s)"
+              << std::setw(12) << "ns/element"
+              << std::setw(20) << "sum"
+              << std::endl ;
+
+    // the slices are traversed in the storage order
+    double sum = 0. ;
+    double t = time_best_of([&]()
+                            {   sum = 0. ;
+                                for(size_t k=0; k<size; k++)
+                                {   for(size_t i=0; i<size; i++)
+                                    {   for(size_t j=0; j<size; j++)
+                                        {   sum += m({i,j,k}) ; }
+                                    }
+                                }
+                            },
+                            n_repeat) ;
+    print_access_result("vector", t, n, sum) ;
+
+    t = time_best_of([&]()
+                     {   sum = 0. ;
+                         for(size_t k=0; k<size; k++)
+                         {   for(size_t i=0; i<size; i++)
+                             {   for(size_t j=0; j<size; j++)
+                                 {   sum += m(i,j,k) ; }
+                             }
+                         }
+                     },
+                     n_repeat) ;
+    print_access_result("variadic", t, n, sum) ;
+
+    t = time_best_of([&]()
+                     {   sum = 0. ;
+                         for(size_t k=0; k<size; k++)
+                         {   for(size_t i=0; i<size; i++)
+                             {   for(size_t j=0; j<size; j++)
+                                 {   sum += m3(i,j,k) ; }
+                             }
+                         }
+                     },
+                     n_repeat) ;
+    print_access_result("Matrix3D", t, n, sum) ;
+
+    t = time_best_of([&]()
+                     {   sum = 0. ;
+                         for(size_t k=0; k<size; k++)
+                         {   for(size_t i=0; i<size; i++)
+                             {   for(size_t j=0; j<size; j++)
+                                 {   sum += mn(i,j,k) ; }
+                             }
+                         }
+                     },
+                     n_repeat) ;
+    print_access_result("MatrixN", t, n, sum) ;
+
+    t = time_best_of([&]()
+                     {   sum = 0. ;
+                         for(size_t k=0; k<size; k++)
+                         {   for(size_t i=0; i<size; i++)
+                             {   for(size_t j=0; j<size; j++)
+                                 {   sum += ptr[k*size*size + i*size + j] ; }
+                             }
+                         }
+                     },
+                     n_repeat) ;
+    print_access_result("pointer", t, n, sum) ;
+}
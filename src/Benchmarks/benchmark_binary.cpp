@@ -0,0 +1,124 @@
+#include "Benchmarks/benchmarks.hpp"
+
+#include <iostream>
+#include <iomanip>   // setw(), setprecision(), fixed
+#include <string>
+#include <vector>
+#include <cstdio>    // remove()
+
+#include <fcntl.h>   // open()
+#include <unistd.h>  // close()
+
+#include "Matrix/Matrix3D.hpp"
+#include "Matrix/MatrixIOEngine.hpp"
+
+
+/*!
+ * \brief Writes a line of the result table on stdout.
+ * \param method the name of the method.
+ * \param t the time taken, in seconds.
+ * \param bytes the number of bytes needed.
+ */
+void print_binary_result(const std::string& method, double t, double bytes)
+{   std::cout << std::setw(28) << method
+              << std::setw(12) << std::fixed << std::setprecision(3) << t * 1e3
+              << std::setw(12) << std::fixed << std::setprecision(2) << bytes / 1e6
+              << std::endl ;
+}
+
+void benchmark_binary(size_t size)
+{   std::string file_address = "benchmark_binary.bin" ;
+    size_t n_slice = 64 ;
+    Matrix3D<double> m(size, size, n_slice) ;
+    for(size_t i=0; i<m.get_data_size(); i++)
+    {   m.set(i, static_cast<double>(i)) ; }
+    m.save(file_address) ;
+    size_t n_repeat = 5 ;
+
+    std::cout << "binary region loading, " << size << "x" << size << "x" << n_slice << " matrix" << std::endl ;
+    std::cout << std::setw(28) << "method"
+              << std::setw(12) << "time (ms)"
+              << std::setw(12) << "MB needed"
+              << std::endl ;
+
+    double sum = 0. ;
+    double t = time_best_of([&]()
+                            {   Matrix3D<double> m2 ;
+                                m2.load(file_address) ;
+                                sum += m2(0, 0, n_slice/2) ;
+                            },
+                            n_repeat) ;
+    print_binary_result("load", t, m.get_data_size()*sizeof(double)) ;
+    MatrixIOEngine::set_direct(true) ;
+    t = time_best_of([&]()
+                     {   Matrix3D<double> m2 ;
+                         m2.load(file_address) ;
+                         sum += m2(0, 0, n_slice/2) ;
+                     },
+                     n_repeat) ;
+    MatrixIOEngine::set_direct(false) ;
+    print_binary_result("load O_DIRECT", t, m.get_data_size()*sizeof(double)) ;
+    // the values read by each way of the engine
+    std::vector<double> values(m.get_data_size()) ;
+    for(bool io_uring : {false, true})
+    {   MatrixIOEngine engine(32, 1 << 20, io_uring) ;
+        int fd = open(file_address.c_str(), O_RDONLY) ;
+        t = time_best_of([&]()
+                         {   engine.read(fd, reinterpret_cast<char*>(values.data()), values.size()*sizeof(double), matrix_binary_alignment) ;
+                             sum += values[values.size()/2] ;
+                         },
+                         n_repeat) ;
+        close(fd) ;
+        print_binary_result(engine.uses_io_uring() ? "engine io_uring" : "engine pread", t, values.size()*sizeof(double)) ;
+    }
+    t = time_best_of([&]()
+                     {   Matrix3D<double> m2 ;
+                         m2.load_region(file_address, {0, 0, n_slice/2}, {size, size, 1}) ;
+                         sum += m2(0, 0, 0) ;
+                     },
+                     n_repeat) ;
+    print_binary_result("load_region z slice", t, size*size*sizeof(double)) ;
+    t = time_best_of([&]()
+                     {   Matrix3D<double> m2 ;
+                         m2.load_region(file_address, {size/2, size/2, 0}, {16, 16, n_slice}) ;
+                         sum += m2(0, 0, 0) ;
+                     },
+                     n_repeat) ;
+    print_binary_result("load_region 16x16 column", t, 16*16*n_slice*sizeof(double)) ;
+    t = time_best_of([&]()
+                     {   Matrix3D<double> m2 ;
+                         m2.load_region(file_address, {0, size/2, 0}, {size, 1, n_slice}) ;
+                         sum += m2(0, 0, 0) ;
+                     },
+                     n_repeat) ;
+    print_binary_result("load_region yz plane", t, size*n_slice*sizeof(double)) ;
+
+    // the same regions of a chunked file
+    std::vector<size_t> chunk_dim = {32, 32, 8} ;
+    m.save_chunked(file_address, chunk_dim) ;
+    t = time_best_of([&]()
+                     {   Matrix3D<double> m2 ;
+                         m2.load_region(file_address, {0, 0, n_slice/2}, {size, size, 1}) ;
+                         sum += m2(0, 0, 0) ;
+                     },
+                     n_repeat) ;
+    print_binary_result("chunked z slice", t, size*size*sizeof(double)) ;
+    t = time_best_of([&]()
+                     {   Matrix3D<double> m2 ;
+                         m2.load_region(file_address, {size/2, size/2, 0}, {16, 16, n_slice}) ;
+                         sum += m2(0, 0, 0) ;
+                     },
+                     n_repeat) ;
+    print_binary_result("chunked 16x16 column", t, 16*16*n_slice*sizeof(double)) ;
+    t = time_best_of([&]()
+                     {   Matrix3D<double> m2 ;
+                         m2.load_region(file_address, {0, size/2, 0}, {size, 1, n_slice}) ;
+                         sum += m2(0, 0, 0) ;
+                     },
+                     n_repeat) ;
+    print_binary_result("chunked yz plane", t, size*n_slice*sizeof(double)) ;
+    if(sum < 0.)
+    {   std::cerr << "error! unexpected values" << std::endl ; }
+
+    remove(file_address.c_str()) ;
+}
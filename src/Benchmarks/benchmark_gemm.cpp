@@ -0,0 +1,49 @@
+#include "Benchmarks/benchmarks.hpp"
+
+#include <iostream>
+#include <iomanip>   // setw(), setprecision(), fixed
+#include <string>
+#include <algorithm> // min()
+
+#include "Matrix/Matrix2D.hpp"
+#include "Matrix/ThreadPool.hpp"
+
+
+/*!
+ * \brief Measures the throughput of the matrix product of
+ * two square matrices of the given size and writes it on
+ * stdout.
+ * \param size the matrix size.
+ * \param type the name of the value type.
+ */
+template<class T>
+void benchmark_gemm_size(size_t size, const std::string& type)
+{   Matrix2D<T> a(size, size), b(size, size) ;
+    for(size_t i=0; i<a.get_data_size(); i++)
+    {   a.set(i, static_cast<T>((i % 13) * 0.1)) ;
+        b.set(i, static_cast<T>((i % 7) * 0.2)) ;
+    }
+    // large products take long enough to be measured once
+    size_t n_repeat = size >= 2048 ? 1 : 5 ;
+    double t = time_best_of([&]() { Matrix2D<T> c = multiply(a, b) ; }, n_repeat) ;
+    double gflops = 2. * size * size * size / t / 1e9 ;
+    std::cout << std::setw(8) << type
+              << std::setw(8) << size
+              << std::setw(12) << std::fixed << std::setprecision(4) << t
+              << std::setw(12) << std::fixed << std::setprecision(2) << gflops
+              << std::endl ;
+}
+
+void benchmark_gemm(size_t size_max)
+{   std::cout << "matrix product, "
+              << ThreadPool::get_default().get_thread_number() << " threads" << std::endl ;
+    std::cout << std::setw(8)  << "type"
+              << std::setw(8)  << "size"
+              << std::setw(12) << "time (s)"
+              << std::setw(12) << "GFLOP/s"
+              << std::endl ;
+    for(size_t size=std::min(static_cast<size_t>(256), size_max); size<=size_max; size*=2)
+    {   benchmark_gemm_size<float>(size, "float") ;
+        benchmark_gemm_size<double>(size, "double") ;
+    }
+}
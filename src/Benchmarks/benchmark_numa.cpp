@@ -0,0 +1,159 @@
+#include "Benchmarks/benchmarks.hpp"
+
+#include <iostream>
+#include <iomanip>   // setw(), setprecision(), fixed
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <memory>    // unique_ptr
+#include <cstdio>    // sprintf()
+
+#include <pthread.h> // pthread_setaffinity_np()
+#include <sched.h>   // cpu_set_t
+
+#include "Matrix/Matrix2D.hpp"
+#include "Matrix/MatrixAllocator.hpp"
+#include "Matrix/ThreadPool.hpp"
+
+
+/*!
+ * \brief Lists the CPUs of each NUMA node, from sysfs. A machine
+ * without this information is one node with all the CPUs.
+ * \return the CPUs of each node.
+ */
+std::vector<std::vector<int>> get_numa_node_cpus()
+{   std::vector<std::vector<int>> nodes ;
+    for(int node=0; ; node++)
+    {   char path[256] ;
+        sprintf(path, "/sys/devices/system/node/node%d/cpulist", node) ;
+        std::ifstream file(path) ;
+        if(not file)
+        {   break ; }
+        // ranges, as "0-15,32-47"
+        std::vector<int> cpus ;
+        std::string range ;
+        while(std::getline(file, range, ','))
+        {   int first = 0, last = -1 ;
+            char dash = 0 ;
+            std::istringstream stream(range) ;
+            stream >> first ;
+            if(stream >> dash >> last)
+            {   for(int cpu=first; cpu<=last; cpu++)
+                {   cpus.push_back(cpu) ; }
+            }
+            else
+            {   cpus.push_back(first) ; }
+        }
+        if(not cpus.empty())
+        {   nodes.push_back(cpus) ; }
+    }
+    if(nodes.empty())
+    {   nodes.push_back(std::vector<int>()) ;
+        for(unsigned cpu=0; cpu<std::thread::hardware_concurrency(); cpu++)
+        {   nodes.back().push_back(cpu) ; }
+    }
+    return nodes ;
+}
+
+/*!
+ * \brief Sums values with one thread per CPU of a list, each thread
+ * being pinned to its CPU and reading a contiguous part of the
+ * values.
+ * \param values the values.
+ * \param n the number of values.
+ * \param cpus the CPUs.
+ * \return the sum.
+ */
+double sum_on_cpus(const double* values, size_t n, const std::vector<int>& cpus)
+{   std::vector<double> sums(cpus.size(), 0.) ;
+    std::vector<std::thread> threads ;
+    for(size_t i=0; i<cpus.size(); i++)
+    {   threads.push_back(std::thread([&, i]()
+                                      {   cpu_set_t set ;
+                                          CPU_ZERO(&set) ;
+                                          CPU_SET(cpus[i], &set) ;
+                                          pthread_setaffinity_np(pthread_self(), sizeof(set), &set) ;
+                                          size_t from = n * i / cpus.size() ;
+                                          size_t to   = n * (i+1) / cpus.size() ;
+                                          double sum = 0. ;
+                                          for(size_t j=from; j<to; j++)
+                                          {   sum += values[j] ; }
+                                          sums[i] = sum ;
+                                      })) ;
+    }
+    double sum = 0. ;
+    for(size_t i=0; i<threads.size(); i++)
+    {   threads[i].join() ;
+        sum += sums[i] ;
+    }
+    return sum ;
+}
+
+/*!
+ * \brief Measures the time taken to construct a square matrix with
+ * the given allocator and the bandwidth reached when reading it with
+ * the default pool and with the CPUs of each NUMA node, and writes
+ * them on stdout.
+ * \param name the name of the allocation policy.
+ * \param size the matrix size.
+ * \param nodes the CPUs of each NUMA node.
+ */
+template<class A>
+void benchmark_numa_policy(const std::string& name, size_t size,
+                           const std::vector<std::vector<int>>& nodes)
+{   // the pages are placed once, when the matrix is constructed
+    std::unique_ptr<Matrix2D<double,A>> m ;
+    double t_construct = time_best_of([&]() { m.reset(new Matrix2D<double,A>(size, size, 1.)) ; }, 1) ;
+    const double* values = m->get_data_ptr() ;
+    size_t n = m->get_data_size() ;
+    double bytes = sizeof(double) * n ;
+    size_t n_repeat = 5 ;
+
+    ThreadPool& pool = ThreadPool::get_default() ;
+    double sum = 0. ;
+    std::mutex mutex ;
+    double t_pool = time_best_of([&]()
+                                 {   sum = 0. ;
+                                     pool.parallel_for(0, n,
+                                                       [&](size_t from, size_t to)
+                                                       {   double s = 0. ;
+                                                           for(size_t i=from; i<to; i++)
+                                                           {   s += values[i] ; }
+                                                           std::lock_guard<std::mutex> lock(mutex) ;
+                                                           sum += s ;
+                                                       }) ;
+                                 },
+                                 n_repeat) ;
+    std::cout << std::setw(12) << name
+              << std::setw(14) << std::fixed << std::setprecision(1) << t_construct * 1e3
+              << std::setw(12) << std::fixed << std::setprecision(2) << bytes / t_pool / 1e9 ;
+    for(const auto& cpus : nodes)
+    {   double t_node = time_best_of([&]() { sum = sum_on_cpus(values, n, cpus) ; }, n_repeat) ;
+        std::cout << std::setw(12) << std::fixed << std::setprecision(2) << bytes / t_node / 1e9 ;
+    }
+    std::cout << std::endl ;
+    if(sum != static_cast<double>(n))
+    {   std::cerr << "error! wrong sum with " << name << std::endl ; }
+}
+
+void benchmark_numa(size_t size)
+{   std::vector<std::vector<int>> nodes = get_numa_node_cpus() ;
+    std::cout << "allocation policies, " << size << "x" << size << " matrix of double, "
+              << ThreadPool::get_default().get_thread_number() << " threads, "
+              << nodes.size() << " NUMA node(s)" << std::endl ;
+    std::cout << std::setw(12) << "policy"
+              << std::setw(14) << "construct ms"
+              << std::setw(12) << "pool GB/s" ;
+    for(size_t i=0; i<nodes.size(); i++)
+    {   std::cout << std::setw(12) << ("node " + std::to_string(i) + " GB/s") ; }
+    std::cout << std::endl ;
+
+    benchmark_numa_policy<MatrixAlignedAllocator<double>>("aligned", size, nodes) ;
+    benchmark_numa_policy<MatrixPageAllocator<double, matrix_page_huge>>("huge", size, nodes) ;
+    benchmark_numa_policy<MatrixPageAllocator<double, matrix_page_interleave>>("interleave", size, nodes) ;
+    benchmark_numa_policy<MatrixPageAllocator<double, matrix_page_first_touch>>("first touch", size, nodes) ;
+    benchmark_numa_policy<MatrixPageAllocator<double>>("huge+touch", size, nodes) ;
+}
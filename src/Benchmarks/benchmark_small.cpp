@@ -0,0 +1,90 @@
+#include "Benchmarks/benchmarks.hpp"
+
+#include <iostream>
+#include <iomanip>   // setw(), setprecision(), fixed
+#include <string>
+#include <vector>
+
+#include "Matrix/Matrix2D.hpp"
+#include "Matrix/SmallMatrix2D.hpp"
+#include "Matrix/FixedMatrix.hpp"
+
+
+/*!
+ * \brief Measures the time taken to construct, copy, add and multiply
+ * many small square matrices, as Matrix2D, as SmallMatrix2D and as
+ * FixedMatrix, and writes it on stdout in ns per matrix.
+ * \param n_matrix the number of matrices.
+ */
+template<class T, size_t n>
+void benchmark_small_size(size_t n_matrix)
+{   size_t n_repeat = 3 ;
+    std::vector<Matrix2D<T>> m(n_matrix) ;
+    std::vector<SmallMatrix2D<T>> m_small(n_matrix) ;
+    std::vector<FixedMatrix<T,n,n>> m_fixed(n_matrix) ;
+
+    // the matrices are constructed, copied and combined with the
+    // previous one
+    T sum = 0 ;
+    double t = time_best_of([&]()
+                            {   for(size_t i=0; i<n_matrix; i++)
+                                {   Matrix2D<T> a(n, n, static_cast<T>(i % 3)) ;
+                                    Matrix2D<T> b(a) ;
+                                    m[i] = multiply(Matrix2D<T>(a + b), b) ;
+                                }
+                                sum = 0 ;
+                                for(size_t i=0; i<n_matrix; i++)
+                                {   sum += m[i](n-1, n-1) ; }
+                            },
+                            n_repeat) ;
+    std::cout << std::setw(6) << n
+              << std::setw(16) << "Matrix2D"
+              << std::setw(12) << std::fixed << std::setprecision(1) << t / n_matrix * 1e9
+              << std::setw(16) << std::fixed << std::setprecision(1) << sum
+              << std::endl ;
+
+    t = time_best_of([&]()
+                     {   for(size_t i=0; i<n_matrix; i++)
+                         {   SmallMatrix2D<T> a(n, n, static_cast<T>(i % 3)) ;
+                             SmallMatrix2D<T> b(a) ;
+                             m_small[i] = multiply(a + b, b) ;
+                         }
+                         sum = 0 ;
+                         for(size_t i=0; i<n_matrix; i++)
+                         {   sum += m_small[i](n-1, n-1) ; }
+                     },
+                     n_repeat) ;
+    std::cout << std::setw(6) << n
+              << std::setw(16) << "SmallMatrix2D"
+              << std::setw(12) << std::fixed << std::setprecision(1) << t / n_matrix * 1e9
+              << std::setw(16) << std::fixed << std::setprecision(1) << sum
+              << std::endl ;
+
+    t = time_best_of([&]()
+                     {   for(size_t i=0; i<n_matrix; i++)
+                         {   FixedMatrix<T,n,n> a(static_cast<T>(i % 3)) ;
+                             FixedMatrix<T,n,n> b(a) ;
+                             m_fixed[i] = multiply(a + b, b) ;
+                         }
+                         sum = 0 ;
+                         for(size_t i=0; i<n_matrix; i++)
+                         {   sum += m_fixed[i](n-1, n-1) ; }
+                     },
+                     n_repeat) ;
+    std::cout << std::setw(6) << n
+              << std::setw(16) << "FixedMatrix"
+              << std::setw(12) << std::fixed << std::setprecision(1) << t / n_matrix * 1e9
+              << std::setw(16) << std::fixed << std::setprecision(1) << sum
+              << std::endl ;
+}
+
+void benchmark_small(size_t n_matrix)
+{   std::cout << "small matrices, " << n_matrix << " matrices of double" << std::endl ;
+    std::cout << std::setw(6) << "size"
+              << std::setw(16) << "class"
+              << std::setw(12) << "ns/matrix"
+              << std::setw(16) << "sum"
+              << std::endl ;
+    benchmark_small_size<double,3>(n_matrix) ;
+    benchmark_small_size<double,4>(n_matrix) ;
+}
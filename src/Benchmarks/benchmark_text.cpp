@@ -0,0 +1,194 @@
+#include "Benchmarks/benchmarks.hpp"
+
+#include <iostream>
+#include <iomanip>   // setw(), setprecision(), fixed
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>    // remove()
+
+#include "Matrix/Matrix2D.hpp"
+#include "Matrix/Matrix3D.hpp"
+#include "Matrix/MatrixSliceReader.hpp"
+#include "Matrix/ThreadPool.hpp"
+
+
+/*!
+ * \brief Writes a line of the result table on stdout.
+ * \param type the name of the value type.
+ * \param method the name of the method.
+ * \param t the time taken, in seconds.
+ * \param bytes the size of the file.
+ */
+void print_text_result(const std::string& type, const std::string& method, double t, double bytes)
+{   std::cout << std::setw(8)  << type
+              << std::setw(16) << method
+              << std::setw(12) << std::fixed << std::setprecision(4) << t
+              << std::setw(12) << std::fixed << std::setprecision(1) << bytes / t / 1e6
+              << std::endl ;
+}
+
+/*!
+ * \brief Reads a Matrix2D text file the way the file constructor
+ * used to, with a std::istringstream per line, as a reference.
+ * \param file_address the path to the file.
+ * \return the values read.
+ */
+template<class T>
+std::vector<T> read_text_istream(const std::string& file_address)
+{   std::ifstream file(file_address) ;
+    std::vector<T> values ;
+    std::string line ;
+    T value ;
+    while(getline(file, line))
+    {   std::istringstream line_stream(line) ;
+        while(line_stream >> value)
+        {   values.push_back(value) ; }
+    }
+    return values ;
+}
+
+/*!
+ * \brief Measures the throughput of the loading of a Matrix2D
+ * text file and writes it on stdout.
+ * \param size the matrix size.
+ * \param type the name of the value type.
+ */
+template<class T>
+void benchmark_text_type(size_t size, const std::string& type)
+{   std::string file_address = "benchmark_text.mat" ;
+    Matrix2D<T> m(size, size) ;
+    for(size_t i=0; i<m.get_data_size(); i++)
+    {   m.set(i, static_cast<T>(i % 100003) / static_cast<T>(7)) ; }
+    std::ofstream file(file_address) ;
+    file << m << std::endl ;
+    double bytes = static_cast<double>(file.tellp()) ;
+    file.close() ;
+    size_t n_repeat = 3 ;
+
+    size_t n = 0 ;
+    double t = time_best_of([&]()
+                            {   n = read_text_istream<T>(file_address).size() ; },
+                            n_repeat) ;
+    print_text_result(type, "istream", t, bytes) ;
+    t = time_best_of([&]()
+                     {   n = Matrix2D<T>(file_address).get_data_size() ; },
+                     n_repeat) ;
+    print_text_result(type, "parser", t, bytes) ;
+    if(n != m.get_data_size())
+    {   std::cerr << "error! the number of values read differs" << std::endl ; }
+
+    // the same values in a 3D matrix of 16 slices, read with one thread
+    // and with all the threads
+    Matrix3D<T> m3(size/16, size, 16) ;
+    for(size_t i=0; i<m3.get_data_size(); i++)
+    {   m3.set(i, m.get(i)) ; }
+    file.open(file_address) ;
+    file << m3 << std::endl ;
+    bytes = static_cast<double>(file.tellp()) ;
+    file.close() ;
+    ThreadPool pool_1(1) ;
+    t = time_best_of([&]()
+                     {   n = Matrix3D<T>(file_address, pool_1).get_data_size() ; },
+                     n_repeat) ;
+    print_text_result(type, "3D serial", t, bytes) ;
+    ThreadPool& pool = ThreadPool::get_default() ;
+    t = time_best_of([&]()
+                     {   n = Matrix3D<T>(file_address, pool).get_data_size() ; },
+                     n_repeat) ;
+    print_text_result(type, "3D parallel", t, bytes) ;
+    if(n != m3.get_data_size())
+    {   std::cerr << "error! the number of values read differs" << std::endl ; }
+    // one slice at a time
+    t = time_best_of([&]()
+                     {   n = 0 ;
+                         for(const Matrix2D<T>& slice : Matrix3DSliceReader<T>(file_address))
+                         {   n += slice.get_data_size() ; }
+                     },
+                     n_repeat) ;
+    print_text_result(type, "3D slice reader", t, bytes) ;
+    if(n != m3.get_data_size())
+    {   std::cerr << "error! the number of values read differs" << std::endl ; }
+
+    remove(file_address.c_str()) ;
+}
+
+/*!
+ * \brief Writes a Matrix2D on a stream the way print() used
+ * to, value by value with a flush per row, as a reference.
+ * \param stream the stream.
+ * \param m the matrix.
+ */
+template<class T>
+void print_text_stream(std::ostream& stream, const Matrix2D<T>& m)
+{   stream.setf(std::ios::left) ;
+    stream << std::setprecision(4) << std::fixed ;
+    for(size_t i=0; i<m.get_nrow(); i++)
+    {   for(size_t j=0; j<m.get_ncol(); j++)
+        {   stream << std::setw(8) << m(i,j) << ' ' ; }
+        if(i+1 < m.get_nrow())
+        {   stream << std::endl ; }
+    }
+}
+
+/*!
+ * \brief Measures the throughput of the writing of a Matrix2D
+ * text file and writes it on stdout.
+ * \param size the matrix size.
+ * \param type the name of the value type.
+ */
+template<class T>
+void benchmark_print_type(size_t size, const std::string& type)
+{   std::string file_address = "benchmark_text.mat" ;
+    Matrix2D<T> m(size, size) ;
+    for(size_t i=0; i<m.get_data_size(); i++)
+    {   m.set(i, static_cast<T>(i % 100003) / static_cast<T>(7)) ; }
+    size_t n_repeat = 3 ;
+
+    double bytes = 0. ;
+    double t = time_best_of([&]()
+                            {   std::ofstream file(file_address) ;
+                                print_text_stream(file, m) ;
+                                bytes = static_cast<double>(file.tellp()) ;
+                            },
+                            n_repeat) ;
+    print_text_result(type, "stream", t, bytes) ;
+    t = time_best_of([&]()
+                     {   std::ofstream file(file_address) ;
+                         m.print(file) ;
+                     },
+                     n_repeat) ;
+    print_text_result(type, "print", t, bytes) ;
+    ThreadPool& pool = ThreadPool::get_default() ;
+    t = time_best_of([&]()
+                     {   std::ofstream file(file_address) ;
+                         m.print(file, pool) ;
+                     },
+                     n_repeat) ;
+    print_text_result(type, "print parallel", t, bytes) ;
+
+    remove(file_address.c_str()) ;
+}
+
+void benchmark_text(size_t size)
+{   std::cout << "text loading, " << size << "x" << size << " matrix" << std::endl ;
+    std::cout << std::setw(8)  << "type"
+              << std::setw(16) << "method"
+              << std::setw(12) << "time (s)"
+              << std::setw(12) << "MB/s"
+              << std::endl ;
+    benchmark_text_type<int>(size, "int") ;
+    benchmark_text_type<float>(size, "float") ;
+    benchmark_text_type<double>(size, "double") ;
+
+    std::cout << "text writing, " << size << "x" << size << " matrix" << std::endl ;
+    std::cout << std::setw(8)  << "type"
+              << std::setw(16) << "method"
+              << std::setw(12) << "time (s)"
+              << std::setw(12) << "MB/s"
+              << std::endl ;
+    benchmark_print_type<int>(size, "int") ;
+    benchmark_print_type<float>(size, "float") ;
+    benchmark_print_type<double>(size, "double") ;
+}
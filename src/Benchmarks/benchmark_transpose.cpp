@@ -0,0 +1,86 @@
+#include "Benchmarks/benchmarks.hpp"
+
+#include <iostream>
+#include <iomanip>   // setw(), setprecision(), fixed
+#include <string>
+#include <vector>
+#include <algorithm> // min()
+#include <cstring>   // memcpy()
+
+#include "Matrix/Matrix2D.hpp"
+#include "Matrix/ThreadPool.hpp"
+
+
+/*!
+ * \brief Writes a line of the result table on stdout.
+ * \param type the name of the value type.
+ * \param size the matrix size.
+ * \param method the name of the method.
+ * \param t the time taken, in seconds.
+ * \param bytes the number of bytes read and written.
+ */
+void print_transpose_result(const std::string& type, size_t size,
+                            const std::string& method, double t, double bytes)
+{   std::cout << std::setw(8)  << type
+              << std::setw(8)  << size
+              << std::setw(12) << method
+              << std::setw(12) << std::fixed << std::setprecision(4) << t
+              << std::setw(12) << std::fixed << std::setprecision(2) << bytes / t / 1e9
+              << std::endl ;
+}
+
+/*!
+ * \brief Measures the bandwidth of the transposition of a
+ * square matrix of the given size and writes it on stdout.
+ * \param size the matrix size.
+ * \param type the name of the value type.
+ */
+template<class T>
+void benchmark_transpose_size(size_t size, const std::string& type)
+{   Matrix2D<T> m(size, size), m2(size, size) ;
+    for(size_t i=0; i<m.get_data_size(); i++)
+    {   m.set(i, static_cast<T>(i % 127)) ; }
+    // every value is read once and written once
+    double bytes = 2. * sizeof(T) * size * size ;
+    size_t n_repeat = 5 ;
+
+    double t_memcpy = time_best_of([&]()
+                                   {   memcpy(m2.get_data_ptr(), m.get_data_ptr(), sizeof(T)*size*size) ; },
+                                   n_repeat) ;
+    double t_naive = time_best_of([&]()
+                                  {   for(size_t i=0; i<size; i++)
+                                      {   for(size_t j=0; j<size; j++)
+                                          {   m2(i,j) = m(j,i) ; }
+                                      }
+                                  },
+                                  n_repeat) ;
+    double t_blocked = time_best_of([&]()
+                                    {   transpose_data(size, size, m.get_data_ptr(), m2.get_data_ptr(),
+                                                       ThreadPool::get_default()) ;
+                                    },
+                                    n_repeat) ;
+    // the destination is allocated, and not initialized, each time
+    double t_copy = time_best_of([&]() { Matrix2D<T> m3 = transpose(m) ; }, n_repeat) ;
+    double t_in_place = time_best_of([&]() { transpose_in_place(m) ; }, n_repeat) ;
+
+    print_transpose_result(type, size, "memcpy",   t_memcpy,   bytes) ;
+    print_transpose_result(type, size, "naive",    t_naive,    bytes) ;
+    print_transpose_result(type, size, "blocked",  t_blocked,  bytes) ;
+    print_transpose_result(type, size, "copy",     t_copy,     bytes) ;
+    print_transpose_result(type, size, "in place", t_in_place, bytes) ;
+}
+
+void benchmark_transpose(size_t size_max)
+{   std::cout << "matrix transposition, "
+              << ThreadPool::get_default().get_thread_number() << " threads" << std::endl ;
+    std::cout << std::setw(8)  << "type"
+              << std::setw(8)  << "size"
+              << std::setw(12) << "method"
+              << std::setw(12) << "time (s)"
+              << std::setw(12) << "GB/s"
+              << std::endl ;
+    for(size_t size=std::min(static_cast<size_t>(256), size_max); size<=size_max; size*=2)
+    {   benchmark_transpose_size<float>(size, "float") ;
+        benchmark_transpose_size<double>(size, "double") ;
+    }
+}
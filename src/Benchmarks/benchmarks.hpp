@@ -0,0 +1,103 @@
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+#include <chrono>
+#include <cstddef>
+
+
+/*!
+ * \brief Measures the time taken by a function call.
+ * The function is called the given number of times and
+ * the shortest time is returned.
+ * \param f the function to call, it should take no
+ * argument.
+ * \param n_repeat the number of calls.
+ * \return the shortest time taken by a call, in
+ * seconds.
+ */
+template<class F>
+double time_best_of(F f, size_t n_repeat)
+{   double best = -1. ;
+    for(size_t i=0; i<n_repeat; i++)
+    {   auto start = std::chrono::steady_clock::now() ;
+        f() ;
+        auto stop  = std::chrono::steady_clock::now() ;
+        double elapsed = std::chrono::duration<double>(stop - start).count() ;
+        if(best < 0. or elapsed < best)
+        {   best = elapsed ; }
+    }
+    return best ;
+}
+
+/*!
+ * \brief Measures the throughput of the matrix product of
+ * square matrices of increasing sizes, up to the given size,
+ * in single and double precision, and writes it on stdout in
+ * GFLOP/s.
+ * \param size_max the largest matrix size.
+ */
+void benchmark_gemm(size_t size_max) ;
+
+/*!
+ * \brief Measures the bandwidth reached by the transposition
+ * of square matrices of increasing sizes, up to the given size,
+ * out of place and in place, compared to a naive transposition
+ * and to a copy with memcpy(), and writes it on stdout in GB/s.
+ * \param size_max the largest matrix size.
+ */
+void benchmark_transpose(size_t size_max) ;
+
+/*!
+ * \brief Measures the time taken to access the elements of a 3D
+ * matrix through coordinates, with the different accessors (vector
+ * of coordinates, Matrix3D, MatrixN and raw pointer), and writes it
+ * on stdout in ns per element.
+ * \param size the length of the matrix in each dimension.
+ */
+void benchmark_access(size_t size) ;
+
+/*!
+ * \brief Measures the throughput of the loading of Matrix2D text
+ * files of int, float and double values, compared to a parsing
+ * with a std::istringstream per line, and of Matrix3D text files
+ * with one thread, with all the threads and slice by slice, as
+ * well as the throughput of print() compared to a writing value
+ * by value, and writes them on stdout in MB/s.
+ * \param size the matrix size.
+ */
+void benchmark_text(size_t size) ;
+
+/*!
+ * \brief Measures the time taken to load a z slice and smaller
+ * regions of a 3D matrix binary file with load_region(), compared
+ * to loading the whole file (also with O_DIRECT and with the I/O
+ * engine alone, through pread() and io_uring) and to loading the
+ * same regions from a chunked file, and writes it on stdout in ms,
+ * with the number of MB the region actually contains.
+ * \param size the number of rows and columns of the matrix, which
+ * has 64 slices.
+ */
+void benchmark_binary(size_t size) ;
+
+/*!
+ * \brief Measures, for each allocation policy (aligned, huge pages,
+ * NUMA interleaving, parallel first touch, see MatrixAllocator.hpp),
+ * the time taken to construct a square matrix of double and the
+ * bandwidth reached when reading it with the default pool and with
+ * the CPUs of each NUMA node (socket) alone, and writes them on
+ * stdout in ms and GB/s.
+ * \param size the matrix size.
+ */
+void benchmark_numa(size_t size) ;
+
+/*!
+ * \brief Measures the time taken to construct, copy, add and
+ * multiply 3x3 and 4x4 matrices of double, as Matrix2D, as
+ * SmallMatrix2D (which values are held by the object) and as
+ * FixedMatrix (which dimensions are also constant), and writes it
+ * on stdout in ns per matrix.
+ * \param n_matrix the number of matrices.
+ */
+void benchmark_small(size_t n_matrix) ;
+
+#endif // BENCHMARKS_HPP
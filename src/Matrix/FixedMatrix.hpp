@@ -0,0 +1,845 @@
+#ifndef FIXEDMATRIX_HPP
+#define FIXEDMATRIX_HPP
+
+#include <array>
+#include <vector>
+#include <initializer_list>
+#include <algorithm>    // copy(), fill(), equal(), swap()
+#include <cmath>        // abs()
+#include <iostream>
+#include <cstdio>       // sprintf()
+#include <stdexcept>    // invalid_argument
+#include <type_traits>  // integral_constant, is_floating_point
+
+#include "Matrix.hpp"
+#include "Matrix2D.hpp"
+#include "Matrix3D.hpp"
+#include "Matrix4D.hpp"
+#include "MatrixKernels.hpp"
+
+
+/*!
+ * The FixedMatrix class is a matrix which dimensions are known at
+ * compile time, FixedMatrix<double,3,3> for a 3x3 matrix for instance,
+ * for the small matrices of the geometry code.
+ *
+ * The dimensions, the strides and the number of values are constant
+ * expressions and the values are stored within the object, in a
+ * std::array. The offset of an element is thus computed with
+ * constant strides, without the offset tables of Matrix2D, Matrix3D
+ * and Matrix4D, and the loops of the arithmetic, of multiply(),
+ * transpose(), determinant() and inverse() are fully unrolled up to
+ * fixed_matrix_unroll_max values. A product which dimensions do not
+ * match does not compile.
+ *
+ * As for all the other matrix classes, the coordinates are given as
+ * (row, column, 3rd dimension, ...) and the values are stored in the
+ * same order, so that a FixedMatrix converts from a Matrix, Matrix2D,
+ * Matrix3D or Matrix4D with the same dimensions and into one of these
+ * (to_matrix()).
+ *
+ * FixedMatrix<double,3,3> m = {1, 2, 0,
+ *                              0, 1, 0,
+ *                              0, 0, 2} ;
+ * FixedMatrix<double,3,3> m_inv = inverse(m) ;
+ * Matrix2D<double> m2 = m.to_matrix() ;
+ */
+
+
+/*!
+ * \brief The largest number of iterations of a loop over the values
+ * which is unrolled.
+ */
+const size_t fixed_matrix_unroll_max = 64 ;
+
+
+/*!
+ * \brief Computes the product of the dimensions, the number of values.
+ */
+template<size_t... Dims>
+struct fixed_matrix_size ;
+
+template<>
+struct fixed_matrix_size<>
+{   static const size_t value = 1 ; } ;
+
+template<size_t D, size_t... Dims>
+struct fixed_matrix_size<D, Dims...>
+{   static const size_t value = D * fixed_matrix_size<Dims...>::value ; } ;
+
+
+/*!
+ * \brief Calls f(i) for each i in [Begin, Begin+N), the calls
+ * being generated by halving the range so that the recursion
+ * depth is log2(N).
+ */
+template<size_t Begin, size_t N>
+struct fixed_matrix_unroll
+{   template<class F>
+    static void apply(F& f)
+    {   fixed_matrix_unroll<Begin, N/2>::apply(f) ;
+        fixed_matrix_unroll<Begin + N/2, N - N/2>::apply(f) ;
+    }
+} ;
+
+template<size_t Begin>
+struct fixed_matrix_unroll<Begin, 1>
+{   template<class F>
+    static void apply(F& f)
+    {   f(Begin) ; }
+} ;
+
+template<size_t Begin>
+struct fixed_matrix_unroll<Begin, 0>
+{   template<class F>
+    static void apply(F&)
+    {}
+} ;
+
+template<size_t N, class F>
+void fixed_matrix_for(F& f, std::true_type)
+{   fixed_matrix_unroll<0, N>::apply(f) ; }
+
+template<size_t N, class F>
+void fixed_matrix_for(F& f, std::false_type)
+{   for(size_t i=0; i<N; i++)
+    {   f(i) ; }
+}
+
+/*!
+ * \brief Calls f(i) for each i in [0, N), the loop being unrolled
+ * if N is at most fixed_matrix_unroll_max.
+ * \param f the function, taking the index.
+ */
+template<size_t N, class F>
+void fixed_matrix_for(F f)
+{   fixed_matrix_for<N>(f, std::integral_constant<bool, (N <= fixed_matrix_unroll_max)>()) ; }
+
+
+/*!
+ * \brief The matrix class with dynamic dimensions corresponding to
+ * a number of dimensions (Matrix2D for 2, ...) and how to construct
+ * it.
+ */
+template<class T, class A, size_t N>
+struct fixed_matrix_dynamic
+{   typedef Matrix<T,A> type ;
+
+    template<class... Dim>
+    static type create(Dim... dim)
+    {   return type(std::vector<size_t>{dim...}) ; }
+} ;
+
+template<class T, class A>
+struct fixed_matrix_dynamic<T,A,2>
+{   typedef Matrix2D<T,A> type ;
+
+    template<class... Dim>
+    static type create(Dim... dim)
+    {   return type(dim...) ; }
+} ;
+
+template<class T, class A>
+struct fixed_matrix_dynamic<T,A,3>
+{   typedef Matrix3D<T,A> type ;
+
+    template<class... Dim>
+    static type create(Dim... dim)
+    {   return type(dim...) ; }
+} ;
+
+template<class T, class A>
+struct fixed_matrix_dynamic<T,A,4>
+{   typedef Matrix4D<T,A> type ;
+
+    template<class... Dim>
+    static type create(Dim... dim)
+    {   return type(dim...) ; }
+} ;
+
+
+template<class T, size_t... Dims>
+class FixedMatrix
+{
+    static_assert(sizeof...(Dims) > 0, "a matrix should have at least one dimension") ;
+    static_assert(fixed_matrix_size<Dims...>::value > 0, "the dimensions should not be null") ;
+
+    public:
+        typedef T value_type ;
+
+        /*!
+         * \brief The number of dimensions and of values.
+         */
+        static constexpr size_t n_dim = sizeof...(Dims) ;
+        static constexpr size_t size  = fixed_matrix_size<Dims...>::value ;
+
+        /*!
+         * \brief The type of the matrix with dynamic dimensions
+         * converted to, Matrix2D<T,A> for a 2D matrix, ...
+         */
+        template<class A>
+        using matrix_type = typename fixed_matrix_dynamic<T,A,sizeof...(Dims)>::type ;
+
+        // constructors
+        /*!
+         * \brief Constructs a matrix filled with 0 values.
+         */
+        FixedMatrix() ;
+        /*!
+         * \brief Constructs a matrix and initialize the values to
+         * the given value.
+         * \param value the value to initialize the matrix content
+         * with.
+         */
+        explicit FixedMatrix(T value) ;
+        /*!
+         * \brief Constructs a matrix with the given values.
+         * \param values the values, in the storage order (row by
+         * row, then slice by slice, ...).
+         * \throw std::invalid_argument if the number of values is
+         * not the size of the matrix.
+         */
+        FixedMatrix(std::initializer_list<T> values) ;
+        /*!
+         * \brief Constructs a matrix by copying the values of a
+         * matrix with dynamic dimensions, a Matrix2D for a 2D matrix
+         * for instance.
+         * \param other the matrix to copy the values from.
+         * \throw std::invalid_argument if the matrix does not have
+         * the same dimensions.
+         */
+        template<class A>
+        explicit FixedMatrix(const Matrix<T,A>& other) ;
+
+        // methods
+        /*!
+         * \brief Copies the values into a matrix with dynamic
+         * dimensions, a Matrix2D for a 2D matrix, a Matrix3D for a
+         * 3D matrix, a Matrix4D for a 4D matrix and a Matrix
+         * otherwise.
+         * \return the matrix.
+         */
+        template<class A = MatrixAlignedAllocator<T>>
+        matrix_type<A> to_matrix() const ;
+
+        /*!
+         * \brief Gets a dimension.
+         * \param i the index of the dimension, as (row, column, ...).
+         * \return the dimension.
+         */
+        static constexpr size_t get_dim(size_t i) ;
+
+        /*!
+         * \brief Gets the stride of a dimension, that is the distance
+         * between two consecutive elements along this dimension.
+         * \param i the index of the dimension, as (row, column, ...).
+         * \return the stride.
+         */
+        static constexpr size_t get_stride(size_t i) ;
+
+        /*!
+         * \brief Gets the number of values.
+         * \return the number of values.
+         */
+        static constexpr size_t get_data_size() ;
+
+        /*!
+         * \brief Computes the offset of the element at the given
+         * coordinates. This method does not perform any check on
+         * the coordinates.
+         * \param coord the coordinates of the element.
+         * \return the offset of the element.
+         */
+        template<class... Idx>
+        static size_t get_offset(Idx... coord) ;
+
+        /*!
+         * \brief Gives the address of the values.
+         * \return the address of the 1st value.
+         */
+        T* get_data_ptr() ;
+        const T* get_data_ptr() const ;
+
+        /*!
+         * \brief Produces a nice representation of the matrix on the
+         * given stream, as the matrix converted by to_matrix().
+         * \param stream the stream.
+         * \param precision the rounding precision.
+         * \param width the column width in number of characters.
+         * \param sep the character separator.
+         */
+        void print(std::ostream& stream, size_t precision=4, size_t width=8, char sep=' ') const ;
+
+        // operators
+        /*!
+         * \brief Returns a reference to the corrresponding
+         * element. This method does not perform any check on
+         * the coordinates.
+         * \param coord the coordinates of the element.
+         * \return a reference to this element.
+         */
+        template<class... Idx>
+        T& operator () (Idx... coord) ;
+        template<class... Idx>
+        const T& operator () (Idx... coord) const ;
+
+        /*!
+         * \brief Modifies each value of the matrix with the
+         * given value.
+         * \param value the value.
+         * \return a reference to the instance.
+         */
+        FixedMatrix& operator += (T value) ;
+        FixedMatrix& operator -= (T value) ;
+        FixedMatrix& operator *= (T value) ;
+
+        /*!
+         * \brief Divides each value of the matrix by the given
+         * value.
+         * \param value the value.
+         * \throw std::invalid_argument if the value is 0, the
+         * matrix being left unchanged.
+         * \return a reference to the instance.
+         */
+        FixedMatrix& operator /= (T value) ;
+
+        /*!
+         * \brief Modifies each value of the matrix with the
+         * value of the other matrix at the same coordinates.
+         * \param other the other matrix.
+         * \return a reference to the instance.
+         */
+        FixedMatrix& operator += (const FixedMatrix& other) ;
+        FixedMatrix& operator -= (const FixedMatrix& other) ;
+        FixedMatrix& operator *= (const FixedMatrix& other) ;
+
+        /*!
+         * \brief Divides each value of the matrix by the value
+         * of the other matrix at the same coordinates.
+         * \param other the other matrix.
+         * \throw std::invalid_argument if a value of the other
+         * matrix is 0, the matrix being left unchanged.
+         * \return a reference to the instance.
+         */
+        FixedMatrix& operator /= (const FixedMatrix& other) ;
+
+        /*!
+         * \brief Checks whether two matrices have the same values.
+         * \param other the other matrix.
+         * \return whether the matrices are equal.
+         */
+        bool operator == (const FixedMatrix& other) const ;
+        bool operator != (const FixedMatrix& other) const ;
+
+    private:
+        /*!
+         * \brief Computes the product of a range of dimensions.
+         * \param from the index of the 1st dimension.
+         * \param to the index past the last dimension.
+         * \return the product.
+         */
+        static constexpr size_t get_dim_prod(size_t from, size_t to) ;
+
+        /*!
+         * \brief The dimensions, as (row, column, ...).
+         */
+        static constexpr size_t _dim[sizeof...(Dims)] = {Dims...} ;
+        /*!
+         * \brief The values, in the storage order.
+         */
+        std::array<T, fixed_matrix_size<Dims...>::value> _data ;
+} ;
+
+template<class T, size_t... Dims>
+constexpr size_t FixedMatrix<T,Dims...>::n_dim ;
+
+template<class T, size_t... Dims>
+constexpr size_t FixedMatrix<T,Dims...>::size ;
+
+template<class T, size_t... Dims>
+constexpr size_t FixedMatrix<T,Dims...>::_dim[sizeof...(Dims)] ;
+
+
+/*!
+ * \brief Produces a nice representation of the matrix on the given
+ * stream.
+ * \param stream the stream.
+ * \param m the matrix.
+ * \return the stream.
+ */
+template<class T, size_t... Dims>
+std::ostream& operator << (std::ostream& stream, const FixedMatrix<T,Dims...>& m) ;
+
+/*!
+ * \brief Computes the matrix resulting from an operation on each value
+ * of a matrix and the value of the other matrix at the same coordinates,
+ * or the given value.
+ * \throw std::invalid_argument if dividing by 0.
+ * \return the resulting matrix.
+ */
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator + (FixedMatrix<T,Dims...> m1, const FixedMatrix<T,Dims...>& m2) ;
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator - (FixedMatrix<T,Dims...> m1, const FixedMatrix<T,Dims...>& m2) ;
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator * (FixedMatrix<T,Dims...> m1, const FixedMatrix<T,Dims...>& m2) ;
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator / (FixedMatrix<T,Dims...> m1, const FixedMatrix<T,Dims...>& m2) ;
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator + (FixedMatrix<T,Dims...> m, typename FixedMatrix<T,Dims...>::value_type value) ;
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator - (FixedMatrix<T,Dims...> m, typename FixedMatrix<T,Dims...>::value_type value) ;
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator * (FixedMatrix<T,Dims...> m, typename FixedMatrix<T,Dims...>::value_type value) ;
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator / (FixedMatrix<T,Dims...> m, typename FixedMatrix<T,Dims...>::value_type value) ;
+
+/*!
+ * \brief Computes the transpose of a 2D matrix.
+ * \param m the matrix.
+ * \return the transpose of m.
+ */
+template<class T, size_t N, size_t M>
+FixedMatrix<T,M,N> transpose(const FixedMatrix<T,N,M>& m) ;
+
+/*!
+ * \brief Computes the matrix product of two 2D matrices, which
+ * dimensions are checked at compile time.
+ * \param m1 the left matrix.
+ * \param m2 the right matrix.
+ * \return the matrix product of m1 and m2.
+ */
+template<class T, size_t N, size_t K, size_t M>
+FixedMatrix<T,N,M> multiply(const FixedMatrix<T,N,K>& m1, const FixedMatrix<T,K,M>& m2) ;
+
+/*!
+ * \brief Computes the determinant of a square matrix, with the
+ * closed-form expressions up to 4x4 and with a LU decomposition
+ * (of floating point values) otherwise.
+ * \param m the matrix.
+ * \return the determinant of m.
+ */
+template<class T, size_t N>
+T determinant(const FixedMatrix<T,N,N>& m) ;
+
+/*!
+ * \brief Computes the inverse of a square matrix of floating point
+ * values, with the closed-form expressions up to 4x4 and with a
+ * Gauss-Jordan elimination otherwise.
+ * \param m the matrix.
+ * \throw std::invalid_argument if the matrix is singular.
+ * \return the inverse of m.
+ */
+template<class T, size_t N>
+FixedMatrix<T,N,N> inverse(const FixedMatrix<T,N,N>& m) ;
+
+
+/*!
+ * \brief The determinant and the inverse of the square matrices
+ * of a given size.
+ */
+template<class T, size_t N>
+struct fixed_matrix_square
+{   static T determinant(FixedMatrix<T,N,N> m)
+    {   static_assert(std::is_floating_point<T>::value,
+                      "the determinant of a matrix larger than 4x4 needs floating point values") ;
+        // LU decomposition with partial pivoting
+        T det = 1 ;
+        for(size_t k=0; k<N; k++)
+        {   size_t pivot = k ;
+            for(size_t i=k+1; i<N; i++)
+            {   if(std::abs(m(i,k)) > std::abs(m(pivot,k)))
+                {   pivot = i ; }
+            }
+            if(m(pivot,k) == 0)
+            {   return 0 ; }
+            if(pivot != k)
+            {   for(size_t j=0; j<N; j++)
+                {   std::swap(m(k,j), m(pivot,j)) ; }
+                det = -det ;
+            }
+            det *= m(k,k) ;
+            for(size_t i=k+1; i<N; i++)
+            {   T factor = m(i,k) / m(k,k) ;
+                for(size_t j=k+1; j<N; j++)
+                {   m(i,j) -= factor * m(k,j) ; }
+            }
+        }
+        return det ;
+    }
+
+    static FixedMatrix<T,N,N> inverse(FixedMatrix<T,N,N> m)
+    {   // Gauss-Jordan elimination with partial pivoting
+        FixedMatrix<T,N,N> m_inv ;
+        for(size_t i=0; i<N; i++)
+        {   m_inv(i,i) = 1 ; }
+        for(size_t k=0; k<N; k++)
+        {   size_t pivot = k ;
+            for(size_t i=k+1; i<N; i++)
+            {   if(std::abs(m(i,k)) > std::abs(m(pivot,k)))
+                {   pivot = i ; }
+            }
+            if(m(pivot,k) == 0)
+            {   throw std::invalid_argument("error! the matrix is singular!") ; }
+            if(pivot != k)
+            {   for(size_t j=0; j<N; j++)
+                {   std::swap(m(k,j), m(pivot,j)) ;
+                    std::swap(m_inv(k,j), m_inv(pivot,j)) ;
+                }
+            }
+            T scale = 1 / m(k,k) ;
+            for(size_t j=0; j<N; j++)
+            {   m(k,j)     *= scale ;
+                m_inv(k,j) *= scale ;
+            }
+            for(size_t i=0; i<N; i++)
+            {   if(i == k)
+                {   continue ; }
+                T factor = m(i,k) ;
+                for(size_t j=0; j<N; j++)
+                {   m(i,j)     -= factor * m(k,j) ;
+                    m_inv(i,j) -= factor * m_inv(k,j) ;
+                }
+            }
+        }
+        return m_inv ;
+    }
+} ;
+
+template<class T>
+struct fixed_matrix_square<T,1>
+{   static T determinant(const FixedMatrix<T,1,1>& m)
+    {   return m(0,0) ; }
+
+    static FixedMatrix<T,1,1> inverse(const FixedMatrix<T,1,1>& m)
+    {   if(m(0,0) == 0)
+        {   throw std::invalid_argument("error! the matrix is singular!") ; }
+        return FixedMatrix<T,1,1>(1 / m(0,0)) ;
+    }
+} ;
+
+template<class T>
+struct fixed_matrix_square<T,2>
+{   static T determinant(const FixedMatrix<T,2,2>& m)
+    {   return m(0,0)*m(1,1) - m(0,1)*m(1,0) ; }
+
+    static FixedMatrix<T,2,2> inverse(const FixedMatrix<T,2,2>& m)
+    {   T det = determinant(m) ;
+        if(det == 0)
+        {   throw std::invalid_argument("error! the matrix is singular!") ; }
+        T inv_det = 1 / det ;
+        return FixedMatrix<T,2,2>{ m(1,1)*inv_det, -m(0,1)*inv_det,
+                                  -m(1,0)*inv_det,  m(0,0)*inv_det} ;
+    }
+} ;
+
+template<class T>
+struct fixed_matrix_square<T,3>
+{   static T determinant(const FixedMatrix<T,3,3>& m)
+    {   return m(0,0) * (m(1,1)*m(2,2) - m(1,2)*m(2,1)) +
+               m(0,1) * (m(1,2)*m(2,0) - m(1,0)*m(2,2)) +
+               m(0,2) * (m(1,0)*m(2,1) - m(1,1)*m(2,0)) ;
+    }
+
+    static FixedMatrix<T,3,3> inverse(const FixedMatrix<T,3,3>& m)
+    {   // the adjugate, the transpose of the cofactors
+        FixedMatrix<T,3,3> adj{m(1,1)*m(2,2) - m(1,2)*m(2,1),
+                               m(0,2)*m(2,1) - m(0,1)*m(2,2),
+                               m(0,1)*m(1,2) - m(0,2)*m(1,1),
+                               m(1,2)*m(2,0) - m(1,0)*m(2,2),
+                               m(0,0)*m(2,2) - m(0,2)*m(2,0),
+                               m(0,2)*m(1,0) - m(0,0)*m(1,2),
+                               m(1,0)*m(2,1) - m(1,1)*m(2,0),
+                               m(0,1)*m(2,0) - m(0,0)*m(2,1),
+                               m(0,0)*m(1,1) - m(0,1)*m(1,0)} ;
+        T det = m(0,0)*adj(0,0) + m(0,1)*adj(1,0) + m(0,2)*adj(2,0) ;
+        if(det == 0)
+        {   throw std::invalid_argument("error! the matrix is singular!") ; }
+        return adj *= 1 / det ;
+    }
+} ;
+
+template<class T>
+struct fixed_matrix_square<T,4>
+{   static T determinant(const FixedMatrix<T,4,4>& m)
+    {   // the 2x2 determinants of the 2 first and of the 2 last rows
+        T s0 = m(0,0)*m(1,1) - m(1,0)*m(0,1) ;
+        T s1 = m(0,0)*m(1,2) - m(1,0)*m(0,2) ;
+        T s2 = m(0,0)*m(1,3) - m(1,0)*m(0,3) ;
+        T s3 = m(0,1)*m(1,2) - m(1,1)*m(0,2) ;
+        T s4 = m(0,1)*m(1,3) - m(1,1)*m(0,3) ;
+        T s5 = m(0,2)*m(1,3) - m(1,2)*m(0,3) ;
+        T c5 = m(2,2)*m(3,3) - m(3,2)*m(2,3) ;
+        T c4 = m(2,1)*m(3,3) - m(3,1)*m(2,3) ;
+        T c3 = m(2,1)*m(3,2) - m(3,1)*m(2,2) ;
+        T c2 = m(2,0)*m(3,3) - m(3,0)*m(2,3) ;
+        T c1 = m(2,0)*m(3,2) - m(3,0)*m(2,2) ;
+        T c0 = m(2,0)*m(3,1) - m(3,0)*m(2,1) ;
+        return s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0 ;
+    }
+
+    static FixedMatrix<T,4,4> inverse(const FixedMatrix<T,4,4>& m)
+    {   T s0 = m(0,0)*m(1,1) - m(1,0)*m(0,1) ;
+        T s1 = m(0,0)*m(1,2) - m(1,0)*m(0,2) ;
+        T s2 = m(0,0)*m(1,3) - m(1,0)*m(0,3) ;
+        T s3 = m(0,1)*m(1,2) - m(1,1)*m(0,2) ;
+        T s4 = m(0,1)*m(1,3) - m(1,1)*m(0,3) ;
+        T s5 = m(0,2)*m(1,3) - m(1,2)*m(0,3) ;
+        T c5 = m(2,2)*m(3,3) - m(3,2)*m(2,3) ;
+        T c4 = m(2,1)*m(3,3) - m(3,1)*m(2,3) ;
+        T c3 = m(2,1)*m(3,2) - m(3,1)*m(2,2) ;
+        T c2 = m(2,0)*m(3,3) - m(3,0)*m(2,3) ;
+        T c1 = m(2,0)*m(3,2) - m(3,0)*m(2,2) ;
+        T c0 = m(2,0)*m(3,1) - m(3,0)*m(2,1) ;
+        T det = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0 ;
+        if(det == 0)
+        {   throw std::invalid_argument("error! the matrix is singular!") ; }
+        FixedMatrix<T,4,4> adj{ m(1,1)*c5 - m(1,2)*c4 + m(1,3)*c3,
+                               -m(0,1)*c5 + m(0,2)*c4 - m(0,3)*c3,
+                                m(3,1)*s5 - m(3,2)*s4 + m(3,3)*s3,
+                               -m(2,1)*s5 + m(2,2)*s4 - m(2,3)*s3,
+                               -m(1,0)*c5 + m(1,2)*c2 - m(1,3)*c1,
+                                m(0,0)*c5 - m(0,2)*c2 + m(0,3)*c1,
+                               -m(3,0)*s5 + m(3,2)*s2 - m(3,3)*s1,
+                                m(2,0)*s5 - m(2,2)*s2 + m(2,3)*s1,
+                                m(1,0)*c4 - m(1,1)*c2 + m(1,3)*c0,
+                               -m(0,0)*c4 + m(0,1)*c2 - m(0,3)*c0,
+                                m(3,0)*s4 - m(3,1)*s2 + m(3,3)*s0,
+                               -m(2,0)*s4 + m(2,1)*s2 - m(2,3)*s0,
+                               -m(1,0)*c3 + m(1,1)*c1 - m(1,2)*c0,
+                                m(0,0)*c3 - m(0,1)*c1 + m(0,2)*c0,
+                               -m(3,0)*s3 + m(3,1)*s1 - m(3,2)*s0,
+                                m(2,0)*s3 - m(2,1)*s1 + m(2,2)*s0} ;
+        return adj *= 1 / det ;
+    }
+} ;
+
+
+// method implementation
+template<class T, size_t... Dims>
+std::ostream& operator << (std::ostream& stream, const FixedMatrix<T,Dims...>& m)
+{   m.print(stream) ;
+    return stream ;
+}
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator + (FixedMatrix<T,Dims...> m1, const FixedMatrix<T,Dims...>& m2)
+{   return m1 += m2 ; }
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator - (FixedMatrix<T,Dims...> m1, const FixedMatrix<T,Dims...>& m2)
+{   return m1 -= m2 ; }
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator * (FixedMatrix<T,Dims...> m1, const FixedMatrix<T,Dims...>& m2)
+{   return m1 *= m2 ; }
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator / (FixedMatrix<T,Dims...> m1, const FixedMatrix<T,Dims...>& m2)
+{   return m1 /= m2 ; }
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator + (FixedMatrix<T,Dims...> m, typename FixedMatrix<T,Dims...>::value_type value)
+{   return m += value ; }
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator - (FixedMatrix<T,Dims...> m, typename FixedMatrix<T,Dims...>::value_type value)
+{   return m -= value ; }
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator * (FixedMatrix<T,Dims...> m, typename FixedMatrix<T,Dims...>::value_type value)
+{   return m *= value ; }
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...> operator / (FixedMatrix<T,Dims...> m, typename FixedMatrix<T,Dims...>::value_type value)
+{   return m /= value ; }
+
+template<class T, size_t N, size_t M>
+FixedMatrix<T,M,N> transpose(const FixedMatrix<T,N,M>& m)
+{   FixedMatrix<T,M,N> m2 ;
+    fixed_matrix_for<N*M>([&](size_t k)
+                          {   size_t i = k / M ;
+                              size_t j = k % M ;
+                              m2(j,i) = m(i,j) ;
+                          }) ;
+    return m2 ;
+}
+
+template<class T, size_t N, size_t K, size_t M>
+FixedMatrix<T,N,M> multiply(const FixedMatrix<T,N,K>& m1, const FixedMatrix<T,K,M>& m2)
+{   FixedMatrix<T,N,M> m3 ;
+    fixed_matrix_for<N*M>([&](size_t ij)
+                          {   size_t i = ij / M ;
+                              size_t j = ij % M ;
+                              T sum = 0 ;
+                              fixed_matrix_for<K>([&](size_t k)
+                                                  {   sum += m1(i,k) * m2(k,j) ; }) ;
+                              m3(i,j) = sum ;
+                          }) ;
+    return m3 ;
+}
+
+template<class T, size_t N>
+T determinant(const FixedMatrix<T,N,N>& m)
+{   return fixed_matrix_square<T,N>::determinant(m) ; }
+
+template<class T, size_t N>
+FixedMatrix<T,N,N> inverse(const FixedMatrix<T,N,N>& m)
+{   static_assert(std::is_floating_point<T>::value,
+                  "the inverse of a matrix needs floating point values") ;
+    return fixed_matrix_square<T,N>::inverse(m) ;
+}
+
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>::FixedMatrix()
+    : _data()
+{}
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>::FixedMatrix(T value)
+{   this->_data.fill(value) ; }
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>::FixedMatrix(std::initializer_list<T> values)
+{   if(values.size() != size)
+    {   char msg[4096] ;
+        sprintf(msg, "error! %zu values given for a matrix of %zu values!",
+                values.size(), size) ;
+        throw std::invalid_argument(msg) ;
+    }
+    std::copy(values.begin(), values.end(), this->_data.begin()) ;
+}
+
+template<class T, size_t... Dims>
+template<class A>
+FixedMatrix<T,Dims...>::FixedMatrix(const Matrix<T,A>& other)
+{   if(other.get_dim() != std::vector<size_t>{Dims...})
+    {   throw std::invalid_argument("error! the matrix does not have the dimensions of the FixedMatrix!") ; }
+    std::copy(other.get_data_ptr(), other.get_data_ptr() + size, this->_data.begin()) ;
+}
+
+template<class T, size_t... Dims>
+template<class A>
+typename FixedMatrix<T,Dims...>::template matrix_type<A> FixedMatrix<T,Dims...>::to_matrix() const
+{   matrix_type<A> m = fixed_matrix_dynamic<T,A,sizeof...(Dims)>::create(Dims...) ;
+    std::copy(this->_data.begin(), this->_data.end(), m.get_data_ptr()) ;
+    return m ;
+}
+
+template<class T, size_t... Dims>
+constexpr size_t FixedMatrix<T,Dims...>::get_dim(size_t i)
+{   return _dim[i] ; }
+
+template<class T, size_t... Dims>
+constexpr size_t FixedMatrix<T,Dims...>::get_dim_prod(size_t from, size_t to)
+{   return from >= to ? 1 : _dim[from] * get_dim_prod(from + 1, to) ; }
+
+template<class T, size_t... Dims>
+constexpr size_t FixedMatrix<T,Dims...>::get_stride(size_t i)
+{   // the values are stored row by row, then slice by slice, ...
+    return n_dim == 1 ? 1 :
+           i == 0     ? _dim[1] :
+           i == 1     ? 1 :
+                        get_dim_prod(0, i) ;
+}
+
+template<class T, size_t... Dims>
+constexpr size_t FixedMatrix<T,Dims...>::get_data_size()
+{   return size ; }
+
+template<class T, size_t... Dims>
+template<class... Idx>
+size_t FixedMatrix<T,Dims...>::get_offset(Idx... coord)
+{   static_assert(sizeof...(Idx) == sizeof...(Dims), "the number of coordinates should be equal to the number of dimensions") ;
+    static_assert(are_integral<Idx...>::value, "coordinates should be integral values") ;
+    const size_t coord_array[sizeof...(Dims)] = {static_cast<size_t>(coord)...} ;
+    size_t offset = 0 ;
+    for(size_t i=0; i<sizeof...(Dims); i++)
+    {   offset += coord_array[i] * get_stride(i) ; }
+    return offset ;
+}
+
+template<class T, size_t... Dims>
+T* FixedMatrix<T,Dims...>::get_data_ptr()
+{   return this->_data.data() ; }
+
+template<class T, size_t... Dims>
+const T* FixedMatrix<T,Dims...>::get_data_ptr() const
+{   return this->_data.data() ; }
+
+template<class T, size_t... Dims>
+void FixedMatrix<T,Dims...>::print(std::ostream& stream, size_t precision, size_t width, char sep) const
+{   this->to_matrix().print(stream, precision, width, sep) ; }
+
+template<class T, size_t... Dims>
+template<class... Idx>
+T& FixedMatrix<T,Dims...>::operator () (Idx... coord)
+{   return this->_data[get_offset(coord...)] ; }
+
+template<class T, size_t... Dims>
+template<class... Idx>
+const T& FixedMatrix<T,Dims...>::operator () (Idx... coord) const
+{   return this->_data[get_offset(coord...)] ; }
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>& FixedMatrix<T,Dims...>::operator += (T value)
+{   fixed_matrix_for<size>([&](size_t i) { this->_data[i] += value ; }) ;
+    return *this ;
+}
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>& FixedMatrix<T,Dims...>::operator -= (T value)
+{   fixed_matrix_for<size>([&](size_t i) { this->_data[i] -= value ; }) ;
+    return *this ;
+}
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>& FixedMatrix<T,Dims...>::operator *= (T value)
+{   fixed_matrix_for<size>([&](size_t i) { this->_data[i] *= value ; }) ;
+    return *this ;
+}
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>& FixedMatrix<T,Dims...>::operator /= (T value)
+{   if(value == static_cast<T>(0))
+    {   throw std::invalid_argument("division by 0!") ; }
+    fixed_matrix_for<size>([&](size_t i) { this->_data[i] /= value ; }) ;
+    return *this ;
+}
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>& FixedMatrix<T,Dims...>::operator += (const FixedMatrix& other)
+{   fixed_matrix_for<size>([&](size_t i) { this->_data[i] += other._data[i] ; }) ;
+    return *this ;
+}
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>& FixedMatrix<T,Dims...>::operator -= (const FixedMatrix& other)
+{   fixed_matrix_for<size>([&](size_t i) { this->_data[i] -= other._data[i] ; }) ;
+    return *this ;
+}
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>& FixedMatrix<T,Dims...>::operator *= (const FixedMatrix& other)
+{   fixed_matrix_for<size>([&](size_t i) { this->_data[i] *= other._data[i] ; }) ;
+    return *this ;
+}
+
+template<class T, size_t... Dims>
+FixedMatrix<T,Dims...>& FixedMatrix<T,Dims...>::operator /= (const FixedMatrix& other)
+{   if(kernel_has_zero(other._data.data(), size))
+    {   throw std::invalid_argument("division by 0!") ; }
+    fixed_matrix_for<size>([&](size_t i) { this->_data[i] /= other._data[i] ; }) ;
+    return *this ;
+}
+
+template<class T, size_t... Dims>
+bool FixedMatrix<T,Dims...>::operator == (const FixedMatrix& other) const
+{   return this->_data == other._data ; }
+
+template<class T, size_t... Dims>
+bool FixedMatrix<T,Dims...>::operator != (const FixedMatrix& other) const
+{   return not (*this == other) ; }
+
+#endif // FIXEDMATRIX_HPP
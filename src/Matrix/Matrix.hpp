@@ -4,12 +4,31 @@
 
 #include <vector>
 #include <numeric> // accumulate()
+#include <algorithm> // copy()
 #include <iostream>
 #include <fstream>
 #include <iomanip>   // setw(), setprecision(), fixed
 #include <stdexcept> // out_of_range, invalid_argument
 #include <utility>   // swap()f
-
+#include <type_traits> // is_integral
+#include <memory>    // unique_ptr
+#include <cstring>   // memcpy()
+#include <atomic>    // atomic_thread_fence()
+#include <cassert>   // assert()
+
+#include <fcntl.h>   // open()
+#include <sys/stat.h> // fstat()
+#include <unistd.h>  // close()
+
+#include "MatrixKernels.hpp"
+#include "MatrixExpression.hpp"
+#include "MatrixView.hpp"
+#include "MatrixStorage.hpp"
+#include "MatrixBinaryFormat.hpp"
+#include "MatrixNpyFormat.hpp"
+#include "MatrixChunkedFile.hpp"
+#include "MatrixTextWriter.hpp"
+#include "ThreadPool.hpp"
 
 
 /*!
@@ -66,22 +85,46 @@
  * that the user given coordinates can be used in this referencial.
  *
  *
- * A format to save a Matrix objects in a binary file is defined. The following values
- * are written :
- * 1x size_t :     the number <N> of dimensions of the Matrix stored. This is the value
- *                 of _dim_size field.
- * Nx size_t :     the width of the matrix in each dimension. These values correspond
- *                 to the content of the _dim vector and can be loaded inside this
- *                 vector as they are.
- * Dx <T> values : the <D> values contained in the matrix, in the _data vector.
- *                 These values can be loaded directly in this vector. <D> is equal to the
- *                 product of the <N> values stored right before. The type <T> depends on
- *                 the type of the data stored in the matrix. The 1st of the D values is
- *                 also the first value of the _data vector.
+ * A format to save a Matrix objects in a binary file is defined (see
+ * MatrixBinaryFormat.hpp). A header gives the format version, the byte order,
+ * the type of the values, the number <N> of dimensions of the Matrix stored
+ * (the _dim_size field) and the width of the matrix in each dimension (the
+ * content of the _dim vector). The <D> values contained in the matrix follow,
+ * in the _data order, at an offset which is a multiple of the page size. The
+ * files written in the legacy format (the number of dimensions, the dimensions
+ * and the values) can still be read.
+ * A matrix can also be saved in a chunked file (see MatrixChunkedFile.hpp),
+ * made of blocks of fixed dimensions stored independently, which can be read
+ * and updated region by region without rewriting the whole file.
+ *
+ *
+ * The arithmetic operators between matrices, and between a matrix and a value,
+ * build lazy expressions which are evaluated in a single pass when assigned to
+ * a matrix (see MatrixExpression.hpp).
+ *
+ * The values held in memory are allocated by the allocator A, which is by
+ * default MatrixAlignedAllocator<T>, aligning them on 64 bytes (see
+ * MatrixAllocator.hpp). The subclasses take the same parameter.
+ */
+
+/*!
+ * \brief Checks that all the types of a parameter pack are
+ * integral types, as coordinates should be.
  */
+template<class... Idx>
+struct are_integral ;
+
+template<>
+struct are_integral<>
+{   static const bool value = true ; } ;
+
+template<class I, class... Idx>
+struct are_integral<I, Idx...>
+{   static const bool value = std::is_integral<I>::value and are_integral<Idx...>::value ; } ;
 
-template <class T>
-class Matrix
+
+template<class T, class A>
+class Matrix : public MatrixExpression<Matrix<T,A>>
 {
     public:
         // constructors
@@ -100,6 +143,13 @@ class Matrix
          * with.
          */
         Matrix(const std::vector<size_t>& dim, T value) ;
+        /*!
+         * \brief Constructs a matrix with the given dimensions which
+         * values are not initialized, they should all be set before
+         * being read.
+         * \param dim the dimensions.
+         */
+        Matrix(const std::vector<size_t>& dim, MatrixUninitialized) ;
 
         /*!
          * \brief Copy constructor.
@@ -113,6 +163,14 @@ class Matrix
          */
         Matrix(Matrix&& other) ;
 
+        /*!
+         * \brief Constructs a matrix by evaluating an expression,
+         * each value being written once.
+         * \param e the expression of interest.
+         */
+        template<class E>
+        Matrix(const MatrixExpression<E>& e) ;
+
         /*!
          * \brief Destructor.
          */
@@ -121,25 +179,219 @@ class Matrix
         // methods
         /*!
          * \brief loads a matrix from the given binary
-         * file.
+         * file. The values are converted if they were
+         * written with another byte order or with a type
+         * which can be widened to T, and the checksum is
+         * verified if the file contains one. Chunked
+         * files (see save_chunked()) are also read, chunk
+         * by chunk. The file is read by the I/O engine of
+         * the thread (see MatrixIOEngine.hpp), with many
+         * reads in flight.
          * \param path the path to the file to read.
          * \param dim_n the expected number of dimensions
          * of the matrix.
-         * \throw std::invalid_argument if the dimensionality
+         * \throw std::runtime_error if the dimensionality
          * of the matrix stored in the file is not equal to
-         * the expected number of dimensions and
-         * std::runtime_error if any reading error
-         * occures.
+         * the expected number of dimensions, if the values
+         * cannot be loaded as T, if the checksum does not
+         * match or if any reading error occures.
          */
         virtual void load(const std::string& file_address,
                           size_t dim_n) ;
 
+        /*!
+         * \brief loads a region of a matrix stored in the
+         * given binary file, without reading the rest of the
+         * file. The region is a block of the stored matrix,
+         * with the same number of dimensions. Only the runs
+         * of values of the region are read, through the I/O
+         * engine of the thread (see MatrixIOEngine.hpp), the
+         * runs which are close to each other in the file being
+         * read at once. The values are converted as by load(),
+         * the checksum is not verified. In a chunked file
+         * (see save_chunked()), only the chunks intersecting
+         * the region are read.
+         * \param path the path to the file to read.
+         * \param dim_n the expected number of dimensions
+         * of the matrix.
+         * \param origin the coordinates of the 1st element of
+         * the region, as (row, column, ...).
+         * \param extent the dimensions of the region, as (row,
+         * column, ...).
+         * \throw std::runtime_error if the dimensionality
+         * of the matrix stored in the file is not equal to
+         * the expected number of dimensions, if the values
+         * cannot be loaded as T or if any reading error
+         * occures and std::out_of_range if the region does
+         * not fit within the stored matrix.
+         */
+        virtual void load_region(const std::string& file_address,
+                                 size_t dim_n,
+                                 const std::vector<size_t>& origin,
+                                 const std::vector<size_t>& extent) ;
+
+        /*!
+         * \brief maps a matrix stored in the given binary
+         * file in memory, instead of reading it. Only the
+         * header is read, the values are read lazily, when
+         * they are accessed for the first time. The file
+         * should not be truncated as long as the matrix is
+         * mapped on it.
+         * Copying the matrix copies the values in memory.
+         * \param path the path to the file to map.
+         * \param dim_n the expected number of dimensions
+         * of the matrix.
+         * \param mode how the file is mapped. Modifying the
+         * values of a matrix mapped with MatrixMapMode::read_only
+         * crashes the program. Matrices mapped with
+         * MatrixMapMode::copy_on_write can be modified, but the
+         * file is never modified.
+         * \throw std::runtime_error if the file cannot be
+         * mapped, if the dimensionality of the matrix stored
+         * in the file is not equal to the expected number of
+         * dimensions, if the values are not of type T in
+         * the byte order of the machine or if the file is too
+         * short. The checksum is not verified.
+         */
+        virtual void map(const std::string& file_address,
+                         size_t dim_n,
+                         MatrixMapMode mode) ;
+
         /*!
          * \brief writes to content of the matrix
-         * to a given binary file.
+         * to a given binary file, through the I/O engine
+         * of the thread (see MatrixIOEngine.hpp).
+         * \param path the path to the file.
+         * \param checksum whether to store a CRC32C
+         * checksum of the values, verified by load().
+         */
+        virtual void save(const std::string& file_address, bool checksum=false) ;
+
+        /*!
+         * \brief writes the content of the matrix to a
+         * given chunked file, the matrix being split in
+         * chunks of the given dimensions which are stored
+         * independently (see MatrixChunkedFile.hpp). A
+         * region of such a file can be read or updated
+         * with MatrixChunkedFile without rewriting the rest
+         * of the file, and the file can be read with load()
+         * and load_region() as a matrix of type T only.
+         * \param path the path to the file.
+         * \param chunk_dim the dimensions of the chunks, as
+         * (row, column, ...).
+         * \throw std::invalid_argument if the chunk dimensions
+         * do not match the matrix dimensions and
+         * std::runtime_error if the file cannot be written.
+         */
+        virtual void save_chunked(const std::string& file_address,
+                                  const std::vector<size_t>& chunk_dim) ;
+
+        /*!
+         * \brief loads a matrix from the given NumPy .npy file,
+         * or from an array of the given .npz file stored
+         * without compression (see MatrixNpyFormat.hpp). The
+         * array of shape (..., dim3, rows, columns) is the
+         * matrix with these dimensions. The values are
+         * converted as by load(), and reordered if the array
+         * is in Fortran order.
+         * \param path the path to the file to read.
+         * \param dim_n the expected number of dimensions
+         * of the matrix.
+         * \param name in a .npz file, the name of the array,
+         * by default the 1st array.
+         * \throw std::runtime_error if the dimensionality
+         * of the array is not equal to the expected number
+         * of dimensions, if the values cannot be loaded as
+         * T, if the array cannot be found or if any reading
+         * error occures.
+         */
+        virtual void load_npy(const std::string& file_address,
+                              size_t dim_n,
+                              const std::string& name="") ;
+
+        /*!
+         * \brief maps a matrix stored in the given NumPy .npy
+         * file in memory, or an array of the given .npz file,
+         * as map() does for a binary file. The array should
+         * be in C order, its values of type T in the byte
+         * order of the machine, and, in a .npz file, stored
+         * without compression.
+         * \param path the path to the file to map.
+         * \param dim_n the expected number of dimensions
+         * of the matrix.
+         * \param mode how the file is mapped, see map().
+         * \param name in a .npz file, the name of the array,
+         * by default the 1st array.
+         * \throw std::runtime_error if the file cannot be
+         * mapped, if the dimensionality of the array is not
+         * equal to the expected number of dimensions, if the
+         * values cannot be mapped as T (or are in Fortran
+         * order) or if the array cannot be found.
+         */
+        virtual void map_npy(const std::string& file_address,
+                             size_t dim_n,
+                             MatrixMapMode mode,
+                             const std::string& name="") ;
+
+        /*!
+         * \brief writes the content of the matrix to a given
+         * NumPy .npy file, as an array in C order of shape
+         * (..., dim3, rows, columns), through the I/O engine
+         * of the thread. Several matrices are written in a
+         * .npz file by MatrixNpzWriter.
          * \param path the path to the file.
+         * \throw std::runtime_error if the values have no
+         * NumPy type or if the file cannot be written.
          */
-        virtual void save(const std::string& file_address) ;
+        virtual void save_npy(const std::string& file_address) ;
+
+        /*!
+         * \brief moves the values of the matrix to a new POSIX
+         * shared memory object, which other processes attach to
+         * with attach_shared() to access the values without any
+         * copy. The object has the layout of a binary file (see
+         * save()), so it can also be read from /dev/shm with
+         * load() or map(). The matrix then uses the values in
+         * the shared memory, which it can modify, the changes
+         * being seen by the attached processes.
+         * \param name the name of the object ("/table", the
+         * leading '/' being added if missing).
+         * \param persistent whether the object outlives the
+         * matrix. By default, its name is removed when the
+         * matrix releases its values, the memory being released
+         * once all the attached matrices are destroyed. A
+         * persistent object is removed with remove_shared().
+         * \throw std::runtime_error if an object with this name
+         * already exists or if it cannot be created.
+         */
+        virtual void create_shared(const std::string& name, bool persistent=false) ;
+
+        /*!
+         * \brief attaches the matrix to the values of a POSIX
+         * shared memory object created by create_shared(),
+         * in this process or in another one. The values are
+         * mapped read-only, modifying them crashes the program.
+         * Copying the matrix copies the values in memory.
+         * \param name the name of the object.
+         * \param dim_n the expected number of dimensions
+         * of the matrix.
+         * \throw std::runtime_error if the object does not exist
+         * or is not complete yet, if the dimensionality of the
+         * matrix is not equal to the expected number of
+         * dimensions or if the values are not of type T.
+         */
+        virtual void attach_shared(const std::string& name,
+                                   size_t dim_n) ;
+
+        /*!
+         * \brief removes the name of a POSIX shared memory
+         * object created by create_shared(). The matrices
+         * attached to it remain valid, the memory is released
+         * when they are all destroyed.
+         * \param name the name of the object.
+         * \return whether the object existed.
+         */
+        static bool remove_shared(const std::string& name) ;
 
         /*!
          * \brief Gets the element at the given offset.
@@ -190,6 +442,22 @@ class Matrix
          */
         std::vector<T> get_data() ;
 
+        /*!
+         * \brief Gets the address of the data, which are stored
+         * contiguously. This address is valid as long as the
+         * dimensions of the matrix are not modified.
+         * \return the address of the 1st element.
+         */
+        T* get_data_ptr() ;
+
+        /*!
+         * \brief Gets the address of the data, which are stored
+         * contiguously. This address is valid as long as the
+         * dimensions of the matrix are not modified.
+         * \return the address of the 1st element.
+         */
+        const T* get_data_ptr() const ;
+
         /*!
          * \brief Gets the number of dimensions (the length
          * of the dimension vector).
@@ -210,6 +478,23 @@ class Matrix
          * \return the partial products of the dimensions.
          */
         std::vector<size_t> get_dim_product() const ;
+
+        /*!
+         * \brief Creates a view on the whole matrix, which gives
+         * access to the data without copying them (see
+         * MatrixView.hpp). The view is valid as long as the
+         * dimensions of the matrix are not modified.
+         * \return a view on the matrix.
+         */
+        MatrixView<T> get_view() ;
+
+        /*!
+         * \brief Creates a read-only view on the whole matrix.
+         * The view is valid as long as the dimensions of the
+         * matrix are not modified.
+         * \return a view on the matrix.
+         */
+        MatrixView<const T> get_view() const ;
 		
         /*!
          * \brief Produces a nice representation of the matrix on the given
@@ -221,20 +506,43 @@ class Matrix
          */
         virtual void print(std::ostream& stram, size_t precision=4, size_t width=8, char sep=' ') const ;
 
+        /*!
+         * \brief Produces the same representation as print(), the
+         * values being formatted by chunks in parallel.
+         * \param stream the stream.
+         * \param pool the threads to use.
+         * \param precision the rounding precision.
+         * \param width the column width in number of characters.
+         * \param sep the character separator.
+         */
+        virtual void print(std::ostream& stream, ThreadPool& pool, size_t precision=4, size_t width=8, char sep=' ') const ;
+
         // operator
         /*!
          * \brief Assignment operator.
          * \param other an other matrix to copy the values from.
          * \return a reference to the current instance.
          */
-        Matrix& operator = (const Matrix<T>& other) ;
+        Matrix& operator = (const Matrix<T,A>& other) ;
 
         /*!
          * \brief Move assignment operator.
          * \param other an other matrix to use the values from.
          * \return a reference to the current instance.
          */
-        Matrix& operator = (Matrix<T>&& other) ;
+        Matrix& operator = (Matrix<T,A>&& other) ;
+
+        /*!
+         * \brief Assignment operator, evaluates an expression and
+         * stores the result. The expression may involve the
+         * instance itself.
+         * \param e the expression of interest.
+         * \throw std::invalid_argument if the expression divides
+         * by 0, in which case the instance is left unchanged.
+         * \return a reference to the current instance.
+         */
+        template<class E>
+        Matrix& operator = (const MatrixExpression<E>& e) ;
 
         /*!
          * \brief Adds value to each element.
@@ -265,6 +573,88 @@ class Matrix
          */
         Matrix& operator /= (T value) ;
 
+        /*!
+         * \brief Element-wise addition, adds the elements of other
+         * to the corresponding elements of the instance.
+         * \param other a matrix with the same dimensions.
+         * \throw std::invalid_argument if both matrices do not have
+         * the same dimensions.
+         * \return a reference to the instance.
+         */
+        Matrix& operator += (const Matrix<T,A>& other) ;
+
+        /*!
+         * \brief Element-wise substraction, substracts the elements of
+         * other to the corresponding elements of the instance.
+         * \param other a matrix with the same dimensions.
+         * \throw std::invalid_argument if both matrices do not have
+         * the same dimensions.
+         * \return a reference to the instance.
+         */
+        Matrix& operator -= (const Matrix<T,A>& other) ;
+
+        /*!
+         * \brief Element-wise multiplication, multiplies the elements
+         * of the instance by the corresponding elements of other.
+         * \param other a matrix with the same dimensions.
+         * \throw std::invalid_argument if both matrices do not have
+         * the same dimensions.
+         * \return a reference to the instance.
+         */
+        Matrix& operator *= (const Matrix<T,A>& other) ;
+
+        /*!
+         * \brief Element-wise division, divides the elements of the
+         * instance by the corresponding elements of other.
+         * \param other a matrix with the same dimensions.
+         * \throw std::invalid_argument if both matrices do not have
+         * the same dimensions or if other contains a 0 value.
+         * \return a reference to the instance.
+         */
+        Matrix& operator /= (const Matrix<T,A>& other) ;
+
+        /*!
+         * \brief Element-wise addition of the result of an
+         * expression, evaluated in a single pass.
+         * \param e an expression with the same dimensions.
+         * \throw std::invalid_argument if the dimensions differ.
+         * \return a reference to the instance.
+         */
+        template<class E>
+        Matrix& operator += (const MatrixExpression<E>& e) ;
+
+        /*!
+         * \brief Element-wise substraction of the result of an
+         * expression, evaluated in a single pass.
+         * \param e an expression with the same dimensions.
+         * \throw std::invalid_argument if the dimensions differ.
+         * \return a reference to the instance.
+         */
+        template<class E>
+        Matrix& operator -= (const MatrixExpression<E>& e) ;
+
+        /*!
+         * \brief Element-wise multiplication by the result of an
+         * expression, evaluated in a single pass.
+         * \param e an expression with the same dimensions.
+         * \throw std::invalid_argument if the dimensions differ.
+         * \return a reference to the instance.
+         */
+        template<class E>
+        Matrix& operator *= (const MatrixExpression<E>& e) ;
+
+        /*!
+         * \brief Element-wise division by the result of an
+         * expression, evaluated in a single pass.
+         * \param e an expression with the same dimensions.
+         * \throw std::invalid_argument if the dimensions differ
+         * or if the expression contains a 0 value, in which
+         * case the instance is left unchanged.
+         * \return a reference to the instance.
+         */
+        template<class E>
+        Matrix& operator /= (const MatrixExpression<E>& e) ;
+
         /*!
          * \brief Comparison operator, returns true if
          * both matrices are identical, that is do not
@@ -273,7 +663,7 @@ class Matrix
          * \return true if both matrices have the same
          * data and dimensions.
          */
-        bool operator == (const Matrix<T>& other) const ;
+        bool operator == (const Matrix<T,A>& other) const ;
 
         /*!
          * \brief Comparison operator, returns true if
@@ -302,6 +692,32 @@ class Matrix
          */
         const T& operator () (const std::vector<size_t>& coord) const ;
 
+        /*!
+         * \brief Returns a reference to the corrresponding
+         * element, given as many coordinates as the matrix has
+         * dimensions, as (row, column, ...). Unlike the vector
+         * version, no temporary vector is built. This method
+         * does not perform any check on the coordinates, only
+         * their number is asserted in debug builds.
+         * \param coord the coordinates of the element to get.
+         * \return a reference to this element.
+         */
+        template<class... Idx>
+        T& operator () (Idx... coord) ;
+
+        /*!
+         * \brief Returns a const reference to the corrresponding
+         * element, given as many coordinates as the matrix has
+         * dimensions, as (row, column, ...). Unlike the vector
+         * version, no temporary vector is built. This method
+         * does not perform any check on the coordinates, only
+         * their number is asserted in debug builds.
+         * \param coord the coordinates of the element to get.
+         * \return a const reference to this element.
+         */
+        template<class... Idx>
+        const T& operator () (Idx... coord) const ;
+
     protected:
         // methods
         /*!
@@ -311,6 +727,34 @@ class Matrix
          */
         void compute_dim_product() ;
 
+        /*!
+         * \brief loads a region of a matrix stored in the
+         * given chunked file, see load_region().
+         * \param path the path to the file to read.
+         * \param dim_n the expected number of dimensions
+         * of the matrix.
+         * \param origin the coordinates of the 1st element of
+         * the region, as (row, column, ...), or an empty vector
+         * to load the whole matrix.
+         * \param extent the dimensions of the region.
+         */
+        void load_chunked(const std::string& file_address,
+                          size_t dim_n,
+                          const std::vector<size_t>& origin,
+                          const std::vector<size_t>& extent) ;
+
+        /*!
+         * \brief Evaluates an expression with the dimensions of
+         * the instance and stores its values in the instance. The
+         * divisors of an expression which may throw while it is
+         * evaluated (a division by a matrix) are checked first, so
+         * that the instance is left unchanged if it does.
+         * \param e the expression of interest.
+         * \throw std::invalid_argument if a divisor value is 0.
+         */
+        template<class E>
+        void evaluate_in_place(const MatrixExpression<E>& e) ;
+
         /*!
          * \brief Given a vector of at least 2 dimensional coordinates,
          * it simply swaps the elements at index 0 (row number) and 1
@@ -357,6 +801,33 @@ class Matrix
          */
         size_t convert_to_offset(const std::vector<size_t>& coord) const ;
 
+        /*!
+         * \brief Checks whether coordinates in (row,col,...) format
+         * are valid, without copying them.
+         * \param coord a vector of coordinates with (row,col,...)
+         * format.
+         * \return whether the coordinates are valid.
+         */
+        bool is_valid_coord(const std::vector<size_t>& coord) const ;
+
+        /*!
+         * \brief Converts a vector of VALID (row,col,...) coordinates
+         * to the corresponding offset, without copying them.
+         * \param coord a vector of coordinates with (row,col,...)
+         * format.
+         * \return the corresponding offset.
+         */
+        size_t convert_coord_to_offset(const std::vector<size_t>& coord) const ;
+
+        /*!
+         * \brief Converts VALID (row,col,...) coordinates, given
+         * as separate arguments, to the corresponding offset.
+         * \param coord the coordinates.
+         * \return the corresponding offset.
+         */
+        template<class... Idx>
+        size_t convert_index_to_offset(Idx... coord) const ;
+
         /*!
          * \brief Complementary function of convert_to_offset(). Given an
          * offset, this function returns the corresponding coordinate
@@ -366,23 +837,40 @@ class Matrix
          */
         std::vector<size_t> convert_to_coord(size_t offset) const ;
 
+        /*!
+         * \brief Checks whether the other matrix has exactly the
+         * same dimensions as the instance and throws an exception
+         * if not.
+         * \param other an other matrix.
+         * \throw std::invalid_argument if the dimensions differ.
+         */
+        void check_same_dim(const Matrix<T,A>& other) const ;
+
+        /*!
+         * \brief Empties a matrix which values were moved to
+         * another matrix. It keeps its number of dimensions,
+         * the dimensions being set to 0, and can be used again.
+         */
+        void clear_moved() ;
+
         // fields
         /*!
          * \brief The dimensions values.
          */
         std::vector<size_t> _dim ;
         /*!
-         * \brief Stores the data.
+         * \brief Stores the data, either in memory or in a
+         * mapped file.
          */
-        std::vector<T>* _data ;
+        MatrixStorage<T>* _data = nullptr ;
         /*!
          * \brief The number of dimensions.
          */
-        size_t _dim_size ;
+        size_t _dim_size = 0 ;
         /*!
          * \brief The number of data elements stored.
          */
-        size_t _data_size ;
+        size_t _data_size = 0 ;
         /*!
          * \brief Contains the partial product of the dimensions. That is,
          * the ith element contains the product of all the i-1 precedent
@@ -396,69 +884,14 @@ class Matrix
 } ;
 
 // operators
-/*!
- * \brief Addition operator.
- * \param m the matrix of interest
- * \param value the value to add to each element.
- * \return the resulting matrix.
- */
-template<class T>
-const Matrix<T> operator + (Matrix<T> m, T value)
-{   Matrix<T> other(m) ;
-    other += value ;
-    return other ;
-}
-
-/*!
- * \brief Substraction operator
- * \param m the matrix of interest.
- * \param value the value to substract to each element.
- * \return the resulting matrix.
- */
-template<class T>
-const Matrix<T> operator - (Matrix<T> m, T value)
-{   Matrix<T> other(m) ;
-    other -= value ;
-    return other ;
-}
-
-/*!
- * \brief Multiplication operator.
- * \param m the matrix of interest.
- * \param value the value to multiply each elements by.
- * \return the resulting matrix.
- */
-template<class T>
-const Matrix<T> operator * (Matrix<T> m, T value)
-{   Matrix<T> other(m) ;
-    other *= value ;
-    return other ;
-}
-
-/*!
- * \brief Division operator.
- * \param m the matrix of interest.
- * \param value the value to divide each elements by.
- * \throw std::invalid_argument if value is 0.
- * \return the resulting matrix.
- */
-template<class T>
-const Matrix<T> operator / (Matrix<T> m, T value)
-{   if(value == static_cast<T>(0))
-    {   throw std::invalid_argument("division by 0!") ; }
-    Matrix<T> other(m) ;
-    other /= value ;
-    return other ;
-}
-
 /*!
  * \brief Sends a representation of the matrix to the stream.
  * \param stream the stream of interest.
  * \param m the matrix of interest.
  * \return a reference to the stream.
  */
-template<class T>
-std::ostream& operator << (std::ostream& stream, const Matrix<T>& m)
+template<class T, class A>
+std::ostream& operator << (std::ostream& stream, const Matrix<T,A>& m)
 {	m.print(stream) ;   
     return stream ;
 }
@@ -466,270 +899,815 @@ std::ostream& operator << (std::ostream& stream, const Matrix<T>& m)
 
 
 // method implementation
-template<class T>
-Matrix<T>::Matrix(const std::vector<size_t>& dim)
+template<class T, class A>
+Matrix<T,A>::Matrix(const std::vector<size_t>& dim)
     : Matrix(dim, 0)
 {}
 
-template<class T>
-Matrix<T>::Matrix(const std::vector<size_t>& dim, T value)
+template<class T, class A>
+Matrix<T,A>::Matrix(const std::vector<size_t>& dim, T value)
+{   this->_dim_size  = dim.size() ;
+    this->_dim       = this->swap_coord(dim) ;
+    this->_data_size = std::accumulate(dim.begin(), dim.end(), (size_t)1, std::multiplies<size_t>()) ;
+    this->_data      = new MatrixHeapStorage<T,A>(this->_data_size, value) ;
+    this->compute_dim_product() ;
+}
+
+template<class T, class A>
+Matrix<T,A>::Matrix(const std::vector<size_t>& dim, MatrixUninitialized)
 {   this->_dim_size  = dim.size() ;
     this->_dim       = this->swap_coord(dim) ;
     this->_data_size = std::accumulate(dim.begin(), dim.end(), (size_t)1, std::multiplies<size_t>()) ;
-    this->_data      = new std::vector<T>(this->_data_size, value) ;
+    this->_data      = new MatrixHeapStorage<T,A>(this->_data_size, matrix_uninitialized) ;
     this->compute_dim_product() ;
 }
 
-template<class T>
-Matrix<T>::Matrix(const Matrix& other)
+template<class T, class A>
+Matrix<T,A>::Matrix(const Matrix& other)
 {   this->_dim_size  = other._dim_size ;
     this->_dim       = other._dim ;
     this->_data_size = other._data_size ;
-    this->_data      = new std::vector<T>(*(other._data)) ;
+    this->_data      = new MatrixHeapStorage<T,A>(other._data->begin(), other._data->end()) ;
     this->_dim_prod  = other._dim_prod ;
 }
 
-template<class T>
-Matrix<T>::Matrix(Matrix<T>&& other)
+template<class T, class A>
+Matrix<T,A>::Matrix(Matrix<T,A>&& other)
 {   this->_dim_size  = other._dim_size ;
-    this->_dim       = other._dim ;
+    this->_dim       = std::move(other._dim) ;
     this->_data_size = other._data_size ;
     this->_data      = other._data ;
+    this->_dim_prod  = std::move(other._dim_prod) ;
     other._data      = nullptr ;
-    this->_dim_prod  = other._dim_prod ;
+    other.clear_moved() ;
 }
 
-template<class T>
-Matrix<T>::~Matrix()
+template<class T, class A>
+template<class E>
+Matrix<T,A>::Matrix(const MatrixExpression<E>& e)
+    : Matrix(e.self().get_dim(), matrix_uninitialized)
+{   evaluate_expression(e, this->_data->data()) ; }
+
+template<class T, class A>
+Matrix<T,A>::~Matrix()
 {   if(this->_data != nullptr)
     {   delete this->_data ;
         this->_data = nullptr ;
     }
 }
 
-template<class T>
-void Matrix<T>::load(const std::string& file_address,
+template<class T, class A>
+void Matrix<T,A>::load(const std::string& file_address,
                      size_t dim_n)
-{
+{   if(is_matrix_chunked_file(file_address))
+    {   this->load_chunked(file_address, dim_n, std::vector<size_t>(), std::vector<size_t>()) ;
+        return ;
+    }
+
     // open
-    std::ifstream file(file_address, std::ifstream::in | std::ifstream::binary) ;
-    if(file.fail())
-    {   char msg[4096] ;
+    int fd = MatrixIOEngine::open_read(file_address) ;
+    struct stat status ;
+    if(fd < 0 or fstat(fd, &status) != 0)
+    {   if(fd >= 0)
+        {   close(fd) ; }
+        char msg[4096] ;
         sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
         throw std::runtime_error(msg) ;
     }
 
-    // read number of dimensions
-    file.read((char*) &(this->_dim_size), sizeof(size_t)) ;
-    if(not file)
-    {   file.close() ;
-        char msg[4096] ;
-        sprintf(msg, "Error! something occured while reading number of dimensions in %s",
-                file_address.c_str()) ;
-        throw std::invalid_argument(msg) ;
+    MatrixIOEngine& engine = MatrixIOEngine::get_default() ;
+    MatrixBinaryHeader header ;
+    std::unique_ptr<MatrixHeapStorage<T,A>> data ;
+    size_t data_size = 0 ;
+    try
+    {   // read header
+        uint64_t position = 0 ;
+        header = read_matrix_binary_header<T>([fd, &engine, &position](void* dst, size_t n)
+                                              {   bool ok = engine.read(fd, static_cast<char*>(dst), n, position) ;
+                                                  position += n ;
+                                                  return ok ;
+                                              },
+                                              file_address,
+                                              dim_n,
+                                              status.st_size) ;
+        // this file does not store a matrix with the expected dimensions
+        if(header.dim.size() != dim_n)
+        {   char msg[4096] ;
+            sprintf(msg, "Error! Invalid number of dimensions (%zu) found in %s",
+                    header.dim.size(),
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        check_matrix_binary_load<T>(header, file_address) ;
+
+        // read data
+        data_size = header.get_value_number() ;
+        data.reset(new MatrixHeapStorage<T,A>(data_size)) ;
+        uint32_t crc = 0 ;
+        if(not read_matrix_binary_values(engine, fd, header, data->data(), data_size, crc))
+        {   char msg[4096] ;
+            sprintf(msg, "Error! something occured while reading data in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        if(header.has_crc and crc != header.crc)
+        {   char msg[4096] ;
+            sprintf(msg, "Error! the checksum of the data does not match in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+    }
+    catch(...)
+    {   close(fd) ;
+        throw ;
     }
-    // this file does not store a matrix with the expected dimensions
-    if(this->_dim_size != dim_n)
-    {   file.close() ;
+    close(fd) ;
+
+    delete this->_data ;
+    this->_data      = data.release() ;
+    this->_dim_size  = header.dim.size() ;
+    this->_dim       = header.dim ;
+    this->_data_size = data_size ;
+    this->compute_dim_product() ;
+}
+
+template<class T, class A>
+void Matrix<T,A>::load_region(const std::string& file_address,
+                            size_t dim_n,
+                            const std::vector<size_t>& origin,
+                            const std::vector<size_t>& extent)
+{   if(is_matrix_chunked_file(file_address))
+    {   this->load_chunked(file_address, dim_n, origin, extent) ;
+        return ;
+    }
+
+    // open
+    int fd = MatrixIOEngine::open_read(file_address) ;
+    struct stat status ;
+    if(fd < 0 or fstat(fd, &status) != 0)
+    {   if(fd >= 0)
+        {   close(fd) ; }
         char msg[4096] ;
-        sprintf(msg, "Error! Invalid number of dimensions (%zu) found in %s",
-                this->_dim_size,
-                file_address.c_str()) ;
+        sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
         throw std::runtime_error(msg) ;
     }
 
-    // read dimensions
-    this->_dim = std::vector<size_t>(this->_dim_size) ;
-    file.read((char*) &(this->_dim[0]), this->_dim_size*sizeof(size_t)) ;
-    if(not file)
-    {   file.close() ;
-        char msg[4096] ;
-        sprintf(msg, "Error! something occured while reading dimensions in %s",
+    MatrixIOEngine& engine = MatrixIOEngine::get_default() ;
+    std::vector<size_t> dim ;
+    std::unique_ptr<MatrixHeapStorage<T,A>> data ;
+    try
+    {   // read header
+        uint64_t position = 0 ;
+        MatrixBinaryHeader header = read_matrix_binary_header<T>([fd, &engine, &position](void* dst, size_t n)
+                                                                 {   bool ok = engine.read(fd, static_cast<char*>(dst), n, position) ;
+                                                                     position += n ;
+                                                                     return ok ;
+                                                                 },
+                                                                 file_address,
+                                                                 dim_n,
+                                                                 status.st_size) ;
+        if(header.dim.size() != dim_n)
+        {   char msg[4096] ;
+            sprintf(msg, "Error! Invalid number of dimensions (%zu) found in %s",
+                    header.dim.size(),
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        check_matrix_binary_load<T>(header, file_address) ;
+
+        // the region, in the internal order
+        if(origin.size() != dim_n or extent.size() != dim_n)
+        {   throw std::out_of_range("the region coordinates do not have the matrix dimensionality!") ; }
+        // swap_coord() depends on the current dimensions
+        std::vector<size_t> region_origin = origin ;
+        dim = extent ;
+        if(dim_n > 1)
+        {   std::swap(region_origin[0], region_origin[1]) ;
+            std::swap(dim[0], dim[1]) ;
+        }
+        for(size_t i=0; i<dim_n; i++)
+        {   if(region_origin[i] > header.dim[i] or dim[i] > header.dim[i] - region_origin[i])
+            {   throw std::out_of_range("the region is out of range!") ; }
+        }
+
+        // read data
+        size_t data_size = std::accumulate(dim.begin(), dim.end(), (size_t)1, std::multiplies<size_t>()) ;
+        data.reset(new MatrixHeapStorage<T,A>(data_size)) ;
+        std::vector<MatrixBinaryRun> runs = get_matrix_binary_runs(header.dim, region_origin, dim) ;
+        if(not read_matrix_binary_runs(fd, header, runs, data->data(), 1 << 16, 1 << 24, engine))
+        {   char msg[4096] ;
+            sprintf(msg, "Error! something occured while reading data in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+    }
+    catch(...)
+    {   close(fd) ;
+        throw ;
+    }
+    close(fd) ;
+
+    delete this->_data ;
+    this->_data      = data.release() ;
+    this->_dim_size  = dim.size() ;
+    this->_dim       = dim ;
+    this->_data_size = this->_data->size() ;
+    this->compute_dim_product() ;
+}
+
+template<class T, class A>
+template<class E>
+void Matrix<T,A>::evaluate_in_place(const MatrixExpression<E>& e)
+{   if(matrix_expression_operand<E>::type::may_throw and expression_has_zero_divisor(e))
+    {   throw std::invalid_argument("division by 0!") ; }
+    evaluate_expression(e, this->_data->data()) ;
+}
+
+template<class T, class A>
+void Matrix<T,A>::load_chunked(const std::string& file_address,
+                             size_t dim_n,
+                             const std::vector<size_t>& origin,
+                             const std::vector<size_t>& extent)
+{   MatrixChunkedFile<T> file(file_address, true, 1) ;
+    if(file.get_dim_size() != dim_n)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! Invalid number of dimensions (%zu) found in %s",
+                file.get_dim_size(),
                 file_address.c_str()) ;
         throw std::runtime_error(msg) ;
     }
+    std::vector<size_t> region_origin = origin ;
+    std::vector<size_t> dim           = extent ;
+    if(region_origin.empty())
+    {   region_origin = std::vector<size_t>(dim_n, 0) ;
+        dim           = file.get_dim() ;
+    }
 
-    // read data
-    this->_data_size = std::accumulate(this->_dim.begin(),
-                                    this->_dim.end(),
-                                    (size_t)1,
-                                    std::multiplies<size_t>()) ;
-    this->_data = new std::vector<T>(this->_data_size) ;
-    file.read((char*) &((*this->_data)[0]), this->_data_size*sizeof(T)) ;
-    if(not file)
-    {   file.close() ;
-        char msg[4096] ;
-        sprintf(msg, "Error! something occured while reading data in %s",
+    // read data, the region is checked by the file
+    size_t data_size = std::accumulate(dim.begin(), dim.end(), (size_t)1, std::multiplies<size_t>()) ;
+    std::unique_ptr<MatrixHeapStorage<T,A>> data(new MatrixHeapStorage<T,A>(data_size)) ;
+    file.read_region(region_origin, dim, data->data()) ;
+    if(dim_n > 1)
+    {   std::swap(dim[0], dim[1]) ; }
+
+    delete this->_data ;
+    this->_data      = data.release() ;
+    this->_dim_size  = dim.size() ;
+    this->_dim       = dim ;
+    this->_data_size = data_size ;
+    this->compute_dim_product() ;
+}
+
+template<class T, class A>
+void Matrix<T,A>::map(const std::string& file_address,
+                    size_t dim_n,
+                    MatrixMapMode mode)
+{
+    // the storage is only kept if the header is valid
+    std::unique_ptr<MatrixMmapStorage<T>> storage(new MatrixMmapStorage<T>(file_address, mode)) ;
+    const char* bytes = storage->get_bytes() ;
+    size_t byte_size  = storage->get_byte_size() ;
+    size_t position   = 0 ;
+
+    // read header
+    MatrixBinaryHeader header = read_matrix_binary_header<T>([bytes, byte_size, &position](void* dst, size_t n)
+                                                             {   if(n > byte_size - position)
+                                                                 {   return false ; }
+                                                                 memcpy(dst, bytes + position, n) ;
+                                                                 position += n ;
+                                                                 return true ;
+                                                             },
+                                                             file_address,
+                                                             dim_n,
+                                                             byte_size) ;
+    if(header.dim.size() != dim_n)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! Invalid number of dimensions (%zu) found in %s",
+                header.dim.size(),
                 file_address.c_str()) ;
         throw std::runtime_error(msg) ;
     }
+    check_matrix_binary_map<T>(header, file_address) ;
 
-    file.close() ;
+    // map data
+    size_t data_size = header.get_value_number() ;
+    try
+    {   storage->set_range(header.data_offset, data_size) ; }
+    catch(std::runtime_error& e)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! something occured while reading data in %s (%s)",
+                file_address.c_str(),
+                e.what()) ;
+        throw std::runtime_error(msg) ;
+    }
 
+    delete this->_data ;
+    this->_data      = storage.release() ;
+    this->_dim_size  = header.dim.size() ;
+    this->_dim       = header.dim ;
+    this->_data_size = data_size ;
     this->compute_dim_product() ;
 }
 
-template<class T>
-void Matrix<T>::save(const std::string &file_address)
+template<class T, class A>
+void Matrix<T,A>::save(const std::string &file_address, bool checksum)
 {
     // open
-    std::ofstream file(file_address, std::ifstream::out | std::ifstream::binary) ;
-    if(file.fail())
+    int fd = open(file_address.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666) ;
+    if(fd < 0)
     {   char msg[4096] ;
         sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
         throw std::runtime_error(msg) ;
     }
 
-    // write number of dimensions
-    file.write((char*) &this->_dim_size, sizeof(size_t)) ;
-    if(not file)
+    // header, the dimensions and the padding up to the data
+    MatrixBinaryHeader header = make_matrix_binary_header<T>(this->_dim) ;
+    const char* data = (this->_data == nullptr) ? nullptr : reinterpret_cast<const char*>(this->_data->data()) ;
+    if(checksum)
+    {   header.has_crc = true ;
+        header.crc     = crc32c(data, this->_data_size*sizeof(T)) ;
+    }
+    std::vector<char> header_bytes = encode_matrix_binary_header(header) ;
+
+    // write header and data together
+    std::vector<MatrixIORequest> requests = {MatrixIORequest{fd, header_bytes.data(), header_bytes.size(), 0}} ;
+    if(this->_data_size != 0)
+    {   requests.push_back(MatrixIORequest{fd, const_cast<char*>(data), this->_data_size*sizeof(T), header.data_offset}) ; }
+    bool ok = MatrixIOEngine::get_default().write(requests) ;
+    if(close(fd) != 0)
+    {   ok = false ; }
+    if(not ok)
     {   char msg[4096] ;
-        sprintf(msg, "Error! something happened while writting dimension number to %s",
+        sprintf(msg, "Error! something happened while writting data to %s",
                 file_address.c_str()) ;
-        file.close() ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+template<class T, class A>
+void Matrix<T,A>::save_chunked(const std::string& file_address,
+                             const std::vector<size_t>& chunk_dim)
+{   // every chunk is entirely written once, in the order of the chunks
+    std::vector<size_t> dim = this->swap_coord(this->_dim) ;
+    MatrixChunkedFile<T> file(file_address, dim, chunk_dim, 1) ;
+    file.write_region(std::vector<size_t>(dim.size(), 0), dim, this->_data->data()) ;
+    file.flush() ;
+}
+
+template<class T, class A>
+void Matrix<T,A>::load_npy(const std::string& file_address,
+                         size_t dim_n,
+                         const std::string& name)
+{
+    // open
+    int fd = MatrixIOEngine::open_read(file_address) ;
+    struct stat status ;
+    if(fd < 0 or fstat(fd, &status) != 0)
+    {   if(fd >= 0)
+        {   close(fd) ; }
+        char msg[4096] ;
+        sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
         throw std::runtime_error(msg) ;
     }
 
-    // write dimensions
-    for(auto x : this->_dim)
-    {   file.write((char*) &x, sizeof(size_t)) ;
-        if(not file)
+    MatrixIOEngine& engine = MatrixIOEngine::get_default() ;
+    MatrixBinaryHeader header ;
+    std::unique_ptr<MatrixHeapStorage<T,A>> data ;
+    size_t data_size = 0 ;
+    try
+    {   // read header
+        uint64_t file_size = status.st_size ;
+        bool fortran_order = false ;
+        header = read_matrix_npy_file_header([fd, &engine, file_size](void* dst, size_t n, uint64_t offset)
+                                             {   if(offset > file_size or n > file_size - offset)
+                                                 {   return false ; }
+                                                 return engine.read(fd, static_cast<char*>(dst), n, offset) ;
+                                             },
+                                             file_size,
+                                             name,
+                                             file_address,
+                                             fortran_order) ;
+        if(header.dim.size() != dim_n)
         {   char msg[4096] ;
-            sprintf(msg, "Error! something happened while writting dimensions to %s",
+            sprintf(msg, "Error! Invalid number of dimensions (%zu) found in %s",
+                    header.dim.size(),
                     file_address.c_str()) ;
-            file.close() ;
             throw std::runtime_error(msg) ;
         }
+        check_matrix_binary_load<T>(header, file_address) ;
+
+        // read data
+        data_size = header.get_value_number() ;
+        data.reset(new MatrixHeapStorage<T,A>(data_size)) ;
+        uint32_t crc = 0 ;
+        if(not read_matrix_binary_values(engine, fd, header, data->data(), data_size, crc))
+        {   char msg[4096] ;
+            sprintf(msg, "Error! something occured while reading data in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        if(fortran_order and dim_n > 1)
+        {   std::unique_ptr<MatrixHeapStorage<T,A>> reordered(new MatrixHeapStorage<T,A>(data_size)) ;
+            reorder_matrix_npy_fortran(data->data(), reordered->data(), header.dim) ;
+            data.swap(reordered) ;
+        }
+    }
+    catch(...)
+    {   close(fd) ;
+        throw ;
     }
+    close(fd) ;
+
+    delete this->_data ;
+    this->_data      = data.release() ;
+    this->_dim_size  = header.dim.size() ;
+    this->_dim       = header.dim ;
+    this->_data_size = data_size ;
+    this->compute_dim_product() ;
+}
 
-    // write data
-    file.write((char*) &((*this->_data)[0]), this->_data_size*sizeof(T)) ;
-    if(not file)
+template<class T, class A>
+void Matrix<T,A>::map_npy(const std::string& file_address,
+                        size_t dim_n,
+                        MatrixMapMode mode,
+                        const std::string& name)
+{
+    // the storage is only kept if the header is valid
+    std::unique_ptr<MatrixMmapStorage<T>> storage(new MatrixMmapStorage<T>(file_address, mode)) ;
+    const char* bytes = storage->get_bytes() ;
+    uint64_t byte_size = storage->get_byte_size() ;
+
+    // read header
+    bool fortran_order = false ;
+    MatrixBinaryHeader header = read_matrix_npy_file_header([bytes, byte_size](void* dst, size_t n, uint64_t offset)
+                                                            {   if(offset > byte_size or n > byte_size - offset)
+                                                                {   return false ; }
+                                                                memcpy(dst, bytes + offset, n) ;
+                                                                return true ;
+                                                            },
+                                                            byte_size,
+                                                            name,
+                                                            file_address,
+                                                            fortran_order) ;
+    if(header.dim.size() != dim_n)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! Invalid number of dimensions (%zu) found in %s",
+                header.dim.size(),
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    check_matrix_binary_map<T>(header, file_address) ;
+    if(fortran_order and dim_n > 1)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! the array of %s is in Fortran order and cannot be mapped, it should be loaded",
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+
+    // map data
+    size_t data_size = header.get_value_number() ;
+    try
+    {   storage->set_range(header.data_offset, data_size) ; }
+    catch(std::runtime_error& e)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! something occured while reading data in %s (%s)",
+                file_address.c_str(),
+                e.what()) ;
+        throw std::runtime_error(msg) ;
+    }
+
+    delete this->_data ;
+    this->_data      = storage.release() ;
+    this->_dim_size  = header.dim.size() ;
+    this->_dim       = header.dim ;
+    this->_data_size = data_size ;
+    this->compute_dim_product() ;
+}
+
+template<class T, class A>
+void Matrix<T,A>::save_npy(const std::string& file_address)
+{   std::vector<char> header_bytes = encode_matrix_npy_header<T>(this->_dim) ;
+
+    // open
+    int fd = open(file_address.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666) ;
+    if(fd < 0)
+    {   char msg[4096] ;
+        sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+
+    // write header and data together
+    std::vector<MatrixIORequest> requests = {MatrixIORequest{fd, header_bytes.data(), header_bytes.size(), 0}} ;
+    if(this->_data_size != 0)
+    {   requests.push_back(MatrixIORequest{fd,
+                                           reinterpret_cast<char*>(this->_data->data()),
+                                           this->_data_size*sizeof(T),
+                                           header_bytes.size()}) ;
+    }
+    bool ok = MatrixIOEngine::get_default().write(requests) ;
+    if(close(fd) != 0)
+    {   ok = false ; }
+    if(not ok)
     {   char msg[4096] ;
         sprintf(msg, "Error! something happened while writting data to %s",
                 file_address.c_str()) ;
-        file.close() ;
         throw std::runtime_error(msg) ;
     }
+}
+
+template<class T, class A>
+void Matrix<T,A>::create_shared(const std::string& name, bool persistent)
+{   MatrixBinaryHeader header = make_matrix_binary_header<T>(this->_dim) ;
+    std::vector<char> header_bytes = encode_matrix_binary_header(header) ;
+    std::unique_ptr<MatrixShmStorage<T>> storage(new MatrixShmStorage<T>(name,
+                                                                          header.data_offset + header.data_size,
+                                                                          persistent)) ;
+    // the magic number is written last, an object is not attached
+    // to before it is complete
+    char* bytes = storage->get_bytes_for_writing() ;
+    if(this->_data_size != 0)
+    {   memcpy(bytes + header.data_offset, this->_data->data(), header.data_size) ; }
+    memcpy(bytes + sizeof(matrix_binary_magic),
+           header_bytes.data() + sizeof(matrix_binary_magic),
+           header_bytes.size() - sizeof(matrix_binary_magic)) ;
+    std::atomic_thread_fence(std::memory_order_release) ;
+    memcpy(bytes, matrix_binary_magic, sizeof(matrix_binary_magic)) ;
+    storage->set_range(header.data_offset, this->_data_size) ;
+
+    delete this->_data ;
+    this->_data = storage.release() ;
+}
+
+template<class T, class A>
+void Matrix<T,A>::attach_shared(const std::string& name,
+                              size_t dim_n)
+{
+    // the storage is only kept if the header is valid
+    std::unique_ptr<MatrixShmStorage<T>> storage(new MatrixShmStorage<T>(name)) ;
+    const char* bytes = storage->get_bytes() ;
+    size_t byte_size  = storage->get_byte_size() ;
+    size_t position   = 0 ;
+    if(byte_size < sizeof(matrix_binary_magic) or
+       memcmp(bytes, matrix_binary_magic, sizeof(matrix_binary_magic)) != 0)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! the shared memory %s does not contain a matrix (yet)", name.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire) ;
+
+    // read header
+    MatrixBinaryHeader header = read_matrix_binary_header<T>([bytes, byte_size, &position](void* dst, size_t n)
+                                                             {   if(n > byte_size - position)
+                                                                 {   return false ; }
+                                                                 memcpy(dst, bytes + position, n) ;
+                                                                 position += n ;
+                                                                 return true ;
+                                                             },
+                                                             name,
+                                                             dim_n,
+                                                             byte_size) ;
+    if(header.dim.size() != dim_n)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! Invalid number of dimensions (%zu) found in %s",
+                header.dim.size(),
+                name.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    check_matrix_binary_map<T>(header, name) ;
 
-    file.close() ;
+    // map data
+    size_t data_size = header.get_value_number() ;
+    storage->set_range(header.data_offset, data_size) ;
+
+    delete this->_data ;
+    this->_data      = storage.release() ;
+    this->_dim_size  = header.dim.size() ;
+    this->_dim       = header.dim ;
+    this->_data_size = data_size ;
+    this->compute_dim_product() ;
 }
 
-template<class T>
-T Matrix<T>::get(size_t offset) const
+template<class T, class A>
+bool Matrix<T,A>::remove_shared(const std::string& name)
+{   return MatrixShmStorage<T>::remove(name) ; }
+
+template<class T, class A>
+T Matrix<T,A>::get(size_t offset) const
 {   if(not this->is_valid(offset))
     {   throw std::out_of_range("offset is out of range!") ; }
     return (*this->_data)[offset] ;
 }
 
-template<class T>
-T Matrix<T>::get(const std::vector<size_t>& coord) const
-{   std::vector<size_t> coord_new = this->swap_coord(coord) ;
-    if(not this->is_valid(coord_new))
+template<class T, class A>
+T Matrix<T,A>::get(const std::vector<size_t>& coord) const
+{   if(not this->is_valid_coord(coord))
     {   throw std::out_of_range("coordinates are out of range!") ; }
-    return (*this->_data)[this->convert_to_offset(coord_new)] ;
+    return (*this->_data)[this->convert_coord_to_offset(coord)] ;
 }
 
 
-template<class T>
-void Matrix<T>::set(size_t offset, T value)
+template<class T, class A>
+void Matrix<T,A>::set(size_t offset, T value)
 {   if(not this->is_valid(offset))
     {   throw std::out_of_range("offset is out of range!") ; }
     (*this->_data)[offset] = value ;
 }
 
-template<class T>
-void Matrix<T>::set(const std::vector<size_t>& coord, T value)
-{   std::vector<size_t> coord_new = this->swap_coord(coord) ;
-    if(not this->is_valid(coord_new))
+template<class T, class A>
+void Matrix<T,A>::set(const std::vector<size_t>& coord, T value)
+{   if(not this->is_valid_coord(coord))
     {   throw std::out_of_range("coordinates are out of range!") ; }
-    (*this->_data)[this->convert_to_offset(coord_new)] = value ;
+    (*this->_data)[this->convert_coord_to_offset(coord)] = value ;
 }
 
 
-template<class T>
-std::vector<size_t> Matrix<T>::get_dim() const
+template<class T, class A>
+std::vector<size_t> Matrix<T,A>::get_dim() const
 {   return this->swap_coord(this->_dim) ; }
 
-template<class T>
-std::vector<T> Matrix<T>::get_data()
-{   return (*this->_data) ; }
+template<class T, class A>
+std::vector<T> Matrix<T,A>::get_data()
+{   return std::vector<T>(this->_data->begin(), this->_data->end()) ; }
 
-template<class T>
-size_t Matrix<T>::get_dim_size() const
+template<class T, class A>
+T* Matrix<T,A>::get_data_ptr()
+{   return this->_data->data() ; }
+
+template<class T, class A>
+const T* Matrix<T,A>::get_data_ptr() const
+{   return this->_data->data() ; }
+
+template<class T, class A>
+size_t Matrix<T,A>::get_dim_size() const
 {   return this->_dim_size ; }
 
-template<class T>
-size_t Matrix<T>::get_data_size() const
+template<class T, class A>
+size_t Matrix<T,A>::get_data_size() const
 {   return this->_data_size ; }
 
-template<class T>
-std::vector<size_t> Matrix<T>::get_dim_product() const
+template<class T, class A>
+std::vector<size_t> Matrix<T,A>::get_dim_product() const
 {   return this->_dim_prod ; }
 
-template<class T>
-void Matrix<T>::print(std::ostream& stream, size_t precision, size_t width, char sep) const
+template<class T, class A>
+MatrixView<T> Matrix<T,A>::get_view()
+{   // the partial dimension products are the strides, in (x,y,...) format
+    return MatrixView<T>(this->_data == nullptr ? nullptr : this->_data->data(),
+                         this->get_dim(),
+                         this->swap_coord(this->_dim_prod)) ;
+}
+
+template<class T, class A>
+MatrixView<const T> Matrix<T,A>::get_view() const
+{   return MatrixView<const T>(this->_data == nullptr ? nullptr : this->_data->data(),
+                               this->get_dim(),
+                               this->swap_coord(this->_dim_prod)) ;
+}
+
+template<class T, class A>
+void Matrix<T,A>::print(std::ostream& stream, size_t precision, size_t width, char sep) const
 {	stream.setf(std::ios::left) ;
     stream << std::setprecision(precision) << std::fixed ;
-	for(size_t i=0; i<this->get_data_size(); i++)
-    {   stream << std::setw(width) << this->get(i) << sep ; }
+    MatrixTextWriter<T>(stream, this->_dim, 0, width, sep).write(this->get_data_ptr()) ;
 }
 
-template<class T>
-Matrix<T>& Matrix<T>::operator = (const Matrix<T>& other)
-{   this->_dim       = other._dim ;
+template<class T, class A>
+void Matrix<T,A>::print(std::ostream& stream, ThreadPool& pool, size_t precision, size_t width, char sep) const
+{   stream.setf(std::ios::left) ;
+    stream << std::setprecision(precision) << std::fixed ;
+    MatrixTextWriter<T>(stream, this->_dim, 0, width, sep).write(this->get_data_ptr(), pool) ;
+}
+
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator = (const Matrix<T,A>& other)
+{   if(&other == this)
+    {   return *this ; }
+    delete this->_data ;
+    this->_dim       = other._dim ;
     this->_dim_size  = other._dim_size ;
-    this->_data      = new std::vector<T>(*other._data) ;
+    this->_data      = new MatrixHeapStorage<T,A>(other._data->begin(), other._data->end()) ;
     this->_data_size = other._data_size ;
     this->_dim_prod  = other._dim_prod ;
     return *this ;
 }
 
-template<class T>
-Matrix<T>& Matrix<T>::operator = (Matrix<T>&& other)
-{   this->_dim       = other._dim ;
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator = (Matrix<T,A>&& other)
+{   if(&other == this)
+    {   return *this ; }
+    delete this->_data ;
+    this->_dim       = std::move(other._dim) ;
     this->_dim_size  = other._dim_size ;
     this->_data      = other._data ;
-    other._data      = nullptr ;
     this->_data_size = other._data_size ;
-    this->_dim_prod  = other._dim_prod ;
+    this->_dim_prod  = std::move(other._dim_prod) ;
+    other._data      = nullptr ;
+    other.clear_moved() ;
+    return *this ;
+}
+
+template<class T, class A>
+template<class E>
+Matrix<T,A>& Matrix<T,A>::operator = (const MatrixExpression<E>& e)
+{   std::vector<size_t> dim = e.self().get_dim() ;
+    // the dimensions differ thus the instance is not involved in the
+    // expression and can be replaced
+    if(dim != this->get_dim())
+    {   *this = Matrix<T,A>(e) ; }
+    else
+    {   this->evaluate_in_place(e) ; }
     return *this ;
 }
 
-template<class T>
-Matrix<T>& Matrix<T>::operator += (T value)
-{   for(auto& i : (*this->_data))
-    {   i += value ; }
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator += (T value)
+{   kernel_add_value(this->_data->data(), value, this->_data->data(), this->_data_size) ;
     return *this ;
 }
 
-template<class T>
-Matrix<T>& Matrix<T>::operator -= (T value)
-{   for(auto& i : (*this->_data))
-    {   i -= value ; }
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator -= (T value)
+{   kernel_sub_value(this->_data->data(), value, this->_data->data(), this->_data_size) ;
     return *this ;
 }
 
-template<class T>
-Matrix<T>& Matrix<T>::operator *= (T value)
-{   for(auto& i : (*this->_data))
-    {   i *= value ; }
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator *= (T value)
+{   kernel_mul_value(this->_data->data(), value, this->_data->data(), this->_data_size) ;
     return *this ;
 }
 
-template<class T>
-Matrix<T>& Matrix<T>::operator /= (T value)
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator /= (T value)
 {
     if(value == static_cast<T>(0))
     {   throw std::invalid_argument("division by 0!") ; }
 
-    for(auto& i : (*this->_data))
-    {   i /= value ; }
+    kernel_div_value(this->_data->data(), value, this->_data->data(), this->_data_size) ;
+    return *this ;
+}
+
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator += (const Matrix<T,A>& other)
+{   this->check_same_dim(other) ;
+    kernel_add_arrays(this->_data->data(), other._data->data(), this->_data->data(), this->_data_size) ;
+    return *this ;
+}
+
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator -= (const Matrix<T,A>& other)
+{   this->check_same_dim(other) ;
+    kernel_sub_arrays(this->_data->data(), other._data->data(), this->_data->data(), this->_data_size) ;
+    return *this ;
+}
+
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator *= (const Matrix<T,A>& other)
+{   this->check_same_dim(other) ;
+    kernel_mul_arrays(this->_data->data(), other._data->data(), this->_data->data(), this->_data_size) ;
+    return *this ;
+}
+
+template<class T, class A>
+Matrix<T,A>& Matrix<T,A>::operator /= (const Matrix<T,A>& other)
+{   this->check_same_dim(other) ;
+    if(kernel_has_zero(other._data->data(), other._data_size))
+    {   throw std::invalid_argument("division by 0!") ; }
+
+    kernel_div_arrays(this->_data->data(), other._data->data(), this->_data->data(), this->_data_size) ;
+    return *this ;
+}
+
+template<class T, class A>
+template<class E>
+Matrix<T,A>& Matrix<T,A>::operator += (const MatrixExpression<E>& e)
+{   this->evaluate_in_place((*this) + e.self()) ;
     return *this ;
 }
 
-template<class T>
-bool Matrix<T>::operator == (const Matrix<T>& other) const
+template<class T, class A>
+template<class E>
+Matrix<T,A>& Matrix<T,A>::operator -= (const MatrixExpression<E>& e)
+{   this->evaluate_in_place((*this) - e.self()) ;
+    return *this ;
+}
+
+template<class T, class A>
+template<class E>
+Matrix<T,A>& Matrix<T,A>::operator *= (const MatrixExpression<E>& e)
+{   this->evaluate_in_place((*this) * e.self()) ;
+    return *this ;
+}
+
+template<class T, class A>
+template<class E>
+Matrix<T,A>& Matrix<T,A>::operator /= (const MatrixExpression<E>& e)
+{   this->evaluate_in_place((*this) / e.self()) ;
+    return *this ;
+}
+
+template<class T, class A>
+bool Matrix<T,A>::operator == (const Matrix<T,A>& other) const
 {   if(&other == this)
     {   return true ; }
     // check dim
@@ -749,25 +1727,31 @@ bool Matrix<T>::operator == (const Matrix<T>& other) const
     return true ;
 }
 
-template<class T>
-bool Matrix<T>::operator !=(const Matrix<T>& other) const
+template<class T, class A>
+bool Matrix<T,A>::operator !=(const Matrix<T,A>& other) const
 {   return not ((*this) == other) ;}
 
-template<class T>
-T& Matrix<T>::operator () (const std::vector<size_t>& coord)
-{   std::vector<size_t> coord_new = this->swap_coord(coord) ;
-    return (*this->_data)[this->convert_to_offset(coord_new)] ;
-}
+template<class T, class A>
+T& Matrix<T,A>::operator () (const std::vector<size_t>& coord)
+{   return (*this->_data)[this->convert_coord_to_offset(coord)] ; }
 
-template<class T>
-const T& Matrix<T>::operator () (const std::vector<size_t>& coord) const
-{   std::vector<size_t> coord_new = this->swap_coord(coord) ;
-    return (*this->_data)[this->convert_to_offset(coord_new)] ;
-}
+template<class T, class A>
+const T& Matrix<T,A>::operator () (const std::vector<size_t>& coord) const
+{   return (*this->_data)[this->convert_coord_to_offset(coord)] ; }
+
+template<class T, class A>
+template<class... Idx>
+T& Matrix<T,A>::operator () (Idx... coord)
+{   return (*this->_data)[this->convert_index_to_offset(coord...)] ; }
 
+template<class T, class A>
+template<class... Idx>
+const T& Matrix<T,A>::operator () (Idx... coord) const
+{   return (*this->_data)[this->convert_index_to_offset(coord...)] ; }
 
-template<class T>
-void Matrix<T>::compute_dim_product()
+
+template<class T, class A>
+void Matrix<T,A>::compute_dim_product()
 {   this->_dim_prod = std::vector<size_t>(this->_dim_size, 0) ;
     this->_dim_prod[0] = 1 ;
     if(this->_dim_size > 1)
@@ -779,8 +1763,20 @@ void Matrix<T>::compute_dim_product()
 }
 
 
-template<class T>
-std::vector<size_t> Matrix<T>::swap_coord(const std::vector<size_t> &coord) const
+template<class T, class A>
+void Matrix<T,A>::clear_moved()
+{   delete this->_data ;
+    this->_data      = new MatrixHeapStorage<T,A>(0) ;
+    this->_data_size = 0 ;
+    this->_dim       = std::vector<size_t>(this->_dim_size, 0) ;
+    if(this->_dim_size == 0)
+    {   this->_dim_prod.clear() ; }
+    else
+    {   this->compute_dim_product() ; }
+}
+
+template<class T, class A>
+std::vector<size_t> Matrix<T,A>::swap_coord(const std::vector<size_t> &coord) const
 {   std::vector<size_t> coord_new = coord ;
     // reformat coord = (row,col,...) = (y,y,...) into coord = (col,row,...) = (x,y,...)
     if(this->_dim_size > 1)
@@ -789,19 +1785,32 @@ std::vector<size_t> Matrix<T>::swap_coord(const std::vector<size_t> &coord) cons
 }
 
 
-template<class T>
-bool Matrix<T>::is_valid(size_t offset) const
+template<class T, class A>
+bool Matrix<T,A>::is_valid(size_t offset) const
 {   if(offset > this->_data_size-1)
     {   return false ; }
     return true ;
 }
 
-template<class T>
-bool Matrix<T>::is_valid(const std::vector<size_t>& coord) const
+template<class T, class A>
+bool Matrix<T,A>::is_valid(const std::vector<size_t>& coord) const
+{   if(coord.size() != this->_dim_size)
+    {   return false ; }
+    for(size_t i=0; i<coord.size(); i++)
+    {   if(coord[i] >= this->_dim[i])
+        {   return false ; }
+    }
+    return true ;
+}
+
+template<class T, class A>
+bool Matrix<T,A>::is_valid_coord(const std::vector<size_t>& coord) const
 {   if(coord.size() != this->_dim_size)
     {   return false ; }
     for(size_t i=0; i<coord.size(); i++)
-    {   if(coord[i] > this->_dim[i])
+    {   // row and column are swapped in _dim
+        size_t j = (this->_dim_size > 1 and i < 2) ? 1 - i : i ;
+        if(coord[i] >= this->_dim[j])
         {   return false ; }
     }
     return true ;
@@ -809,8 +1818,8 @@ bool Matrix<T>::is_valid(const std::vector<size_t>& coord) const
 
 
 
-template<class T>
-size_t Matrix<T>::convert_to_offset(const std::vector<size_t>& coord) const
+template<class T, class A>
+size_t Matrix<T,A>::convert_to_offset(const std::vector<size_t>& coord) const
 {   size_t offset = 0 ;
 
     for(size_t i=0; i<this->_dim_size; i++)
@@ -820,8 +1829,40 @@ size_t Matrix<T>::convert_to_offset(const std::vector<size_t>& coord) const
 }
 
 
-template<class T>
-std::vector<size_t> Matrix<T>::convert_to_coord(size_t offset) const
+template<class T, class A>
+size_t Matrix<T,A>::convert_coord_to_offset(const std::vector<size_t>& coord) const
+{   if(this->_dim_size == 1)
+    {   return coord[0] ; }
+    // (row,col) is (y,x)
+    size_t offset = coord[1] + coord[0] * this->_dim_prod[1] ;
+    for(size_t i=2; i<this->_dim_size; i++)
+    {   offset += coord[i] * this->_dim_prod[i] ; }
+
+    return offset ;
+}
+
+template<class T, class A>
+template<class... Idx>
+size_t Matrix<T,A>::convert_index_to_offset(Idx... coord) const
+{   static_assert(sizeof...(Idx) > 0, "at least one coordinate is needed") ;
+    static_assert(are_integral<Idx...>::value, "coordinates should be integral values") ;
+    const size_t coord_array[] = {static_cast<size_t>(coord)...} ;
+    const size_t n = sizeof...(Idx) ;
+    // more coordinates would read past _dim_prod
+    assert(n == this->_dim_size and "the number of coordinates should be equal to the number of dimensions") ;
+    if(n == 1)
+    {   return coord_array[0] ; }
+    // (row,col) is (y,x)
+    size_t offset = coord_array[n > 1 ? 1 : 0] + coord_array[0] * this->_dim_prod[1] ;
+    for(size_t i=2; i<n; i++)
+    {   offset += coord_array[i] * this->_dim_prod[i] ; }
+
+    return offset ;
+}
+
+
+template<class T, class A>
+std::vector<size_t> Matrix<T,A>::convert_to_coord(size_t offset) const
 {
     std::vector<size_t> coord(this->_dim_size, 0) ;
 
@@ -834,6 +1875,13 @@ std::vector<size_t> Matrix<T>::convert_to_coord(size_t offset) const
     return coord ;
 }
 
+template<class T, class A>
+void Matrix<T,A>::check_same_dim(const Matrix<T,A>& other) const
+{   if(this->_dim_size != other._dim_size or
+       this->_dim      != other._dim)
+    {   throw std::invalid_argument("matrices have different dimensions!") ; }
+}
+
 
 
 
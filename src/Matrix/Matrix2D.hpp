@@ -2,6 +2,10 @@
 #define MATRIX2D_HPP
 
 #include <Matrix.hpp>
+#include "MatrixMultiply.hpp"
+#include "MatrixTranspose.hpp"
+#include "MatrixTextParser.hpp"
+#include "ThreadPool.hpp"
 
 #include <vector>
 #include <string>
@@ -10,7 +14,7 @@
 #include <iostream>
 #include <iomanip>   //  setw(), setprecision(), fixed
 #include <sstream>   //  istringstream
-#include <stdexcept> //  runtime_error, out_of_range
+#include <stdexcept> //  runtime_error, out_of_range, invalid_argument
 
 #define BUFFER_SIZE 4096
 
@@ -18,19 +22,9 @@
  * class to make work with 2D matrices easier.
  *
  *
- * A format to save a Matrix2D objects in a binary file is defined. The following values
- * are written :
- * 1x size_t :     the number <N> of dimensions of the Matrix stored. This is the value
- *                 of _dim_size field. This value must be 2 otherwise this is not a 2D
- *                 matrix.
- * 2x size_t :     the width of the matrix in each dimension. These values correspond
- *                 to the content of the _dim vector and can be loaded inside this
- *                 vector as they are.
- * Dx <T> values : the <D> values contained in the matrix, in the _data vector.
- *                 These values can be loaded directly in this vector. <D> is equal to the
- *                 product of the 2 values stored right before. The type <T> depends on
- *                 the type of the data stored in the matrix. The 1st of the D values is
- *                 also the first value of the _data vector.
+ * A format to save a Matrix2D objects in a binary file is defined, it is the
+ * format of the Matrix class (see MatrixBinaryFormat.hpp). The number of dimensions
+ * stored in the file must be 2 otherwise this is not a 2D matrix.
  *
  *
  * A text format is defined to store such matrices.
@@ -50,8 +44,8 @@
  * dimension creates an empty file.
  *
  */
-template<class T>
-class Matrix2D : public Matrix<T>
+template<class T, class A = MatrixAlignedAllocator<T>>
+class Matrix2D : public Matrix<T,A>
 {
     public:
         // constructors
@@ -72,6 +66,14 @@ class Matrix2D : public Matrix<T>
          * with.
          */
         Matrix2D(size_t nrow, size_t ncol, T value) ;
+        /*!
+         * \brief Constructs a matrix with the given dimensions which
+         * values are not initialized, they should all be set before
+         * being read.
+         * \param nrow the number of rows.
+         * \param ncol the number of columns.
+         */
+        Matrix2D(size_t nrow, size_t ncol, MatrixUninitialized) ;
         /*!
          * \brief Copy constructor
          * \param other the matrix to copy the values from.
@@ -92,14 +94,66 @@ class Matrix2D : public Matrix<T>
          */
         Matrix2D(const std::string& file_address) ;
 
+        /*!
+         * \brief Constructs a matrix by evaluating an expression.
+         * \param e the expression of interest.
+         * \throw std::invalid_argument if the expression does not
+         * have 2 dimensions.
+         */
+        template<class E, class = typename std::enable_if<matrix_expression_has_dim_number<E,2>::value>::type>
+        Matrix2D(const MatrixExpression<E>& e) ;
+
         /*!
          * \brief Destructor.
          */
         virtual ~Matrix2D() ;
 
         // methods overloaded in Matrix
-        using Matrix<T>::get ;
-        using Matrix<T>::set ;        
+        using Matrix<T,A>::get ;
+        using Matrix<T,A>::set ;        
+
+        // methods overriden from Matrix, which also update the
+        // offsets
+        /*!
+         * \brief See Matrix::map().
+         * \throw std::invalid_argument if dim_n is not 2.
+         */
+        virtual void map(const std::string& file_address,
+                         size_t dim_n,
+                         MatrixMapMode mode) override ;
+
+        /*!
+         * \brief See Matrix::load_region().
+         * \throw std::invalid_argument if dim_n is not 2.
+         */
+        virtual void load_region(const std::string& file_address,
+                                 size_t dim_n,
+                                 const std::vector<size_t>& origin,
+                                 const std::vector<size_t>& extent) override ;
+
+        /*!
+         * \brief See Matrix::load_npy().
+         * \throw std::invalid_argument if dim_n is not 2.
+         */
+        virtual void load_npy(const std::string& file_address,
+                              size_t dim_n,
+                              const std::string& name="") override ;
+
+        /*!
+         * \brief See Matrix::map_npy().
+         * \throw std::invalid_argument if dim_n is not 2.
+         */
+        virtual void map_npy(const std::string& file_address,
+                             size_t dim_n,
+                             MatrixMapMode mode,
+                             const std::string& name="") override ;
+
+        /*!
+         * \brief See Matrix::attach_shared().
+         * \throw std::invalid_argument if dim_n is not 2.
+         */
+        virtual void attach_shared(const std::string& name,
+                                   size_t dim_n) override ;
 
         // methods
         /*!
@@ -109,6 +163,73 @@ class Matrix2D : public Matrix<T>
          */
         void load(const std::string& file_address) ;
 
+        /*!
+         * \brief maps a binary file containing a matrix
+         * in memory, the values are read lazily when they
+         * are accessed. See Matrix::map().
+         * \param path the path to the file.
+         * \param mode how the file is mapped.
+         * \throw std::runtime_error if the file cannot be
+         * mapped or does not contain a 2D matrix.
+         */
+        void map(const std::string& file_address,
+                 MatrixMapMode mode=MatrixMapMode::read_only) ;
+
+        /*!
+         * \brief loads a NumPy .npy file, or an array of a
+         * .npz file, containing a 2D matrix. See
+         * Matrix::load_npy().
+         * \param path the path to the file.
+         * \param name in a .npz file, the name of the array,
+         * by default the 1st array.
+         * \throw std::runtime_error if the file cannot be
+         * read or does not contain a 2D matrix.
+         */
+        void load_npy(const std::string& file_address,
+                      const std::string& name="") ;
+
+        /*!
+         * \brief maps a NumPy .npy file, or an array of a
+         * .npz file, containing a 2D matrix in memory. See
+         * Matrix::map_npy().
+         * \param path the path to the file.
+         * \param mode how the file is mapped.
+         * \param name in a .npz file, the name of the array,
+         * by default the 1st array.
+         * \throw std::runtime_error if the file cannot be
+         * mapped or does not contain a 2D matrix.
+         */
+        void map_npy(const std::string& file_address,
+                     MatrixMapMode mode=MatrixMapMode::read_only,
+                     const std::string& name="") ;
+
+        /*!
+         * \brief attaches to a POSIX shared memory object
+         * containing a 2D matrix, read-only. See
+         * Matrix::attach_shared().
+         * \param name the name of the object.
+         * \throw std::runtime_error if the object cannot be
+         * mapped or does not contain a 2D matrix.
+         */
+        void attach_shared(const std::string& name) ;
+
+        /*!
+         * \brief loads a region of a matrix stored in a
+         * binary file, without reading the rest of the file.
+         * See Matrix::load_region().
+         * \param path the path to the file.
+         * \param origin the coordinates of the 1st element of
+         * the region, as (row, column).
+         * \param extent the dimensions of the region, as (row, column).
+         * \throw std::runtime_error if the file cannot be
+         * read or does not contain a 2D matrix and
+         * std::out_of_range if the region does not fit within
+         * the stored matrix.
+         */
+        void load_region(const std::string& file_address,
+                         const std::vector<size_t>& origin,
+                         const std::vector<size_t>& extent) ;
+
         /*!
          * \brief Gets the element at the given coordinates.
          * \param row the row number of the element to set.
@@ -176,6 +297,68 @@ class Matrix2D : public Matrix<T>
          */
         void set_col(size_t i, const std::vector<T>& values) ;
 
+        /*!
+         * \brief Creates a view on a given row, without copying
+         * its values.
+         * \param i the row of interest.
+         * \throw std::out_of_range if i is out of range.
+         * \return a 1D view on the row.
+         */
+        MatrixView<T> get_row_view(size_t i) ;
+
+        /*!
+         * \brief Creates a read-only view on a given row, without
+         * copying its values.
+         * \param i the row of interest.
+         * \throw std::out_of_range if i is out of range.
+         * \return a 1D view on the row.
+         */
+        MatrixView<const T> get_row_view(size_t i) const ;
+
+        /*!
+         * \brief Creates a view on a given column, without
+         * copying its values.
+         * \param i the column of interest.
+         * \throw std::out_of_range if i is out of range.
+         * \return a 1D view on the column.
+         */
+        MatrixView<T> get_col_view(size_t i) ;
+
+        /*!
+         * \brief Creates a read-only view on a given column,
+         * without copying its values.
+         * \param i the column of interest.
+         * \throw std::out_of_range if i is out of range.
+         * \return a 1D view on the column.
+         */
+        MatrixView<const T> get_col_view(size_t i) const ;
+
+        /*!
+         * \brief Creates a view on a sub-block of the matrix,
+         * without copying its values.
+         * \param row the first row of the block.
+         * \param col the first column of the block.
+         * \param nrow the number of rows of the block.
+         * \param ncol the number of columns of the block.
+         * \throw std::out_of_range if the block does not fit
+         * within the matrix.
+         * \return a 2D view on the block.
+         */
+        MatrixView<T> get_block_view(size_t row, size_t col, size_t nrow, size_t ncol) ;
+
+        /*!
+         * \brief Creates a read-only view on a sub-block of the
+         * matrix, without copying its values.
+         * \param row the first row of the block.
+         * \param col the first column of the block.
+         * \param nrow the number of rows of the block.
+         * \param ncol the number of columns of the block.
+         * \throw std::out_of_range if the block does not fit
+         * within the matrix.
+         * \return a 2D view on the block.
+         */
+        MatrixView<const T> get_block_view(size_t row, size_t col, size_t nrow, size_t ncol) const ;
+
         /*!
          * \brief Produces a nice representation of the matrix on the given
          * stream.
@@ -186,20 +369,42 @@ class Matrix2D : public Matrix<T>
          */
         virtual void print(std::ostream& stram, size_t precision=4, size_t width=8, char sep=' ') const override ;
 
+        /*!
+         * \brief Produces the same representation as print(), the
+         * values being formatted by chunks in parallel.
+         * \param stream the stream.
+         * \param pool the threads to use.
+         * \param precision the rounding precision.
+         * \param width the column width in number of characters.
+         * \param sep the character separator.
+         */
+        virtual void print(std::ostream& stream, ThreadPool& pool, size_t precision=4, size_t width=8, char sep=' ') const override ;
+
         // operators
         /*!
          * Assignment operator.
          * \param other an other matrix to copy the values from.
          * \return a reference to the current the instance.
          */
-        Matrix2D<T>& operator = (const Matrix2D<T>& other) ;
+        Matrix2D<T,A>& operator = (const Matrix2D<T,A>& other) ;
 
         /*!
          * Move Assignment operator.
          * \param other an other matrix to use the values from.
          * \return a reference to the instance.
          */
-        Matrix2D<T>& operator = (Matrix2D<T>&& other) ;
+        Matrix2D<T,A>& operator = (Matrix2D<T,A>&& other) ;
+
+        /*!
+         * Assignment operator, evaluates an expression and stores
+         * the result. The expression may involve the instance itself.
+         * \param e the expression of interest.
+         * \throw std::invalid_argument if the expression does not
+         * have 2 dimensions.
+         * \return a reference to the instance.
+         */
+        template<class E>
+        Matrix2D& operator = (const MatrixExpression<E>& e) ;
 
         /*!
          * \brief Returns a reference to the corrresponding
@@ -222,6 +427,14 @@ class Matrix2D : public Matrix<T>
         const T& operator () (size_t row, size_t col) const ;
 
     private:
+        /*!
+         * \brief Checks a number of dimensions given to the
+         * methods overriden from Matrix.
+         * \param dim_n the number of dimensions.
+         * \throw std::invalid_argument if dim_n is not 2.
+         */
+        void check_dim_number(size_t dim_n) const ;
+
         /*!
          * \brief Converts a pair of VALID (x,y) coordinates to a
          * the corresponding offset allowing to get an element in the
@@ -259,200 +472,207 @@ class Matrix2D : public Matrix<T>
 
 } ;
 
-// operators
 /*!
- * \brief Addition operator.
- * \param m the matrix of interest
- * \param value the value to add to each element.
- * \return the resulting matrix.
+ * \brief The number of dimensions of a Matrix2D, used to
+ * type the expressions involving it (see MatrixExpression.hpp).
  */
-template<class T>
-const Matrix2D<T> operator + (Matrix2D<T> m, T value)
-{   Matrix2D<T> other(m) ;
-    m += value ;
-    return m ;
-}
+template<class T, class A>
+struct matrix_dim_number<Matrix2D<T,A>>
+{   static const size_t value = 2 ; } ;
 
+// operators
 /*!
- * \brief Substraction operator
+ * \brief Sends a representation of the matrix to the stream.
+ * \param stream the stream of interest.
  * \param m the matrix of interest.
- * \param value the value to substract to each element.
- * \return the resulting matrix.
+ * \return a reference to the stream.
  */
-template<class T>
-const Matrix2D<T> operator - (Matrix2D<T> m, T value)
-{    Matrix2D<T> other(m) ;
-     m -= value ;
-     return m ;
+template<class T, class A>
+std::ostream& operator << (std::ostream& stream, const Matrix2D<T,A>& m)
+{   m.print(stream) ;
+    return stream ;
 }
 
+// other usefull functions
 /*!
- * \brief Multiplication operator.
- * \param m the matrix of interest.
- * \param value the value to multiply each elements by.
- * \return the resulting matrix.
+ * \brief Produces a transpose of the given matrix.
+ * The transposition is done block by block, using the
+ * default thread pool.
+ * \param m a matrix.
  */
-template<class T>
-const Matrix2D<T> operator * (Matrix2D<T> m, T value)
-{    Matrix2D<T> other(m) ;
-     m *= value ;
-     return m ;
-}
+template<class T, class A>
+Matrix2D<T,A> transpose(const Matrix2D<T,A>& m) ;
 
 /*!
- * \brief Division operator.
- * \param m the matrix of interest.
- * \param value the value to divide each elements by.
- * \throw std::invalid_argument if value is 0.
- * \return the resulting matrix.
+ * \brief Transposes the given matrix in place. Square
+ * matrices are transposed without any temporary matrix,
+ * others are replaced by their transpose.
+ * \param m a matrix.
  */
-template<class T>
-const Matrix2D<T> operator / (Matrix2D<T> m, T value)
-{   if(value == static_cast<T>(0))
-    {   throw std::invalid_argument("division by 0!") ; }
-    Matrix2D<T> other(m) ;
-    other /= value ;
-    return other ;
-}
+template<class T, class A>
+void transpose_in_place(Matrix2D<T,A>& m) ;
 
 /*!
- * \brief Sends a representation of the matrix to the stream.
- * \param stream the stream of interest.
- * \param m the matrix of interest.
- * \return a reference to the stream.
+ * \brief Computes the matrix product of two matrices, using
+ * the default thread pool. Beware, the * operator computes the
+ * element-wise product.
+ * \param m1 the left hand side matrix, with as many columns as
+ * m2 has rows.
+ * \param m2 the right hand side matrix.
+ * \throw std::invalid_argument if the number of columns of m1
+ * is not equal to the number of rows of m2.
+ * \return the matrix product of m1 and m2.
  */
-template<class T>
-std::ostream& operator << (std::ostream& stream, const Matrix2D<T>& m)
-{   m.print(stream) ;
-    return stream ;
-}
+template<class T, class A>
+Matrix2D<T,A> multiply(const Matrix2D<T,A>& m1, const Matrix2D<T,A>& m2) ;
 
-// other usefull functions
 /*!
- * \brief Produces a transpose of the given matrix.
- * \param m a matrix.
+ * \brief Computes the matrix product of two matrices, using
+ * the threads of the given pool.
+ * \param m1 the left hand side matrix, with as many columns as
+ * m2 has rows.
+ * \param m2 the right hand side matrix.
+ * \param pool the threads to use.
+ * \throw std::invalid_argument if the number of columns of m1
+ * is not equal to the number of rows of m2.
+ * \return the matrix product of m1 and m2.
  */
-template<class T>
-Matrix2D<T> transpose(const Matrix2D<T>& m) ;
+template<class T, class A>
+Matrix2D<T,A> multiply(const Matrix2D<T,A>& m1, const Matrix2D<T,A>& m2, ThreadPool& pool) ;
 
 
 // method implementation
-template<class T>
-Matrix2D<T> transpose(const Matrix2D<T>& m)
+template<class T, class A>
+Matrix2D<T,A> transpose(const Matrix2D<T,A>& m)
 {   std::vector<size_t> dim = m.get_dim() ;
     size_t nrow = dim[0] ;
     size_t ncol = dim[1] ;
-    Matrix2D<T> m2(ncol, nrow, 0) ;
-    for(size_t i=0; i<ncol; i++)
-    {   for(size_t j=0; j<nrow; j++)
-        {   m2(i,j) = m(j,i) ; }
-    }
+    Matrix2D<T,A> m2(ncol, nrow, matrix_uninitialized) ;
+    transpose_data(nrow, ncol, m.get_data_ptr(), m2.get_data_ptr(), ThreadPool::get_default()) ;
     return m2 ;
 }
 
+template<class T, class A>
+void transpose_in_place(Matrix2D<T,A>& m)
+{   std::vector<size_t> dim = m.get_dim() ;
+    if(dim[0] == dim[1])
+    {   transpose_square_in_place(dim[0], m.get_data_ptr(), ThreadPool::get_default()) ; }
+    else
+    {   m = transpose(m) ; }
+}
+
+template<class T, class A>
+Matrix2D<T,A> multiply(const Matrix2D<T,A>& m1, const Matrix2D<T,A>& m2)
+{   return multiply(m1, m2, ThreadPool::get_default()) ; }
+
+template<class T, class A>
+Matrix2D<T,A> multiply(const Matrix2D<T,A>& m1, const Matrix2D<T,A>& m2, ThreadPool& pool)
+{   std::vector<size_t> dim1 = m1.get_dim() ;
+    std::vector<size_t> dim2 = m2.get_dim() ;
+    if(dim1[1] != dim2[0])
+    {   char msg[4096] ;
+        sprintf(msg, "error! cannot multiply a %zu x %zu matrix by a %zu x %zu matrix!",
+                dim1[0], dim1[1], dim2[0], dim2[1]) ;
+        throw std::invalid_argument(msg) ;
+    }
+    Matrix2D<T,A> m3(dim1[0], dim2[1], matrix_uninitialized) ;
+    gemm(dim1[0], dim2[1], dim1[1], m1.get_data_ptr(), m2.get_data_ptr(), m3.get_data_ptr(), pool) ;
+    return m3 ;
+}
+
 
-template<class T>
-Matrix2D<T>::Matrix2D(size_t nrow, size_t ncol)
-    : Matrix2D<T>(nrow, ncol, static_cast<T>(0))
+template<class T, class A>
+Matrix2D<T,A>::Matrix2D(size_t nrow, size_t ncol)
+    : Matrix2D<T,A>(nrow, ncol, static_cast<T>(0))
 {}
 
-template<class T>
-Matrix2D<T>::Matrix2D(size_t nrow, size_t ncol, T value)
-     : Matrix<T>({nrow, ncol}, value),
+template<class T, class A>
+Matrix2D<T,A>::Matrix2D(size_t nrow, size_t ncol, T value)
+     : Matrix<T,A>({nrow, ncol}, value),
        _row_offsets(nrow),
        _col_offsets(ncol)
 {   this->compute_row_offsets() ;
     this->compute_col_offsets() ;
 }
 
-template<class T>
-Matrix2D<T>::Matrix2D(const Matrix2D<T>& other)
-    : Matrix<T>(other)
-{   this->_row_offsets = other._row_offsets ;
-    this->_col_offsets = other._col_offsets ;
+template<class T, class A>
+Matrix2D<T,A>::Matrix2D(size_t nrow, size_t ncol, MatrixUninitialized)
+     : Matrix<T,A>({nrow, ncol}, matrix_uninitialized),
+       _row_offsets(nrow),
+       _col_offsets(ncol)
+{   this->compute_row_offsets() ;
+    this->compute_col_offsets() ;
 }
 
-template<class T>
-Matrix2D<T>::Matrix2D(Matrix2D&& other)
-    : Matrix<T>(std::move(other))
+template<class T, class A>
+Matrix2D<T,A>::Matrix2D(const Matrix2D<T,A>& other)
+    : Matrix<T,A>(other)
 {   this->_row_offsets = other._row_offsets ;
     this->_col_offsets = other._col_offsets ;
 }
 
-template<class T>
-Matrix2D<T>::Matrix2D(const std::string &file_address)
+template<class T, class A>
+Matrix2D<T,A>::Matrix2D(Matrix2D&& other)
+    : Matrix<T,A>(std::move(other))
+{   this->_row_offsets = std::move(other._row_offsets) ;
+    this->_col_offsets = std::move(other._col_offsets) ;
+    other._row_offsets.clear() ;
+    other._col_offsets.clear() ;
+}
+
+template<class T, class A>
+Matrix2D<T,A>::Matrix2D(const std::string &file_address)
 {
     this->_dim       = {0,0} ;
-    this->_data      = new std::vector<T>() ;
     this->_dim_size  = this->_dim.size() ;
-    this->_data_size = this->_data->size() ;
+    this->_data_size = 0 ;
     this->_dim_prod  = std::vector<size_t>(this->_dim_size, 0) ;
 
-    std::ifstream file(file_address, std::ifstream::in) ;
-    if(file.fail())
-    {   char msg[BUFFER_SIZE] ;
-        sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
-        throw std::runtime_error(msg) ;
-    }
-
-    std::string         buffer_str ;
-    std::vector<T>      buffer_vec ;
-    T                   buffer_T ;
+    typename MatrixHeapStorage<T,A>::vector_type data ;
+    MatrixTextReader file(file_address) ;
+    const char* line     = nullptr ;
+    const char* line_end = nullptr ;
 
     // read file
     size_t n_line = 0 ;
     size_t row_len = 0 ;
 
-    while(getline(file, buffer_str))
-    {   // check stream status and read content
-        if(file.fail())
-        {   file.close() ;
-            char msg[BUFFER_SIZE] ;
-            sprintf(msg, "error! while reading %s", file_address.c_str()) ;
-            throw std::runtime_error(msg) ;
-        }
-        if(buffer_str.size() == 0)
+    while(file.getline(line, line_end))
+    {   if(line == line_end)
         {   // this file only contains one eol char and should be considered as empty,
             // -> returns empty matrix not an error
-            if(n_line == 0 and file.peek() == EOF and file.eof())
+            if(n_line == 0 and file.eof())
             {  break ; }
 
-            file.close() ;
             char msg[BUFFER_SIZE] ;
             sprintf(msg, "format error! while reading %s (empty line)", file_address.c_str()) ;
             throw std::runtime_error(msg) ;
         }
-        // parse line
-        buffer_vec.clear() ;
-        std::istringstream buffer_ss(buffer_str) ;
-        while(buffer_ss >> buffer_T)
-        {   buffer_vec.push_back(buffer_T) ; }
+        // parse line, the values are directly appended to the data
+        size_t n_value = data.size() ;
         // check for an error which likely indicates that a value could not be
         // casted into a type T (mixed data types in the file)
-        if(buffer_ss.fail() and not buffer_ss.eof())
-        {   file.close() ;
-            char msg[BUFFER_SIZE] ;
+        if(not parse_text_line(line, line_end, data))
+        {   char msg[BUFFER_SIZE] ;
             sprintf(msg, "format error! could not read a line in %s (incompatible data types)", file_address.c_str()) ;
             throw std::runtime_error(msg) ;
         }
+        n_value = data.size() - n_value ;
         // check that number of column is constant
         if(n_line == 0)
-        {  row_len = buffer_vec.size() ; }
-        else if(buffer_vec.size() != row_len)
-        {   file.close() ;
-            char msg[BUFFER_SIZE] ;
+        {   row_len = n_value ;
+            data.reserve(file.estimate_value_number(n_value, line_end - line)) ;
+        }
+        else if(n_value != row_len)
+        {   char msg[BUFFER_SIZE] ;
             sprintf(msg, "format error! variable number of columns in %s", file_address.c_str()) ;
             throw std::runtime_error(msg) ;
         }
-        // update matrix content
-        for(auto i : buffer_vec)
-        {   this->_data->push_back(i) ;
-            this->_data_size++ ;
-        }
+        this->_data_size += n_value ;
         this->_dim[1]++ ;
         n_line++ ;
     }
-    file.close() ;
+    this->_data = new MatrixHeapStorage<T,A>(std::move(data)) ;
 
     this->_dim[0] = row_len ;
     this->compute_dim_product() ;
@@ -463,18 +683,90 @@ Matrix2D<T>::Matrix2D(const std::string &file_address)
     this->compute_col_offsets() ;
 }
 
-template<class T>
-Matrix2D<T>::~Matrix2D()
+template<class T, class A>
+template<class E, class>
+Matrix2D<T,A>::Matrix2D(const MatrixExpression<E>& e)
+    : Matrix<T,A>(e)
+{   if(this->_dim_size != 2)
+    {   throw std::invalid_argument("the expression does not have 2 dimensions!") ; }
+    this->_row_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_col_offsets = std::vector<size_t>(this->_dim[0]) ;
+    this->compute_row_offsets() ;
+    this->compute_col_offsets() ;
+}
+
+template<class T, class A>
+Matrix2D<T,A>::~Matrix2D()
 {   if(this->_data != nullptr)
     {   delete this->_data ;
         this->_data = nullptr ;
     }
 }
 
-template<class T>
-void Matrix2D<T>::load(const std::string& file_address)
+template<class T, class A>
+void Matrix2D<T,A>::load(const std::string& file_address)
+{
+    Matrix<T,A>::load(file_address, 2) ;
+
+    this->_row_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_col_offsets = std::vector<size_t>(this->_dim[0]) ;
+
+    this->compute_dim_product() ;
+    this->compute_row_offsets() ;
+    this->compute_col_offsets() ;
+}
+
+template<class T, class A>
+void Matrix2D<T,A>::load_region(const std::string& file_address,
+                                size_t dim_n,
+                                const std::vector<size_t>& origin,
+                                const std::vector<size_t>& extent)
+{
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::load_region(file_address, 2, origin, extent) ;
+
+    this->_row_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_col_offsets = std::vector<size_t>(this->_dim[0]) ;
+
+    this->compute_dim_product() ;
+    this->compute_row_offsets() ;
+    this->compute_col_offsets() ;
+}
+
+template<class T, class A>
+void Matrix2D<T,A>::load_region(const std::string& file_address,
+                                const std::vector<size_t>& origin,
+                                const std::vector<size_t>& extent)
+{   this->load_region(file_address, 2, origin, extent) ; }
+
+template<class T, class A>
+void Matrix2D<T,A>::map(const std::string& file_address,
+                        size_t dim_n,
+                        MatrixMapMode mode)
+{
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::map(file_address, 2, mode) ;
+
+    this->_row_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_col_offsets = std::vector<size_t>(this->_dim[0]) ;
+
+    this->compute_dim_product() ;
+    this->compute_row_offsets() ;
+    this->compute_col_offsets() ;
+}
+
+template<class T, class A>
+void Matrix2D<T,A>::map(const std::string& file_address,
+                        MatrixMapMode mode)
+{   this->map(file_address, 2, mode) ; }
+
+template<class T, class A>
+void Matrix2D<T,A>::load_npy(const std::string& file_address,
+                             size_t dim_n,
+                             const std::string& name)
 {
-    Matrix<T>::load(file_address, 2) ;
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::load_npy(file_address, 2, name) ;
 
     this->_row_offsets = std::vector<size_t>(this->_dim[1]) ;
     this->_col_offsets = std::vector<size_t>(this->_dim[0]) ;
@@ -484,36 +776,81 @@ void Matrix2D<T>::load(const std::string& file_address)
     this->compute_col_offsets() ;
 }
 
-template<class T>
-T Matrix2D<T>::get(size_t row, size_t col) const
-{   try
-    {   return this->get({row, col}) ; }
-    catch(std::out_of_range& e)
-    {   throw e ; }
+template<class T, class A>
+void Matrix2D<T,A>::load_npy(const std::string& file_address,
+                             const std::string& name)
+{   this->load_npy(file_address, 2, name) ; }
+
+template<class T, class A>
+void Matrix2D<T,A>::map_npy(const std::string& file_address,
+                            size_t dim_n,
+                            MatrixMapMode mode,
+                            const std::string& name)
+{
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::map_npy(file_address, 2, mode, name) ;
+
+    this->_row_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_col_offsets = std::vector<size_t>(this->_dim[0]) ;
+
+    this->compute_dim_product() ;
+    this->compute_row_offsets() ;
+    this->compute_col_offsets() ;
 }
 
+template<class T, class A>
+void Matrix2D<T,A>::map_npy(const std::string& file_address,
+                            MatrixMapMode mode,
+                            const std::string& name)
+{   this->map_npy(file_address, 2, mode, name) ; }
+
+template<class T, class A>
+void Matrix2D<T,A>::attach_shared(const std::string& name,
+                                  size_t dim_n)
+{
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::attach_shared(name, 2) ;
 
-template<class T>
-void Matrix2D<T>::set(size_t row, size_t col, T value)
-{   try
-    {   this->set({row, col}, value) ; }
-    catch(std::out_of_range& e)
-    {   throw e ; }
+    this->_row_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_col_offsets = std::vector<size_t>(this->_dim[0]) ;
+
+    this->compute_dim_product() ;
+    this->compute_row_offsets() ;
+    this->compute_col_offsets() ;
 }
 
+template<class T, class A>
+void Matrix2D<T,A>::attach_shared(const std::string& name)
+{   this->attach_shared(name, 2) ; }
 
-template<class T>
-size_t Matrix2D<T>::get_nrow() const
+template<class T, class A>
+T Matrix2D<T,A>::get(size_t row, size_t col) const
+{   if(row >= this->_dim[1] or col >= this->_dim[0])
+    {   throw std::out_of_range("coordinates are out of range!") ; }
+    return (*this->_data)[this->convert_to_offset(row, col)] ;
+}
+
+
+template<class T, class A>
+void Matrix2D<T,A>::set(size_t row, size_t col, T value)
+{   if(row >= this->_dim[1] or col >= this->_dim[0])
+    {   throw std::out_of_range("coordinates are out of range!") ; }
+    (*this->_data)[this->convert_to_offset(row, col)] = value ;
+}
+
+
+template<class T, class A>
+size_t Matrix2D<T,A>::get_nrow() const
 {   return this->_dim[1] ; }
 
 
-template<class T>
-size_t Matrix2D<T>::get_ncol() const
+template<class T, class A>
+size_t Matrix2D<T,A>::get_ncol() const
 {   return this->_dim[0] ; }
 
 
-template<class T>
-std::vector<T> Matrix2D<T>::get_row(size_t i) const
+template<class T, class A>
+std::vector<T> Matrix2D<T,A>::get_row(size_t i) const
 {   if(i>=this->get_nrow())
     {   throw std::out_of_range("row index is out of range!") ; }
 
@@ -525,8 +862,8 @@ std::vector<T> Matrix2D<T>::get_row(size_t i) const
 }
 
 
-template<class T>
-std::vector<T> Matrix2D<T>::get_col(size_t i) const
+template<class T, class A>
+std::vector<T> Matrix2D<T,A>::get_col(size_t i) const
 {   if(i>=this->get_ncol())
     {   throw std::out_of_range("column index is out of range!") ; }
 
@@ -538,8 +875,8 @@ std::vector<T> Matrix2D<T>::get_col(size_t i) const
 }
 
 
-template<class T>
-void Matrix2D<T>::set_row(size_t i, const std::vector<T>& values)
+template<class T, class A>
+void Matrix2D<T,A>::set_row(size_t i, const std::vector<T>& values)
 {   if(i>=this->get_nrow())
     {   throw std::out_of_range("row index is out of range!") ; }
     else if(values.size() != this->get_ncol())
@@ -550,8 +887,8 @@ void Matrix2D<T>::set_row(size_t i, const std::vector<T>& values)
 }
 
 
-template<class T>
-void Matrix2D<T>::set_col(size_t i, const std::vector<T>& values)
+template<class T, class A>
+void Matrix2D<T,A>::set_col(size_t i, const std::vector<T>& values)
 {   if(i>=this->get_ncol())
     {   throw std::out_of_range("row index is out of range!") ; }
     else if(values.size() != this->get_nrow())
@@ -561,24 +898,46 @@ void Matrix2D<T>::set_col(size_t i, const std::vector<T>& values)
     {   (*this->_data)[j] = values[n] ; }
 }
 
-template<class T>
-void Matrix2D<T>::print(std::ostream& stream, size_t precision, size_t width, char sep) const
+template<class T, class A>
+MatrixView<T> Matrix2D<T,A>::get_row_view(size_t i)
+{   return this->get_view().slice(0, i) ; }
+
+template<class T, class A>
+MatrixView<const T> Matrix2D<T,A>::get_row_view(size_t i) const
+{   return this->get_view().slice(0, i) ; }
+
+template<class T, class A>
+MatrixView<T> Matrix2D<T,A>::get_col_view(size_t i)
+{   return this->get_view().slice(1, i) ; }
+
+template<class T, class A>
+MatrixView<const T> Matrix2D<T,A>::get_col_view(size_t i) const
+{   return this->get_view().slice(1, i) ; }
+
+template<class T, class A>
+MatrixView<T> Matrix2D<T,A>::get_block_view(size_t row, size_t col, size_t nrow, size_t ncol)
+{   return this->get_view().block({row, col}, {nrow, ncol}) ; }
+
+template<class T, class A>
+MatrixView<const T> Matrix2D<T,A>::get_block_view(size_t row, size_t col, size_t nrow, size_t ncol) const
+{   return this->get_view().block({row, col}, {nrow, ncol}) ; }
+
+template<class T, class A>
+void Matrix2D<T,A>::print(std::ostream& stream, size_t precision, size_t width, char sep) const
 {   stream.setf(std::ios::left) ;
     stream << std::setprecision(precision) << std::fixed ;
+    MatrixTextWriter<T>(stream, this->_dim, 2, width, sep).write(this->get_data_ptr()) ;
+}
 
-    size_t    n  = 0 ;
-    size_t n_tot = this->get_nrow()*this->get_ncol() ;
-
-    for(size_t i=0; i<this->get_nrow(); i++)
-    {   for(size_t j=0; j<this->get_ncol(); j++, n++)
-        {   stream << std::setw(width) << (*this)(i,j) << sep ; }
-        if(n<n_tot)
-        {   stream << std::endl ; }
-    }
+template<class T, class A>
+void Matrix2D<T,A>::print(std::ostream& stream, ThreadPool& pool, size_t precision, size_t width, char sep) const
+{   stream.setf(std::ios::left) ;
+    stream << std::setprecision(precision) << std::fixed ;
+    MatrixTextWriter<T>(stream, this->_dim, 2, width, sep).write(this->get_data_ptr(), pool) ;
 }
 
-template<class T>
-Matrix2D<T>& Matrix2D<T>::operator = (const Matrix2D<T>& other)
+template<class T, class A>
+Matrix2D<T,A>& Matrix2D<T,A>::operator = (const Matrix2D<T,A>& other)
 {   /*
     this->_dim           = other._dim ;
     this->_dim_size      = other._dim_size ;
@@ -586,45 +945,68 @@ Matrix2D<T>& Matrix2D<T>::operator = (const Matrix2D<T>& other)
     this->_data_size     = other._data_size ;
     this->_dim_prod      = other._dim_prod ;
     */
-    Matrix<T>::operator=(other) ;
+    Matrix<T,A>::operator=(other) ;
     this->_row_offsets = other._row_offsets ;
     this->_col_offsets = other._col_offsets ;
     return *this ;
 }
 
-template<class T>
-Matrix2D<T>& Matrix2D<T>::operator = (Matrix2D<T>&& other)
-{   Matrix<T>::operator=(std::move(other)) ;
-    this->_row_offsets = other._row_offsets ;
-    this->_col_offsets = other._col_offsets ;
+template<class T, class A>
+Matrix2D<T,A>& Matrix2D<T,A>::operator = (Matrix2D<T,A>&& other)
+{   if(&other == this)
+    {   return *this ; }
+    Matrix<T,A>::operator=(std::move(other)) ;
+    this->_row_offsets = std::move(other._row_offsets) ;
+    this->_col_offsets = std::move(other._col_offsets) ;
+    other._row_offsets.clear() ;
+    other._col_offsets.clear() ;
     return *this ;
 }
 
-template<class T>
-T& Matrix2D<T>::operator () (size_t row, size_t col)
+template<class T, class A>
+template<class E>
+Matrix2D<T,A>& Matrix2D<T,A>::operator = (const MatrixExpression<E>& e)
+{   if(e.self().get_dim().size() != 2)
+    {   throw std::invalid_argument("the expression does not have 2 dimensions!") ; }
+    Matrix<T,A>::operator=(e) ;
+    this->_row_offsets.resize(this->_dim[1]) ;
+    this->_col_offsets.resize(this->_dim[0]) ;
+    this->compute_row_offsets() ;
+    this->compute_col_offsets() ;
+    return *this ;
+}
+
+template<class T, class A>
+T& Matrix2D<T,A>::operator () (size_t row, size_t col)
 {   return (*this->_data)[this->convert_to_offset(row, col)] ; }
 
 
-template<class T>
-const T& Matrix2D<T>::operator () (size_t row, size_t col) const
+template<class T, class A>
+const T& Matrix2D<T,A>::operator () (size_t row, size_t col) const
 {   return (*this->_data)[this->convert_to_offset(row, col)] ; }
 
 
 
-template<class T>
-void Matrix2D<T>::compute_row_offsets()
+template<class T, class A>
+void Matrix2D<T,A>::check_dim_number(size_t dim_n) const
+{   if(dim_n != 2)
+    {   throw std::invalid_argument("the matrix does not have 2 dimensions!") ; }
+}
+
+template<class T, class A>
+void Matrix2D<T,A>::compute_row_offsets()
 {   for(size_t i=0; i<this->_dim[1]; i++)
     {   this->_row_offsets[i] = i * this->_dim_prod[1] ; }
 }
 
-template<class T>
-void Matrix2D<T>::compute_col_offsets()
+template<class T, class A>
+void Matrix2D<T,A>::compute_col_offsets()
 {   for(size_t i=0; i<this->_dim[0]; i++)
     {   this->_col_offsets[i] = i * this->_dim_prod[0] ; }
 }
 
-template<class T>
-size_t Matrix2D<T>::convert_to_offset(size_t row, size_t col) const
+template<class T, class A>
+size_t Matrix2D<T,A>::convert_to_offset(size_t row, size_t col) const
 {
     size_t offset = this->_row_offsets[row] + this->_col_offsets[col] ;
     return offset ;
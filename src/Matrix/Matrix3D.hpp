@@ -2,6 +2,7 @@
 #define MATRIX3D_HPP
 
 #include <Matrix.hpp>
+#include "MatrixTextParser.hpp"
 
 #include <string>
 #include <vector>
@@ -19,19 +20,9 @@
  * The Matrix3D class is a specialisation of the Matrix
  * class to make work with 3D matrices more easily.
  *
- * A format to save a Matrix3D objects in a binary file is defined. The following values
- * are written :
- * 1x size_t :     the number <N> of dimensions of the Matrix stored. This is the value
- *                 of _dim_size field. This value must be 3 otherwise this is not a 3D
- *                 matrix.
- * 3x size_t :     the width of the matrix in each dimension. These values correspond
- *                 to the content of the _dim vector and can be loaded inside this
- *                 vector as they are.
- * Dx <T> values : the <D> values contained in the matrix, in the _data vector.
- *                 These values can be loaded directly in this vector. <D> is equal to the
- *                 product of the 3 values stored right before. The type <T> depends on
- *                 the type of the data stored in the matrix. The 1st of the D values is
- *                 also the first value of the _data vector.
+ * A format to save a Matrix3D objects in a binary file is defined, it is the
+ * format of the Matrix class (see MatrixBinaryFormat.hpp). The number of dimensions
+ * stored in the file must be 3 otherwise this is not a 3D matrix.
  *
  *
  * A text file format is defined to store Matrix3D objects. The specifications are as
@@ -63,8 +54,8 @@
  * dimension creates an empty file.
  *
  */
-template<class T>
-class Matrix3D : public Matrix<T>
+template<class T, class A = MatrixAlignedAllocator<T>>
+class Matrix3D : public Matrix<T,A>
 {
     public:
         // constructors
@@ -115,14 +106,76 @@ class Matrix3D : public Matrix<T>
          */
         Matrix3D(const std::string& file_address) ;
 
+        /*!
+         * \brief Constructs a matrix from a text file, the slices of the
+         * file being parsed in parallel (see load_text_slices()).
+         * \param file_address the address of the file containing the matrix.
+         * \param pool the threads to use.
+         * \throw std::runtime_error if anything happen while reading the
+         * file (format error, file not found, etc).
+         */
+        Matrix3D(const std::string& file_address, ThreadPool& pool) ;
+
+        /*!
+         * \brief Constructs a matrix by evaluating an expression.
+         * \param e the expression of interest.
+         * \throw std::invalid_argument if the expression does not
+         * have 3 dimensions.
+         */
+        template<class E, class = typename std::enable_if<matrix_expression_has_dim_number<E,3>::value>::type>
+        Matrix3D(const MatrixExpression<E>& e) ;
+
         /*!
          * \brief Destructor.
          */
         virtual ~Matrix3D() ;
 
         // methods overloaded from Matrix
-        using Matrix<T>::get ;
-        using Matrix<T>::set ;
+        using Matrix<T,A>::get ;
+        using Matrix<T,A>::set ;
+
+        // methods overriden from Matrix, which also update the
+        // offsets
+        /*!
+         * \brief See Matrix::map().
+         * \throw std::invalid_argument if dim_n is not 3.
+         */
+        virtual void map(const std::string& file_address,
+                         size_t dim_n,
+                         MatrixMapMode mode) override ;
+
+        /*!
+         * \brief See Matrix::load_region().
+         * \throw std::invalid_argument if dim_n is not 3.
+         */
+        virtual void load_region(const std::string& file_address,
+                                 size_t dim_n,
+                                 const std::vector<size_t>& origin,
+                                 const std::vector<size_t>& extent) override ;
+
+        /*!
+         * \brief See Matrix::load_npy().
+         * \throw std::invalid_argument if dim_n is not 3.
+         */
+        virtual void load_npy(const std::string& file_address,
+                              size_t dim_n,
+                              const std::string& name="") override ;
+
+        /*!
+         * \brief See Matrix::map_npy().
+         * \throw std::invalid_argument if dim_n is not 3.
+         */
+        virtual void map_npy(const std::string& file_address,
+                             size_t dim_n,
+                             MatrixMapMode mode,
+                             const std::string& name="") override ;
+
+        /*!
+         * \brief See Matrix::attach_shared().
+         * \throw std::invalid_argument if dim_n is not 3.
+         */
+        virtual void attach_shared(const std::string& name,
+                                   size_t dim_n) override ;
 
         // methods
         /*!
@@ -132,6 +185,73 @@ class Matrix3D : public Matrix<T>
          */
         void load(const std::string& file_address) ;
 
+        /*!
+         * \brief maps a binary file containing a matrix
+         * in memory, the values are read lazily when they
+         * are accessed. See Matrix::map().
+         * \param path the path to the file.
+         * \param mode how the file is mapped.
+         * \throw std::runtime_error if the file cannot be
+         * mapped or does not contain a 3D matrix.
+         */
+        void map(const std::string& file_address,
+                 MatrixMapMode mode=MatrixMapMode::read_only) ;
+
+        /*!
+         * \brief loads a NumPy .npy file, or an array of a
+         * .npz file, containing a 3D matrix. See
+         * Matrix::load_npy().
+         * \param path the path to the file.
+         * \param name in a .npz file, the name of the array,
+         * by default the 1st array.
+         * \throw std::runtime_error if the file cannot be
+         * read or does not contain a 3D matrix.
+         */
+        void load_npy(const std::string& file_address,
+                      const std::string& name="") ;
+
+        /*!
+         * \brief maps a NumPy .npy file, or an array of a
+         * .npz file, containing a 3D matrix in memory. See
+         * Matrix::map_npy().
+         * \param path the path to the file.
+         * \param mode how the file is mapped.
+         * \param name in a .npz file, the name of the array,
+         * by default the 1st array.
+         * \throw std::runtime_error if the file cannot be
+         * mapped or does not contain a 3D matrix.
+         */
+        void map_npy(const std::string& file_address,
+                     MatrixMapMode mode=MatrixMapMode::read_only,
+                     const std::string& name="") ;
+
+        /*!
+         * \brief attaches to a POSIX shared memory object
+         * containing a 3D matrix, read-only. See
+         * Matrix::attach_shared().
+         * \param name the name of the object.
+         * \throw std::runtime_error if the object cannot be
+         * mapped or does not contain a 3D matrix.
+         */
+        void attach_shared(const std::string& name) ;
+
+        /*!
+         * \brief loads a region of a matrix stored in a
+         * binary file, without reading the rest of the file.
+         * See Matrix::load_region().
+         * \param path the path to the file.
+         * \param origin the coordinates of the 1st element of
+         * the region, as (dim1, dim2, dim3).
+         * \param extent the dimensions of the region, as (dim1, dim2, dim3).
+         * \throw std::runtime_error if the file cannot be
+         * read or does not contain a 3D matrix and
+         * std::out_of_range if the region does not fit within
+         * the stored matrix.
+         */
+        void load_region(const std::string& file_address,
+                         const std::vector<size_t>& origin,
+                         const std::vector<size_t>& extent) ;
+
         /*!
          * \brief Gets the element at the given coordinates.
          * \param dim1 the first dimension coordinate.
@@ -155,6 +275,24 @@ class Matrix3D : public Matrix<T>
          */
         void set(size_t dim1, size_t dim2, size_t dim3, T value) ;
 
+        /*!
+         * \brief Creates a view on a given slice of the 3rd
+         * dimension, without copying its values.
+         * \param dim3 the 3rd dimension slice of interest.
+         * \throw std::out_of_range if dim3 is out of range.
+         * \return a 2D view on the slice.
+         */
+        MatrixView<T> get_slice_view(size_t dim3) ;
+
+        /*!
+         * \brief Creates a read-only view on a given slice of
+         * the 3rd dimension, without copying its values.
+         * \param dim3 the 3rd dimension slice of interest.
+         * \throw std::out_of_range if dim3 is out of range.
+         * \return a 2D view on the slice.
+         */
+        MatrixView<const T> get_slice_view(size_t dim3) const ;
+
         /*!
          * \brief Produces a nice representation of the matrix on the given
          * stream.
@@ -165,6 +303,17 @@ class Matrix3D : public Matrix<T>
          */
         virtual void print(std::ostream& stream, size_t precision=4 ,size_t width=8, char sep=' ') const override ;
 
+        /*!
+         * \brief Produces the same representation as print(), the
+         * values being formatted by chunks in parallel.
+         * \param stream the stream.
+         * \param pool the threads to use.
+         * \param precision the rounding precision.
+         * \param width the column width in number of characters.
+         * \param sep the character separator.
+         */
+        virtual void print(std::ostream& stream, ThreadPool& pool, size_t precision=4, size_t width=8, char sep=' ') const override ;
+
         // operators
         /*!
          * Assignment operator.
@@ -180,6 +329,17 @@ class Matrix3D : public Matrix<T>
          */
         Matrix3D& operator = (Matrix3D&& other) ;
 
+        /*!
+         * Assignment operator, evaluates an expression and stores
+         * the result. The expression may involve the instance itself.
+         * \param e the expression of interest.
+         * \throw std::invalid_argument if the expression does not
+         * have 3 dimensions.
+         * \return a reference to the instance.
+         */
+        template<class E>
+        Matrix3D& operator = (const MatrixExpression<E>& e) ;
+
         /*!
          * \brief Returns a reference to the corrresponding
          * element. This method does not perform any check on
@@ -205,12 +365,12 @@ class Matrix3D : public Matrix<T>
     private:
         // methods
         /*!
-         * \brief Checks whether a given string is a slice header
-         * (such as ",,0"), as found in files storing Matrix3D.
-         * \param str the string to check.
-         * \return whether the string is a slice header.
+         * \brief Checks a number of dimensions given to the
+         * methods overriden from Matrix.
+         * \param dim_n the number of dimensions.
+         * \throw std::invalid_argument if dim_n is not 3.
          */
-        bool is_header(const std::string& str) const ;
+        void check_dim_number(size_t dim_n) const ;
 
         /*!
          * \brief Converts a triplet of VALID (dim1, dim2, dim3) coordinates
@@ -262,70 +422,23 @@ class Matrix3D : public Matrix<T>
         std::vector<size_t> _dim3_offsets ;
 } ;
 
-// operators
-/*!
- * \brief Addition operator.
- * \param m the matrix of interest
- * \param value the value to add to each element.
- * \return the resulting matrix.
- */
-template<class T>
-const Matrix3D<T> operator + (Matrix3D<T> m, T value)
-{   Matrix3D<T> other(m) ;
-    m += value ;
-    return m ;
-}
-
 /*!
- * \brief Substraction operator
- * \param m the matrix of interest.
- * \param value the value to substract to each element.
- * \return the resulting matrix.
+ * \brief The number of dimensions of a Matrix3D, used to
+ * type the expressions involving it (see MatrixExpression.hpp).
  */
-template<class T>
-const Matrix3D<T> operator - (Matrix3D<T> m, T value)
-{    Matrix3D<T> other(m) ;
-     m -= value ;
-     return m ;
-}
-
-/*!
- * \brief Multiplication operator.
- * \param m the matrix of interest.
- * \param value the value to multiply each elements by.
- * \return the resulting matrix.
- */
-template<class T>
-const Matrix3D<T> operator * (Matrix3D<T> m, T value)
-{    Matrix3D<T> other(m) ;
-     m *= value ;
-     return m ;
-}
-
-/*!
- * \brief Division operator.
- * \param m the matrix of interest.
- * \param value the value to divide each elements by.
- * \throw std::invalid_argument if value is 0.
- * \return the resulting matrix.
- */
-template<class T>
-const Matrix3D<T> operator / (Matrix3D<T> m, T value)
-{   if(value == static_cast<T>(0))
-    {   throw std::invalid_argument("division by 0!") ; }
-    Matrix3D<T> other(m) ;
-    other /= value ;
-    return other ;
-}
+template<class T, class A>
+struct matrix_dim_number<Matrix3D<T,A>>
+{   static const size_t value = 3 ; } ;
 
+// operators
 /*!
  * \brief Sends a representation of the matrix to the stream.
  * \param stream the stream of interest.
  * \param m the matrix of interest.
  * \return a reference to the stream.
  */
-template<class T>
-std::ostream& operator << (std::ostream& stream, const Matrix3D<T>& m)
+template<class T, class A>
+std::ostream& operator << (std::ostream& stream, const Matrix3D<T,A>& m)
 {   m.print(stream) ;
     return stream ;
 }
@@ -333,14 +446,14 @@ std::ostream& operator << (std::ostream& stream, const Matrix3D<T>& m)
 
 
 // method implementation
-template<class T>
-Matrix3D<T>::Matrix3D(size_t dim1, size_t dim2, size_t dim3)
-    : Matrix3D<T>(dim1, dim2, dim3, 0)
+template<class T, class A>
+Matrix3D<T,A>::Matrix3D(size_t dim1, size_t dim2, size_t dim3)
+    : Matrix3D<T,A>(dim1, dim2, dim3, 0)
 {}
 
-template<class T>
-Matrix3D<T>::Matrix3D(size_t dim1, size_t dim2, size_t dim3, T value)
-    : Matrix<T>({dim1, dim2, dim3}, value),
+template<class T, class A>
+Matrix3D<T,A>::Matrix3D(size_t dim1, size_t dim2, size_t dim3, T value)
+    : Matrix<T,A>({dim1, dim2, dim3}, value),
       _dim1_offsets(dim1),
       _dim2_offsets(dim2),
       _dim3_offsets(dim3)
@@ -349,145 +462,37 @@ Matrix3D<T>::Matrix3D(size_t dim1, size_t dim2, size_t dim3, T value)
     this->compute_dim3_offsets() ;
 }
 
-template<class T>
-Matrix3D<T>::Matrix3D(const Matrix3D& other)
-    : Matrix<T>(other)
+template<class T, class A>
+Matrix3D<T,A>::Matrix3D(const Matrix3D& other)
+    : Matrix<T,A>(other)
 {   this->_dim1_offsets = other._dim1_offsets ;
     this->_dim2_offsets = other._dim2_offsets ;
     this->_dim3_offsets = other._dim3_offsets ;
 }
 
-template<class T>
-Matrix3D<T>::Matrix3D(Matrix3D<T>&& other)
-    : Matrix<T>(std::move(other))
-{   this->_dim1_offsets = other._dim1_offsets ;
-    this->_dim2_offsets = other._dim2_offsets ;
-    this->_dim3_offsets = other._dim3_offsets ;
+template<class T, class A>
+Matrix3D<T,A>::Matrix3D(Matrix3D<T,A>&& other)
+    : Matrix<T,A>(std::move(other))
+{   this->_dim1_offsets = std::move(other._dim1_offsets) ;
+    this->_dim2_offsets = std::move(other._dim2_offsets) ;
+    this->_dim3_offsets = std::move(other._dim3_offsets) ;
+    other._dim1_offsets.clear() ;
+    other._dim2_offsets.clear() ;
+    other._dim3_offsets.clear() ;
 }
 
-template<class T>
-Matrix3D<T>::Matrix3D(const std::string &file_address)
-{
-    this->_dim       = {0,0,0} ;
-    this->_data      = new std::vector<T>() ;
-    this->_dim_size  = this->_dim.size() ;
-    this->_data_size = this->_data->size() ;
-    this->_dim_prod  = std::vector<size_t>(this->_dim_size, 0) ;
-
-    std::ifstream file(file_address, std::ifstream::in) ;
-    if(file.fail())
-    {   char msg[BUFFER_SIZE] ;
-        sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
-        throw std::runtime_error(msg) ;
-    }
-
-    std::string         buffer_str ;
-    std::vector<T>      buffer_vec ;
-    T                   buffer_T ;
-
-    // read file
-    size_t n_line      = 0, n_line_data = 0 ; // number of line and of data line read
-    size_t row_len     = 0, col_len     = 0 ; // length of row and column in nber of values
-    size_t row_len_cur = 0, col_len_cur = 0 ; // current number of values read in row and col
-
-    while(getline(file, buffer_str))
-    {   if(file.fail())
-        {   file.close() ;
-            char msg[BUFFER_SIZE] ;
-            sprintf(msg, "error! while reading %s", file_address.c_str()) ;
-            throw std::runtime_error(msg) ;
-        }
-        // check empty line
-        if(buffer_str.size() == 0)
-        {   // this file only contains one eol char and should be considered as empty,
-            // -> returns empty matrix not an error
-            if(n_line == 0 and file.peek() == EOF and file.eof())
-            {  break ; }
-
-            file.close() ;
-            char msg[BUFFER_SIZE] ;
-            sprintf(msg, "format error! while reading %s (empty line)", file_address.c_str()) ;
-            throw std::runtime_error(msg) ;
-        }
-
-
-        // check whether it is the beginning of a slice
-        // 1st line in file should be one like this
-        if(this->is_header(buffer_str))
-        {   // check that slice have a constant number of rows
-            if(this->_dim[2] == 1)
-            {   col_len = col_len_cur ;
-                // this->_dim[0] = row_len ;
-                // this->_dim[1]  = col_len ;
-            }
-            else if(col_len_cur != col_len)
-            {   file.close() ;
-                char msg[BUFFER_SIZE] ;
-                sprintf(msg, "format error! slice have variable dimensions 1 in %s", file_address.c_str()) ;
-                throw std::runtime_error(msg) ;
-            }
-            this->_dim[2]++ ;
-            col_len_cur = 0 ;
-            n_line++ ;
-            continue ;
-        }
-        // 1st line in file should be a header and entering
-        // this block is forbidden
-        if(n_line == 0)
-        {   file.close() ;
-            char msg[BUFFER_SIZE] ;
-            sprintf(msg, "format error! first line is not a slice header in %s", file_address.c_str()) ;
-            throw std::runtime_error(msg) ;
-        }
-
-        // parse line
-        row_len_cur = 0 ;
-        buffer_vec.clear() ;
-        std::istringstream buffer_ss(buffer_str) ;
-        while(buffer_ss >> buffer_T)
-        {   buffer_vec.push_back(buffer_T) ;
-            row_len_cur++ ;
-        }
-        // check for an error which likely indicates that a value could not be
-        // casted into a type T (mixed data types in the file)
-        if(buffer_ss.fail() and not buffer_ss.eof())
-        {   file.close() ;
-            char msg[BUFFER_SIZE] ;
-            sprintf(msg, "format error! could not read a line in %s (incompatible data types)", file_address.c_str()) ;
-            throw std::runtime_error(msg) ;
-        }
-
-        // check that number of column is constant
-        if(n_line_data == 0)
-        {  row_len = row_len_cur ; }
-        else if(row_len_cur != row_len)
-        {   file.close() ;
-            char msg[BUFFER_SIZE] ;
-            sprintf(msg, "format error! slice have variable dimensions 2 in %s", file_address.c_str()) ;
-            throw std::runtime_error(msg) ;
-        }
-
-        // update matrix content
-        for(auto i : buffer_vec)
-        {   this->_data->push_back(i) ;
-            this->_data_size++ ;
-        }
-        col_len_cur++ ;
-        n_line_data++ ;
-        n_line++ ;
-        // update matrix dimensions
-        this->_dim[0] = row_len_cur ;
-        this->_dim[1] = col_len_cur ;
-    }
-    // check dimensions of last slice
-    if(col_len_cur != this->_dim[1])
-    {   file.close() ;
-        char msg[BUFFER_SIZE] ;
-        sprintf(msg, "format error! slice have variable dimensions in %s", file_address.c_str()) ;
-        throw std::runtime_error(msg) ;
-    }
+template<class T, class A>
+Matrix3D<T,A>::Matrix3D(const std::string &file_address)
+    : Matrix3D(file_address, ThreadPool::get_default())
+{}
 
-    file.close() ;
+template<class T, class A>
+Matrix3D<T,A>::Matrix3D(const std::string &file_address, ThreadPool& pool)
+{   typename MatrixHeapStorage<T,A>::vector_type data ;
+    load_text_slices(file_address, 3, this->_dim, data, pool) ;
+    this->_dim_size  = this->_dim.size() ;
+    this->_data_size = data.size() ;
+    this->_data      = new MatrixHeapStorage<T,A>(std::move(data)) ;
     this->compute_dim_product() ;
 
     this->_dim1_offsets = std::vector<size_t>(this->_dim[1]) ;
@@ -498,18 +503,135 @@ Matrix3D<T>::Matrix3D(const std::string &file_address)
     this->compute_dim3_offsets() ;
 }
 
-template<class T>
-Matrix3D<T>::~Matrix3D()
+template<class T, class A>
+template<class E, class>
+Matrix3D<T,A>::Matrix3D(const MatrixExpression<E>& e)
+    : Matrix<T,A>(e)
+{   if(this->_dim_size != 3)
+    {   throw std::invalid_argument("the expression does not have 3 dimensions!") ; }
+    this->_dim1_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_dim2_offsets = std::vector<size_t>(this->_dim[0]) ;
+    this->_dim3_offsets = std::vector<size_t>(this->_dim[2]) ;
+    this->compute_dim1_offsets() ;
+    this->compute_dim2_offsets() ;
+    this->compute_dim3_offsets() ;
+}
+
+template<class T, class A>
+Matrix3D<T,A>::~Matrix3D()
 {   if(this->_data != nullptr)
     {   delete this->_data ;
         this->_data = nullptr ;
     }
 }
 
-template<class T>
-void Matrix3D<T>::load(const std::string& file_address)
+template<class T, class A>
+void Matrix3D<T,A>::load(const std::string& file_address)
+{
+    Matrix<T,A>::load(file_address, 3) ;
+
+    this->_dim1_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_dim2_offsets = std::vector<size_t>(this->_dim[0]) ;
+    this->_dim3_offsets = std::vector<size_t>(this->_dim[2]) ;
+    this->compute_dim1_offsets() ;
+    this->compute_dim2_offsets() ;
+    this->compute_dim3_offsets() ;
+}
+
+template<class T, class A>
+void Matrix3D<T,A>::load_region(const std::string& file_address,
+                                size_t dim_n,
+                                const std::vector<size_t>& origin,
+                                const std::vector<size_t>& extent)
+{
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::load_region(file_address, 3, origin, extent) ;
+
+    this->_dim1_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_dim2_offsets = std::vector<size_t>(this->_dim[0]) ;
+    this->_dim3_offsets = std::vector<size_t>(this->_dim[2]) ;
+    this->compute_dim1_offsets() ;
+    this->compute_dim2_offsets() ;
+    this->compute_dim3_offsets() ;
+}
+
+template<class T, class A>
+void Matrix3D<T,A>::load_region(const std::string& file_address,
+                                const std::vector<size_t>& origin,
+                                const std::vector<size_t>& extent)
+{   this->load_region(file_address, 3, origin, extent) ; }
+
+template<class T, class A>
+void Matrix3D<T,A>::map(const std::string& file_address,
+                        size_t dim_n,
+                        MatrixMapMode mode)
+{
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::map(file_address, 3, mode) ;
+
+    this->_dim1_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_dim2_offsets = std::vector<size_t>(this->_dim[0]) ;
+    this->_dim3_offsets = std::vector<size_t>(this->_dim[2]) ;
+    this->compute_dim1_offsets() ;
+    this->compute_dim2_offsets() ;
+    this->compute_dim3_offsets() ;
+}
+
+template<class T, class A>
+void Matrix3D<T,A>::map(const std::string& file_address,
+                        MatrixMapMode mode)
+{   this->map(file_address, 3, mode) ; }
+
+template<class T, class A>
+void Matrix3D<T,A>::load_npy(const std::string& file_address,
+                             size_t dim_n,
+                             const std::string& name)
+{
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::load_npy(file_address, 3, name) ;
+
+    this->_dim1_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_dim2_offsets = std::vector<size_t>(this->_dim[0]) ;
+    this->_dim3_offsets = std::vector<size_t>(this->_dim[2]) ;
+    this->compute_dim1_offsets() ;
+    this->compute_dim2_offsets() ;
+    this->compute_dim3_offsets() ;
+}
+
+template<class T, class A>
+void Matrix3D<T,A>::load_npy(const std::string& file_address,
+                             const std::string& name)
+{   this->load_npy(file_address, 3, name) ; }
+
+template<class T, class A>
+void Matrix3D<T,A>::map_npy(const std::string& file_address,
+                            size_t dim_n,
+                            MatrixMapMode mode,
+                            const std::string& name)
+{
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::map_npy(file_address, 3, mode, name) ;
+
+    this->_dim1_offsets = std::vector<size_t>(this->_dim[1]) ;
+    this->_dim2_offsets = std::vector<size_t>(this->_dim[0]) ;
+    this->_dim3_offsets = std::vector<size_t>(this->_dim[2]) ;
+    this->compute_dim1_offsets() ;
+    this->compute_dim2_offsets() ;
+    this->compute_dim3_offsets() ;
+}
+
+template<class T, class A>
+void Matrix3D<T,A>::map_npy(const std::string& file_address,
+                            MatrixMapMode mode,
+                            const std::string& name)
+{   this->map_npy(file_address, 3, mode, name) ; }
+
+template<class T, class A>
+void Matrix3D<T,A>::attach_shared(const std::string& name,
+                                  size_t dim_n)
 {
-    Matrix<T>::load(file_address, 3) ;
+    this->check_dim_number(dim_n) ;
+    Matrix<T,A>::attach_shared(name, 3) ;
 
     this->_dim1_offsets = std::vector<size_t>(this->_dim[1]) ;
     this->_dim2_offsets = std::vector<size_t>(this->_dim[0]) ;
@@ -519,24 +641,34 @@ void Matrix3D<T>::load(const std::string& file_address)
     this->compute_dim3_offsets() ;
 }
 
-template<class T>
-T Matrix3D<T>::get(size_t dim1, size_t dim2, size_t dim3) const
-{   try
-    {  return this->get({dim1, dim2, dim3}) ; }
-    catch(std::out_of_range& e)
-    {   throw e ; }
+template<class T, class A>
+void Matrix3D<T,A>::attach_shared(const std::string& name)
+{   this->attach_shared(name, 3) ; }
+
+template<class T, class A>
+T Matrix3D<T,A>::get(size_t dim1, size_t dim2, size_t dim3) const
+{   if(dim1 >= this->_dim[1] or dim2 >= this->_dim[0] or dim3 >= this->_dim[2])
+    {   throw std::out_of_range("coordinates are out of range!") ; }
+    return (*this->_data)[this->convert_to_offset(dim1, dim2, dim3)] ;
 }
 
-template<class T>
-void Matrix3D<T>::set(size_t dim1, size_t dim2, size_t dim3, T value)
-{   try
-    {  return this->set({dim1, dim2, dim3}, value) ; }
-    catch(std::out_of_range& e)
-    {   throw e ; }
+template<class T, class A>
+void Matrix3D<T,A>::set(size_t dim1, size_t dim2, size_t dim3, T value)
+{   if(dim1 >= this->_dim[1] or dim2 >= this->_dim[0] or dim3 >= this->_dim[2])
+    {   throw std::out_of_range("coordinates are out of range!") ; }
+    (*this->_data)[this->convert_to_offset(dim1, dim2, dim3)] = value ;
 }
 
-template<class T>
-Matrix3D<T>& Matrix3D<T>::operator = (const Matrix3D<T>& other)
+template<class T, class A>
+MatrixView<T> Matrix3D<T,A>::get_slice_view(size_t dim3)
+{   return this->get_view().slice(2, dim3) ; }
+
+template<class T, class A>
+MatrixView<const T> Matrix3D<T,A>::get_slice_view(size_t dim3) const
+{   return this->get_view().slice(2, dim3) ; }
+
+template<class T, class A>
+Matrix3D<T,A>& Matrix3D<T,A>::operator = (const Matrix3D<T,A>& other)
 {   /*
     this->_dim           = other._dim ;
     this->_dim_size      = other._dim_size ;
@@ -544,82 +676,95 @@ Matrix3D<T>& Matrix3D<T>::operator = (const Matrix3D<T>& other)
     this->_data_size     = other._data_size ;
     this->_dim_prod      = other._dim_prod ;
     */
-    Matrix<T>::operator=(other) ;
+    Matrix<T,A>::operator=(other) ;
     this->_dim1_offsets  = other._dim1_offsets ;
     this->_dim2_offsets  = other._dim2_offsets ;
     this->_dim3_offsets  = other._dim3_offsets ;
     return *this ;
 }
 
-template<class T>
-Matrix3D<T>& Matrix3D<T>::operator = (Matrix3D<T>&& other)
-{   Matrix<T>::operator=(std::move(other)) ;
-    this->_dim1_offsets = other._dim1_offsets ;
-    this->_dim2_offsets = other._dim2_offsets ;
-    this->_dim3_offsets = other._dim3_offsets ;
+template<class T, class A>
+Matrix3D<T,A>& Matrix3D<T,A>::operator = (Matrix3D<T,A>&& other)
+{   if(&other == this)
+    {   return *this ; }
+    Matrix<T,A>::operator=(std::move(other)) ;
+    this->_dim1_offsets = std::move(other._dim1_offsets) ;
+    this->_dim2_offsets = std::move(other._dim2_offsets) ;
+    this->_dim3_offsets = std::move(other._dim3_offsets) ;
+    other._dim1_offsets.clear() ;
+    other._dim2_offsets.clear() ;
+    other._dim3_offsets.clear() ;
     return *this ;
 }
 
-template<class T>
-T& Matrix3D<T>::operator () (size_t dim1, size_t dim2, size_t dim3)
+template<class T, class A>
+template<class E>
+Matrix3D<T,A>& Matrix3D<T,A>::operator = (const MatrixExpression<E>& e)
+{   if(e.self().get_dim().size() != 3)
+    {   throw std::invalid_argument("the expression does not have 3 dimensions!") ; }
+    Matrix<T,A>::operator=(e) ;
+    this->_dim1_offsets.resize(this->_dim[1]) ;
+    this->_dim2_offsets.resize(this->_dim[0]) ;
+    this->_dim3_offsets.resize(this->_dim[2]) ;
+    this->compute_dim1_offsets() ;
+    this->compute_dim2_offsets() ;
+    this->compute_dim3_offsets() ;
+    return *this ;
+}
+
+template<class T, class A>
+T& Matrix3D<T,A>::operator () (size_t dim1, size_t dim2, size_t dim3)
 {   return (*this->_data)[this->convert_to_offset(dim1, dim2, dim3)] ; }
 
-template<class T>
-const T& Matrix3D<T>::operator () (size_t dim1, size_t dim2, size_t dim3) const
+template<class T, class A>
+const T& Matrix3D<T,A>::operator () (size_t dim1, size_t dim2, size_t dim3) const
 {   return (*this->_data)[this->convert_to_offset(dim1, dim2, dim3)] ; }
 
-template<class T>
-void Matrix3D<T>::print(std::ostream& stream, size_t precision, size_t width, char sep) const
+template<class T, class A>
+void Matrix3D<T,A>::print(std::ostream& stream, size_t precision, size_t width, char sep) const
 {   // if the matrix has at least one 0 dimension (no data), don't do anything
     if(this->_dim[0]==0 or this->_dim[1]==0 or this->_dim[2]==0)
     {   return ; }
     stream.setf(std::ios::left) ;
     stream << std::setprecision(precision) << std::fixed ;
-    std::vector<size_t> dim = this->get_dim() ;
-
-    size_t    n  = 0 ;
-    size_t n_tot = std::accumulate(dim.begin(), dim.end(), (size_t)1, std::multiplies<int>()) ;
-
-    for(size_t z=0; z<dim[2]; z++)
-    {   stream << ",," << z << std::endl ;
-        for(size_t x=0; x<dim[0]; x++)
-        {   for(size_t y=0; y<dim[1]; y++, n++)
-            {   stream << std::setw(width) << (*this)(x,y,z) << sep ; }
-            if(n<n_tot)
-            {   stream << std::endl ; }
-        }
-    }
+    MatrixTextWriter<T>(stream, this->_dim, 3, width, sep).write(this->get_data_ptr()) ;
+}
+
+template<class T, class A>
+void Matrix3D<T,A>::print(std::ostream& stream, ThreadPool& pool, size_t precision, size_t width, char sep) const
+{   if(this->_dim[0]==0 or this->_dim[1]==0 or this->_dim[2]==0)
+    {   return ; }
+    stream.setf(std::ios::left) ;
+    stream << std::setprecision(precision) << std::fixed ;
+    MatrixTextWriter<T>(stream, this->_dim, 3, width, sep).write(this->get_data_ptr(), pool) ;
 }
 
-template<class T>
-bool Matrix3D<T>::is_header(const std::string& str) const
-{   if(str[0] == ',' and
-            str[1] == ',' and
-            str.find(',', 2) == std::string::npos)
-   {   return true ; }
-   return false ;
+template<class T, class A>
+void Matrix3D<T,A>::check_dim_number(size_t dim_n) const
+{   if(dim_n != 3)
+    {   throw std::invalid_argument("the matrix does not have 3 dimensions!") ; }
 }
 
-template<class T>
-void Matrix3D<T>::compute_dim1_offsets()
+template<class T, class A>
+void Matrix3D<T,A>::compute_dim1_offsets()
 {   for(size_t i=0; i<this->_dim[1]; i++)
     {   this->_dim1_offsets[i] = i * this->_dim_prod[1] ; }
 }
 
-template<class T>
-void Matrix3D<T>::compute_dim2_offsets()
+template<class T, class A>
+void Matrix3D<T,A>::compute_dim2_offsets()
 {   for(size_t i=0; i<this->_dim[0]; i++)
     {   this->_dim2_offsets[i] = i * this->_dim_prod[0] ; }
 }
 
-template<class T>
-void Matrix3D<T>::compute_dim3_offsets()
+template<class T, class A>
+void Matrix3D<T,A>::compute_dim3_offsets()
 {   for(size_t i=0; i<this->_dim[2]; i++)
     {   this->_dim3_offsets[i] = i * this->_dim_prod[2] ; }
 }
 
-template<class T>
-size_t Matrix3D<T>::convert_to_offset(size_t dim1, size_t dim2, size_t dim3) const
+template<class T, class A>
+size_t Matrix3D<T,A>::convert_to_offset(size_t dim1, size_t dim2, size_t dim3) const
 {   /*
     size_t offset = 0 ;
 
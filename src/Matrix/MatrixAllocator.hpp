@@ -0,0 +1,366 @@
+#ifndef MATRIXALLOCATOR_HPP
+#define MATRIXALLOCATOR_HPP
+
+#include <cstddef>     // size_t, ptrdiff_t
+#include <cstdint>     // uintptr_t
+#include <cstdlib>     // posix_memalign(), free()
+#include <new>         // bad_alloc
+#include <limits>
+#include <memory>      // allocator_traits
+#include <utility>     // forward()
+
+#if defined(__linux__)
+#include <unistd.h>       // syscall()
+#include <sys/mman.h>     // mmap(), munmap(), madvise()
+#include <sys/syscall.h>  // SYS_mbind, SYS_get_mempolicy
+#endif
+
+#include "ThreadPool.hpp"
+
+
+/*!
+ * The values of the matrices held in memory (MatrixHeapStorage) are
+ * allocated by the allocator given as the last template parameter of
+ * the matrix classes, Matrix<T,A>, Matrix2D<T,A>, Matrix3D<T,A> and
+ * Matrix4D<T,A>. Any standard allocator can be used, to get the memory
+ * from huge pages, from a given NUMA node, from a pool or an arena (see
+ * MatrixScratch.hpp), ...
+ *
+ * The default allocator, MatrixAlignedAllocator, aligns the values on
+ * 64 bytes, the size of a cache line and of an AVX-512 register, so
+ * that the rows of the SIMD kernels start on a cache line and aligned
+ * loads can be used on the values of a matrix.
+ *
+ * MatrixPageAllocator places the pages of the large matrices, for the
+ * machines with several NUMA nodes (sockets), where a matrix which
+ * pages are all touched first by the constructing thread lands on one
+ * node and the parallel kernels of the other nodes are bound by the
+ * remote memory accesses. The large allocations are mapped directly,
+ * aligned on 2 MiB, and, depending on the flags given :
+ * - matrix_page_huge         : are backed by transparent huge pages
+ *                              (madvise(MADV_HUGEPAGE)), fewer TLB
+ *                              misses.
+ * - matrix_page_interleave   : are interleaved page by page on all the
+ *                              nodes the process may use (mbind()),
+ *                              the bandwidth of all the nodes is used
+ *                              whatever the thread accessing a page.
+ * - matrix_page_first_touch  : are touched first by the threads of the
+ *                              default pool, in the contiguous slices
+ *                              in which ThreadPool::parallel_for()
+ *                              splits the pages, so that the pages are
+ *                              spread over the nodes of these threads
+ *                              instead of all landing on the node of
+ *                              the constructing thread.
+ * The slices touched only match a parallel_for() over the values with
+ * the default number of chunks, not the kernels of this library : the
+ * element-wise kernels and the expressions run on the calling thread,
+ * the products and the transpositions split the matrix in blocks of
+ * rows or columns. The threads of the pool are not bound to CPUs
+ * either, a slice is not always processed on the node it was touched
+ * from.
+ * The policies are hints, a machine which does not support one simply
+ * ignores it.
+ */
+
+
+/*!
+ * \brief The alignment of the values allocated by default, in bytes.
+ */
+const size_t matrix_default_alignment = 64 ;
+
+
+/*!
+ * \brief A standard allocator returning memory aligned on a given
+ * number of bytes, a power of 2 multiple of sizeof(void*).
+ */
+template<class T, size_t Alignment = matrix_default_alignment>
+class MatrixAlignedAllocator
+{
+    static_assert(Alignment >= sizeof(void*) and (Alignment & (Alignment - 1)) == 0,
+                  "the alignment should be a power of 2 multiple of sizeof(void*)") ;
+
+    public:
+        typedef T value_type ;
+        typedef T* pointer ;
+        typedef const T* const_pointer ;
+        typedef T& reference ;
+        typedef const T& const_reference ;
+        typedef size_t size_type ;
+        typedef ptrdiff_t difference_type ;
+
+        template<class U>
+        struct rebind
+        {   typedef MatrixAlignedAllocator<U, Alignment> other ; } ;
+
+        /*!
+         * \brief The alignment of the memory returned, in bytes.
+         */
+        static const size_t alignment = Alignment ;
+
+        MatrixAlignedAllocator() = default ;
+
+        template<class U>
+        MatrixAlignedAllocator(const MatrixAlignedAllocator<U, Alignment>&)
+        {}
+
+        /*!
+         * \brief Allocates the memory of n values, which are not
+         * constructed.
+         * \param n the number of values.
+         * \throw std::bad_alloc if the memory cannot be allocated.
+         * \return the address of the 1st value.
+         */
+        T* allocate(size_t n)
+        {   if(n > std::numeric_limits<size_t>::max() / sizeof(T))
+            {   throw std::bad_alloc() ; }
+            void* p = nullptr ;
+            if(n != 0 and posix_memalign(&p, Alignment, n*sizeof(T)) != 0)
+            {   throw std::bad_alloc() ; }
+            return static_cast<T*>(p) ;
+        }
+
+        /*!
+         * \brief Releases the memory allocated by allocate().
+         * \param p the address of the 1st value.
+         * \param n the number of values.
+         */
+        void deallocate(T* p, size_t)
+        {   free(p) ; }
+
+        template<class U>
+        bool operator == (const MatrixAlignedAllocator<U, Alignment>&) const
+        {   return true ; }
+
+        template<class U>
+        bool operator != (const MatrixAlignedAllocator<U, Alignment>&) const
+        {   return false ; }
+} ;
+
+template<class T, size_t Alignment>
+const size_t MatrixAlignedAllocator<T, Alignment>::alignment ;
+
+
+/*!
+ * \brief The flags of the policies of MatrixPageAllocator.
+ */
+const unsigned matrix_page_huge        = 1 ;
+const unsigned matrix_page_interleave  = 2 ;
+const unsigned matrix_page_first_touch = 4 ;
+
+/*!
+ * \brief The size of a huge page, the alignment of the large
+ * allocations of MatrixPageAllocator and the smallest size of
+ * such an allocation, in bytes.
+ */
+const size_t matrix_huge_page_size = 1 << 21 ;
+
+/*!
+ * \brief Interleaves the pages of a range of memory on all the
+ * NUMA nodes the process may use. The pages should not have been
+ * touched yet.
+ * \param p the address of the range, a multiple of the page size.
+ * \param size the size of the range, in bytes.
+ * \return whether the policy was set.
+ */
+inline bool interleave_matrix_pages(void* p, size_t size)
+{
+#if defined(__linux__) and defined(SYS_mbind) and defined(SYS_get_mempolicy)
+    // the values of numaif.h, which belongs to libnuma
+    const int mpol_interleave     = 3 ;
+    const unsigned long mpol_f_mems_allowed = 1 << 2 ;
+    const unsigned long max_node  = 1024 ;
+    unsigned long mask[max_node / (8*sizeof(unsigned long))] = {0} ;
+    if(syscall(SYS_get_mempolicy, nullptr, mask, max_node, nullptr, mpol_f_mems_allowed) != 0)
+    {   return false ; }
+    // the kernel reads max_node - 1 bits
+    return syscall(SYS_mbind, p, size, mpol_interleave, mask, max_node + 1, 0) == 0 ;
+#else
+    (void)p ;
+    (void)size ;
+    return false ;
+#endif
+}
+
+/*!
+ * \brief Touches the pages of a range of memory with the threads
+ * of a pool, in the contiguous slices in which parallel_for() splits
+ * the pages, so that the OS places each slice on the NUMA node of the
+ * thread which touched it.
+ * \param p the address of the range.
+ * \param size the size of the range, in bytes.
+ * \param pool the threads.
+ */
+inline void touch_matrix_pages(char* p, size_t size, ThreadPool& pool)
+{   const size_t page_size = 4096 ;
+    pool.parallel_for(0, (size + page_size - 1) / page_size,
+                      [p](size_t from, size_t to)
+                      {   for(size_t i=from; i<to; i++)
+                          {   p[i*page_size] = 0 ; }
+                      }) ;
+}
+
+
+/*!
+ * \brief A standard allocator placing the pages of the large
+ * allocations, of at least matrix_huge_page_size bytes, according
+ * to the given policies (see the top of this file). The smaller
+ * ones are aligned on 64 bytes.
+ *
+ * Matrix4D<double, MatrixPageAllocator<double>> m(dim1, dim2, dim3,
+ *                                                 dim4, 0.) ;
+ */
+template<class T, unsigned Flags = matrix_page_huge | matrix_page_first_touch>
+class MatrixPageAllocator
+{
+    public:
+        typedef T value_type ;
+        typedef T* pointer ;
+        typedef const T* const_pointer ;
+        typedef T& reference ;
+        typedef const T& const_reference ;
+        typedef size_t size_type ;
+        typedef ptrdiff_t difference_type ;
+
+        template<class U>
+        struct rebind
+        {   typedef MatrixPageAllocator<U, Flags> other ; } ;
+
+        MatrixPageAllocator() = default ;
+
+        template<class U>
+        MatrixPageAllocator(const MatrixPageAllocator<U, Flags>&)
+        {}
+
+        /*!
+         * \brief Allocates the memory of n values, which are not
+         * constructed.
+         * \param n the number of values.
+         * \throw std::bad_alloc if the memory cannot be allocated.
+         * \return the address of the 1st value.
+         */
+        T* allocate(size_t n)
+        {   if(n > std::numeric_limits<size_t>::max() / sizeof(T) - matrix_huge_page_size)
+            {   throw std::bad_alloc() ; }
+            size_t size = n*sizeof(T) ;
+            if(size < matrix_huge_page_size)
+            {   return MatrixAlignedAllocator<T>().allocate(n) ; }
+            size = get_map_size(size) ;
+#if defined(__linux__)
+            // mapped with a huge page of margin to align it
+            char* map = static_cast<char*>(mmap(nullptr, size + matrix_huge_page_size,
+                                                PROT_READ | PROT_WRITE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) ;
+            if(map == MAP_FAILED)
+            {   throw std::bad_alloc() ; }
+            uintptr_t address = reinterpret_cast<uintptr_t>(map) ;
+            size_t head = (matrix_huge_page_size - address % matrix_huge_page_size) % matrix_huge_page_size ;
+            if(head != 0)
+            {   munmap(map, head) ; }
+            if(matrix_huge_page_size != head)
+            {   munmap(map + head + size, matrix_huge_page_size - head) ; }
+            char* p = map + head ;
+#if defined(MADV_HUGEPAGE)
+            if(Flags & matrix_page_huge)
+            {   madvise(p, size, MADV_HUGEPAGE) ; }
+#endif
+#else
+            void* memory = nullptr ;
+            if(posix_memalign(&memory, matrix_huge_page_size, size) != 0)
+            {   throw std::bad_alloc() ; }
+            char* p = static_cast<char*>(memory) ;
+#endif
+            if(Flags & matrix_page_interleave)
+            {   interleave_matrix_pages(p, size) ; }
+            if(Flags & matrix_page_first_touch)
+            {   touch_matrix_pages(p, size, ThreadPool::get_default()) ; }
+            return reinterpret_cast<T*>(p) ;
+        }
+
+        /*!
+         * \brief Releases the memory allocated by allocate().
+         * \param p the address of the 1st value.
+         * \param n the number of values.
+         */
+        void deallocate(T* p, size_t n)
+        {   size_t size = n*sizeof(T) ;
+            if(size < matrix_huge_page_size)
+            {   MatrixAlignedAllocator<T>().deallocate(p, n) ;
+                return ;
+            }
+#if defined(__linux__)
+            munmap(p, get_map_size(size)) ;
+#else
+            free(p) ;
+#endif
+        }
+
+        template<class U>
+        bool operator == (const MatrixPageAllocator<U, Flags>&) const
+        {   return true ; }
+
+        template<class U>
+        bool operator != (const MatrixPageAllocator<U, Flags>&) const
+        {   return false ; }
+
+    private:
+        /*!
+         * \brief Gives the size of the memory mapped for a
+         * large allocation, a whole number of huge pages.
+         * \param size the size of the allocation, in bytes.
+         * \return the size mapped, in bytes.
+         */
+        static size_t get_map_size(size_t size)
+        {   return ((size + matrix_huge_page_size - 1) / matrix_huge_page_size) * matrix_huge_page_size ; }
+} ;
+
+
+/*!
+ * \brief An adaptor of a standard allocator which default-initializes
+ * the values constructed without any argument, instead of
+ * value-initializing them. The values of the arithmetic types are
+ * then left uninitialized, the memory is not written (and its pages
+ * are not touched) until the values are actually set, for instance
+ * by a matrix which values are all computed right after the
+ * allocation (see MatrixHeapStorage).
+ */
+template<class A>
+class MatrixDefaultInitAllocator : public A
+{
+    typedef std::allocator_traits<A> traits ;
+
+    public:
+        template<class U>
+        struct rebind
+        {   typedef MatrixDefaultInitAllocator<typename traits::template rebind_alloc<U>> other ; } ;
+
+        MatrixDefaultInitAllocator() = default ;
+
+        MatrixDefaultInitAllocator(const A& allocator)
+            : A(allocator)
+        {}
+
+        template<class B>
+        MatrixDefaultInitAllocator(const MatrixDefaultInitAllocator<B>& other)
+            : A(static_cast<const B&>(other))
+        {}
+
+        /*!
+         * \brief Default-initializes a value.
+         * \param p the address of the value.
+         */
+        template<class U>
+        void construct(U* p)
+        {   ::new(static_cast<void*>(p)) U ; }
+
+        /*!
+         * \brief Constructs a value with the given arguments,
+         * as the adapted allocator does.
+         * \param p the address of the value.
+         * \param args the arguments.
+         */
+        template<class U, class... Args>
+        void construct(U* p, Args&&... args)
+        {   traits::construct(static_cast<A&>(*this), p, std::forward<Args>(args)...) ; }
+} ;
+
+#endif // MATRIXALLOCATOR_HPP
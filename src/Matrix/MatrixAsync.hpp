@@ -0,0 +1,219 @@
+#ifndef MATRIXASYNC_HPP
+#define MATRIXASYNC_HPP
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <future>
+#include <memory>       // make_shared()
+#include <utility>      // move()
+#include <algorithm>    // max()
+#include <stdexcept>    // out_of_range
+
+#include "ThreadPool.hpp"
+#include "MatrixWriter.hpp"  // MatrixWriterFormat
+
+
+/*!
+ * The asynchronous accesses read and write the files of the matrices
+ * (Matrix2D, Matrix3D, Matrix4D, ...) in the threads of a pool, by
+ * default the I/O pool (ThreadPool::get_io()), so that the calling
+ * thread goes on computing while the disk is accessed :
+ * - load_async() and save_async() return a future on the matrix read
+ *   and on the end of the writing. The exceptions of load() and
+ *   save() are thrown by the get() method of the future.
+ * - a MatrixPrefetcher reads a list of files in order, keeping a given
+ *   number of files being read ahead of the matrix returned, so that
+ *   the files are read while the previous matrices are processed.
+ */
+
+
+/*!
+ * \brief Reads a matrix in a thread of a pool.
+ * \param file_address the path to the file.
+ * \param format the format of the file, the binary format being
+ * read with load() and the text format with the constructor of
+ * the matrix.
+ * \param pool the threads to use.
+ * \return a future on the matrix read.
+ */
+template<class M>
+std::future<M> load_async(const std::string& file_address,
+                          MatrixWriterFormat format = MatrixWriterFormat::binary,
+                          ThreadPool& pool = ThreadPool::get_io())
+{   return pool.add_job([file_address, format]() -> M
+                        {   if(format == MatrixWriterFormat::text)
+                            {   return M(file_address) ; }
+                            M m ;
+                            m.load(file_address) ;
+                            return m ;
+                        }) ;
+}
+
+
+/*!
+ * \brief Writes a matrix in a binary file (see Matrix::save()) in
+ * a thread of a pool. The matrix is moved (or copied) to the job,
+ * so that it does not need to outlive the call.
+ * \param m the matrix.
+ * \param file_address the path to the file.
+ * \param checksum whether to store a checksum of the values.
+ * \param pool the threads to use.
+ * \return a future signaling the end of the writing.
+ */
+template<class M>
+std::future<void> save_async(M m,
+                             const std::string& file_address,
+                             bool checksum = false,
+                             ThreadPool& pool = ThreadPool::get_io())
+{   std::shared_ptr<M> matrix = std::make_shared<M>(std::move(m)) ;
+    return pool.add_job([matrix, file_address, checksum]()
+                        {   matrix->save(file_address, checksum) ; }) ;
+}
+
+
+/*!
+ * \brief Reads the matrices of a list of files, in order, the next
+ * files being read in advance in the threads of a pool.
+ *
+ * for(MatrixPrefetcher<Matrix2D<double>> files(addresses) ;
+ *     files.has_next() ; )
+ * {   Matrix2D<double> m = files.next() ; ... }
+ */
+template<class M>
+class MatrixPrefetcher
+{
+    public:
+        /*!
+         * \brief Starts reading the 1st files.
+         * \param file_addresses the paths to the files.
+         * \param n_ahead the number of files being read at the
+         * same time, if 0 one file.
+         * \param format the format of the files (see
+         * load_async()).
+         * \param pool the threads to use.
+         */
+        MatrixPrefetcher(const std::vector<std::string>& file_addresses,
+                         size_t n_ahead = 2,
+                         MatrixWriterFormat format = MatrixWriterFormat::binary,
+                         ThreadPool& pool = ThreadPool::get_io()) ;
+
+        MatrixPrefetcher(const MatrixPrefetcher& other) = delete ;
+
+        /*!
+         * \brief Destructor, waits for the files being read.
+         */
+        ~MatrixPrefetcher() ;
+
+        MatrixPrefetcher& operator = (const MatrixPrefetcher& other) = delete ;
+
+        /*!
+         * \brief Whether matrices remain to be returned.
+         * \return whether next() can be called.
+         */
+        bool has_next() const ;
+
+        /*!
+         * \brief Returns the matrix of the next file, waiting for
+         * it to be read if needed, and starts reading the next
+         * file not read yet.
+         * \throw std::out_of_range if all the matrices have been
+         * returned.
+         * \throw the exceptions thrown while reading the file.
+         * \return the matrix.
+         */
+        M next() ;
+
+        /*!
+         * \brief Gets the index of the file of the next matrix.
+         * \return the index.
+         */
+        size_t get_file_index() const ;
+
+    private:
+        /*!
+         * \brief Starts reading files until n are being read or
+         * all have been.
+         * \param n the number of files.
+         */
+        void fill(size_t n) ;
+
+        /*!
+         * \brief The paths to the files.
+         */
+        std::vector<std::string> _file_addresses ;
+        /*!
+         * \brief The number of files read at the same time.
+         */
+        size_t _n_ahead ;
+        /*!
+         * \brief The format of the files.
+         */
+        MatrixWriterFormat _format ;
+        /*!
+         * \brief The threads reading the files.
+         */
+        ThreadPool& _pool ;
+        /*!
+         * \brief The matrices being read, in order.
+         */
+        std::deque<std::future<M>> _futures ;
+        /*!
+         * \brief The index of the next file to return and of the
+         * next file to start reading.
+         */
+        size_t _next = 0 ;
+        size_t _next_read = 0 ;
+} ;
+
+
+template<class M>
+MatrixPrefetcher<M>::MatrixPrefetcher(const std::vector<std::string>& file_addresses,
+                                      size_t n_ahead,
+                                      MatrixWriterFormat format,
+                                      ThreadPool& pool)
+    : _file_addresses(file_addresses),
+      _n_ahead(std::max(n_ahead, static_cast<size_t>(1))),
+      _format(format),
+      _pool(pool)
+{   this->fill(this->_n_ahead) ; }
+
+template<class M>
+MatrixPrefetcher<M>::~MatrixPrefetcher()
+{   for(auto& future : this->_futures)
+    {   future.wait() ; }
+}
+
+template<class M>
+bool MatrixPrefetcher<M>::has_next() const
+{   return this->_next < this->_file_addresses.size() ; }
+
+template<class M>
+M MatrixPrefetcher<M>::next()
+{   if(not this->has_next())
+    {   throw std::out_of_range("Error! all the files have been read") ; }
+    // the next file is read while this one is processed, started
+    // before this one is taken so that nothing changes if it fails
+    this->fill(this->_n_ahead + 1) ;
+    std::future<M> future = std::move(this->_futures.front()) ;
+    this->_futures.pop_front() ;
+    this->_next++ ;
+    return future.get() ;
+}
+
+template<class M>
+size_t MatrixPrefetcher<M>::get_file_index() const
+{   return this->_next ; }
+
+template<class M>
+void MatrixPrefetcher<M>::fill(size_t n)
+{   while(this->_futures.size() < n and
+          this->_next_read < this->_file_addresses.size())
+    {   this->_futures.push_back(load_async<M>(this->_file_addresses[this->_next_read],
+                                               this->_format,
+                                               this->_pool)) ;
+        this->_next_read++ ;
+    }
+}
+
+#endif // MATRIXASYNC_HPP
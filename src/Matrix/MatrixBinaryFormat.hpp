@@ -0,0 +1,880 @@
+#ifndef MATRIXBINARYFORMAT_HPP
+#define MATRIXBINARYFORMAT_HPP
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <numeric>     // accumulate()
+#include <functional>  // multiplies
+#include <algorithm>   // min(), reverse(), find()
+#include <type_traits> // is_integral, is_signed, is_arithmetic
+#include <limits>
+#include <cstddef>     // size_t
+#include <cstdint>     // uint32_t, uint64_t
+#include <cstdio>      // sprintf()
+#include <cstring>     // memcpy(), memcmp()
+#include <stdexcept>   // runtime_error
+#include <cerrno>      // errno
+
+#include "MatrixIOEngine.hpp"  // pread_matrix_binary(), MatrixIOEngine
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+
+/*!
+ * The binary files written by Matrix::save() have the following
+ * layout (version 2). All the header fields are written in the byte
+ * order of the machine which wrote the file, which is given by the
+ * byte order mark :
+ * 8x char   : the magic number "\x89MATRIX\n".
+ * 1x uint32 : the byte order mark, 0x01020304.
+ * 1x uint32 : the version of the format, 2.
+ * 1x uint32 : the type of the values, see MatrixTypeId.
+ * 1x uint32 : the size of a value, in bytes.
+ * 1x uint32 : the flags, 1 if a checksum of the values is stored.
+ * 1x uint32 : the CRC32C checksum of the values, or 0.
+ * 1x uint64 : the number <N> of dimensions of the matrix.
+ * 1x uint64 : the offset of the values from the beginning of the
+ *             file, in bytes. It is a multiple of the page size
+ *             (4096) so that the values can be mapped in memory.
+ * 1x uint64 : the size of the values, in bytes.
+ * Nx uint64 : the width of the matrix in each dimension, as stored
+ *             in the _dim vector.
+ * zeros up to the offset of the values.
+ * Dx <T>    : the <D> values of the matrix, in the _data order.
+ *
+ * The files written before this format, the legacy layout, only
+ * contain :
+ * 1x size_t : the number <N> of dimensions.
+ * Nx size_t : the width of the matrix in each dimension.
+ * Dx <T>    : the <D> values.
+ * They are still read, their values being assumed of the type of
+ * the matrix they are read into.
+ *
+ * A file can be loaded into a matrix of another type if this type
+ * can represent all the values of the type of the file (an int16
+ * file can be loaded as int or double, a float file as double but
+ * not the opposite) and a file written on a machine with another
+ * byte order can be loaded, the bytes being swapped. Mapping a
+ * file in memory requires the exact type and byte order.
+ *
+ * A region of a matrix can be read without reading the rest of the
+ * file : the region is made of runs of values which are contiguous
+ * in the file (get_matrix_binary_runs()), the runs which are close to
+ * each other in the file are read at once (read_matrix_binary_runs()).
+ *
+ * The files are read and written through a MatrixIOEngine (see
+ * MatrixIOEngine.hpp), which keeps many reads or writes in flight
+ * with io_uring where available and uses pread() and pwrite()
+ * otherwise.
+ */
+
+
+/*!
+ * \brief The alignment of the values in the files, in bytes.
+ */
+const size_t matrix_binary_alignment = 4096 ;
+
+/*!
+ * \brief The version of the format written.
+ */
+const uint32_t matrix_binary_version = 2 ;
+
+/*!
+ * \brief The byte order mark, as written.
+ */
+const uint32_t matrix_binary_bom = 0x01020304 ;
+
+/*!
+ * \brief The flag telling that a checksum is stored.
+ */
+const uint32_t matrix_binary_flag_crc = 1 ;
+
+/*!
+ * \brief The magic number at the beginning of the files.
+ */
+const char matrix_binary_magic[8] = {'\x89', 'M', 'A', 'T', 'R', 'I', 'X', '\n'} ;
+
+/*!
+ * \brief The size of the header fields before the dimensions.
+ */
+const size_t matrix_binary_header_size = 56 ;
+
+
+/*!
+ * \brief The types of the values stored in the files.
+ */
+enum class MatrixTypeId : uint32_t
+{   unknown     = 0,
+    int8        = 1,
+    uint8       = 2,
+    int16       = 3,
+    uint16      = 4,
+    int32       = 5,
+    uint32      = 6,
+    int64       = 7,
+    uint64      = 8,
+    float32     = 9,
+    float64     = 10,
+    long_double = 11,
+    character   = 12
+} ;
+
+
+/*!
+ * \brief Gives the type id of an integer type.
+ * \param size the size of the type in bytes.
+ * \param is_signed whether the type is signed.
+ * \return the type id.
+ */
+constexpr MatrixTypeId get_matrix_integer_type_id(size_t size, bool is_signed)
+{   return size == 1 ? (is_signed ? MatrixTypeId::int8  : MatrixTypeId::uint8)  :
+           size == 2 ? (is_signed ? MatrixTypeId::int16 : MatrixTypeId::uint16) :
+           size == 4 ? (is_signed ? MatrixTypeId::int32 : MatrixTypeId::uint32) :
+           size == 8 ? (is_signed ? MatrixTypeId::int64 : MatrixTypeId::uint64) :
+           MatrixTypeId::unknown ;
+}
+
+/*!
+ * \brief Gives the type id of a type of values.
+ */
+template<class T>
+struct matrix_type_id
+{   static const MatrixTypeId value =
+        std::is_same<T,char>::value        ? MatrixTypeId::character :
+        std::is_same<T,bool>::value        ? MatrixTypeId::unknown :
+        std::is_integral<T>::value         ? get_matrix_integer_type_id(sizeof(T), std::is_signed<T>::value) :
+        std::is_same<T,float>::value       ? MatrixTypeId::float32 :
+        std::is_same<T,double>::value      ? MatrixTypeId::float64 :
+        std::is_same<T,long double>::value ? MatrixTypeId::long_double :
+        MatrixTypeId::unknown ;
+} ;
+
+
+/*!
+ * \brief Describes a type of values.
+ */
+struct MatrixTypeInfo
+{   /*!
+     * \brief The name of the type.
+     */
+    const char* name ;
+    /*!
+     * \brief The size of a value in bytes, 0 if unknown.
+     */
+    size_t size ;
+    /*!
+     * \brief Whether the type is an integer type and whether
+     * it is signed.
+     */
+    bool is_integer ;
+    bool is_signed ;
+    /*!
+     * \brief The number of bits of the values, without the
+     * sign (of the mantissa for the floating point types).
+     */
+    int digits ;
+} ;
+
+/*!
+ * \brief Describes a type of values.
+ * \param id the type id.
+ * \return the description of the type.
+ */
+inline MatrixTypeInfo get_matrix_type_info(MatrixTypeId id)
+{   switch(id)
+    {   case MatrixTypeId::int8        : return {"int8",        1, true,  true,  7} ;
+        case MatrixTypeId::uint8       : return {"uint8",       1, true,  false, 8} ;
+        case MatrixTypeId::int16       : return {"int16",       2, true,  true,  15} ;
+        case MatrixTypeId::uint16      : return {"uint16",      2, true,  false, 16} ;
+        case MatrixTypeId::int32       : return {"int32",       4, true,  true,  31} ;
+        case MatrixTypeId::uint32      : return {"uint32",      4, true,  false, 32} ;
+        case MatrixTypeId::int64       : return {"int64",       8, true,  true,  63} ;
+        case MatrixTypeId::uint64      : return {"uint64",      8, true,  false, 64} ;
+        case MatrixTypeId::float32     : return {"float32",     4, false, true,  24} ;
+        case MatrixTypeId::float64     : return {"float64",     8, false, true,  53} ;
+        case MatrixTypeId::long_double : return {"long double", sizeof(long double), false, true,
+                                                 std::numeric_limits<long double>::digits} ;
+        case MatrixTypeId::character   : return {"char",        1, false, false, 0} ;
+        default                        : return {"unknown",     0, false, false, 0} ;
+    }
+}
+
+/*!
+ * \brief Checks whether all the values of a type can be
+ * represented by another type.
+ * \param from the type of the values.
+ * \param to the type to convert the values to.
+ * \return whether the values can be converted without loss.
+ */
+inline bool is_matrix_type_widening(MatrixTypeId from, MatrixTypeId to)
+{   if(from == to)
+    {   return true ; }
+    if(from == MatrixTypeId::unknown or from == MatrixTypeId::character or
+       to   == MatrixTypeId::unknown or to   == MatrixTypeId::character)
+    {   return false ; }
+    MatrixTypeInfo info_from = get_matrix_type_info(from) ;
+    MatrixTypeInfo info_to   = get_matrix_type_info(to) ;
+    if(info_to.is_integer)
+    {   return info_from.is_integer and
+               info_to.digits >= info_from.digits and
+               (info_to.is_signed or not info_from.is_signed) ;
+    }
+    return info_to.digits >= info_from.digits ;
+}
+
+
+/*!
+ * \brief Computes the CRC32C (Castagnoli) checksum of a range
+ * of bytes, with the SSE4.2 crc32 instruction if available.
+ * \param data the address of the 1st byte.
+ * \param n the number of bytes.
+ * \param crc the checksum of the bytes preceding the range, to
+ * compute a checksum in several parts.
+ * \return the checksum.
+ */
+inline uint32_t crc32c(const void* data, size_t n, uint32_t crc=0)
+{   const unsigned char* p = static_cast<const unsigned char*>(data) ;
+    crc = ~crc ;
+#if defined(__SSE4_2__)
+    uint64_t crc64 = crc ;
+    for(; n >= 8; n-=8, p+=8)
+    {   uint64_t word ;
+        memcpy(&word, p, sizeof(word)) ;
+        crc64 = _mm_crc32_u64(crc64, word) ;
+    }
+    crc = static_cast<uint32_t>(crc64) ;
+    for(; n > 0; n--, p++)
+    {   crc = _mm_crc32_u8(crc, *p) ; }
+#else
+    // the reflected polynomial 0x1EDC6F41, one byte at a time
+    static const std::vector<uint32_t> table = []()
+                                               {   std::vector<uint32_t> t(256) ;
+                                                   for(uint32_t i=0; i<256; i++)
+                                                   {   uint32_t c = i ;
+                                                       for(int k=0; k<8; k++)
+                                                       {   c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : (c >> 1) ; }
+                                                       t[i] = c ;
+                                                   }
+                                                   return t ;
+                                               }() ;
+    for(; n > 0; n--, p++)
+    {   crc = table[(crc ^ *p) & 0xff] ^ (crc >> 8) ; }
+#endif
+    return ~crc ;
+}
+
+
+/*!
+ * \brief Reverses the bytes of a value.
+ * \param value the value.
+ * \return the value with its bytes reversed.
+ */
+template<class U>
+U swap_matrix_bytes(U value)
+{   char bytes[sizeof(U)] ;
+    memcpy(bytes, &value, sizeof(U)) ;
+    std::reverse(bytes, bytes + sizeof(U)) ;
+    memcpy(&value, bytes, sizeof(U)) ;
+    return value ;
+}
+
+
+/*!
+ * \brief The content of the header of a binary file.
+ */
+struct MatrixBinaryHeader
+{   /*!
+     * \brief The version of the format, 1 for the legacy
+     * layout.
+     */
+    uint32_t version = matrix_binary_version ;
+    /*!
+     * \brief Whether the file was written with the other
+     * byte order.
+     */
+    bool swap = false ;
+    /*!
+     * \brief The type of the values and their size.
+     */
+    MatrixTypeId type_id = MatrixTypeId::unknown ;
+    uint32_t type_size = 0 ;
+    /*!
+     * \brief Whether a checksum is stored, and its value.
+     */
+    bool has_crc = false ;
+    uint32_t crc = 0 ;
+    /*!
+     * \brief The dimensions, as stored in the _dim vector.
+     */
+    std::vector<size_t> dim ;
+    /*!
+     * \brief The offset and the size of the values in the
+     * file, in bytes.
+     */
+    uint64_t data_offset = 0 ;
+    uint64_t data_size = 0 ;
+
+    /*!
+     * \brief Gets the number of values.
+     * \return the number of values.
+     */
+    size_t get_value_number() const
+    {   return std::accumulate(this->dim.begin(), this->dim.end(), (size_t)1, std::multiplies<size_t>()) ; }
+} ;
+
+
+/*!
+ * \brief Creates the header of a file storing the values of
+ * type T of a matrix.
+ * \param dim the dimensions, as stored in the _dim vector.
+ * \return the header, without checksum.
+ */
+template<class T>
+MatrixBinaryHeader make_matrix_binary_header(const std::vector<size_t>& dim)
+{   MatrixBinaryHeader header ;
+    header.type_id   = matrix_type_id<T>::value ;
+    header.type_size = sizeof(T) ;
+    header.dim       = dim ;
+    size_t size      = matrix_binary_header_size + dim.size()*sizeof(uint64_t) ;
+    header.data_offset = ((size + matrix_binary_alignment - 1) / matrix_binary_alignment) * matrix_binary_alignment ;
+    header.data_size   = header.get_value_number() * sizeof(T) ;
+    return header ;
+}
+
+/*!
+ * \brief Encodes a header, in the byte order of the machine.
+ * \param header the header.
+ * \return the bytes of the file up to the values, the header
+ * followed by zeros.
+ */
+inline std::vector<char> encode_matrix_binary_header(const MatrixBinaryHeader& header)
+{   std::vector<char> bytes(header.data_offset, 0) ;
+    uint32_t fields_32[] = {matrix_binary_bom,
+                            header.version,
+                            static_cast<uint32_t>(header.type_id),
+                            header.type_size,
+                            header.has_crc ? matrix_binary_flag_crc : 0,
+                            header.crc} ;
+    uint64_t fields_64[] = {header.dim.size(), header.data_offset, header.data_size} ;
+    char* p = bytes.data() ;
+    memcpy(p, matrix_binary_magic, sizeof(matrix_binary_magic)) ;
+    p += sizeof(matrix_binary_magic) ;
+    memcpy(p, fields_32, sizeof(fields_32)) ;
+    p += sizeof(fields_32) ;
+    memcpy(p, fields_64, sizeof(fields_64)) ;
+    p += sizeof(fields_64) ;
+    for(auto d : header.dim)
+    {   uint64_t d64 = d ;
+        memcpy(p, &d64, sizeof(d64)) ;
+        p += sizeof(d64) ;
+    }
+    return bytes ;
+}
+
+/*!
+ * \brief Checks the number of dimensions of a file.
+ * \param dim_size the number of dimensions stored in the file.
+ * \param dim_n the expected number of dimensions, any if 0.
+ * \param file_address the path to the file, for the messages.
+ * \throw std::runtime_error if they differ.
+ */
+inline void check_matrix_binary_dim_number(uint64_t dim_size, size_t dim_n, const std::string& file_address)
+{   if(dim_n != 0 and dim_size != dim_n)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! Invalid number of dimensions (%llu) found in %s",
+                static_cast<unsigned long long>(dim_size),
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+/*!
+ * \brief Computes the number of bytes of the values of a matrix,
+ * without overflowing.
+ * \param dim the dimensions.
+ * \param type_size the size of a value, in bytes.
+ * \param data_size where the number of bytes is stored.
+ * \return false if the number of bytes does not fit in a size_t.
+ */
+inline bool get_matrix_binary_data_size(const std::vector<size_t>& dim, size_t type_size, uint64_t& data_size)
+{   size_t n = 1 ;
+    for(auto d : dim)
+    {   if(d != 0 and n > std::numeric_limits<size_t>::max() / d)
+        {   return false ; }
+        n *= d ;
+    }
+    if(type_size != 0 and n > std::numeric_limits<size_t>::max() / type_size)
+    {   return false ; }
+    data_size = n * type_size ;
+    return true ;
+}
+
+/*!
+ * \brief Reads the header of a binary file, in the current or in
+ * the legacy layout. The values of a legacy file are assumed to
+ * be of type T.
+ * \param read a function read(void* dst, size_t n) copying the
+ * next n bytes of the file to dst, returning false if the file is
+ * too short.
+ * \param file_address the path to the file, for the messages.
+ * \param dim_n the expected number of dimensions, any if 0.
+ * \param file_size the size of the file, in bytes.
+ * \return the header.
+ * \throw std::runtime_error if the header is invalid, if it does
+ * not have dim_n dimensions or if it describes more data than the
+ * file contains.
+ */
+template<class T, class F>
+MatrixBinaryHeader read_matrix_binary_header(F read,
+                                             const std::string& file_address,
+                                             size_t dim_n = 0,
+                                             uint64_t file_size = std::numeric_limits<uint64_t>::max())
+{   MatrixBinaryHeader header ;
+    char msg[4096] ;
+
+    char magic[sizeof(matrix_binary_magic)] ;
+    if(not read(magic, sizeof(magic)))
+    {   sprintf(msg, "Error! something occured while reading number of dimensions in %s",
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+
+    // legacy layout, the magic number was the number of dimensions
+    if(memcmp(magic, matrix_binary_magic, sizeof(magic)) != 0)
+    {   size_t dim_size ;
+        memcpy(&dim_size, magic, sizeof(size_t)) ;
+        // any file which is not a matrix ends here, before allocating
+        check_matrix_binary_dim_number(dim_size, dim_n, file_address) ;
+        if(dim_size > file_size / sizeof(size_t) - 1)
+        {   sprintf(msg, "Error! something occured while reading dimensions in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        header.version   = 1 ;
+        header.type_id   = matrix_type_id<T>::value ;
+        header.type_size = sizeof(T) ;
+        header.dim       = std::vector<size_t>(dim_size) ;
+        if(not read(header.dim.data(), dim_size*sizeof(size_t)))
+        {   sprintf(msg, "Error! something occured while reading dimensions in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        header.data_offset = (dim_size + 1)*sizeof(size_t) ;
+        if(not get_matrix_binary_data_size(header.dim, sizeof(T), header.data_size) or
+           header.data_size > file_size - header.data_offset)
+        {   sprintf(msg, "Error! the size of the data does not match the dimensions in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        return header ;
+    }
+
+    uint32_t fields_32[6] ;
+    uint64_t fields_64[3] ;
+    if(not read(fields_32, sizeof(fields_32)) or not read(fields_64, sizeof(fields_64)))
+    {   sprintf(msg, "Error! something occured while reading number of dimensions in %s",
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    if(fields_32[0] == swap_matrix_bytes(matrix_binary_bom))
+    {   header.swap = true ;
+        for(auto& field : fields_32)
+        {   field = swap_matrix_bytes(field) ; }
+        for(auto& field : fields_64)
+        {   field = swap_matrix_bytes(field) ; }
+    }
+    else if(fields_32[0] != matrix_binary_bom)
+    {   sprintf(msg, "Error! invalid byte order mark in %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    header.version = fields_32[1] ;
+    if(header.version != matrix_binary_version)
+    {   sprintf(msg, "Error! unsupported binary format version (%u) in %s",
+                static_cast<unsigned int>(header.version),
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    header.type_id     = static_cast<MatrixTypeId>(fields_32[2]) ;
+    header.type_size   = fields_32[3] ;
+    header.has_crc     = (fields_32[4] & matrix_binary_flag_crc) != 0 ;
+    header.crc         = fields_32[5] ;
+    header.data_offset = fields_64[1] ;
+    header.data_size   = fields_64[2] ;
+
+    // read dimensions
+    uint64_t dim_size = fields_64[0] ;
+    check_matrix_binary_dim_number(dim_size, dim_n, file_address) ;
+    if(header.data_offset < matrix_binary_header_size or
+       header.data_offset > file_size or
+       dim_size > (header.data_offset - matrix_binary_header_size) / sizeof(uint64_t))
+    {   sprintf(msg, "Error! something occured while reading dimensions in %s",
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    header.dim = std::vector<size_t>(dim_size) ;
+    for(auto& d : header.dim)
+    {   uint64_t d64 ;
+        if(not read(&d64, sizeof(d64)))
+        {   sprintf(msg, "Error! something occured while reading dimensions in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        d = static_cast<size_t>(header.swap ? swap_matrix_bytes(d64) : d64) ;
+    }
+
+    uint64_t data_size = 0 ;
+    if(header.type_size == 0 or
+       not get_matrix_binary_data_size(header.dim, header.type_size, data_size) or
+       header.data_size != data_size or
+       header.data_size > file_size - header.data_offset)
+    {   sprintf(msg, "Error! the size of the data does not match the dimensions in %s",
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    return header ;
+}
+
+
+/*!
+ * \brief Checks that the values of a file can be loaded as
+ * values of type T.
+ * \param header the header of the file.
+ * \param file_address the path to the file, for the messages.
+ * \throw std::runtime_error if they cannot.
+ */
+template<class T>
+void check_matrix_binary_load(const MatrixBinaryHeader& header, const std::string& file_address)
+{   MatrixTypeId id = matrix_type_id<T>::value ;
+    MatrixTypeInfo info_file = get_matrix_type_info(header.type_id) ;
+    char msg[4096] ;
+    if(info_file.size != 0 and info_file.size != header.type_size)
+    {   sprintf(msg, "Error! invalid size of the %s values (%u bytes) in %s",
+                info_file.name,
+                static_cast<unsigned int>(header.type_size),
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    // the values of an unknown type can only be copied as they are
+    bool same = header.type_id == id and header.type_size == sizeof(T) ;
+    if((same and (id != MatrixTypeId::unknown or not header.swap)) or
+       (not same and is_matrix_type_widening(header.type_id, id)))
+    {   return ; }
+    sprintf(msg, "Error! the %s values of %s cannot be loaded as %s values",
+            info_file.name,
+            file_address.c_str(),
+            get_matrix_type_info(id).name) ;
+    throw std::runtime_error(msg) ;
+}
+
+/*!
+ * \brief Checks that the values of a file can be mapped in
+ * memory as values of type T.
+ * \param header the header of the file.
+ * \param file_address the path to the file, for the messages.
+ * \throw std::runtime_error if they cannot.
+ */
+template<class T>
+void check_matrix_binary_map(const MatrixBinaryHeader& header, const std::string& file_address)
+{   MatrixTypeId id = matrix_type_id<T>::value ;
+    if(header.type_id == id and header.type_size == sizeof(T) and not header.swap)
+    {   return ; }
+    char msg[4096] ;
+    sprintf(msg, "Error! the %s values of %s cannot be mapped as %s values%s, they should be loaded",
+            get_matrix_type_info(header.type_id).name,
+            file_address.c_str(),
+            get_matrix_type_info(id).name,
+            header.swap ? " (other byte order)" : "") ;
+    throw std::runtime_error(msg) ;
+}
+
+
+/*!
+ * \brief Converts values of type S, read from a file, to
+ * values of type T.
+ */
+template<class S, class T, bool convertible = std::is_arithmetic<T>::value>
+struct matrix_binary_converter
+{   /*!
+     * \brief Converts values.
+     * \param src the bytes of the values.
+     * \param n the number of values.
+     * \param swap whether the bytes of the values should be
+     * reversed.
+     * \param dst where to store the values.
+     */
+    static void convert(const char* src, size_t n, bool swap, T* dst)
+    {   for(size_t i=0; i<n; i++)
+        {   S value ;
+            memcpy(&value, src + i*sizeof(S), sizeof(S)) ;
+            if(swap)
+            {   value = swap_matrix_bytes(value) ; }
+            dst[i] = static_cast<T>(value) ;
+        }
+    }
+} ;
+
+/*!
+ * \brief The types which are not arithmetic types cannot
+ * be converted.
+ */
+template<class S, class T>
+struct matrix_binary_converter<S, T, false>
+{   static void convert(const char*, size_t, bool, T*)
+    {   throw std::runtime_error("error! the values cannot be converted") ; }
+} ;
+
+/*!
+ * \brief Converts values read from a file to values of
+ * type T, see check_matrix_binary_load().
+ * \param id the type of the values in the file.
+ * \param swap whether the bytes of the values should be
+ * reversed.
+ * \param src the bytes of the values.
+ * \param n the number of values.
+ * \param dst where to store the values.
+ */
+template<class T>
+void convert_matrix_binary_values(MatrixTypeId id, bool swap, const char* src, size_t n, T* dst)
+{   switch(id)
+    {   case MatrixTypeId::int8        : matrix_binary_converter<int8_t,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::uint8       : matrix_binary_converter<uint8_t,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::int16       : matrix_binary_converter<int16_t,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::uint16      : matrix_binary_converter<uint16_t,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::int32       : matrix_binary_converter<int32_t,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::uint32      : matrix_binary_converter<uint32_t,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::int64       : matrix_binary_converter<int64_t,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::uint64      : matrix_binary_converter<uint64_t,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::float32     : matrix_binary_converter<float,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::float64     : matrix_binary_converter<double,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::long_double : matrix_binary_converter<long double,T>::convert(src, n, swap, dst) ; break ;
+        case MatrixTypeId::character   : matrix_binary_converter<char,T>::convert(src, n, swap, dst) ; break ;
+        default : throw std::runtime_error("error! the values cannot be converted") ;
+    }
+}
+
+/*!
+ * \brief Reads the values of a binary file. If the file values
+ * have the type and byte order of T, they are read directly,
+ * otherwise they are read by chunks, swapped and converted.
+ * \param engine the engine reading the file.
+ * \param fd the file descriptor.
+ * \param header the header of the file, see
+ * check_matrix_binary_load().
+ * \param values where to store the values.
+ * \param n the number of values.
+ * \param crc where to store the checksum of the bytes read, it
+ * is only computed if the header contains a checksum.
+ * \return whether the values could be read.
+ */
+template<class T>
+bool read_matrix_binary_values(MatrixIOEngine& engine,
+                               int fd,
+                               const MatrixBinaryHeader& header,
+                               T* values,
+                               size_t n,
+                               uint32_t& crc)
+{   crc = 0 ;
+    if(header.type_id == matrix_type_id<T>::value and header.type_size == sizeof(T) and not header.swap)
+    {   if(not engine.read(fd, reinterpret_cast<char*>(values), n*sizeof(T), header.data_offset))
+        {   return false ; }
+        if(header.has_crc)
+        {   crc = crc32c(values, n*sizeof(T)) ; }
+        return true ;
+    }
+    // chunks large enough to keep the engine queue busy
+    size_t chunk_size = std::max(static_cast<size_t>(1), (engine.get_queue_depth()*engine.get_block_size()) / header.type_size) ;
+    std::vector<char> buffer(std::min(chunk_size, n) * header.type_size) ;
+    for(size_t i=0; i<n; i+=chunk_size)
+    {   size_t m = std::min(chunk_size, n - i) ;
+        if(not engine.read(fd, buffer.data(), m*header.type_size, header.data_offset + i*header.type_size))
+        {   return false ; }
+        if(header.has_crc)
+        {   crc = crc32c(buffer.data(), m*header.type_size, crc) ; }
+        convert_matrix_binary_values(header.type_id, header.swap, buffer.data(), m, values + i) ;
+    }
+    return true ;
+}
+
+
+/*!
+ * \brief A run of values which are contiguous both in the
+ * file and in the region read.
+ */
+struct MatrixBinaryRun
+{   /*!
+     * \brief The offset of the 1st value of the run in the
+     * matrix stored in the file, in number of values.
+     */
+    size_t file_offset ;
+    /*!
+     * \brief The offset of the 1st value of the run in the
+     * region, in number of values.
+     */
+    size_t region_offset ;
+    /*!
+     * \brief The number of values.
+     */
+    size_t size ;
+} ;
+
+/*!
+ * \brief Lists the runs of values making a region of a matrix,
+ * in the order of the file. The leading dimensions which are
+ * entirely covered by the region are merged in a single run.
+ * \param dim the dimensions of the matrix, as stored in the
+ * _dim vector.
+ * \param origin the coordinates of the 1st value of the region,
+ * in the same order.
+ * \param extent the dimensions of the region, in the same order.
+ * \return the runs.
+ */
+inline std::vector<MatrixBinaryRun> get_matrix_binary_runs(const std::vector<size_t>& dim,
+                                                          const std::vector<size_t>& origin,
+                                                          const std::vector<size_t>& extent)
+{   std::vector<MatrixBinaryRun> runs ;
+    size_t n = dim.size() ;
+    if(n == 0 or std::find(extent.begin(), extent.end(), (size_t)0) != extent.end())
+    {   return runs ; }
+    std::vector<size_t> dim_prod(n, 1) ;
+    for(size_t i=1; i<n; i++)
+    {   dim_prod[i] = dim_prod[i-1] * dim[i-1] ; }
+
+    // the dimensions merged in a run : all those entirely covered and the next one
+    size_t run_dim  = 0 ;
+    size_t run_size = extent[0] ;
+    while(run_dim+1 < n and extent[run_dim] == dim[run_dim])
+    {   run_dim++ ;
+        run_size *= extent[run_dim] ;
+    }
+    size_t file_offset = 0 ;
+    for(size_t i=0; i<n; i++)
+    {   file_offset += origin[i] * dim_prod[i] ; }
+
+    // iterates over the coordinates of the other dimensions, the last one varying slowest
+    std::vector<size_t> coord(n, 0) ;
+    size_t region_offset = 0 ;
+    while(true)
+    {   runs.push_back({file_offset, region_offset, run_size}) ;
+        region_offset += run_size ;
+        size_t i = run_dim + 1 ;
+        for(; i<n; i++)
+        {   if(++coord[i] < extent[i])
+            {   file_offset += dim_prod[i] ;
+                break ;
+            }
+            file_offset -= (extent[i] - 1) * dim_prod[i] ;
+            coord[i] = 0 ;
+        }
+        if(i == n)
+        {   break ; }
+    }
+    return runs ;
+}
+
+/*!
+ * \brief Reads runs of values of a binary file. The runs which are
+ * contiguous or separated by less than max_gap bytes are read at
+ * once, the bytes in between being skipped, as long as a read does
+ * not exceed max_read bytes. If the values are of type T in the
+ * byte order of the machine, a read made of a single run is done
+ * directly in the destination. The reads are given to the engine
+ * by batches, which it keeps in flight together, the reads through
+ * a buffer of a batch not exceeding max_read bytes in total unless
+ * a single read is larger.
+ * \param fd the file descriptor.
+ * \param header the header of the file, see
+ * check_matrix_binary_load().
+ * \param runs the runs, in the order of the file.
+ * \param values where to store the values of the region.
+ * \param max_gap the largest number of bytes between two runs
+ * read at once.
+ * \param max_read the largest number of bytes read at once,
+ * unless a run is larger.
+ * \param engine the engine reading the file.
+ * \return whether all the runs could be read.
+ */
+template<class T>
+bool read_matrix_binary_runs(int fd,
+                             const MatrixBinaryHeader& header,
+                             const std::vector<MatrixBinaryRun>& runs,
+                             T* values,
+                             size_t max_gap=(1 << 16),
+                             size_t max_read=(1 << 24),
+                             MatrixIOEngine& engine=MatrixIOEngine::get_default())
+{   bool direct = header.type_id == matrix_type_id<T>::value and
+                  header.type_size == sizeof(T) and
+                  not header.swap ;
+    size_t type_size = header.type_size ;
+    std::vector<char> buffer ;
+    // the reads of the batch, each with its first and last runs
+    // and its offset in the buffer (-1 if read in place)
+    struct Read
+    {   size_t first ;
+        size_t last ;
+        size_t begin ;
+        size_t end ;
+        size_t buffer_offset ;
+    } ;
+    std::vector<Read> reads ;
+    size_t buffer_size = 0 ;
+    auto flush = [&]() -> bool
+                 {   buffer.resize(buffer_size) ;
+                     std::vector<MatrixIORequest> requests ;
+                     for(const auto& read : reads)
+                     {   char* dst = (read.buffer_offset == static_cast<size_t>(-1)) ?
+                                     reinterpret_cast<char*>(values + runs[read.first].region_offset) :
+                                     buffer.data() + read.buffer_offset ;
+                         requests.push_back(MatrixIORequest{fd, dst, read.end - read.begin, header.data_offset + read.begin}) ;
+                     }
+                     if(not engine.read(requests))
+                     {   return false ; }
+                     for(const auto& read : reads)
+                     {   if(read.buffer_offset == static_cast<size_t>(-1))
+                         {   continue ; }
+                         for(size_t i=read.first; i<=read.last; i++)
+                         {   const char* src = buffer.data() + read.buffer_offset + runs[i].file_offset * type_size - read.begin ;
+                             T* dst = values + runs[i].region_offset ;
+                             if(direct)
+                             {   memcpy(dst, src, runs[i].size * sizeof(T)) ; }
+                             else
+                             {   convert_matrix_binary_values(header.type_id, header.swap, src, runs[i].size, dst) ; }
+                         }
+                     }
+                     reads.clear() ;
+                     buffer_size = 0 ;
+                     return true ;
+                 } ;
+
+    for(size_t first=0; first<runs.size(); )
+    {   // extends the read as long as the next run is close enough
+        size_t last  = first ;
+        size_t begin = runs[first].file_offset * type_size ;
+        size_t end   = begin + runs[first].size * type_size ;
+        while(last+1 < runs.size())
+        {   size_t next_begin = runs[last+1].file_offset * type_size ;
+            size_t next_end   = next_begin + runs[last+1].size * type_size ;
+            if(next_begin < end or next_begin - end > max_gap or next_end - begin > max_read)
+            {   break ; }
+            end = next_end ;
+            last++ ;
+        }
+
+        if(direct and first == last)
+        {   reads.push_back(Read{first, last, begin, end, static_cast<size_t>(-1)}) ; }
+        else
+        {   if(buffer_size != 0 and buffer_size + (end - begin) > max_read)
+            {   if(not flush())
+                {   return false ; }
+            }
+            reads.push_back(Read{first, last, begin, end, buffer_size}) ;
+            buffer_size += end - begin ;
+        }
+        first = last + 1 ;
+    }
+    return flush() ;
+}
+
+#endif // MATRIXBINARYFORMAT_HPP
@@ -0,0 +1,1058 @@
+#ifndef MATRIXCHUNKEDFILE_HPP
+#define MATRIXCHUNKEDFILE_HPP
+
+#include <vector>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <fstream>
+#include <numeric>     // accumulate()
+#include <functional>  // multiplies
+#include <algorithm>   // min(), max(), copy(), fill(), sort()
+#include <utility>     // swap(), move()
+#include <cstddef>     // size_t
+#include <cstdint>     // uint32_t, uint64_t
+#include <cstdio>      // sprintf()
+#include <cstring>     // memcpy(), memcmp()
+#include <stdexcept>   // runtime_error, invalid_argument, out_of_range
+
+#include <fcntl.h>     // open()
+#include <unistd.h>    // close()
+#include <sys/stat.h>  // fstat()
+
+#include "MatrixBinaryFormat.hpp"
+
+
+/*!
+ * The chunked files split a matrix in chunks of fixed dimensions, the
+ * blocks of the matrix starting at multiples of the chunk dimensions,
+ * which are stored independently, like the chunked datasets of Zarr or
+ * HDF5. A chunk can be read or rewritten without touching the rest of
+ * the file. They have the following layout, all the fields being
+ * written in the byte order of the machine which wrote the file :
+ * 8x char   : the magic number "\x89MCHUNK\n".
+ * 1x uint32 : the byte order mark, 0x01020304.
+ * 1x uint32 : the version of the format, 1.
+ * 1x uint32 : the type of the values, see MatrixTypeId.
+ * 1x uint32 : the size of a value, in bytes.
+ * 1x uint64 : the number <N> of dimensions of the matrix.
+ * 1x uint64 : the offset of the chunk index from the beginning of
+ *             the file, in bytes.
+ * 1x uint64 : the offset of the 1st chunk, a multiple of the page
+ *             size (4096).
+ * Nx uint64 : the width of the matrix in each dimension, as stored
+ *             in the _dim vector.
+ * Nx uint64 : the width of the chunks in each dimension, in the same
+ *             order.
+ * Cx uint64 : the chunk index, the offset of each of the <C> chunks
+ *             in the file, or 0 if the chunk was never written and
+ *             only contains default values. The chunks are numbered
+ *             as the values of a matrix whose dimensions are the
+ *             number of chunks along each dimension.
+ * zeros up to the offset of the 1st chunk.
+ * the chunks, in the order they were first written. Each chunk holds
+ * the values of a full chunk, in the _data order, the chunks on the
+ * edges of the matrix being padded with default values.
+ */
+
+
+/*!
+ * \brief The version of the chunked format written.
+ */
+const uint32_t matrix_chunked_version = 1 ;
+
+/*!
+ * \brief The magic number at the beginning of the chunked files.
+ */
+const char matrix_chunked_magic[8] = {'\x89', 'M', 'C', 'H', 'U', 'N', 'K', '\n'} ;
+
+/*!
+ * \brief The size of the header fields of the chunked files
+ * before the dimensions.
+ */
+const size_t matrix_chunked_header_size = 48 ;
+
+
+/*!
+ * \brief Checks whether a file is a chunked file, from its
+ * magic number.
+ * \param file_address the path to the file.
+ * \return whether the file starts with the magic number of the
+ * chunked files, false if it cannot be read.
+ */
+inline bool is_matrix_chunked_file(const std::string& file_address)
+{   std::ifstream file(file_address, std::ifstream::in | std::ifstream::binary) ;
+    char magic[sizeof(matrix_chunked_magic)] ;
+    file.read(magic, sizeof(magic)) ;
+    return file and memcmp(magic, matrix_chunked_magic, sizeof(magic)) == 0 ;
+}
+
+/*!
+ * \brief Computes the number of chunks needed to cover a
+ * matrix, checking that it does not overflow.
+ * \param dim the dimensions of the matrix.
+ * \param chunk_dim the dimensions of the chunks, none of which
+ * is 0.
+ * \param chunk_number where the number of chunks is stored.
+ * \return false if the number of chunks, or the size of the
+ * index of the chunks, does not fit in a size_t.
+ */
+inline bool get_matrix_chunked_chunk_number(const std::vector<size_t>& dim,
+                                            const std::vector<size_t>& chunk_dim,
+                                            uint64_t& chunk_number)
+{   std::vector<size_t> grid_dim(dim.size()) ;
+    for(size_t i=0; i<dim.size(); i++)
+    {   grid_dim[i] = dim[i] / chunk_dim[i] + (dim[i] % chunk_dim[i] != 0) ; }
+    uint64_t index_size = 0 ;
+    if(not get_matrix_binary_data_size(grid_dim, sizeof(uint64_t), index_size))
+    {   return false ; }
+    chunk_number = index_size / sizeof(uint64_t) ;
+    return true ;
+}
+
+/*!
+ * \brief Copies a block of values from a matrix to another, the
+ * rows of the block being copied at once.
+ * \param src the values of the source matrix.
+ * \param src_dim the dimensions of the source matrix, as stored
+ * in the _dim vector.
+ * \param src_origin the coordinates of the block in the source
+ * matrix, in the same order.
+ * \param dst the values of the destination matrix.
+ * \param dst_dim the dimensions of the destination matrix.
+ * \param dst_origin the coordinates of the block in the
+ * destination matrix.
+ * \param extent the dimensions of the block.
+ */
+template<class T>
+void copy_matrix_block(const T* src,
+                       const std::vector<size_t>& src_dim,
+                       const std::vector<size_t>& src_origin,
+                       T* dst,
+                       const std::vector<size_t>& dst_dim,
+                       const std::vector<size_t>& dst_origin,
+                       const std::vector<size_t>& extent)
+{   size_t n = extent.size() ;
+    if(n == 0 or std::find(extent.begin(), extent.end(), (size_t)0) != extent.end())
+    {   return ; }
+    std::vector<size_t> src_prod(n, 1), dst_prod(n, 1) ;
+    for(size_t i=1; i<n; i++)
+    {   src_prod[i] = src_prod[i-1] * src_dim[i-1] ;
+        dst_prod[i] = dst_prod[i-1] * dst_dim[i-1] ;
+    }
+    size_t src_offset = 0 ;
+    size_t dst_offset = 0 ;
+    for(size_t i=0; i<n; i++)
+    {   src_offset += src_origin[i] * src_prod[i] ;
+        dst_offset += dst_origin[i] * dst_prod[i] ;
+    }
+
+    // iterates over the rows, the last dimension varying slowest
+    std::vector<size_t> coord(n, 0) ;
+    while(true)
+    {   std::copy(src + src_offset, src + src_offset + extent[0], dst + dst_offset) ;
+        size_t i = 1 ;
+        for(; i<n; i++)
+        {   if(++coord[i] < extent[i])
+            {   src_offset += src_prod[i] ;
+                dst_offset += dst_prod[i] ;
+                break ;
+            }
+            src_offset -= (extent[i] - 1) * src_prod[i] ;
+            dst_offset -= (extent[i] - 1) * dst_prod[i] ;
+            coord[i] = 0 ;
+        }
+        if(i == n)
+        {   break ; }
+    }
+}
+
+
+/*!
+ * \brief The MatrixChunkedFile class gives access to a matrix
+ * stored in a chunked file (see the layout above) without
+ * loading it in memory.
+ *
+ * The chunks accessed are kept in a cache of a bounded number of
+ * chunks. When the cache is full, the chunk least recently used
+ * is evicted, and written to the file if it was modified. A
+ * chunk is only allocated in the file when it is written for the
+ * first time, at the end of the file, and a chunk entirely
+ * overwritten is not read. Reading or writing a region of the
+ * matrix thus only reads the chunks it intersects, and updating
+ * a region only rewrites these chunks.
+ *
+ * As for the Matrix class, the coordinates and dimensions are
+ * given as (row, column, ...) while the values of a chunk or of a
+ * region are in the _data order. The values are written as they
+ * are in memory, so T should be trivially copyable, and the
+ * files can only be opened with the type and the byte order they
+ * were written with.
+ *
+ * An object should not be used by several threads at once.
+ */
+template<class T>
+class MatrixChunkedFile
+{
+    public:
+        // constructors
+        MatrixChunkedFile() = delete ;
+
+        /*!
+         * \brief Creates a chunked file storing a matrix
+         * of default values, replacing any existing file.
+         * No chunk is written until a value is set.
+         * \param file_address the path to the file.
+         * \param dim the dimensions of the matrix, as (row,
+         * column, ...).
+         * \param chunk_dim the dimensions of the chunks, in
+         * the same order. A chunk dimension larger than the
+         * matrix is reduced to the matrix dimension.
+         * \param cache_size the number of chunks kept in
+         * memory, at least 1.
+         * \throw std::invalid_argument if the matrix has no
+         * dimension, if the chunk dimensions do not match
+         * or if a chunk dimension is 0 and std::runtime_error
+         * if the file cannot be written.
+         */
+        MatrixChunkedFile(const std::string& file_address,
+                          const std::vector<size_t>& dim,
+                          const std::vector<size_t>& chunk_dim,
+                          size_t cache_size=64) ;
+
+        /*!
+         * \brief Opens an existing chunked file.
+         * \param file_address the path to the file.
+         * \param read_only whether the file is only read, in
+         * which case modifying the values throws an exception.
+         * \param cache_size the number of chunks kept in
+         * memory, at least 1.
+         * \throw std::runtime_error if the file cannot be
+         * opened, if it is not a valid chunked file or if its
+         * values are not of type T in the byte order of the
+         * machine.
+         */
+        MatrixChunkedFile(const std::string& file_address,
+                          bool read_only=false,
+                          size_t cache_size=64) ;
+
+        MatrixChunkedFile(const MatrixChunkedFile& other) = delete ;
+
+        /*!
+         * \brief Destructor. Writes the modified chunks and
+         * closes the file. The errors are ignored, flush()
+         * should be called to detect them.
+         */
+        ~MatrixChunkedFile() ;
+
+        // methods
+        /*!
+         * \brief Gets the number of dimensions of the matrix.
+         * \return the number of dimensions.
+         */
+        size_t get_dim_size() const ;
+
+        /*!
+         * \brief Gets the dimensions of the matrix, as (row,
+         * column, ...).
+         * \return the dimensions.
+         */
+        std::vector<size_t> get_dim() const ;
+
+        /*!
+         * \brief Gets the dimensions of the chunks, as (row,
+         * column, ...).
+         * \return the dimensions.
+         */
+        std::vector<size_t> get_chunk_dim() const ;
+
+        /*!
+         * \brief Gets the number of chunks.
+         * \return the number of chunks.
+         */
+        size_t get_chunk_number() const ;
+
+        /*!
+         * \brief Gets the number of values of a chunk, the
+         * padding included.
+         * \return the number of values.
+         */
+        size_t get_chunk_data_size() const ;
+
+        /*!
+         * \brief Gets the part of the matrix a chunk covers,
+         * the padding excluded.
+         * \param chunk the number of the chunk.
+         * \param origin where to store the coordinates of the
+         * 1st element of the chunk, as (row, column, ...).
+         * \param extent where to store the dimensions of the
+         * part of the chunk within the matrix, in the same
+         * order.
+         * \throw std::out_of_range if the chunk does not exist.
+         */
+        void get_chunk_region(size_t chunk,
+                              std::vector<size_t>& origin,
+                              std::vector<size_t>& extent) const ;
+
+        /*!
+         * \brief Gets the values of a chunk held in the cache,
+         * the chunk being read and cached if it is not. The
+         * values, in the _data order of the chunk, remain valid
+         * until another chunk is accessed or the file is flushed.
+         * \param chunk the number of the chunk.
+         * \param modify whether the values will be modified, the
+         * chunk is then written back when it is evicted or when
+         * the file is flushed.
+         * \throw std::out_of_range if the chunk does not exist
+         * and std::runtime_error if the values are to be
+         * modified and the file is read only or if a chunk
+         * cannot be read or written.
+         * \return the address of the values of the chunk.
+         */
+        T* get_chunk_data(size_t chunk, bool modify) ;
+
+        /*!
+         * \brief Gets the element at the given coordinates.
+         * \param coord the coordinates, as (row, column, ...).
+         * \throw std::out_of_range if the coordinates are out
+         * of range and std::runtime_error if the chunk cannot
+         * be read.
+         * \return the element.
+         */
+        T get(const std::vector<size_t>& coord) ;
+
+        /*!
+         * \brief Sets the element at the given coordinates.
+         * The chunk is written when it is evicted from the
+         * cache or when the file is flushed.
+         * \param coord the coordinates, as (row, column, ...).
+         * \param value the new value.
+         * \throw std::out_of_range if the coordinates are out
+         * of range and std::runtime_error if the file is read
+         * only or if a chunk cannot be read or written.
+         */
+        void set(const std::vector<size_t>& coord, const T& value) ;
+
+        /*!
+         * \brief Reads all the values of a chunk, the padding
+         * included. The cache is used if it holds the chunk,
+         * otherwise the chunk is read without being cached.
+         * \param chunk the number of the chunk.
+         * \param values where to store the get_chunk_data_size()
+         * values.
+         * \throw std::out_of_range if the chunk does not exist
+         * and std::runtime_error if it cannot be read.
+         */
+        void read_chunk(size_t chunk, T* values) ;
+
+        /*!
+         * \brief Writes all the values of a chunk, the padding
+         * included. The cache is updated if it holds the chunk,
+         * otherwise the chunk is written without being cached.
+         * \param chunk the number of the chunk.
+         * \param values the get_chunk_data_size() values.
+         * \throw std::out_of_range if the chunk does not exist
+         * and std::runtime_error if the file is read only or
+         * if the chunk cannot be written.
+         */
+        void write_chunk(size_t chunk, const T* values) ;
+
+        /*!
+         * \brief Reads a region of the matrix, only reading
+         * the chunks it intersects.
+         * \param origin the coordinates of the 1st element of
+         * the region, as (row, column, ...).
+         * \param extent the dimensions of the region, in the
+         * same order.
+         * \param values where to store the values of the
+         * region, in the _data order.
+         * \throw std::out_of_range if the region does not fit
+         * within the matrix and std::runtime_error if a chunk
+         * cannot be read.
+         */
+        void read_region(const std::vector<size_t>& origin,
+                         const std::vector<size_t>& extent,
+                         T* values) ;
+
+        /*!
+         * \brief Writes a region of the matrix. The chunks
+         * the region covers entirely are not read.
+         * \param origin the coordinates of the 1st element of
+         * the region, as (row, column, ...).
+         * \param extent the dimensions of the region, in the
+         * same order.
+         * \param values the values of the region, in the
+         * _data order.
+         * \throw std::out_of_range if the region does not fit
+         * within the matrix and std::runtime_error if the file
+         * is read only or if a chunk cannot be read or written.
+         */
+        void write_region(const std::vector<size_t>& origin,
+                          const std::vector<size_t>& extent,
+                          const T* values) ;
+
+        /*!
+         * \brief Writes the modified chunks of the cache to
+         * the file, in the order of the chunks.
+         * \throw std::runtime_error if a chunk cannot be
+         * written.
+         */
+        void flush() ;
+
+        MatrixChunkedFile& operator = (const MatrixChunkedFile& other) = delete ;
+
+    private:
+        /*!
+         * \brief A chunk held in the cache.
+         */
+        struct Chunk
+        {   /*!
+             * \brief The values of the chunk.
+             */
+            std::vector<T> values ;
+            /*!
+             * \brief Whether the values were modified since
+             * the chunk was read or written.
+             */
+            bool dirty ;
+            /*!
+             * \brief The position of the chunk in the list of
+             * the chunks by use.
+             */
+            std::list<size_t>::iterator position ;
+        } ;
+
+        /*!
+         * \brief Computes the number of chunks along each
+         * dimension and the chunk sizes from the dimensions.
+         */
+        void compute_chunks() ;
+
+        /*!
+         * \brief Converts coordinates given as (row, column,
+         * ...) to the internal order.
+         * \param coord the coordinates.
+         * \return the coordinates in the internal order.
+         */
+        std::vector<size_t> swap_coord(const std::vector<size_t>& coord) const ;
+
+        /*!
+         * \brief Checks that a region, in the internal order,
+         * fits within the matrix.
+         * \throw std::out_of_range if it does not.
+         */
+        void check_region(const std::vector<size_t>& origin,
+                          const std::vector<size_t>& extent) const ;
+
+        /*!
+         * \brief Checks that the file can be modified.
+         * \throw std::runtime_error if it is read only.
+         */
+        void check_writable() const ;
+
+        /*!
+         * \brief Gets a chunk from the cache, reading it if it
+         * is not cached and evicting the least recently used
+         * chunk if the cache is full.
+         * \param chunk the number of the chunk.
+         * \param read whether the chunk should be read if it is
+         * not cached, otherwise it is filled with default
+         * values.
+         * \return the cached chunk.
+         */
+        Chunk& get_cached_chunk(size_t chunk, bool read) ;
+
+        /*!
+         * \brief Reads the values of a chunk from the file,
+         * default values if it was never written.
+         */
+        void read_chunk_values(size_t chunk, T* values) ;
+
+        /*!
+         * \brief Writes the values of a chunk to the file,
+         * allocating it at the end of the file and updating
+         * the index if it was never written.
+         */
+        void write_chunk_values(size_t chunk, const T* values) ;
+
+        /*!
+         * \brief Calls f(chunk, chunk_origin, region_origin,
+         * block_extent, whole) on each block made of the
+         * intersection of a region with a chunk, all in the
+         * internal order. whole tells whether the block covers
+         * all the values of the chunk which are in the matrix.
+         */
+        template<class F>
+        void for_each_chunk_block(const std::vector<size_t>& origin,
+                                  const std::vector<size_t>& extent,
+                                  F f) const ;
+
+        /*!
+         * \brief The path to the file.
+         */
+        std::string _file_address ;
+        /*!
+         * \brief The file descriptor.
+         */
+        int _fd ;
+        /*!
+         * \brief Whether the file is read only.
+         */
+        bool _read_only ;
+        /*!
+         * \brief The dimensions of the matrix and of the chunks,
+         * as stored in the _dim vector of a Matrix.
+         */
+        std::vector<size_t> _dim ;
+        std::vector<size_t> _chunk_dim ;
+        /*!
+         * \brief The number of chunks along each dimension.
+         */
+        std::vector<size_t> _grid_dim ;
+        /*!
+         * \brief The number of values of a chunk.
+         */
+        size_t _chunk_data_size ;
+        /*!
+         * \brief The offset of each chunk in the file, 0 if
+         * it was never written.
+         */
+        std::vector<uint64_t> _index ;
+        /*!
+         * \brief The offset of the index and the offset at
+         * which the next chunk is allocated.
+         */
+        uint64_t _index_offset ;
+        uint64_t _end ;
+        /*!
+         * \brief The maximum number of chunks cached.
+         */
+        size_t _cache_size ;
+        /*!
+         * \brief The numbers of the cached chunks, the most
+         * recently used first.
+         */
+        std::list<size_t> _lru ;
+        /*!
+         * \brief The cached chunks.
+         */
+        std::unordered_map<size_t, Chunk> _cache ;
+} ;
+
+
+template<class T>
+MatrixChunkedFile<T>::MatrixChunkedFile(const std::string& file_address,
+                                        const std::vector<size_t>& dim,
+                                        const std::vector<size_t>& chunk_dim,
+                                        size_t cache_size)
+    : _file_address(file_address),
+      _fd(-1),
+      _read_only(false),
+      _cache_size(std::max(cache_size, (size_t)1))
+{   if(dim.size() == 0)
+    {   throw std::invalid_argument("the matrix should have at least one dimension!") ; }
+    if(chunk_dim.size() != dim.size())
+    {   throw std::invalid_argument("the chunk dimensions do not match the matrix dimensions!") ; }
+    if(std::find(chunk_dim.begin(), chunk_dim.end(), (size_t)0) != chunk_dim.end())
+    {   throw std::invalid_argument("the chunk dimensions should not be 0!") ; }
+    // the chunks are not wider than the matrix
+    std::vector<size_t> chunk_dim_c = chunk_dim ;
+    for(size_t i=0; i<dim.size(); i++)
+    {   chunk_dim_c[i] = std::min(chunk_dim_c[i], std::max(dim[i], (size_t)1)) ; }
+    uint64_t data_size    = 0 ;
+    uint64_t chunk_size   = 0 ;
+    uint64_t chunk_number = 0 ;
+    if(not get_matrix_binary_data_size(dim, sizeof(T), data_size) or
+       not get_matrix_binary_data_size(chunk_dim_c, sizeof(T), chunk_size) or
+       not get_matrix_chunked_chunk_number(dim, chunk_dim_c, chunk_number))
+    {   throw std::invalid_argument("the matrix is too large!") ; }
+    this->_dim       = this->swap_coord(dim) ;
+    this->_chunk_dim = this->swap_coord(chunk_dim_c) ;
+    this->compute_chunks() ;
+
+    // header, dimensions and index of unwritten chunks
+    size_t n = this->_dim.size() ;
+    this->_index_offset = matrix_chunked_header_size + 2*n*sizeof(uint64_t) ;
+    size_t size = this->_index_offset + this->_index.size()*sizeof(uint64_t) ;
+    this->_end  = ((size + matrix_binary_alignment - 1) / matrix_binary_alignment) * matrix_binary_alignment ;
+    std::vector<char> bytes(this->_end, 0) ;
+    uint32_t fields_32[] = {matrix_binary_bom,
+                            matrix_chunked_version,
+                            static_cast<uint32_t>(matrix_type_id<T>::value),
+                            sizeof(T)} ;
+    uint64_t fields_64[] = {n, this->_index_offset, this->_end} ;
+    char* p = bytes.data() ;
+    memcpy(p, matrix_chunked_magic, sizeof(matrix_chunked_magic)) ;
+    p += sizeof(matrix_chunked_magic) ;
+    memcpy(p, fields_32, sizeof(fields_32)) ;
+    p += sizeof(fields_32) ;
+    memcpy(p, fields_64, sizeof(fields_64)) ;
+    p += sizeof(fields_64) ;
+    for(const std::vector<size_t>* d : {&this->_dim, &this->_chunk_dim})
+    {   for(auto d_i : *d)
+        {   uint64_t d64 = d_i ;
+            memcpy(p, &d64, sizeof(d64)) ;
+            p += sizeof(d64) ;
+        }
+    }
+
+    this->_fd = open(file_address.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) ;
+    if(this->_fd < 0)
+    {   char msg[4096] ;
+        sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    if(not pwrite_matrix_binary(this->_fd, bytes.data(), bytes.size(), 0))
+    {   close(this->_fd) ;
+        char msg[4096] ;
+        sprintf(msg, "Error! something happened while writting dimensions to %s",
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+template<class T>
+MatrixChunkedFile<T>::MatrixChunkedFile(const std::string& file_address,
+                                        bool read_only,
+                                        size_t cache_size)
+    : _file_address(file_address),
+      _fd(-1),
+      _read_only(read_only),
+      _cache_size(std::max(cache_size, (size_t)1))
+{   this->_fd = open(file_address.c_str(), read_only ? O_RDONLY : O_RDWR) ;
+    if(this->_fd < 0)
+    {   char msg[4096] ;
+        sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+
+    try
+    {   char msg[4096] ;
+        char magic[sizeof(matrix_chunked_magic)] ;
+        uint32_t fields_32[4] ;
+        uint64_t fields_64[3] ;
+        if(not pread_matrix_binary(this->_fd, magic, sizeof(magic), 0) or
+           memcmp(magic, matrix_chunked_magic, sizeof(magic)) != 0)
+        {   sprintf(msg, "Error! %s is not a chunked matrix file", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        if(not pread_matrix_binary(this->_fd, reinterpret_cast<char*>(fields_32), sizeof(fields_32), sizeof(magic)) or
+           not pread_matrix_binary(this->_fd, reinterpret_cast<char*>(fields_64), sizeof(fields_64), sizeof(magic) + sizeof(fields_32)))
+        {   sprintf(msg, "Error! something occured while reading number of dimensions in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        if(fields_32[0] != matrix_binary_bom)
+        {   sprintf(msg, "Error! %s was written with another byte order", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        if(fields_32[1] != matrix_chunked_version)
+        {   sprintf(msg, "Error! unsupported chunked format version (%u) in %s",
+                    static_cast<unsigned int>(fields_32[1]),
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        MatrixTypeId id = static_cast<MatrixTypeId>(fields_32[2]) ;
+        if(id != matrix_type_id<T>::value or fields_32[3] != sizeof(T))
+        {   sprintf(msg, "Error! the %s values of %s cannot be accessed as %s values",
+                    get_matrix_type_info(id).name,
+                    file_address.c_str(),
+                    get_matrix_type_info(matrix_type_id<T>::value).name) ;
+            throw std::runtime_error(msg) ;
+        }
+
+        // the header, dimensions and index are within the file
+        struct stat st ;
+        if(fstat(this->_fd, &st) != 0)
+        {   sprintf(msg, "Error! cannot get the size of %s", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        uint64_t file_size = static_cast<uint64_t>(st.st_size) ;
+
+        // read dimensions
+        uint64_t n           = fields_64[0] ;
+        this->_index_offset  = fields_64[1] ;
+        uint64_t data_offset = fields_64[2] ;
+        if(n == 0 or
+           this->_index_offset < matrix_chunked_header_size or
+           this->_index_offset > data_offset or
+           data_offset > file_size or
+           n > (this->_index_offset - matrix_chunked_header_size) / (2*sizeof(uint64_t)))
+        {   sprintf(msg, "Error! something occured while reading dimensions in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        std::vector<uint64_t> dims(2*n) ;
+        if(not pread_matrix_binary(this->_fd, reinterpret_cast<char*>(dims.data()), dims.size()*sizeof(uint64_t), matrix_chunked_header_size))
+        {   sprintf(msg, "Error! something occured while reading dimensions in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        this->_dim       = std::vector<size_t>(dims.begin(), dims.begin() + n) ;
+        this->_chunk_dim = std::vector<size_t>(dims.begin() + n, dims.end()) ;
+        for(size_t i=0; i<n; i++)
+        {   if(this->_chunk_dim[i] == 0 or this->_chunk_dim[i] > std::max(this->_dim[i], (size_t)1))
+            {   sprintf(msg, "Error! invalid chunk dimensions in %s", file_address.c_str()) ;
+                throw std::runtime_error(msg) ;
+            }
+        }
+        uint64_t data_size    = 0 ;
+        uint64_t chunk_size   = 0 ;
+        uint64_t chunk_number = 0 ;
+        if(not get_matrix_binary_data_size(this->_dim, sizeof(T), data_size) or
+           not get_matrix_binary_data_size(this->_chunk_dim, sizeof(T), chunk_size) or
+           not get_matrix_chunked_chunk_number(this->_dim, this->_chunk_dim, chunk_number) or
+           chunk_number > (data_offset - this->_index_offset) / sizeof(uint64_t))
+        {   sprintf(msg, "Error! the chunk index does not match the dimensions in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        this->compute_chunks() ;
+
+        // read index
+        if(not pread_matrix_binary(this->_fd,
+                                   reinterpret_cast<char*>(this->_index.data()),
+                                   this->_index.size()*sizeof(uint64_t),
+                                   this->_index_offset))
+        {   sprintf(msg, "Error! something occured while reading the chunk index in %s",
+                    file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        // the written chunks are within the file
+        for(auto offset : this->_index)
+        {   if(offset != 0 and
+               (offset < data_offset or offset > file_size or chunk_size > file_size - offset))
+            {   sprintf(msg, "Error! the chunk index points outside of %s",
+                        file_address.c_str()) ;
+                throw std::runtime_error(msg) ;
+            }
+        }
+
+        // the new chunks are allocated after anything in the file
+        this->_end = file_size ;
+    }
+    catch(...)
+    {   close(this->_fd) ;
+        throw ;
+    }
+}
+
+template<class T>
+MatrixChunkedFile<T>::~MatrixChunkedFile()
+{   try
+    {   this->flush() ; }
+    catch(...)
+    { }
+    close(this->_fd) ;
+}
+
+template<class T>
+size_t MatrixChunkedFile<T>::get_dim_size() const
+{   return this->_dim.size() ; }
+
+template<class T>
+std::vector<size_t> MatrixChunkedFile<T>::get_dim() const
+{   return this->swap_coord(this->_dim) ; }
+
+template<class T>
+std::vector<size_t> MatrixChunkedFile<T>::get_chunk_dim() const
+{   return this->swap_coord(this->_chunk_dim) ; }
+
+template<class T>
+size_t MatrixChunkedFile<T>::get_chunk_number() const
+{   return this->_index.size() ; }
+
+template<class T>
+size_t MatrixChunkedFile<T>::get_chunk_data_size() const
+{   return this->_chunk_data_size ; }
+
+template<class T>
+void MatrixChunkedFile<T>::get_chunk_region(size_t chunk,
+                                            std::vector<size_t>& origin,
+                                            std::vector<size_t>& extent) const
+{   if(chunk >= this->_index.size())
+    {   throw std::out_of_range("the chunk does not exist!") ; }
+    size_t n = this->_dim.size() ;
+    origin = std::vector<size_t>(n) ;
+    extent = std::vector<size_t>(n) ;
+    for(size_t i=0; i<n; i++)
+    {   origin[i] = (chunk % this->_grid_dim[i]) * this->_chunk_dim[i] ;
+        extent[i] = std::min(this->_chunk_dim[i], this->_dim[i] - origin[i]) ;
+        chunk    /= this->_grid_dim[i] ;
+    }
+    origin = this->swap_coord(origin) ;
+    extent = this->swap_coord(extent) ;
+}
+
+template<class T>
+T* MatrixChunkedFile<T>::get_chunk_data(size_t chunk, bool modify)
+{   if(chunk >= this->_index.size())
+    {   throw std::out_of_range("the chunk does not exist!") ; }
+    if(modify)
+    {   this->check_writable() ; }
+    Chunk& cached = this->get_cached_chunk(chunk, true) ;
+    cached.dirty  = cached.dirty or modify ;
+    return cached.values.data() ;
+}
+
+template<class T>
+T MatrixChunkedFile<T>::get(const std::vector<size_t>& coord)
+{   T value = T() ;
+    this->read_region(coord, std::vector<size_t>(coord.size(), 1), &value) ;
+    return value ;
+}
+
+template<class T>
+void MatrixChunkedFile<T>::set(const std::vector<size_t>& coord, const T& value)
+{   this->write_region(coord, std::vector<size_t>(coord.size(), 1), &value) ; }
+
+template<class T>
+void MatrixChunkedFile<T>::read_chunk(size_t chunk, T* values)
+{   if(chunk >= this->_index.size())
+    {   throw std::out_of_range("the chunk does not exist!") ; }
+    auto found = this->_cache.find(chunk) ;
+    if(found != this->_cache.end())
+    {   std::copy(found->second.values.begin(), found->second.values.end(), values) ; }
+    else
+    {   this->read_chunk_values(chunk, values) ; }
+}
+
+template<class T>
+void MatrixChunkedFile<T>::write_chunk(size_t chunk, const T* values)
+{   if(chunk >= this->_index.size())
+    {   throw std::out_of_range("the chunk does not exist!") ; }
+    this->check_writable() ;
+    auto found = this->_cache.find(chunk) ;
+    if(found != this->_cache.end())
+    {   std::copy(values, values + this->_chunk_data_size, found->second.values.begin()) ;
+        found->second.dirty = true ;
+    }
+    else
+    {   this->write_chunk_values(chunk, values) ; }
+}
+
+template<class T>
+void MatrixChunkedFile<T>::read_region(const std::vector<size_t>& origin,
+                                       const std::vector<size_t>& extent,
+                                       T* values)
+{   std::vector<size_t> region_origin = this->swap_coord(origin) ;
+    std::vector<size_t> region_dim    = this->swap_coord(extent) ;
+    this->check_region(region_origin, region_dim) ;
+    this->for_each_chunk_block(region_origin, region_dim,
+                               [&](size_t chunk,
+                                   const std::vector<size_t>& chunk_origin,
+                                   const std::vector<size_t>& block_origin,
+                                   const std::vector<size_t>& block_dim,
+                                   bool)
+                               {   Chunk& cached = this->get_cached_chunk(chunk, true) ;
+                                   copy_matrix_block(cached.values.data(), this->_chunk_dim, chunk_origin,
+                                                     values, region_dim, block_origin,
+                                                     block_dim) ;
+                               }) ;
+}
+
+template<class T>
+void MatrixChunkedFile<T>::write_region(const std::vector<size_t>& origin,
+                                        const std::vector<size_t>& extent,
+                                        const T* values)
+{   this->check_writable() ;
+    std::vector<size_t> region_origin = this->swap_coord(origin) ;
+    std::vector<size_t> region_dim    = this->swap_coord(extent) ;
+    this->check_region(region_origin, region_dim) ;
+    this->for_each_chunk_block(region_origin, region_dim,
+                               [&](size_t chunk,
+                                   const std::vector<size_t>& chunk_origin,
+                                   const std::vector<size_t>& block_origin,
+                                   const std::vector<size_t>& block_dim,
+                                   bool whole)
+                               {   Chunk& cached = this->get_cached_chunk(chunk, not whole) ;
+                                   copy_matrix_block(values, region_dim, block_origin,
+                                                     cached.values.data(), this->_chunk_dim, chunk_origin,
+                                                     block_dim) ;
+                                   cached.dirty = true ;
+                               }) ;
+}
+
+template<class T>
+void MatrixChunkedFile<T>::flush()
+{   std::vector<size_t> dirty ;
+    for(const auto& cached : this->_cache)
+    {   if(cached.second.dirty)
+        {   dirty.push_back(cached.first) ; }
+    }
+    std::sort(dirty.begin(), dirty.end()) ;
+    for(auto chunk : dirty)
+    {   Chunk& cached = this->_cache[chunk] ;
+        this->write_chunk_values(chunk, cached.values.data()) ;
+        cached.dirty = false ;
+    }
+}
+
+template<class T>
+void MatrixChunkedFile<T>::compute_chunks()
+{   size_t n = this->_dim.size() ;
+    this->_grid_dim        = std::vector<size_t>(n) ;
+    this->_chunk_data_size = 1 ;
+    size_t n_chunks        = 1 ;
+    for(size_t i=0; i<n; i++)
+    {   this->_grid_dim[i] = this->_dim[i] / this->_chunk_dim[i] + (this->_dim[i] % this->_chunk_dim[i] != 0) ;
+        this->_chunk_data_size *= this->_chunk_dim[i] ;
+        n_chunks *= this->_grid_dim[i] ;
+    }
+    this->_index = std::vector<uint64_t>(n_chunks, 0) ;
+}
+
+template<class T>
+std::vector<size_t> MatrixChunkedFile<T>::swap_coord(const std::vector<size_t>& coord) const
+{   std::vector<size_t> swapped = coord ;
+    if(swapped.size() > 1)
+    {   std::swap(swapped[0], swapped[1]) ; }
+    return swapped ;
+}
+
+template<class T>
+void MatrixChunkedFile<T>::check_region(const std::vector<size_t>& origin,
+                                        const std::vector<size_t>& extent) const
+{   if(origin.size() != this->_dim.size() or extent.size() != this->_dim.size())
+    {   throw std::out_of_range("the region coordinates do not have the matrix dimensionality!") ; }
+    for(size_t i=0; i<this->_dim.size(); i++)
+    {   if(origin[i] > this->_dim[i] or extent[i] > this->_dim[i] - origin[i])
+        {   throw std::out_of_range("the region is out of range!") ; }
+    }
+}
+
+template<class T>
+void MatrixChunkedFile<T>::check_writable() const
+{   if(this->_read_only)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! %s is opened read only", this->_file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+template<class T>
+typename MatrixChunkedFile<T>::Chunk& MatrixChunkedFile<T>::get_cached_chunk(size_t chunk, bool read)
+{   auto found = this->_cache.find(chunk) ;
+    if(found != this->_cache.end())
+    {   this->_lru.splice(this->_lru.begin(), this->_lru, found->second.position) ;
+        return found->second ;
+    }
+
+    // the buffer of the evicted chunk is reused
+    std::vector<T> values ;
+    if(this->_cache.size() >= this->_cache_size)
+    {   auto evicted = this->_cache.find(this->_lru.back()) ;
+        if(evicted->second.dirty)
+        {   this->write_chunk_values(evicted->first, evicted->second.values.data()) ; }
+        values = std::move(evicted->second.values) ;
+        this->_cache.erase(evicted) ;
+        this->_lru.pop_back() ;
+    }
+    values.resize(this->_chunk_data_size) ;
+    if(read)
+    {   this->read_chunk_values(chunk, values.data()) ; }
+    else
+    {   std::fill(values.begin(), values.end(), T()) ; }
+
+    this->_lru.push_front(chunk) ;
+    Chunk& cached   = this->_cache[chunk] ;
+    cached.values   = std::move(values) ;
+    cached.dirty    = false ;
+    cached.position = this->_lru.begin() ;
+    return cached ;
+}
+
+template<class T>
+void MatrixChunkedFile<T>::read_chunk_values(size_t chunk, T* values)
+{   if(this->_index[chunk] == 0)
+    {   std::fill(values, values + this->_chunk_data_size, T()) ;
+        return ;
+    }
+    if(not pread_matrix_binary(this->_fd,
+                               reinterpret_cast<char*>(values),
+                               this->_chunk_data_size*sizeof(T),
+                               this->_index[chunk]))
+    {   char msg[4096] ;
+        sprintf(msg, "Error! something occured while reading chunk %zu in %s",
+                chunk,
+                this->_file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+template<class T>
+void MatrixChunkedFile<T>::write_chunk_values(size_t chunk, const T* values)
+{   char msg[4096] ;
+    size_t size     = this->_chunk_data_size*sizeof(T) ;
+    uint64_t offset = this->_index[chunk] ;
+    bool allocate   = offset == 0 ;
+    if(allocate)
+    {   offset = this->_end ; }
+    if(not pwrite_matrix_binary(this->_fd, reinterpret_cast<const char*>(values), size, offset))
+    {   sprintf(msg, "Error! something happened while writting chunk %zu to %s",
+                chunk,
+                this->_file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    // the index is only updated once the chunk is written
+    if(allocate)
+    {   this->_end += size ;
+        if(not pwrite_matrix_binary(this->_fd,
+                                    reinterpret_cast<const char*>(&offset),
+                                    sizeof(offset),
+                                    this->_index_offset + chunk*sizeof(uint64_t)))
+        {   sprintf(msg, "Error! something happened while writting the chunk index to %s",
+                    this->_file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        this->_index[chunk] = offset ;
+    }
+}
+
+template<class T>
+template<class F>
+void MatrixChunkedFile<T>::for_each_chunk_block(const std::vector<size_t>& origin,
+                                                const std::vector<size_t>& extent,
+                                                F f) const
+{   size_t n = this->_dim.size() ;
+    if(std::find(extent.begin(), extent.end(), (size_t)0) != extent.end())
+    {   return ; }
+    // the range of chunks intersected along each dimension
+    std::vector<size_t> first(n), last(n) ;
+    for(size_t i=0; i<n; i++)
+    {   first[i] = origin[i] / this->_chunk_dim[i] ;
+        last[i]  = (origin[i] + extent[i] - 1) / this->_chunk_dim[i] ;
+    }
+
+    std::vector<size_t> grid_coord = first ;
+    std::vector<size_t> chunk_origin(n), block_origin(n), block_dim(n) ;
+    while(true)
+    {   size_t chunk      = 0 ;
+        size_t grid_prod  = 1 ;
+        bool whole        = true ;
+        for(size_t i=0; i<n; i++)
+        {   size_t chunk_from = grid_coord[i] * this->_chunk_dim[i] ;
+            size_t chunk_to   = std::min(chunk_from + this->_chunk_dim[i], this->_dim[i]) ;
+            size_t from       = std::max(origin[i], chunk_from) ;
+            size_t to         = std::min(origin[i] + extent[i], chunk_to) ;
+            chunk_origin[i]   = from - chunk_from ;
+            block_origin[i]   = from - origin[i] ;
+            block_dim[i]      = to - from ;
+            whole             = whole and from == chunk_from and to == chunk_to ;
+            chunk            += grid_coord[i] * grid_prod ;
+            grid_prod        *= this->_grid_dim[i] ;
+        }
+        f(chunk, chunk_origin, block_origin, block_dim, whole) ;
+
+        size_t i = 0 ;
+        for(; i<n; i++)
+        {   if(++grid_coord[i] <= last[i])
+            {   break ; }
+            grid_coord[i] = first[i] ;
+        }
+        if(i == n)
+        {   break ; }
+    }
+}
+
+#endif // MATRIXCHUNKEDFILE_HPP
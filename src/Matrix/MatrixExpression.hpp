@@ -0,0 +1,559 @@
+#ifndef MATRIXEXPRESSION_HPP
+#define MATRIXEXPRESSION_HPP
+
+#include <vector>
+#include <algorithm>   // min()
+#include <stdexcept>   // invalid_argument
+#include <type_traits> // enable_if, true_type, false_type
+
+#include "MatrixKernels.hpp"
+#include "MatrixAllocator.hpp"
+
+
+/*!
+ * The arithmetic operators (+, -, *, /) applied on matrices do not compute
+ * anything, they build a lazy expression tree describing the computation.
+ * The tree is evaluated only once it is assigned to (or used to construct)
+ * a matrix, in a single fused pass : each element of the destination is
+ * written once and each element of the operands is read once, whatever the
+ * number of operations chained. For instance
+ *
+ *      Matrix3D<double> m(m1 * 2. + m2 - m3) ;
+ *
+ * does not create any intermediate matrix. An expression has the number
+ * of dimensions of the Matrix2D, Matrix3D, Matrix4D or MatrixN it involves,
+ * so that it is only converted to a matrix of the same kind (or to a
+ * Matrix). An expression only involving Matrix objects has a number of
+ * dimensions known at run time only, which is checked when it is converted.
+ * When all the operations of the expression can be vectorized for the
+ * element type (see MatrixKernels.hpp), the evaluation uses SIMD registers.
+ *
+ * The dimensions of the operands are checked when the expression is built.
+ * A division by 0 is detected when the divisor values are read, during the
+ * evaluation. An expression involving a division by a matrix, assigned to
+ * an existing matrix, is thus first scanned for 0 divisors, reading the
+ * divisor values only (see expression_has_zero_divisor()), so that the
+ * destination is unchanged if it throws.
+ *
+ * An expression only stores references to the matrices it involves, these
+ * ones should thus outlive it. Storing an expression using auto is only
+ * safe if no temporary matrix is involved.
+ */
+
+template<class T, class A = MatrixAlignedAllocator<T>>
+class Matrix ;
+
+/*!
+ * \brief The base class of every matrix expression, including
+ * the matrices themselves (curiously recurring template pattern).
+ * Every expression E provides :
+ * value_type            the type of the elements.
+ * vectorized            whether it can be evaluated with SIMD registers.
+ * dim_number            its number of dimensions, 0 if not known at
+ *                       compile time.
+ * may_throw             whether its evaluation may throw (division
+ *                       by 0).
+ * has_zero_divisor()    whether any of its divisions has a 0 divisor.
+ * get_dim()             the dimensions, in (row, col, ...) format.
+ * get_data_size()       the number of elements.
+ */
+template<class E>
+class MatrixExpression
+{
+    public:
+        /*!
+         * \brief Returns the actual expression.
+         * \return the actual expression.
+         */
+        const E& self() const
+        {   return static_cast<const E&>(*this) ; }
+} ;
+
+/*!
+ * \brief Gives the number of dimensions of the matrices of type M, if
+ * it is known at compile time, 0 otherwise. The matrix classes with a
+ * fixed number of dimensions specialise it.
+ */
+template<class M>
+struct matrix_dim_number
+{   static const size_t value = 0 ; } ;
+
+/*!
+ * \brief Gives the number of dimensions of an expression combining
+ * two expressions with the given number of dimensions (0 if unknown).
+ * \param n1 the number of dimensions of the 1st expression.
+ * \param n2 the number of dimensions of the 2nd expression.
+ * \return the number of dimensions, 0 if unknown.
+ */
+constexpr size_t matrix_expression_dim_number(size_t n1, size_t n2)
+{   return n1 == 0 ? n2 : ((n2 == 0 or n1 == n2) ? n1 : 0) ; }
+
+/*!
+ * \brief Overloads used to tell whether a type is a matrix expression
+ * and, for a matrix, which Matrix it derives from.
+ */
+template<class E>
+std::true_type matrix_expression_test(const MatrixExpression<E>*) ;
+std::false_type matrix_expression_test(...) ;
+template<class T, class A>
+const Matrix<T,A>* matrix_base_test(const Matrix<T,A>*) ;
+const void* matrix_base_test(...) ;
+
+/*!
+ * \brief Tells whether E is a matrix expression, that is a matrix
+ * (of any class deriving from Matrix) or an operation.
+ */
+template<class E>
+struct is_matrix_expression
+{   static const bool value = decltype(matrix_expression_test(static_cast<const E*>(nullptr)))::value ; } ;
+
+/*!
+ * \brief A matrix, as a leaf of an expression tree. It gives a
+ * direct access to the matrix values.
+ * N is the number of dimensions of the matrix, 0 if it is not known
+ * at compile time.
+ */
+template<class T, class A, size_t N = 0>
+class MatrixExpressionLeaf
+{
+    public:
+        typedef T value_type ;
+        static const bool vectorized = simd_traits<T>::enabled ;
+        static const size_t dim_number = N ;
+        static const bool may_throw = false ;
+
+        MatrixExpressionLeaf(const Matrix<T,A>& m)
+            : _m(m), _data(m.get_data_ptr())
+        {}
+
+        std::vector<size_t> get_dim() const
+        {   return this->_m.get_dim() ; }
+
+        size_t get_data_size() const
+        {   return this->_m.get_data_size() ; }
+
+        T evaluate(size_t offset) const
+        {   return this->_data[offset] ; }
+
+        template<class S>
+        typename S::type evaluate_simd(size_t offset) const
+        {   return S::load(this->_data + offset) ; }
+
+        bool has_zero_divisor() const
+        {   return false ; }
+
+        const T* get_data_ptr() const
+        {   return this->_data ; }
+
+    private:
+        const Matrix<T,A>& _m ;
+        const T* _data ;
+} ;
+
+/*!
+ * \brief Gives how an expression of type E is stored in
+ * an expression tree : the matrices (M is the Matrix they
+ * derive from) are stored as leaves, referring to the matrix,
+ * the other expressions are copied.
+ */
+template<class E, class M = typename std::remove_cv<typename std::remove_pointer<decltype(matrix_base_test(static_cast<const E*>(nullptr)))>::type>::type>
+struct matrix_expression_operand
+{   typedef E type ; } ;
+
+template<class E, class T, class A>
+struct matrix_expression_operand<E, Matrix<T,A>>
+{   typedef MatrixExpressionLeaf<T,A,matrix_dim_number<E>::value> type ; } ;
+
+/*!
+ * \brief Tells whether an expression of type E can be converted
+ * to a matrix with N dimensions, that is whether it has N dimensions
+ * or a number of dimensions only known at run time.
+ */
+template<class E, size_t N>
+struct matrix_expression_has_dim_number
+{   static const bool value = matrix_expression_operand<E>::type::dim_number == 0 or
+                              matrix_expression_operand<E>::type::dim_number == N ;
+} ;
+
+/*!
+ * \brief An element-wise operation between two expressions
+ * with the same dimensions.
+ */
+template<class E1, class E2, class Op>
+class MatrixBinaryExpression : public MatrixExpression<MatrixBinaryExpression<E1,E2,Op>>
+{
+    public:
+        typedef typename matrix_expression_operand<E1>::type operand1_type ;
+        typedef typename matrix_expression_operand<E2>::type operand2_type ;
+        typedef typename operand1_type::value_type value_type ;
+        static const bool vectorized = operand1_type::vectorized and
+                                       operand2_type::vectorized and
+                                       Op::template vectorized<value_type>::value ;
+        static const size_t dim_number = matrix_expression_dim_number(operand1_type::dim_number,
+                                                                      operand2_type::dim_number) ;
+        static const bool may_throw = operand1_type::may_throw or operand2_type::may_throw ;
+
+        /*!
+         * \brief Constructs the expression.
+         * \param e1 the left operand.
+         * \param e2 the right operand.
+         * \throw std::invalid_argument if the operands do not
+         * have the same dimensions.
+         */
+        MatrixBinaryExpression(const E1& e1, const E2& e2)
+            : _e1(e1), _e2(e2)
+        {   if(this->_e1.get_dim() != this->_e2.get_dim())
+            {   throw std::invalid_argument("matrices have different dimensions!") ; }
+        }
+
+        std::vector<size_t> get_dim() const
+        {   return this->_e1.get_dim() ; }
+
+        size_t get_data_size() const
+        {   return this->_e1.get_data_size() ; }
+
+        value_type evaluate(size_t offset) const
+        {   return Op::apply(this->_e1.evaluate(offset), this->_e2.evaluate(offset)) ; }
+
+        template<class S>
+        typename S::type evaluate_simd(size_t offset) const
+        {   return Op::template apply_simd<S>(this->_e1.template evaluate_simd<S>(offset),
+                                              this->_e2.template evaluate_simd<S>(offset)) ;
+        }
+
+        bool has_zero_divisor() const
+        {   return this->_e1.has_zero_divisor() or this->_e2.has_zero_divisor() ; }
+
+    private:
+        operand1_type _e1 ;
+        operand2_type _e2 ;
+} ;
+
+/*!
+ * \brief Tells whether any value of an expression is 0. The values
+ * are evaluated by chunks, in a buffer on the stack.
+ * \param e the expression, which should not have any 0 divisor.
+ * \return whether a value is 0.
+ */
+template<class E>
+bool matrix_expression_has_zero(const E& e) ;
+
+/*!
+ * \brief Tells whether any value of a matrix is 0, reading its
+ * values directly.
+ * \param e the matrix.
+ * \return whether a value is 0.
+ */
+template<class T, class A, size_t N>
+bool matrix_expression_has_zero(const MatrixExpressionLeaf<T,A,N>& e)
+{   return kernel_has_zero(e.get_data_ptr(), e.get_data_size()) ; }
+
+/*!
+ * \brief An element-wise division between two expressions with
+ * the same dimensions. The divisor values are checked for 0 while
+ * the expression is evaluated.
+ */
+template<class E1, class E2>
+class MatrixDivisionExpression : public MatrixExpression<MatrixDivisionExpression<E1,E2>>
+{
+    public:
+        typedef typename matrix_expression_operand<E1>::type operand1_type ;
+        typedef typename matrix_expression_operand<E2>::type operand2_type ;
+        typedef typename operand1_type::value_type value_type ;
+        static const bool vectorized = operand1_type::vectorized and
+                                       operand2_type::vectorized and
+                                       kernel_div::template vectorized<value_type>::value ;
+        static const size_t dim_number = matrix_expression_dim_number(operand1_type::dim_number,
+                                                                      operand2_type::dim_number) ;
+        static const bool may_throw = true ;
+
+        /*!
+         * \brief Constructs the expression.
+         * \param e1 the dividend.
+         * \param e2 the divisor.
+         * \throw std::invalid_argument if the operands do not
+         * have the same dimensions.
+         */
+        MatrixDivisionExpression(const E1& e1, const E2& e2)
+            : _e1(e1), _e2(e2)
+        {   if(this->_e1.get_dim() != this->_e2.get_dim())
+            {   throw std::invalid_argument("matrices have different dimensions!") ; }
+        }
+
+        std::vector<size_t> get_dim() const
+        {   return this->_e1.get_dim() ; }
+
+        size_t get_data_size() const
+        {   return this->_e1.get_data_size() ; }
+
+        /*!
+         * \brief Evaluates the element at the given offset.
+         * \param offset the offset of the element.
+         * \throw std::invalid_argument if the divisor is 0.
+         * \return the quotient.
+         */
+        value_type evaluate(size_t offset) const
+        {   value_type divisor = this->_e2.evaluate(offset) ;
+            if(divisor == static_cast<value_type>(0))
+            {   throw std::invalid_argument("division by 0!") ; }
+            return kernel_div::apply(this->_e1.evaluate(offset), divisor) ;
+        }
+
+        /*!
+         * \brief Evaluates the elements fitting in a register, starting
+         * at the given offset.
+         * \param offset the offset of the 1st element.
+         * \throw std::invalid_argument if a divisor is 0.
+         * \return the quotients.
+         */
+        template<class S>
+        typename S::type evaluate_simd(size_t offset) const
+        {   typename S::type divisor = this->_e2.template evaluate_simd<S>(offset) ;
+            if(S::has_zero(divisor))
+            {   throw std::invalid_argument("division by 0!") ; }
+            return kernel_div::template apply_simd<S>(this->_e1.template evaluate_simd<S>(offset), divisor) ;
+        }
+
+        /*!
+         * \brief Tells whether a divisor value is 0, in this division
+         * or in the operands, without evaluating the quotients.
+         * \return whether a divisor value is 0.
+         */
+        bool has_zero_divisor() const
+        {   return this->_e1.has_zero_divisor() or
+                   this->_e2.has_zero_divisor() or
+                   matrix_expression_has_zero(this->_e2) ;
+        }
+
+    private:
+        operand1_type _e1 ;
+        operand2_type _e2 ;
+} ;
+
+/*!
+ * \brief An operation between each element of an expression and
+ * a scalar value.
+ */
+template<class E, class Op>
+class MatrixScalarExpression : public MatrixExpression<MatrixScalarExpression<E,Op>>
+{
+    public:
+        typedef typename matrix_expression_operand<E>::type operand_type ;
+        typedef typename operand_type::value_type value_type ;
+        static const bool vectorized = operand_type::vectorized and
+                                       Op::template vectorized<value_type>::value ;
+        static const size_t dim_number = operand_type::dim_number ;
+        static const bool may_throw = operand_type::may_throw ;
+
+        /*!
+         * \brief Constructs the expression.
+         * \param e the expression.
+         * \param value the value.
+         */
+        MatrixScalarExpression(const E& e, value_type value)
+            : _e(e), _value(value)
+        {}
+
+        std::vector<size_t> get_dim() const
+        {   return this->_e.get_dim() ; }
+
+        size_t get_data_size() const
+        {   return this->_e.get_data_size() ; }
+
+        value_type evaluate(size_t offset) const
+        {   return Op::apply(this->_e.evaluate(offset), this->_value) ; }
+
+        template<class S>
+        typename S::type evaluate_simd(size_t offset) const
+        {   return Op::template apply_simd<S>(this->_e.template evaluate_simd<S>(offset),
+                                              S::set(this->_value)) ;
+        }
+
+        bool has_zero_divisor() const
+        {   return this->_e.has_zero_divisor() ; }
+
+    private:
+        operand_type _e ;
+        value_type _value ;
+} ;
+
+
+/*!
+ * \brief Scalar evaluation of the elements [from,to) of an
+ * expression, written from the start of out.
+ */
+template<class E, bool vectorized = E::vectorized>
+struct matrix_expression_evaluator
+{   static void run(const E& e, typename E::value_type* out, size_t from, size_t to)
+    {   for(size_t i=from; i<to; i++)
+        {   out[i-from] = e.evaluate(i) ; }
+    }
+} ;
+
+/*!
+ * \brief SIMD evaluation of the elements [from,to) of an expression,
+ * the elements which do not fill a whole register are evaluated one
+ * by one.
+ */
+template<class E>
+struct matrix_expression_evaluator<E, true>
+{   typedef simd_traits<typename E::value_type> S ;
+
+    static void run(const E& e, typename E::value_type* out, size_t from, size_t to)
+    {   size_t i = from ;
+        for(; i+S::width<=to; i+=S::width)
+        {   S::store(out+i-from, e.template evaluate_simd<S>(i)) ; }
+        for(; i<to; i++)
+        {   out[i-from] = e.evaluate(i) ; }
+    }
+} ;
+
+/*!
+ * \brief Evaluates an expression and writes the values into the given
+ * array, in a single pass. The array may be the data of a matrix
+ * involved in the expression.
+ * \param e the expression.
+ * \param out the address where the values should be written, there
+ * should be room for e.get_data_size() values.
+ */
+template<class E>
+void evaluate_expression(const MatrixExpression<E>& e, typename matrix_expression_operand<E>::type::value_type* out)
+{   typedef typename matrix_expression_operand<E>::type operand_type ;
+    operand_type root(e.self()) ;
+    matrix_expression_evaluator<operand_type>::run(root, out, 0, root.get_data_size()) ;
+}
+
+/*!
+ * \brief Tells whether any division of an expression has a 0
+ * divisor, reading the divisor values only. An expression which
+ * has none can be evaluated without throwing.
+ * \param e the expression.
+ * \return whether a divisor value is 0.
+ */
+template<class E>
+bool expression_has_zero_divisor(const MatrixExpression<E>& e)
+{   typedef typename matrix_expression_operand<E>::type operand_type ;
+    operand_type root(e.self()) ;
+    return root.has_zero_divisor() ;
+}
+
+template<class E>
+bool matrix_expression_has_zero(const E& e)
+{   typedef typename E::value_type value_type ;
+    const size_t chunk = 256 ;
+    value_type buffer[chunk] ;
+    size_t n = e.get_data_size() ;
+    for(size_t from=0; from<n; from+=chunk)
+    {   size_t to = std::min(n, from + chunk) ;
+        matrix_expression_evaluator<E>::run(e, buffer, from, to) ;
+        if(kernel_has_zero(buffer, to - from))
+        {   return true ; }
+    }
+    return false ;
+}
+
+
+// operators
+/*!
+ * \brief Element-wise addition operator.
+ * \param e1 the 1st matrix (expression).
+ * \param e2 the 2nd matrix (expression), with the same dimensions as e1.
+ * \throw std::invalid_argument if the dimensions differ.
+ * \return the expression.
+ */
+template<class E1, class E2>
+typename std::enable_if<is_matrix_expression<E1>::value and is_matrix_expression<E2>::value,
+                        const MatrixBinaryExpression<E1,E2,kernel_add>>::type
+operator + (const E1& e1, const E2& e2)
+{   return MatrixBinaryExpression<E1,E2,kernel_add>(e1, e2) ; }
+
+/*!
+ * \brief Element-wise substraction operator.
+ * \param e1 the 1st matrix (expression).
+ * \param e2 the 2nd matrix (expression), with the same dimensions as e1.
+ * \throw std::invalid_argument if the dimensions differ.
+ * \return the expression.
+ */
+template<class E1, class E2>
+typename std::enable_if<is_matrix_expression<E1>::value and is_matrix_expression<E2>::value,
+                        const MatrixBinaryExpression<E1,E2,kernel_sub>>::type
+operator - (const E1& e1, const E2& e2)
+{   return MatrixBinaryExpression<E1,E2,kernel_sub>(e1, e2) ; }
+
+/*!
+ * \brief Element-wise multiplication operator.
+ * \param e1 the 1st matrix (expression).
+ * \param e2 the 2nd matrix (expression), with the same dimensions as e1.
+ * \throw std::invalid_argument if the dimensions differ.
+ * \return the expression.
+ */
+template<class E1, class E2>
+typename std::enable_if<is_matrix_expression<E1>::value and is_matrix_expression<E2>::value,
+                        const MatrixBinaryExpression<E1,E2,kernel_mul>>::type
+operator * (const E1& e1, const E2& e2)
+{   return MatrixBinaryExpression<E1,E2,kernel_mul>(e1, e2) ; }
+
+/*!
+ * \brief Element-wise division operator.
+ * \param e1 the 1st matrix (expression).
+ * \param e2 the 2nd matrix (expression), with the same dimensions as e1.
+ * \throw std::invalid_argument if the dimensions differ. A 0 value in
+ * e2 makes the evaluation of the expression throw std::invalid_argument.
+ * \return the expression.
+ */
+template<class E1, class E2>
+typename std::enable_if<is_matrix_expression<E1>::value and is_matrix_expression<E2>::value,
+                        const MatrixDivisionExpression<E1,E2>>::type
+operator / (const E1& e1, const E2& e2)
+{   return MatrixDivisionExpression<E1,E2>(e1, e2) ; }
+
+/*!
+ * \brief Addition operator.
+ * \param e the matrix (expression) of interest.
+ * \param value the value to add to each element.
+ * \return the expression.
+ */
+template<class E>
+typename std::enable_if<is_matrix_expression<E>::value, const MatrixScalarExpression<E,kernel_add>>::type
+operator + (const E& e, typename matrix_expression_operand<E>::type::value_type value)
+{   return MatrixScalarExpression<E,kernel_add>(e, value) ; }
+
+/*!
+ * \brief Substraction operator.
+ * \param e the matrix (expression) of interest.
+ * \param value the value to substract to each element.
+ * \return the expression.
+ */
+template<class E>
+typename std::enable_if<is_matrix_expression<E>::value, const MatrixScalarExpression<E,kernel_sub>>::type
+operator - (const E& e, typename matrix_expression_operand<E>::type::value_type value)
+{   return MatrixScalarExpression<E,kernel_sub>(e, value) ; }
+
+/*!
+ * \brief Multiplication operator.
+ * \param e the matrix (expression) of interest.
+ * \param value the value to multiply each elements by.
+ * \return the expression.
+ */
+template<class E>
+typename std::enable_if<is_matrix_expression<E>::value, const MatrixScalarExpression<E,kernel_mul>>::type
+operator * (const E& e, typename matrix_expression_operand<E>::type::value_type value)
+{   return MatrixScalarExpression<E,kernel_mul>(e, value) ; }
+
+/*!
+ * \brief Division operator.
+ * \param e the matrix (expression) of interest.
+ * \param value the value to divide each elements by.
+ * \throw std::invalid_argument if value is 0.
+ * \return the expression.
+ */
+template<class E>
+typename std::enable_if<is_matrix_expression<E>::value, const MatrixScalarExpression<E,kernel_div>>::type
+operator / (const E& e, typename matrix_expression_operand<E>::type::value_type value)
+{   typedef typename matrix_expression_operand<E>::type::value_type value_type ;
+    if(value == static_cast<value_type>(0))
+    {   throw std::invalid_argument("division by 0!") ; }
+    return MatrixScalarExpression<E,kernel_div>(e, value) ;
+}
+
+#endif // MATRIXEXPRESSION_HPP
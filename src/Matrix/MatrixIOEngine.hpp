@@ -0,0 +1,718 @@
+#ifndef MATRIXIOENGINE_HPP
+#define MATRIXIOENGINE_HPP
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <algorithm>   // min(), max()
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t, uintptr_t
+#include <cstdlib>     // posix_memalign(), free()
+#include <cstring>     // memset(), memcpy()
+#include <cerrno>      // errno
+#include <new>         // bad_alloc
+
+#include <fcntl.h>     // open(), fcntl(), O_DIRECT
+#include <unistd.h>    // pread(), pwrite(), close()
+
+// io_uring is used if the kernel headers provide it, unless
+// MATRIX_NO_IO_URING is defined
+#if defined(__linux__) && !defined(MATRIX_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define MATRIX_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/syscall.h>  // __NR_io_uring_setup, __NR_io_uring_enter
+#include <sys/mman.h>     // mmap(), munmap()
+#include <sched.h>        // sched_yield()
+#endif
+#endif
+
+
+/*!
+ * The binary files are read and written by a MatrixIOEngine, which
+ * splits the transfers in blocks and keeps many of them in flight at
+ * once :
+ * - with io_uring, on Linux, the blocks are queued in the submission
+ *   ring of the engine and the kernel processes them in parallel,
+ *   which saturates fast devices better than one large synchronous
+ *   read. The blocks of several transfers, for instance of several
+ *   small files, are queued together.
+ * - otherwise, or if the ring cannot be created (an old kernel, a
+ *   sandbox forbidding it), the blocks are transferred one after the
+ *   other with pread() and pwrite().
+ * A block which fails or is transferred partially in the ring is
+ * completed with pread() or pwrite(), so both ways behave the same.
+ *
+ * Reads on a file opened with O_DIRECT bypass the page cache. The
+ * blocks which are not aligned on matrix_io_alignment (in memory, in
+ * the file or in size) are then read through aligned buffers.
+ * open_read() opens the files with O_DIRECT when set_direct(true) has
+ * been called. The writes never use O_DIRECT.
+ *
+ * An engine is not thread safe, get_default() returns an engine per
+ * thread.
+ */
+
+
+/*!
+ * \brief The alignment required by O_DIRECT, in bytes.
+ */
+const size_t matrix_io_alignment = 4096 ;
+
+
+/*!
+ * \brief Reads n bytes at the given offset of a file, even if
+ * pread() returns less.
+ * \param fd the file descriptor.
+ * \param dst where to store the bytes.
+ * \param n the number of bytes.
+ * \param offset the offset of the 1st byte in the file.
+ * \return whether the n bytes could be read.
+ */
+inline bool pread_matrix_binary(int fd, char* dst, size_t n, uint64_t offset)
+{   while(n > 0)
+    {   ssize_t n_read = pread(fd, dst, n, static_cast<off_t>(offset)) ;
+        if(n_read < 0 and errno == EINTR)
+        {   continue ; }
+        if(n_read <= 0)
+        {   return false ; }
+        dst    += n_read ;
+        n      -= static_cast<size_t>(n_read) ;
+        offset += static_cast<uint64_t>(n_read) ;
+    }
+    return true ;
+}
+
+/*!
+ * \brief Writes n bytes at the given offset of a file, even if
+ * pwrite() writes less.
+ * \param fd the file descriptor.
+ * \param src the bytes to write.
+ * \param n the number of bytes.
+ * \param offset the offset of the 1st byte in the file.
+ * \return whether the n bytes could be written.
+ */
+inline bool pwrite_matrix_binary(int fd, const char* src, size_t n, uint64_t offset)
+{   while(n > 0)
+    {   ssize_t n_written = pwrite(fd, src, n, static_cast<off_t>(offset)) ;
+        if(n_written < 0 and errno == EINTR)
+        {   continue ; }
+        if(n_written <= 0)
+        {   return false ; }
+        src    += n_written ;
+        n      -= static_cast<size_t>(n_written) ;
+        offset += static_cast<uint64_t>(n_written) ;
+    }
+    return true ;
+}
+
+
+/*!
+ * \brief A transfer between a file and memory.
+ */
+struct MatrixIORequest
+{   /*!
+     * \brief The file descriptor.
+     */
+    int fd ;
+    /*!
+     * \brief The bytes in memory, read or written.
+     */
+    char* buffer ;
+    /*!
+     * \brief The number of bytes.
+     */
+    size_t size ;
+    /*!
+     * \brief The offset of the 1st byte in the file.
+     */
+    uint64_t offset ;
+} ;
+
+
+/*!
+ * \brief Transfers blocks of bytes between files and memory, many
+ * at a time.
+ */
+class MatrixIOEngine
+{
+    public:
+        /*!
+         * \brief Constructs an engine.
+         * \param queue_depth the largest number of blocks in
+         * flight.
+         * \param block_size the size of the blocks, in bytes,
+         * rounded up to a multiple of matrix_io_alignment.
+         * \param io_uring whether to try using io_uring, if
+         * false pread() and pwrite() are used.
+         */
+        MatrixIOEngine(size_t queue_depth = 32,
+                       size_t block_size = 1 << 20,
+                       bool io_uring = true) ;
+
+        MatrixIOEngine(const MatrixIOEngine& other) = delete ;
+
+        /*!
+         * \brief Destructor, releases the ring.
+         */
+        ~MatrixIOEngine() ;
+
+        MatrixIOEngine& operator = (const MatrixIOEngine& other) = delete ;
+
+        /*!
+         * \brief Returns the engine of the calling thread, with
+         * the default parameters.
+         * \return the engine.
+         */
+        static MatrixIOEngine& get_default() ;
+
+        /*!
+         * \brief Sets whether open_read() opens the files with
+         * O_DIRECT, for all the threads. This is false by
+         * default.
+         * \param direct whether to use O_DIRECT.
+         */
+        static void set_direct(bool direct) ;
+
+        /*!
+         * \brief Gets whether open_read() opens the files with
+         * O_DIRECT.
+         * \return whether O_DIRECT is used.
+         */
+        static bool get_direct() ;
+
+        /*!
+         * \brief Opens a file to read, with O_DIRECT if
+         * get_direct() is true and if the file system
+         * supports it.
+         * \param file_address the path to the file.
+         * \return the file descriptor, -1 if the file cannot
+         * be opened.
+         */
+        static int open_read(const std::string& file_address) ;
+
+        /*!
+         * \brief Whether the transfers go through io_uring.
+         * \return whether io_uring is used.
+         */
+        bool uses_io_uring() const ;
+
+        /*!
+         * \brief Gets the largest number of blocks in flight.
+         * \return the queue depth.
+         */
+        size_t get_queue_depth() const ;
+
+        /*!
+         * \brief Gets the size of the blocks.
+         * \return the block size, in bytes.
+         */
+        size_t get_block_size() const ;
+
+        /*!
+         * \brief Reads n bytes at the given offset of a file.
+         * \param fd the file descriptor.
+         * \param dst where to store the bytes.
+         * \param n the number of bytes.
+         * \param offset the offset of the 1st byte in the file.
+         * \return whether the n bytes could be read.
+         */
+        bool read(int fd, char* dst, size_t n, uint64_t offset) ;
+
+        /*!
+         * \brief Reads the bytes of several requests, their
+         * blocks being in flight together.
+         * \param requests the requests.
+         * \return whether all the bytes could be read.
+         */
+        bool read(const std::vector<MatrixIORequest>& requests) ;
+
+        /*!
+         * \brief Writes n bytes at the given offset of a file.
+         * \param fd the file descriptor.
+         * \param src the bytes.
+         * \param n the number of bytes.
+         * \param offset the offset of the 1st byte in the file.
+         * \return whether the n bytes could be written.
+         */
+        bool write(int fd, const char* src, size_t n, uint64_t offset) ;
+
+        /*!
+         * \brief Writes the bytes of several requests, their
+         * blocks being in flight together.
+         * \param requests the requests.
+         * \return whether all the bytes could be written.
+         */
+        bool write(const std::vector<MatrixIORequest>& requests) ;
+
+    private:
+        /*!
+         * \brief A block of a request.
+         */
+        struct Block
+        {   int fd ;
+            char* buffer ;
+            size_t size ;
+            uint64_t offset ;
+            /*!
+             * \brief For the reads through an aligned buffer,
+             * the index of the buffer and the aligned range
+             * read, otherwise the index is -1.
+             */
+            int bounce ;
+            uint64_t bounce_offset ;
+            size_t bounce_size ;
+        } ;
+
+        /*!
+         * \brief Splits the requests in blocks and transfers
+         * them.
+         * \param requests the requests.
+         * \param write whether to write or to read.
+         * \return whether all the blocks could be transferred.
+         */
+        bool transfer(const std::vector<MatrixIORequest>& requests, bool write) ;
+
+        /*!
+         * \brief Transfers a block, or what remains of it, with
+         * pread() or pwrite().
+         * \param block the block.
+         * \param done the number of bytes already transferred,
+         * of the aligned range for a read through an aligned
+         * buffer.
+         * \param write whether to write or to read.
+         * \return whether the block could be transferred.
+         */
+        bool transfer_sync(Block& block, size_t done, bool write) ;
+
+        /*!
+         * \brief Copies a block read through an aligned buffer
+         * to its destination.
+         * \param block the block.
+         */
+        void copy_bounce(const Block& block) ;
+
+        /*!
+         * \brief Gets an aligned buffer.
+         * \param i the index of the buffer.
+         * \return the buffer, of block_size + 2 alignments.
+         */
+        char* get_bounce(size_t i) ;
+
+#ifdef MATRIX_IO_URING
+        /*!
+         * \brief Creates the ring.
+         * \return whether the ring could be created.
+         */
+        bool setup_ring() ;
+
+        /*!
+         * \brief Releases the ring.
+         */
+        void release_ring() ;
+
+        /*!
+         * \brief Transfers the blocks through the ring.
+         * \param blocks the blocks.
+         * \param write whether to write or to read.
+         * \return whether all the blocks could be transferred.
+         */
+        bool transfer_ring(std::vector<Block>& blocks, bool write) ;
+
+        /*!
+         * \brief Processes the completed blocks of the ring.
+         * \param blocks the blocks.
+         * \param write whether to write or to read.
+         * \param free_bounces where the aligned buffers of the
+         * completed blocks are returned.
+         * \param in_flight the number of blocks in flight,
+         * decreased by the number of completed blocks.
+         * \return whether all the completed blocks could be
+         * transferred.
+         */
+        bool reap_ring(std::vector<Block>& blocks, bool write,
+                       std::vector<int>& free_bounces, size_t& in_flight) ;
+
+        /*!
+         * \brief The ring file descriptor, -1 if there is no
+         * ring.
+         */
+        int _ring_fd = -1 ;
+        /*!
+         * \brief The mapped rings and submission entries.
+         */
+        void* _sq_ptr = nullptr ;
+        void* _cq_ptr = nullptr ;
+        size_t _sq_map_size = 0 ;
+        size_t _cq_map_size = 0 ;
+        io_uring_sqe* _sqes = nullptr ;
+        size_t _sqes_map_size = 0 ;
+        /*!
+         * \brief The fields of the submission ring.
+         */
+        unsigned* _sq_tail = nullptr ;
+        unsigned* _sq_mask = nullptr ;
+        unsigned* _sq_array = nullptr ;
+        /*!
+         * \brief The fields of the completion ring.
+         */
+        unsigned* _cq_head = nullptr ;
+        unsigned* _cq_tail = nullptr ;
+        unsigned* _cq_mask = nullptr ;
+        io_uring_cqe* _cqes = nullptr ;
+#endif
+
+        /*!
+         * \brief The largest number of blocks in flight and
+         * the size of the blocks.
+         */
+        size_t _queue_depth ;
+        size_t _block_size ;
+        /*!
+         * \brief The aligned buffers, one per block in flight,
+         * allocated when needed.
+         */
+        std::vector<char*> _bounces ;
+
+        /*!
+         * \brief Whether open_read() uses O_DIRECT.
+         */
+        static std::atomic<bool>& direct() ;
+} ;
+
+
+inline MatrixIOEngine::MatrixIOEngine(size_t queue_depth, size_t block_size, bool io_uring)
+    : _queue_depth(std::max(queue_depth, static_cast<size_t>(1))),
+      _block_size(((std::max(block_size, static_cast<size_t>(1)) + matrix_io_alignment - 1) / matrix_io_alignment) * matrix_io_alignment),
+      _bounces(_queue_depth, nullptr)
+{
+#ifdef MATRIX_IO_URING
+    if(io_uring)
+    {   this->setup_ring() ; }
+#else
+    (void)io_uring ;
+#endif
+}
+
+inline MatrixIOEngine::~MatrixIOEngine()
+{
+#ifdef MATRIX_IO_URING
+    this->release_ring() ;
+#endif
+    for(auto bounce : this->_bounces)
+    {   free(bounce) ; }
+}
+
+inline MatrixIOEngine& MatrixIOEngine::get_default()
+{   static thread_local MatrixIOEngine engine ;
+    return engine ;
+}
+
+inline std::atomic<bool>& MatrixIOEngine::direct()
+{   static std::atomic<bool> direct(false) ;
+    return direct ;
+}
+
+inline void MatrixIOEngine::set_direct(bool direct)
+{   MatrixIOEngine::direct() = direct ; }
+
+inline bool MatrixIOEngine::get_direct()
+{   return MatrixIOEngine::direct() ; }
+
+inline int MatrixIOEngine::open_read(const std::string& file_address)
+{
+#ifdef O_DIRECT
+    if(MatrixIOEngine::get_direct())
+    {   int fd = open(file_address.c_str(), O_RDONLY | O_DIRECT) ;
+        // the file system does not support O_DIRECT
+        if(fd >= 0 or errno != EINVAL)
+        {   return fd ; }
+    }
+#endif
+    return open(file_address.c_str(), O_RDONLY) ;
+}
+
+inline bool MatrixIOEngine::uses_io_uring() const
+{
+#ifdef MATRIX_IO_URING
+    return this->_ring_fd >= 0 ;
+#else
+    return false ;
+#endif
+}
+
+inline size_t MatrixIOEngine::get_queue_depth() const
+{   return this->_queue_depth ; }
+
+inline size_t MatrixIOEngine::get_block_size() const
+{   return this->_block_size ; }
+
+inline bool MatrixIOEngine::read(int fd, char* dst, size_t n, uint64_t offset)
+{   return this->transfer({MatrixIORequest{fd, dst, n, offset}}, false) ; }
+
+inline bool MatrixIOEngine::read(const std::vector<MatrixIORequest>& requests)
+{   return this->transfer(requests, false) ; }
+
+inline bool MatrixIOEngine::write(int fd, const char* src, size_t n, uint64_t offset)
+{   return this->transfer({MatrixIORequest{fd, const_cast<char*>(src), n, offset}}, true) ; }
+
+inline bool MatrixIOEngine::write(const std::vector<MatrixIORequest>& requests)
+{   return this->transfer(requests, true) ; }
+
+inline bool MatrixIOEngine::transfer(const std::vector<MatrixIORequest>& requests, bool write)
+{   std::vector<Block> blocks ;
+    for(const auto& request : requests)
+    {   bool direct = false ;
+#ifdef O_DIRECT
+        if(not write)
+        {   int flags = fcntl(request.fd, F_GETFL) ;
+            direct = flags >= 0 and (flags & O_DIRECT) ;
+        }
+#endif
+        for(size_t done=0; done<request.size; done+=this->_block_size)
+        {   Block block ;
+            block.fd     = request.fd ;
+            block.buffer = request.buffer + done ;
+            block.size   = std::min(this->_block_size, request.size - done) ;
+            block.offset = request.offset + done ;
+            block.bounce = -1 ;
+            block.bounce_offset = block.offset ;
+            block.bounce_size   = block.size ;
+            if(direct and (reinterpret_cast<uintptr_t>(block.buffer) % matrix_io_alignment != 0 or
+                           block.offset % matrix_io_alignment != 0 or
+                           block.size % matrix_io_alignment != 0))
+            {   // the index is given when the block is sent
+                block.bounce = 0 ;
+                block.bounce_offset = (block.offset / matrix_io_alignment) * matrix_io_alignment ;
+                uint64_t end = ((block.offset + block.size + matrix_io_alignment - 1) / matrix_io_alignment) * matrix_io_alignment ;
+                block.bounce_size = end - block.bounce_offset ;
+            }
+            blocks.push_back(block) ;
+        }
+    }
+
+#ifdef MATRIX_IO_URING
+    if(this->_ring_fd >= 0)
+    {   return this->transfer_ring(blocks, write) ; }
+#endif
+    bool ok = true ;
+    for(auto& block : blocks)
+    {   ok = this->transfer_sync(block, 0, write) and ok ; }
+    return ok ;
+}
+
+inline bool MatrixIOEngine::transfer_sync(Block& block, size_t done, bool write)
+{   if(write)
+    {   return pwrite_matrix_binary(block.fd, block.buffer + done, block.size - done, block.offset + done) ; }
+    if(block.bounce < 0)
+    {   return pread_matrix_binary(block.fd, block.buffer + done, block.size - done, block.offset + done) ; }
+
+    // aligned reads, the end of the file being reached before
+    // the end of the aligned range
+    char* bounce = this->get_bounce(block.bounce) ;
+    size_t needed = block.offset - block.bounce_offset + block.size ;
+    while(done < needed)
+    {   ssize_t n_read = pread(block.fd, bounce + done, block.bounce_size - done,
+                               static_cast<off_t>(block.bounce_offset + done)) ;
+        if(n_read < 0 and errno == EINTR)
+        {   continue ; }
+        if(n_read <= 0)
+        {   return false ; }
+        done += static_cast<size_t>(n_read) ;
+        // a partial aligned block, at the end of the file, is
+        // the only partial read possible
+        if(done % matrix_io_alignment != 0 and done < needed)
+        {   return false ; }
+    }
+    this->copy_bounce(block) ;
+    return true ;
+}
+
+inline void MatrixIOEngine::copy_bounce(const Block& block)
+{   const char* bounce = this->get_bounce(block.bounce) ;
+    memcpy(block.buffer, bounce + (block.offset - block.bounce_offset), block.size) ;
+}
+
+inline char* MatrixIOEngine::get_bounce(size_t i)
+{   if(this->_bounces[i] == nullptr)
+    {   void* ptr = nullptr ;
+        if(posix_memalign(&ptr, matrix_io_alignment, this->_block_size + 2*matrix_io_alignment) != 0)
+        {   throw std::bad_alloc() ; }
+        this->_bounces[i] = static_cast<char*>(ptr) ;
+    }
+    return this->_bounces[i] ;
+}
+
+#ifdef MATRIX_IO_URING
+inline bool MatrixIOEngine::setup_ring()
+{   io_uring_params params ;
+    memset(&params, 0, sizeof(params)) ;
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(this->_queue_depth), &params)) ;
+    if(fd < 0)
+    {   return false ; }
+    this->_ring_fd = fd ;
+
+    this->_sq_map_size = params.sq_off.array + params.sq_entries*sizeof(unsigned) ;
+    this->_cq_map_size = params.cq_off.cqes + params.cq_entries*sizeof(io_uring_cqe) ;
+    bool single_map = params.features & IORING_FEAT_SINGLE_MMAP ;
+    if(single_map)
+    {   this->_sq_map_size = this->_cq_map_size = std::max(this->_sq_map_size, this->_cq_map_size) ; }
+    this->_sq_ptr = mmap(nullptr, this->_sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQ_RING) ;
+    if(this->_sq_ptr == MAP_FAILED)
+    {   this->_sq_ptr = nullptr ;
+        this->release_ring() ;
+        return false ;
+    }
+    if(single_map)
+    {   this->_cq_ptr = this->_sq_ptr ; }
+    else
+    {   this->_cq_ptr = mmap(nullptr, this->_cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             fd, IORING_OFF_CQ_RING) ;
+        if(this->_cq_ptr == MAP_FAILED)
+        {   this->_cq_ptr = nullptr ;
+            this->release_ring() ;
+            return false ;
+        }
+    }
+    this->_sqes_map_size = params.sq_entries*sizeof(io_uring_sqe) ;
+    void* sqes = mmap(nullptr, this->_sqes_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES) ;
+    if(sqes == MAP_FAILED)
+    {   this->release_ring() ;
+        return false ;
+    }
+    this->_sqes = static_cast<io_uring_sqe*>(sqes) ;
+
+    char* sq = static_cast<char*>(this->_sq_ptr) ;
+    char* cq = static_cast<char*>(this->_cq_ptr) ;
+    this->_sq_tail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail) ;
+    this->_sq_mask  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask) ;
+    this->_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array) ;
+    this->_cq_head  = reinterpret_cast<unsigned*>(cq + params.cq_off.head) ;
+    this->_cq_tail  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail) ;
+    this->_cq_mask  = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask) ;
+    this->_cqes     = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes) ;
+    // the ring may have less entries than asked
+    this->_queue_depth = std::min(this->_queue_depth, static_cast<size_t>(params.sq_entries)) ;
+    return true ;
+}
+
+inline void MatrixIOEngine::release_ring()
+{   if(this->_sqes != nullptr)
+    {   munmap(this->_sqes, this->_sqes_map_size) ; }
+    if(this->_cq_ptr != nullptr and this->_cq_ptr != this->_sq_ptr)
+    {   munmap(this->_cq_ptr, this->_cq_map_size) ; }
+    if(this->_sq_ptr != nullptr)
+    {   munmap(this->_sq_ptr, this->_sq_map_size) ; }
+    if(this->_ring_fd >= 0)
+    {   close(this->_ring_fd) ; }
+    this->_sqes    = nullptr ;
+    this->_cq_ptr  = nullptr ;
+    this->_sq_ptr  = nullptr ;
+    this->_ring_fd = -1 ;
+}
+
+inline bool MatrixIOEngine::transfer_ring(std::vector<Block>& blocks, bool write)
+{   bool ok = true ;
+    std::vector<int> free_bounces ;
+    for(size_t i=0; i<this->_queue_depth; i++)
+    {   free_bounces.push_back(static_cast<int>(this->_queue_depth - 1 - i)) ; }
+    size_t next = 0 ;
+    size_t in_flight = 0 ;
+    unsigned to_submit = 0 ;
+    while(next < blocks.size() or in_flight > 0)
+    {   // fills the submission ring, only this thread writes the tail
+        unsigned tail = *this->_sq_tail ;
+        while(next < blocks.size() and in_flight < this->_queue_depth)
+        {   Block& block = blocks[next] ;
+            char* address = block.buffer ;
+            if(block.bounce >= 0)
+            {   block.bounce = free_bounces.back() ;
+                free_bounces.pop_back() ;
+                address = this->get_bounce(block.bounce) ;
+            }
+            unsigned index = tail & *this->_sq_mask ;
+            io_uring_sqe* sqe = this->_sqes + index ;
+            memset(sqe, 0, sizeof(*sqe)) ;
+            sqe->opcode    = write ? IORING_OP_WRITE : IORING_OP_READ ;
+            sqe->fd        = block.fd ;
+            sqe->addr      = reinterpret_cast<uintptr_t>(address) ;
+            sqe->len       = static_cast<unsigned>(block.bounce_size) ;
+            sqe->off       = block.bounce_offset ;
+            sqe->user_data = next ;
+            this->_sq_array[index] = index ;
+            tail++ ;
+            next++ ;
+            in_flight++ ;
+            to_submit++ ;
+        }
+        __atomic_store_n(this->_sq_tail, tail, __ATOMIC_RELEASE) ;
+
+        // submits and waits for at least one block
+        int n_submitted = static_cast<int>(syscall(__NR_io_uring_enter, this->_ring_fd, to_submit, 1,
+                                                   IORING_ENTER_GETEVENTS, nullptr, 0)) ;
+        if(n_submitted < 0)
+        {   if(errno != EINTR and errno != EAGAIN and errno != EBUSY)
+            {   // the ring cannot be used anymore. The blocks which
+                // were not submitted are taken back, the kernel may
+                // still transfer the others, which are waited for
+                // before releasing the ring and the aligned buffers
+                unsigned n_queued = to_submit ;
+                __atomic_store_n(this->_sq_tail, tail - n_queued, __ATOMIC_RELEASE) ;
+                in_flight -= n_queued ;
+                while(in_flight > 0)
+                {   ok = this->reap_ring(blocks, write, free_bounces, in_flight) and ok ;
+                    if(in_flight > 0 and
+                       syscall(__NR_io_uring_enter, this->_ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 and
+                       errno != EINTR)
+                    {   // the completions are still posted to the
+                        // ring, without waiting for them in the kernel
+                        sched_yield() ;
+                    }
+                }
+                this->release_ring() ;
+                for(size_t i=next-n_queued; i<next; i++)
+                {   ok = this->transfer_sync(blocks[i], 0, write) and ok ; }
+                for(size_t i=next; i<blocks.size(); i++)
+                {   if(blocks[i].bounce >= 0)
+                    {   blocks[i].bounce = 0 ; }
+                    ok = this->transfer_sync(blocks[i], 0, write) and ok ;
+                }
+                return ok ;
+            }
+            // nothing was submitted, with EBUSY the completion ring
+            // is full and must be reaped before submitting again
+            n_submitted = 0 ;
+        }
+        to_submit -= static_cast<unsigned>(n_submitted) ;
+        ok = this->reap_ring(blocks, write, free_bounces, in_flight) and ok ;
+    }
+    return ok ;
+}
+
+inline bool MatrixIOEngine::reap_ring(std::vector<Block>& blocks, bool write,
+                                      std::vector<int>& free_bounces, size_t& in_flight)
+{   // the completed blocks, the kernel writes the tail
+    bool ok = true ;
+    unsigned head = *this->_cq_head ;
+    unsigned cq_tail = __atomic_load_n(this->_cq_tail, __ATOMIC_ACQUIRE) ;
+    for(; head != cq_tail; head++)
+    {   const io_uring_cqe* cqe = this->_cqes + (head & *this->_cq_mask) ;
+        Block& block = blocks[cqe->user_data] ;
+        size_t done = cqe->res > 0 ? static_cast<size_t>(cqe->res) : 0 ;
+        // a failed or partial transfer is completed synchronously
+        if(done < block.bounce_size)
+        {   ok = this->transfer_sync(block, done, write) and ok ; }
+        else if(block.bounce >= 0)
+        {   this->copy_bounce(block) ; }
+        if(block.bounce >= 0)
+        {   free_bounces.push_back(block.bounce) ; }
+        in_flight-- ;
+    }
+    __atomic_store_n(this->_cq_head, head, __ATOMIC_RELEASE) ;
+    return ok ;
+}
+#endif
+
+#endif // MATRIXIOENGINE_HPP
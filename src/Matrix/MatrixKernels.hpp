@@ -0,0 +1,371 @@
+#ifndef MATRIXKERNELS_HPP
+#define MATRIXKERNELS_HPP
+
+#include <cstddef>     // size_t
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+/*!
+ * The element-wise kernels used by the Matrix classes to perform the
+ * arithmetic operations on their data. They work on contiguous arrays of
+ * values, which is how the data of any matrix is stored, regardless of its
+ * dimensionality.
+ *
+ * Every kernel has an out-of-place form, which computes
+ *          out[i] = a[i] <op> b[i]   (or a[i] <op> value)
+ * for i in [0,n). out is allowed to be equal to a (or to b), in which case
+ * the operation is performed in place.
+ *
+ * Vectorized versions of the kernels are available for float, double
+ * and int values. They are selected at compile time depending on the
+ * instruction sets the code is compiled for (AVX-512 is preferred over
+ * AVX2, -march=native or -mavx2/-mavx512f enable them). Any other type, and
+ * the remainder of an array which does not fill a whole SIMD register, are
+ * processed by a scalar loop.
+ */
+
+/*!
+ * \brief Describes the SIMD registers available to process values
+ * of type T. The generic version states that no register can be
+ * used, the specialisations below provide the loading, storing and
+ * arithmetic routines for the types supported (fmadd(a,b,c) computes
+ * a*b+c). The types supporting div() also provide has_zero(v), which
+ * tells whether any value of the register is 0.
+ */
+template<class T>
+struct simd_traits
+{   static const bool enabled = false ;
+    static const bool has_div = false ;
+} ;
+
+#if defined(__AVX512F__)
+template<>
+struct simd_traits<double>
+{   typedef __m512d type ;
+    static const bool   enabled = true ;
+    static const bool   has_div = true ;
+    static const size_t width   = 8 ;
+    static type load(const double* p)   { return _mm512_loadu_pd(p) ; }
+    static void store(double* p, type v){ _mm512_storeu_pd(p, v) ; }
+    static type set(double value)       { return _mm512_set1_pd(value) ; }
+    static type add(type a, type b)     { return _mm512_add_pd(a, b) ; }
+    static type sub(type a, type b)     { return _mm512_sub_pd(a, b) ; }
+    static type mul(type a, type b)     { return _mm512_mul_pd(a, b) ; }
+    static type div(type a, type b)     { return _mm512_div_pd(a, b) ; }
+    static bool has_zero(type v)        { return _mm512_cmpeq_pd_mask(v, _mm512_setzero_pd()) != 0 ; }
+    static type fmadd(type a, type b, type c) { return _mm512_fmadd_pd(a, b, c) ; }
+} ;
+
+template<>
+struct simd_traits<float>
+{   typedef __m512 type ;
+    static const bool   enabled = true ;
+    static const bool   has_div = true ;
+    static const size_t width   = 16 ;
+    static type load(const float* p)    { return _mm512_loadu_ps(p) ; }
+    static void store(float* p, type v) { _mm512_storeu_ps(p, v) ; }
+    static type set(float value)        { return _mm512_set1_ps(value) ; }
+    static type add(type a, type b)     { return _mm512_add_ps(a, b) ; }
+    static type sub(type a, type b)     { return _mm512_sub_ps(a, b) ; }
+    static type mul(type a, type b)     { return _mm512_mul_ps(a, b) ; }
+    static type div(type a, type b)     { return _mm512_div_ps(a, b) ; }
+    static bool has_zero(type v)        { return _mm512_cmpeq_ps_mask(v, _mm512_setzero_ps()) != 0 ; }
+    static type fmadd(type a, type b, type c) { return _mm512_fmadd_ps(a, b, c) ; }
+} ;
+
+template<>
+struct simd_traits<int>
+{   typedef __m512i type ;
+    static const bool   enabled = true ;
+    static const bool   has_div = false ;
+    static const size_t width   = 16 ;
+    static type load(const int* p)      { return _mm512_loadu_si512(p) ; }
+    static void store(int* p, type v)   { _mm512_storeu_si512(p, v) ; }
+    static type set(int value)          { return _mm512_set1_epi32(value) ; }
+    static type add(type a, type b)     { return _mm512_add_epi32(a, b) ; }
+    static type sub(type a, type b)     { return _mm512_sub_epi32(a, b) ; }
+    static type mul(type a, type b)     { return _mm512_mullo_epi32(a, b) ; }
+    static type fmadd(type a, type b, type c) { return add(mul(a, b), c) ; }
+} ;
+#elif defined(__AVX2__)
+template<>
+struct simd_traits<double>
+{   typedef __m256d type ;
+    static const bool   enabled = true ;
+    static const bool   has_div = true ;
+    static const size_t width   = 4 ;
+    static type load(const double* p)   { return _mm256_loadu_pd(p) ; }
+    static void store(double* p, type v){ _mm256_storeu_pd(p, v) ; }
+    static type set(double value)       { return _mm256_set1_pd(value) ; }
+    static type add(type a, type b)     { return _mm256_add_pd(a, b) ; }
+    static type sub(type a, type b)     { return _mm256_sub_pd(a, b) ; }
+    static type mul(type a, type b)     { return _mm256_mul_pd(a, b) ; }
+    static type div(type a, type b)     { return _mm256_div_pd(a, b) ; }
+    static bool has_zero(type v)        { return _mm256_movemask_pd(_mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_EQ_OQ)) != 0 ; }
+#if defined(__FMA__)
+    static type fmadd(type a, type b, type c) { return _mm256_fmadd_pd(a, b, c) ; }
+#else
+    static type fmadd(type a, type b, type c) { return add(mul(a, b), c) ; }
+#endif
+} ;
+
+template<>
+struct simd_traits<float>
+{   typedef __m256 type ;
+    static const bool   enabled = true ;
+    static const bool   has_div = true ;
+    static const size_t width   = 8 ;
+    static type load(const float* p)    { return _mm256_loadu_ps(p) ; }
+    static void store(float* p, type v) { _mm256_storeu_ps(p, v) ; }
+    static type set(float value)        { return _mm256_set1_ps(value) ; }
+    static type add(type a, type b)     { return _mm256_add_ps(a, b) ; }
+    static type sub(type a, type b)     { return _mm256_sub_ps(a, b) ; }
+    static type mul(type a, type b)     { return _mm256_mul_ps(a, b) ; }
+    static type div(type a, type b)     { return _mm256_div_ps(a, b) ; }
+    static bool has_zero(type v)        { return _mm256_movemask_ps(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_EQ_OQ)) != 0 ; }
+#if defined(__FMA__)
+    static type fmadd(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c) ; }
+#else
+    static type fmadd(type a, type b, type c) { return add(mul(a, b), c) ; }
+#endif
+} ;
+
+template<>
+struct simd_traits<int>
+{   typedef __m256i type ;
+    static const bool   enabled = true ;
+    static const bool   has_div = false ;
+    static const size_t width   = 8 ;
+    static type load(const int* p)      { return _mm256_loadu_si256(reinterpret_cast<const type*>(p)) ; }
+    static void store(int* p, type v)   { _mm256_storeu_si256(reinterpret_cast<type*>(p), v) ; }
+    static type set(int value)          { return _mm256_set1_epi32(value) ; }
+    static type add(type a, type b)     { return _mm256_add_epi32(a, b) ; }
+    static type sub(type a, type b)     { return _mm256_sub_epi32(a, b) ; }
+    static type mul(type a, type b)     { return _mm256_mullo_epi32(a, b) ; }
+    static type fmadd(type a, type b, type c) { return add(mul(a, b), c) ; }
+} ;
+#endif
+
+// the arithmetic operations
+/*!
+ * \brief Addition.
+ */
+struct kernel_add
+{   template<class T>
+    static T apply(T a, T b)
+    {   return a + b ; }
+    template<class S>
+    static typename S::type apply_simd(typename S::type a, typename S::type b)
+    {   return S::add(a, b) ; }
+    template<class T>
+    struct vectorized
+    {   static const bool value = simd_traits<T>::enabled ; } ;
+} ;
+
+/*!
+ * \brief Substraction.
+ */
+struct kernel_sub
+{   template<class T>
+    static T apply(T a, T b)
+    {   return a - b ; }
+    template<class S>
+    static typename S::type apply_simd(typename S::type a, typename S::type b)
+    {   return S::sub(a, b) ; }
+    template<class T>
+    struct vectorized
+    {   static const bool value = simd_traits<T>::enabled ; } ;
+} ;
+
+/*!
+ * \brief Multiplication.
+ */
+struct kernel_mul
+{   template<class T>
+    static T apply(T a, T b)
+    {   return a * b ; }
+    template<class S>
+    static typename S::type apply_simd(typename S::type a, typename S::type b)
+    {   return S::mul(a, b) ; }
+    template<class T>
+    struct vectorized
+    {   static const bool value = simd_traits<T>::enabled ; } ;
+} ;
+
+/*!
+ * \brief Division. There is no SIMD integer division, this
+ * operation is only vectorized for floating point values.
+ */
+struct kernel_div
+{   template<class T>
+    static T apply(T a, T b)
+    {   return a / b ; }
+    template<class S>
+    static typename S::type apply_simd(typename S::type a, typename S::type b)
+    {   return S::div(a, b) ; }
+    template<class T>
+    struct vectorized
+    {   static const bool value = simd_traits<T>::enabled and simd_traits<T>::has_div ; } ;
+} ;
+
+
+/*!
+ * \brief Scalar implementation of the element-wise kernels.
+ */
+template<class Op, class T, bool vectorized = Op::template vectorized<T>::value>
+struct elementwise_kernel
+{   static void run(const T* a, const T* b, T* out, size_t n)
+    {   for(size_t i=0; i<n; i++)
+        {   out[i] = Op::apply(a[i], b[i]) ; }
+    }
+
+    static void run(const T* a, T value, T* out, size_t n)
+    {   for(size_t i=0; i<n; i++)
+        {   out[i] = Op::apply(a[i], value) ; }
+    }
+} ;
+
+/*!
+ * \brief SIMD implementation of the element-wise kernels. The
+ * values which do not fill an entire register at the end of the
+ * arrays are processed by a scalar loop.
+ */
+template<class Op, class T>
+struct elementwise_kernel<Op, T, true>
+{   typedef simd_traits<T> S ;
+
+    static void run(const T* a, const T* b, T* out, size_t n)
+    {   size_t i = 0 ;
+        for(; i+S::width<=n; i+=S::width)
+        {   S::store(out+i, Op::template apply_simd<S>(S::load(a+i), S::load(b+i))) ; }
+        for(; i<n; i++)
+        {   out[i] = Op::apply(a[i], b[i]) ; }
+    }
+
+    static void run(const T* a, T value, T* out, size_t n)
+    {   typename S::type v = S::set(value) ;
+        size_t i = 0 ;
+        for(; i+S::width<=n; i+=S::width)
+        {   S::store(out+i, Op::template apply_simd<S>(S::load(a+i), v)) ; }
+        for(; i<n; i++)
+        {   out[i] = Op::apply(a[i], value) ; }
+    }
+} ;
+
+
+/*!
+ * \brief Computes out[i] = a[i] + b[i] for i in [0,n).
+ * out may be equal to a or b.
+ * \param a the 1st operand values.
+ * \param b the 2nd operand values.
+ * \param out where the results will be stored.
+ * \param n the number of values.
+ */
+template<class T>
+inline void kernel_add_arrays(const T* a, const T* b, T* out, size_t n)
+{   elementwise_kernel<kernel_add, T>::run(a, b, out, n) ; }
+
+/*!
+ * \brief Computes out[i] = a[i] - b[i] for i in [0,n).
+ * out may be equal to a or b.
+ * \param a the 1st operand values.
+ * \param b the 2nd operand values.
+ * \param out where the results will be stored.
+ * \param n the number of values.
+ */
+template<class T>
+inline void kernel_sub_arrays(const T* a, const T* b, T* out, size_t n)
+{   elementwise_kernel<kernel_sub, T>::run(a, b, out, n) ; }
+
+/*!
+ * \brief Computes out[i] = a[i] * b[i] for i in [0,n).
+ * out may be equal to a or b.
+ * \param a the 1st operand values.
+ * \param b the 2nd operand values.
+ * \param out where the results will be stored.
+ * \param n the number of values.
+ */
+template<class T>
+inline void kernel_mul_arrays(const T* a, const T* b, T* out, size_t n)
+{   elementwise_kernel<kernel_mul, T>::run(a, b, out, n) ; }
+
+/*!
+ * \brief Computes out[i] = a[i] / b[i] for i in [0,n).
+ * out may be equal to a or b. No check is performed on
+ * the values of b.
+ * \param a the 1st operand values.
+ * \param b the 2nd operand values.
+ * \param out where the results will be stored.
+ * \param n the number of values.
+ */
+template<class T>
+inline void kernel_div_arrays(const T* a, const T* b, T* out, size_t n)
+{   elementwise_kernel<kernel_div, T>::run(a, b, out, n) ; }
+
+/*!
+ * \brief Computes out[i] = a[i] + value for i in [0,n).
+ * out may be equal to a.
+ * \param a the operand values.
+ * \param value the value to add.
+ * \param out where the results will be stored.
+ * \param n the number of values.
+ */
+template<class T>
+inline void kernel_add_value(const T* a, T value, T* out, size_t n)
+{   elementwise_kernel<kernel_add, T>::run(a, value, out, n) ; }
+
+/*!
+ * \brief Computes out[i] = a[i] - value for i in [0,n).
+ * out may be equal to a.
+ * \param a the operand values.
+ * \param value the value to substract.
+ * \param out where the results will be stored.
+ * \param n the number of values.
+ */
+template<class T>
+inline void kernel_sub_value(const T* a, T value, T* out, size_t n)
+{   elementwise_kernel<kernel_sub, T>::run(a, value, out, n) ; }
+
+/*!
+ * \brief Computes out[i] = a[i] * value for i in [0,n).
+ * out may be equal to a.
+ * \param a the operand values.
+ * \param value the value to multiply by.
+ * \param out where the results will be stored.
+ * \param n the number of values.
+ */
+template<class T>
+inline void kernel_mul_value(const T* a, T value, T* out, size_t n)
+{   elementwise_kernel<kernel_mul, T>::run(a, value, out, n) ; }
+
+/*!
+ * \brief Computes out[i] = a[i] / value for i in [0,n).
+ * out may be equal to a. No check is performed on value.
+ * \param a the operand values.
+ * \param value the value to divide by.
+ * \param out where the results will be stored.
+ * \param n the number of values.
+ */
+template<class T>
+inline void kernel_div_value(const T* a, T value, T* out, size_t n)
+{   elementwise_kernel<kernel_div, T>::run(a, value, out, n) ; }
+
+/*!
+ * \brief Checks whether any of the n given values is
+ * equal to 0.
+ * \param a the values.
+ * \param n the number of values.
+ * \return whether a 0 value was found.
+ */
+template<class T>
+inline bool kernel_has_zero(const T* a, size_t n)
+{   bool found = false ;
+    for(size_t i=0; i<n; i++)
+    {   found |= (a[i] == static_cast<T>(0)) ; }
+    return found ;
+}
+
+#endif // MATRIXKERNELS_HPP
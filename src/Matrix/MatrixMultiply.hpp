@@ -0,0 +1,296 @@
+#ifndef MATRIXMULTIPLY_HPP
+#define MATRIXMULTIPLY_HPP
+
+#include <vector>
+#include <algorithm>   // min(), fill()
+
+#include "MatrixKernels.hpp"
+#include "ThreadPool.hpp"
+
+
+/*!
+ * The general matrix multiplication C = A * B, where A is a m x k matrix,
+ * B a k x n matrix and C a m x n matrix, all stored contiguously in row
+ * major order (which is how the Matrix2D class stores its data).
+ *
+ * The implementation follows the usual scheme of optimized BLAS libraries :
+ * - B is cut into blocks of KC rows and NC columns, which are copied
+ *   (packed) into a buffer as panels of NR columns, such that the values
+ *   needed by the micro-kernel are contiguous.
+ * - A is cut into blocks of MC rows and KC columns, packed as panels of
+ *   MR rows. A packed block of A fits in the L2 cache and a panel of
+ *   B in the L1 cache.
+ * - A micro-kernel computes a MR x NR block of C, keeping it in registers,
+ *   from a panel of A and a panel of B.
+ * The blocks of A are distributed among the threads of a pool, each thread
+ * packing its own blocks, while the packed block of B is shared.
+ *
+ * The micro-kernel uses SIMD registers when available for the type of
+ * the values (see MatrixKernels.hpp), a scalar version otherwise.
+ */
+
+
+/*!
+ * \brief The scalar micro-kernel, computes a MR x NR block of C
+ * from a packed panel of A and a packed panel of B.
+ */
+template<class T, bool vectorized = simd_traits<T>::enabled>
+struct gemm_micro_kernel
+{   static const size_t MR = 4 ;
+    static const size_t NR = 4 ;
+
+    /*!
+     * \brief Computes C = A * B (or C += A * B).
+     * \param kc the number of columns of the A panel and
+     * of rows of the B panel.
+     * \param a the packed A panel, MR values per column.
+     * \param b the packed B panel, NR values per row.
+     * \param c the address of the 1st value of the C block.
+     * \param ldc the row length of C.
+     * \param accumulate whether the product should be added
+     * to the content of C rather than overwriting it.
+     */
+    static void run(size_t kc, const T* a, const T* b, T* c, size_t ldc, bool accumulate)
+    {   T acc[MR][NR] ;
+        for(size_t i=0; i<MR; i++)
+        {   for(size_t j=0; j<NR; j++)
+            {   acc[i][j] = static_cast<T>(0) ; }
+        }
+        for(size_t k=0; k<kc; k++, a+=MR, b+=NR)
+        {   for(size_t i=0; i<MR; i++)
+            {   for(size_t j=0; j<NR; j++)
+                {   acc[i][j] += a[i] * b[j] ; }
+            }
+        }
+        for(size_t i=0; i<MR; i++)
+        {   for(size_t j=0; j<NR; j++)
+            {   c[i*ldc+j] = accumulate ? c[i*ldc+j] + acc[i][j] : acc[i][j] ; }
+        }
+    }
+} ;
+
+/*!
+ * \brief The SIMD micro-kernel, each row of the C block is kept
+ * in two registers.
+ */
+template<class T>
+struct gemm_micro_kernel<T, true>
+{   typedef simd_traits<T> S ;
+    typedef typename S::type V ;
+    static const size_t MR = 6 ;
+    static const size_t NR = 2*S::width ;
+
+    /*!
+     * \brief Computes C = A * B (or C += A * B).
+     * \param kc the number of columns of the A panel and
+     * of rows of the B panel.
+     * \param a the packed A panel, MR values per column.
+     * \param b the packed B panel, NR values per row.
+     * \param c the address of the 1st value of the C block.
+     * \param ldc the row length of C.
+     * \param accumulate whether the product should be added
+     * to the content of C rather than overwriting it.
+     */
+    static void run(size_t kc, const T* a, const T* b, T* c, size_t ldc, bool accumulate)
+    {   V acc[MR][2] ;
+        for(size_t i=0; i<MR; i++)
+        {   acc[i][0] = S::set(static_cast<T>(0)) ;
+            acc[i][1] = S::set(static_cast<T>(0)) ;
+        }
+        for(size_t k=0; k<kc; k++, a+=MR, b+=NR)
+        {   V b0 = S::load(b) ;
+            V b1 = S::load(b + S::width) ;
+            for(size_t i=0; i<MR; i++)
+            {   V ai = S::set(a[i]) ;
+                acc[i][0] = S::fmadd(ai, b0, acc[i][0]) ;
+                acc[i][1] = S::fmadd(ai, b1, acc[i][1]) ;
+            }
+        }
+        for(size_t i=0; i<MR; i++)
+        {   T* ci = c + i*ldc ;
+            if(accumulate)
+            {   acc[i][0] = S::add(acc[i][0], S::load(ci)) ;
+                acc[i][1] = S::add(acc[i][1], S::load(ci + S::width)) ;
+            }
+            S::store(ci, acc[i][0]) ;
+            S::store(ci + S::width, acc[i][1]) ;
+        }
+    }
+} ;
+
+template<class T, bool vectorized>
+const size_t gemm_micro_kernel<T, vectorized>::MR ;
+template<class T, bool vectorized>
+const size_t gemm_micro_kernel<T, vectorized>::NR ;
+template<class T>
+const size_t gemm_micro_kernel<T, true>::MR ;
+template<class T>
+const size_t gemm_micro_kernel<T, true>::NR ;
+
+/*!
+ * \brief The cache blocking parameters. MC is a multiple of all
+ * the possible values of MR and NC of all the possible values of
+ * NR.
+ */
+struct gemm_blocking
+{   static const size_t KC = 256 ;
+    static const size_t MC = 96 ;
+    static const size_t NC = 4096 ;
+} ;
+
+/*!
+ * \brief Packs a mc x kc block of A into panels of MR rows. Within
+ * a panel, the MR values of each column are contiguous. The last
+ * panel is padded with 0 values.
+ * \param mc the number of rows of the block.
+ * \param kc the number of columns of the block.
+ * \param a the address of the 1st value of the block.
+ * \param lda the row length of A.
+ * \param buffer where to pack the block.
+ */
+template<class T, size_t MR>
+void gemm_pack_a(size_t mc, size_t kc, const T* a, size_t lda, T* buffer)
+{   for(size_t i=0; i<mc; i+=MR)
+    {   size_t mr = (mc - i < MR) ? (mc - i) : MR ;
+        for(size_t k=0; k<kc; k++)
+        {   for(size_t ii=0; ii<mr; ii++)
+            {   *(buffer++) = a[(i+ii)*lda + k] ; }
+            for(size_t ii=mr; ii<MR; ii++)
+            {   *(buffer++) = static_cast<T>(0) ; }
+        }
+    }
+}
+
+/*!
+ * \brief Packs a kc x nr panel of B, padded to NR columns with 0
+ * values. The NR values of each row are contiguous.
+ * \param kc the number of rows of the panel.
+ * \param nr the number of columns of the panel.
+ * \param b the address of the 1st value of the panel.
+ * \param ldb the row length of B.
+ * \param buffer where to pack the panel.
+ */
+template<class T, size_t NR>
+void gemm_pack_b(size_t kc, size_t nr, const T* b, size_t ldb, T* buffer)
+{   for(size_t k=0; k<kc; k++)
+    {   const T* bk = b + k*ldb ;
+        for(size_t j=0; j<nr; j++)
+        {   *(buffer++) = bk[j] ; }
+        for(size_t j=nr; j<NR; j++)
+        {   *(buffer++) = static_cast<T>(0) ; }
+    }
+}
+
+/*!
+ * \brief Computes a mc x nc block of C from a packed block of A
+ * and a packed block of B, using the micro-kernel. The blocks of
+ * C on the borders, which are smaller than MR x NR, are computed
+ * in a temporary buffer.
+ * \param mc the number of rows of the block.
+ * \param nc the number of columns of the block.
+ * \param kc the number of columns of A (rows of B) packed.
+ * \param a the packed block of A.
+ * \param b the packed block of B.
+ * \param c the address of the 1st value of the C block.
+ * \param ldc the row length of C.
+ * \param accumulate whether the product should be added to
+ * the content of C rather than overwriting it.
+ */
+template<class T>
+void gemm_macro_kernel(size_t mc, size_t nc, size_t kc, const T* a, const T* b,
+                       T* c, size_t ldc, bool accumulate)
+{   typedef gemm_micro_kernel<T> kernel ;
+    const size_t MR = kernel::MR ;
+    const size_t NR = kernel::NR ;
+    T c_tmp[MR*NR] ;
+
+    for(size_t j=0; j<nc; j+=NR)
+    {   size_t nr = (nc - j < NR) ? (nc - j) : NR ;
+        const T* b_panel = b + (j/NR)*kc*NR ;
+        for(size_t i=0; i<mc; i+=MR)
+        {   size_t mr = (mc - i < MR) ? (mc - i) : MR ;
+            const T* a_panel = a + (i/MR)*kc*MR ;
+            T* c_block = c + i*ldc + j ;
+            if(mr == MR and nr == NR)
+            {   kernel::run(kc, a_panel, b_panel, c_block, ldc, accumulate) ; }
+            else
+            {   kernel::run(kc, a_panel, b_panel, c_tmp, NR, false) ;
+                for(size_t ii=0; ii<mr; ii++)
+                {   for(size_t jj=0; jj<nr; jj++)
+                    {   T& value = c_block[ii*ldc + jj] ;
+                        value = accumulate ? value + c_tmp[ii*NR + jj] : c_tmp[ii*NR + jj] ;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * \brief Computes C = A * B where A is a m x k matrix, B a k x n
+ * matrix and C a m x n matrix, stored contiguously in row major
+ * order. The previous content of C is ignored.
+ * \param m the number of rows of A and C.
+ * \param n the number of columns of B and C.
+ * \param k the number of columns of A and rows of B.
+ * \param a the values of A.
+ * \param b the values of B.
+ * \param c where to write the values of C, C should not
+ * overlap with A or B.
+ * \param pool the threads to use.
+ */
+template<class T>
+void gemm(size_t m, size_t n, size_t k, const T* a, const T* b, T* c, ThreadPool& pool)
+{   typedef gemm_micro_kernel<T> kernel ;
+    const size_t MR = kernel::MR ;
+    const size_t NR = kernel::NR ;
+    const size_t KC = gemm_blocking::KC ;
+    const size_t MC = gemm_blocking::MC ;
+    const size_t NC = gemm_blocking::NC ;
+
+    if(m == 0 or n == 0)
+    {   return ; }
+    if(k == 0)
+    {   std::fill(c, c + m*n, static_cast<T>(0)) ;
+        return ;
+    }
+
+    size_t nc_max = std::min(NC, ((n + NR - 1)/NR)*NR) ;
+    size_t kc_max = std::min(KC, k) ;
+    std::vector<T> b_pack(kc_max*nc_max) ;
+
+    for(size_t jc=0; jc<n; jc+=NC)
+    {   size_t nc = std::min(NC, n - jc) ;
+        for(size_t pc=0; pc<k; pc+=KC)
+        {   size_t kc = std::min(KC, k - pc) ;
+            bool accumulate = pc > 0 ;
+
+            // pack B block, panel by panel
+            size_t n_panels = (nc + NR - 1)/NR ;
+            pool.parallel_for(0, n_panels,
+                              [&](size_t from, size_t to)
+                              {   for(size_t p=from; p<to; p++)
+                                  {   size_t nr = std::min(NR, nc - p*NR) ;
+                                      gemm_pack_b<T,NR>(kc, nr, b + pc*n + jc + p*NR, n,
+                                                        b_pack.data() + p*kc*NR) ;
+                                  }
+                              }) ;
+
+            // pack A blocks and compute the corresponding C blocks
+            size_t n_blocks = (m + MC - 1)/MC ;
+            pool.parallel_for(0, n_blocks,
+                              [&](size_t from, size_t to)
+                              {   std::vector<T> a_pack(MC*kc) ;
+                                  for(size_t block=from; block<to; block++)
+                                  {   size_t ic = block*MC ;
+                                      size_t mc = std::min(MC, m - ic) ;
+                                      gemm_pack_a<T,MR>(mc, kc, a + ic*k + pc, k, a_pack.data()) ;
+                                      gemm_macro_kernel<T>(mc, nc, kc, a_pack.data(), b_pack.data(),
+                                                           c + ic*n + jc, n, accumulate) ;
+                                  }
+                              }) ;
+        }
+    }
+}
+
+#endif // MATRIXMULTIPLY_HPP
@@ -0,0 +1,549 @@
+#ifndef MATRIXN_HPP
+#define MATRIXN_HPP
+
+#include <Matrix.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+#include <utility>    // std::move()
+#include <stdexcept>  // invalid_argument
+
+/*!
+ * The MatrixN class is a specialisation of the Matrix class for
+ * matrices which number of dimensions N is known at compile time.
+ *
+ * The dimensions and the strides (the distance, in number of
+ * elements, between two consecutive elements along each dimension)
+ * are stored in std::array's of length N. The offset of an element
+ * is thus computed from its N coordinates, given as separate
+ * arguments, with N multiplications and additions which the compiler
+ * can fully unroll and inline, without any temporary vector nor
+ * table lookup. Generic N dimensional code can thus access the
+ * elements as fast as it would through a raw pointer.
+ *
+ * As for all the other matrix classes, the coordinates are given as
+ * (row, column, 3rd dimension, ...).
+ */
+template<class T, size_t N>
+class MatrixN : public Matrix<T>
+{
+    static_assert(N > 0, "a matrix should have at least one dimension") ;
+
+    public:
+        // constructors
+        /*!
+         * Default constructor.
+         */
+        MatrixN() = default ;
+
+        /*!
+         * \brief Constructs a matrix with the given dimensions,
+         * filled with 0 values.
+         * \param dim the dimensions, as (row, column, ...).
+         */
+        MatrixN(const std::array<size_t,N>& dim) ;
+
+        /*!
+         * \brief Constructs a matrix with the given dimensions and
+         * initialize the values to the given value.
+         * \param dim the dimensions, as (row, column, ...).
+         * \param value the value to initialize the matrix content
+         * with.
+         */
+        MatrixN(const std::array<size_t,N>& dim, T value) ;
+
+        /*!
+         * \brief Copy constructor
+         * \param other the matrix to copy the values from.
+         */
+        MatrixN(const MatrixN& other) ;
+
+        /*!
+         * \brief Move constructor
+         * \param other the matrix to use the values from.
+         */
+        MatrixN(MatrixN&& other) ;
+
+        /*!
+         * \brief Constructs a matrix by copying any matrix with
+         * N dimensions (for instance a Matrix3D when N is 3).
+         * \param other the matrix to copy the values from.
+         * \throw std::invalid_argument if the matrix does not
+         * have N dimensions.
+         */
+        MatrixN(const Matrix<T>& other) ;
+
+        /*!
+         * \brief Constructs a matrix by evaluating an expression.
+         * \param e the expression of interest.
+         * \throw std::invalid_argument if the expression does not
+         * have N dimensions.
+         */
+        template<class E, class = typename std::enable_if<matrix_expression_has_dim_number<E,N>::value>::type>
+        MatrixN(const MatrixExpression<E>& e) ;
+
+        /*!
+         * \brief Destructor.
+         */
+        virtual ~MatrixN() ;
+
+        // methods overloaded from Matrix
+        using Matrix<T>::get ;
+        using Matrix<T>::set ;
+
+        // methods overriden from Matrix, which also update the
+        // strides
+        /*!
+         * \brief See Matrix::load().
+         * \throw std::invalid_argument if dim_n is not N.
+         */
+        virtual void load(const std::string& file_address,
+                          size_t dim_n) override ;
+
+        /*!
+         * \brief See Matrix::load_region().
+         * \throw std::invalid_argument if dim_n is not N.
+         */
+        virtual void load_region(const std::string& file_address,
+                                 size_t dim_n,
+                                 const std::vector<size_t>& origin,
+                                 const std::vector<size_t>& extent) override ;
+
+        /*!
+         * \brief See Matrix::map().
+         * \throw std::invalid_argument if dim_n is not N.
+         */
+        virtual void map(const std::string& file_address,
+                         size_t dim_n,
+                         MatrixMapMode mode) override ;
+
+        /*!
+         * \brief See Matrix::load_npy().
+         * \throw std::invalid_argument if dim_n is not N.
+         */
+        virtual void load_npy(const std::string& file_address,
+                              size_t dim_n,
+                              const std::string& name="") override ;
+
+        /*!
+         * \brief See Matrix::map_npy().
+         * \throw std::invalid_argument if dim_n is not N.
+         */
+        virtual void map_npy(const std::string& file_address,
+                             size_t dim_n,
+                             MatrixMapMode mode,
+                             const std::string& name="") override ;
+
+        /*!
+         * \brief See Matrix::attach_shared().
+         * \throw std::invalid_argument if dim_n is not N.
+         */
+        virtual void attach_shared(const std::string& name,
+                                   size_t dim_n) override ;
+
+        // methods
+        /*!
+         * \brief loads a binary file containing a matrix
+         * with N dimensions. See Matrix::load().
+         * \param path the path to the file.
+         * \throw std::runtime_error if the file cannot be
+         * read or does not contain a matrix with N
+         * dimensions.
+         */
+        void load(const std::string& file_address) ;
+
+        /*!
+         * \brief maps a binary file containing a matrix
+         * with N dimensions in memory, the values are read
+         * lazily when they are accessed. See Matrix::map().
+         * \param path the path to the file.
+         * \param mode how the file is mapped.
+         * \throw std::runtime_error if the file cannot be
+         * mapped or does not contain a matrix with N
+         * dimensions.
+         */
+        void map(const std::string& file_address,
+                 MatrixMapMode mode=MatrixMapMode::read_only) ;
+
+        /*!
+         * \brief loads a NumPy .npy file, or an array of a
+         * .npz file, containing a matrix with N
+         * dimensions. See Matrix::load_npy().
+         * \param path the path to the file.
+         * \param name in a .npz file, the name of the array,
+         * by default the 1st array.
+         * \throw std::runtime_error if the file cannot be
+         * read or does not contain a matrix with N
+         * dimensions.
+         */
+        void load_npy(const std::string& file_address,
+                      const std::string& name="") ;
+
+        /*!
+         * \brief maps a NumPy .npy file, or an array of a
+         * .npz file, containing a matrix with N
+         * dimensions in memory. See
+         * Matrix::map_npy().
+         * \param path the path to the file.
+         * \param mode how the file is mapped.
+         * \param name in a .npz file, the name of the array,
+         * by default the 1st array.
+         * \throw std::runtime_error if the file cannot be
+         * mapped or does not contain a matrix with N
+         * dimensions.
+         */
+        void map_npy(const std::string& file_address,
+                     MatrixMapMode mode=MatrixMapMode::read_only,
+                     const std::string& name="") ;
+
+        /*!
+         * \brief attaches to a POSIX shared memory object
+         * containing a matrix with N dimensions, read-only.
+         * See Matrix::attach_shared().
+         * \param name the name of the object.
+         * \throw std::runtime_error if the object cannot be
+         * mapped or does not contain a matrix with N
+         * dimensions.
+         */
+        void attach_shared(const std::string& name) ;
+
+        /*!
+         * \brief loads a region of a matrix with N dimensions
+         * stored in a binary file, without reading the rest of
+         * the file. See Matrix::load_region().
+         * \param path the path to the file.
+         * \param origin the coordinates of the 1st element of
+         * the region, as (row, column, ...).
+         * \param extent the dimensions of the region, as (row,
+         * column, ...).
+         * \throw std::runtime_error if the file cannot be
+         * read or does not contain a matrix with N dimensions
+         * and std::out_of_range if the region does not fit
+         * within the stored matrix.
+         */
+        void load_region(const std::string& file_address,
+                         const std::vector<size_t>& origin,
+                         const std::vector<size_t>& extent) ;
+
+        /*!
+         * \brief Gets the matrix dimensions.
+         * \return the dimensions, as (row, column, ...).
+         */
+        const std::array<size_t,N>& get_dim_array() const ;
+
+        /*!
+         * \brief Gets the strides, that is the distance between
+         * two consecutive elements along each dimension.
+         * \return the strides, as (row, column, ...).
+         */
+        const std::array<size_t,N>& get_strides() const ;
+
+        /*!
+         * \brief Computes the offset of the element at the given
+         * coordinates. This method does not perform any check on
+         * the coordinates.
+         * \param coord the N coordinates of the element.
+         * \return the offset of the element.
+         */
+        template<class... Idx>
+        size_t get_offset(Idx... coord) const ;
+
+        // operators
+        /*!
+         * Assignment operator.
+         * \param other an other matrix to copy the values from.
+         * \return a reference to the current the instance.
+         */
+        MatrixN& operator = (const MatrixN& other) ;
+
+        /*!
+         * Move Assignment operator.
+         * \param other an other matrix to use the values from.
+         * \return a reference to the instance.
+         */
+        MatrixN& operator = (MatrixN&& other) ;
+
+        /*!
+         * Assignment operator, evaluates an expression and stores
+         * the result. The expression may involve the instance itself.
+         * \param e the expression of interest.
+         * \throw std::invalid_argument if the expression does not
+         * have N dimensions.
+         * \return a reference to the instance.
+         */
+        template<class E>
+        MatrixN& operator = (const MatrixExpression<E>& e) ;
+
+        /*!
+         * \brief Returns a reference to the corrresponding
+         * element. This method does not perform any check on
+         * the coordinates.
+         * \param coord the N coordinates of the element.
+         * \return a reference to this element.
+         */
+        template<class... Idx>
+        T& operator () (Idx... coord) ;
+
+        /*!
+         * \brief Returns a constant reference to the corrresponding
+         * element. This method does not perform any check on
+         * the coordinates.
+         * \param coord the N coordinates of the element.
+         * \return a constant reference to this element.
+         */
+        template<class... Idx>
+        const T& operator () (Idx... coord) const ;
+
+    private:
+        // methods
+        /*!
+         * \brief Fills the dimension and the stride arrays
+         * from the dimensions stored in the Matrix fields.
+         */
+        void compute_strides() ;
+
+        /*!
+         * \brief Checks a number of dimensions given to the
+         * methods overriden from Matrix.
+         * \param dim_n the number of dimensions.
+         * \throw std::invalid_argument if dim_n is not N.
+         */
+        void check_dim_number(size_t dim_n) const ;
+
+        // fields
+        /*!
+         * \brief The dimensions, as (row, column, ...).
+         */
+        std::array<size_t,N> _dim_array = {} ;
+        /*!
+         * \brief The strides, as (row, column, ...).
+         */
+        std::array<size_t,N> _strides = {} ;
+} ;
+
+/*!
+ * \brief The number of dimensions of a MatrixN, used to
+ * type the expressions involving it (see MatrixExpression.hpp).
+ */
+template<class T, size_t N>
+struct matrix_dim_number<MatrixN<T,N>>
+{   static const size_t value = N ; } ;
+
+
+// method implementation
+template<class T, size_t N>
+MatrixN<T,N>::MatrixN(const std::array<size_t,N>& dim)
+    : MatrixN<T,N>(dim, 0)
+{}
+
+template<class T, size_t N>
+MatrixN<T,N>::MatrixN(const std::array<size_t,N>& dim, T value)
+    : Matrix<T>(std::vector<size_t>(dim.begin(), dim.end()), value)
+{   this->compute_strides() ; }
+
+template<class T, size_t N>
+MatrixN<T,N>::MatrixN(const MatrixN& other)
+    : Matrix<T>(other),
+      _dim_array(other._dim_array),
+      _strides(other._strides)
+{}
+
+template<class T, size_t N>
+MatrixN<T,N>::MatrixN(MatrixN&& other)
+    : Matrix<T>(std::move(other)),
+      _dim_array(other._dim_array),
+      _strides(other._strides)
+{   other.compute_strides() ; }
+
+template<class T, size_t N>
+MatrixN<T,N>::MatrixN(const Matrix<T>& other)
+    : Matrix<T>(other)
+{   if(this->_dim_size != N)
+    {   throw std::invalid_argument("the matrix does not have the expected number of dimensions!") ; }
+    this->compute_strides() ;
+}
+
+template<class T, size_t N>
+template<class E, class>
+MatrixN<T,N>::MatrixN(const MatrixExpression<E>& e)
+    : Matrix<T>(e)
+{   if(this->_dim_size != N)
+    {   throw std::invalid_argument("the expression does not have the expected number of dimensions!") ; }
+    this->compute_strides() ;
+}
+
+template<class T, size_t N>
+MatrixN<T,N>::~MatrixN()
+{   if(this->_data != nullptr)
+    {   delete this->_data ;
+        this->_data = nullptr ;
+    }
+}
+
+template<class T, size_t N>
+void MatrixN<T,N>::load(const std::string& file_address,
+                        size_t dim_n)
+{   this->check_dim_number(dim_n) ;
+    Matrix<T>::load(file_address, N) ;
+    this->compute_strides() ;
+}
+
+template<class T, size_t N>
+void MatrixN<T,N>::load_region(const std::string& file_address,
+                               size_t dim_n,
+                               const std::vector<size_t>& origin,
+                               const std::vector<size_t>& extent)
+{   this->check_dim_number(dim_n) ;
+    Matrix<T>::load_region(file_address, N, origin, extent) ;
+    this->compute_strides() ;
+}
+
+template<class T, size_t N>
+void MatrixN<T,N>::map(const std::string& file_address,
+                       size_t dim_n,
+                       MatrixMapMode mode)
+{   this->check_dim_number(dim_n) ;
+    Matrix<T>::map(file_address, N, mode) ;
+    this->compute_strides() ;
+}
+
+template<class T, size_t N>
+void MatrixN<T,N>::load_npy(const std::string& file_address,
+                            size_t dim_n,
+                            const std::string& name)
+{   this->check_dim_number(dim_n) ;
+    Matrix<T>::load_npy(file_address, N, name) ;
+    this->compute_strides() ;
+}
+
+template<class T, size_t N>
+void MatrixN<T,N>::map_npy(const std::string& file_address,
+                           size_t dim_n,
+                           MatrixMapMode mode,
+                           const std::string& name)
+{   this->check_dim_number(dim_n) ;
+    Matrix<T>::map_npy(file_address, N, mode, name) ;
+    this->compute_strides() ;
+}
+
+template<class T, size_t N>
+void MatrixN<T,N>::attach_shared(const std::string& name,
+                                 size_t dim_n)
+{   this->check_dim_number(dim_n) ;
+    Matrix<T>::attach_shared(name, N) ;
+    this->compute_strides() ;
+}
+
+template<class T, size_t N>
+void MatrixN<T,N>::load(const std::string& file_address)
+{   this->load(file_address, N) ; }
+
+template<class T, size_t N>
+void MatrixN<T,N>::map(const std::string& file_address,
+                       MatrixMapMode mode)
+{   this->map(file_address, N, mode) ; }
+
+template<class T, size_t N>
+void MatrixN<T,N>::load_npy(const std::string& file_address,
+                            const std::string& name)
+{   this->load_npy(file_address, N, name) ; }
+
+template<class T, size_t N>
+void MatrixN<T,N>::map_npy(const std::string& file_address,
+                           MatrixMapMode mode,
+                           const std::string& name)
+{   this->map_npy(file_address, N, mode, name) ; }
+
+template<class T, size_t N>
+void MatrixN<T,N>::attach_shared(const std::string& name)
+{   this->attach_shared(name, N) ; }
+
+template<class T, size_t N>
+void MatrixN<T,N>::load_region(const std::string& file_address,
+                               const std::vector<size_t>& origin,
+                               const std::vector<size_t>& extent)
+{   this->load_region(file_address, N, origin, extent) ; }
+
+template<class T, size_t N>
+const std::array<size_t,N>& MatrixN<T,N>::get_dim_array() const
+{   return this->_dim_array ; }
+
+template<class T, size_t N>
+const std::array<size_t,N>& MatrixN<T,N>::get_strides() const
+{   return this->_strides ; }
+
+template<class T, size_t N>
+template<class... Idx>
+size_t MatrixN<T,N>::get_offset(Idx... coord) const
+{   static_assert(sizeof...(Idx) == N, "the number of coordinates should be equal to the number of dimensions") ;
+    static_assert(are_integral<Idx...>::value, "coordinates should be integral values") ;
+    const size_t coord_array[N] = {static_cast<size_t>(coord)...} ;
+    size_t offset = 0 ;
+    for(size_t i=0; i<N; i++)
+    {   offset += coord_array[i] * this->_strides[i] ; }
+    return offset ;
+}
+
+template<class T, size_t N>
+MatrixN<T,N>& MatrixN<T,N>::operator = (const MatrixN<T,N>& other)
+{   Matrix<T>::operator=(other) ;
+    this->_dim_array = other._dim_array ;
+    this->_strides   = other._strides ;
+    return *this ;
+}
+
+template<class T, size_t N>
+MatrixN<T,N>& MatrixN<T,N>::operator = (MatrixN<T,N>&& other)
+{   if(&other == this)
+    {   return *this ; }
+    Matrix<T>::operator=(std::move(other)) ;
+    this->_dim_array = other._dim_array ;
+    this->_strides   = other._strides ;
+    other.compute_strides() ;
+    return *this ;
+}
+
+template<class T, size_t N>
+template<class E>
+MatrixN<T,N>& MatrixN<T,N>::operator = (const MatrixExpression<E>& e)
+{   if(e.self().get_dim().size() != N)
+    {   throw std::invalid_argument("the expression does not have the expected number of dimensions!") ; }
+    Matrix<T>::operator=(e) ;
+    this->compute_strides() ;
+    return *this ;
+}
+
+template<class T, size_t N>
+template<class... Idx>
+T& MatrixN<T,N>::operator () (Idx... coord)
+{   return this->_data->data()[this->get_offset(coord...)] ; }
+
+template<class T, size_t N>
+template<class... Idx>
+const T& MatrixN<T,N>::operator () (Idx... coord) const
+{   return this->_data->data()[this->get_offset(coord...)] ; }
+
+template<class T, size_t N>
+void MatrixN<T,N>::check_dim_number(size_t dim_n) const
+{   if(dim_n != N)
+    {   throw std::invalid_argument("the matrix does not have the expected number of dimensions!") ; }
+}
+
+template<class T, size_t N>
+void MatrixN<T,N>::compute_strides()
+{   // the 2 first dimensions are swapped in _dim
+    std::vector<size_t> dim = this->get_dim() ;
+    for(size_t i=0; i<N; i++)
+    {   this->_dim_array[i] = dim[i] ; }
+    if(N == 1)
+    {   this->_strides[0] = 1 ;
+        return ;
+    }
+    this->_strides[0] = this->_dim_prod[1] ;
+    this->_strides[N > 1 ? 1 : 0] = 1 ;
+    for(size_t i=2; i<N; i++)
+    {   this->_strides[i] = this->_dim_prod[i] ; }
+}
+
+#endif // MATRIXN_HPP
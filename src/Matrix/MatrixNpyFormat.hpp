@@ -0,0 +1,865 @@
+#ifndef MATRIXNPYFORMAT_HPP
+#define MATRIXNPYFORMAT_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>   // reverse(), max()
+#include <type_traits> // remove_const, remove_pointer
+#include <cstddef>     // size_t
+#include <cstdint>     // uint16_t, uint32_t, uint64_t
+#include <cstdio>      // sprintf()
+#include <cstring>     // memcpy(), memcmp()
+#include <cstdlib>     // strtoull()
+#include <stdexcept>   // runtime_error, invalid_argument
+
+#include <fcntl.h>     // open()
+#include <unistd.h>    // close()
+
+#include "MatrixBinaryFormat.hpp"
+#include "MatrixIOEngine.hpp"
+
+
+/*!
+ * The NumPy .npy files store an array after a header which is a
+ * Python dict literal :
+ * 6x char   : the magic number "\x93NUMPY".
+ * 2x uint8  : the version of the format, 1.0 (2.0 if the header is
+ *             longer than 65535 characters).
+ * 1x uint16 : the length of the header (uint32 in version 2.0),
+ *             little endian.
+ * the header, "{'descr': '<f8', 'fortran_order': False, 'shape': (3,
+ * 4), }" padded with spaces and ended by an end of line so that the
+ * values start at a multiple of 64 bytes.
+ * the values, in C order (the last index varying the fastest) or in
+ * Fortran order (the first index varying the fastest).
+ *
+ * The values of a matrix, stored with the column index varying the
+ * fastest, then the row index, then the 3rd index, ... are those of
+ * an array in C order of shape (..., dim3, rows, columns), the _dim
+ * vector reversed. A 2D matrix is an array of shape (rows, columns),
+ * the 2D slices of a 3D matrix are the arrays a[k] of an array of
+ * shape (slices, rows, columns), ... This shape is written and read,
+ * so that the values are neither copied nor reordered and a .npy file
+ * in C order can be mapped in memory. A file in Fortran order is
+ * loaded with its values reordered.
+ *
+ * The .npz files are zip archives of .npy files, one per array. The
+ * archives whose members are stored without compression can be read,
+ * and mapped if the values of the member are aligned in the file. The
+ * members written by MatrixNpzWriter are aligned.
+ *
+ * The header is read into a MatrixBinaryHeader, so that the values are
+ * checked, converted and read as those of the binary files (see
+ * MatrixBinaryFormat.hpp).
+ */
+
+
+/*!
+ * \brief The magic number of the .npy files.
+ */
+const char matrix_npy_magic[6] = {'\x93', 'N', 'U', 'M', 'P', 'Y'} ;
+
+/*!
+ * \brief The alignment of the values in the .npy files, in bytes.
+ */
+const size_t matrix_npy_alignment = 64 ;
+
+/*!
+ * \brief The signatures of the zip records.
+ */
+const uint32_t matrix_zip_local_signature    = 0x04034b50 ;
+const uint32_t matrix_zip_central_signature  = 0x02014b50 ;
+const uint32_t matrix_zip_end_signature      = 0x06054b50 ;
+const uint32_t matrix_zip64_end_signature    = 0x06064b50 ;
+const uint32_t matrix_zip64_locator_signature = 0x07064b50 ;
+
+
+/*!
+ * \brief Reads a little endian integer.
+ * \param bytes the address of the 1st byte.
+ * \return the integer.
+ */
+template<class U>
+U get_matrix_le(const char* bytes)
+{   U value = 0 ;
+    for(size_t i=0; i<sizeof(U); i++)
+    {   value |= static_cast<U>(static_cast<unsigned char>(bytes[i])) << (8*i) ; }
+    return value ;
+}
+
+/*!
+ * \brief Appends a little endian integer.
+ * \param bytes where to append the bytes.
+ * \param value the integer.
+ */
+template<class U>
+void append_matrix_le(std::vector<char>& bytes, U value)
+{   for(size_t i=0; i<sizeof(U); i++)
+    {   bytes.push_back(static_cast<char>((value >> (8*i)) & 0xff)) ; }
+}
+
+/*!
+ * \brief Whether the machine is little endian.
+ * \return whether the machine is little endian.
+ */
+inline bool is_matrix_little_endian()
+{   uint16_t value = 1 ;
+    char byte ;
+    memcpy(&byte, &value, 1) ;
+    return byte == 1 ;
+}
+
+
+/*!
+ * \brief Computes the CRC-32 checksum of the zip files (the
+ * reflected polynomial 0x04C11DB7), 8 bytes at a time.
+ * \param data the address of the 1st byte.
+ * \param n the number of bytes.
+ * \param crc the checksum of the bytes preceding the range, to
+ * compute a checksum in several parts.
+ * \return the checksum.
+ */
+inline uint32_t crc32_zip(const void* data, size_t n, uint32_t crc=0)
+{   static const std::vector<uint32_t> table = []()
+                                               {   std::vector<uint32_t> t(8*256) ;
+                                                   for(uint32_t i=0; i<256; i++)
+                                                   {   uint32_t c = i ;
+                                                       for(int k=0; k<8; k++)
+                                                       {   c = (c & 1) ? (c >> 1) ^ 0xEDB88320 : (c >> 1) ; }
+                                                       t[i] = c ;
+                                                   }
+                                                   for(uint32_t i=0; i<256; i++)
+                                                   {   for(size_t k=1; k<8; k++)
+                                                       {   t[k*256 + i] = (t[(k-1)*256 + i] >> 8) ^ t[t[(k-1)*256 + i] & 0xff] ; }
+                                                   }
+                                                   return t ;
+                                               }() ;
+    const unsigned char* p = static_cast<const unsigned char*>(data) ;
+    const uint32_t* t = table.data() ;
+    crc = ~crc ;
+    for(; n >= 8; n-=8, p+=8)
+    {   uint32_t low  = crc ^ (static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+                               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24) ;
+        crc = t[7*256 + (low & 0xff)] ^ t[6*256 + ((low >> 8) & 0xff)] ^
+              t[5*256 + ((low >> 16) & 0xff)] ^ t[4*256 + (low >> 24)] ^
+              t[3*256 + p[4]] ^ t[2*256 + p[5]] ^ t[1*256 + p[6]] ^ t[p[7]] ;
+    }
+    for(; n > 0; n--, p++)
+    {   crc = t[(crc ^ *p) & 0xff] ^ (crc >> 8) ; }
+    return ~crc ;
+}
+
+
+/*!
+ * \brief Gives the NumPy type description of a type of values,
+ * in the byte order of the machine.
+ * \param id the type id.
+ * \param size the size of the values.
+ * \return the description, "<f8" for instance.
+ * \throw std::runtime_error if the type has no description.
+ */
+inline std::string get_matrix_npy_descr(MatrixTypeId id, size_t size)
+{   MatrixTypeInfo info = get_matrix_type_info(id) ;
+    if(id == MatrixTypeId::character)
+    {   return "|S1" ; }
+    if(id == MatrixTypeId::unknown or info.size != size)
+    {   throw std::runtime_error("Error! the values have no NumPy type") ; }
+    std::string descr = (size == 1) ? "|" : (is_matrix_little_endian() ? "<" : ">") ;
+    descr += info.is_integer ? (info.is_signed ? "i" : "u") : "f" ;
+    descr += std::to_string(size) ;
+    return descr ;
+}
+
+/*!
+ * \brief Sets the type of the values of a header from a NumPy
+ * type description.
+ * \param descr the description.
+ * \param header the header.
+ * \param file_address the path to the file, for the messages.
+ * \throw std::runtime_error if the type is not supported.
+ */
+inline void parse_matrix_npy_descr(const std::string& descr,
+                                   MatrixBinaryHeader& header,
+                                   const std::string& file_address)
+{   char msg[4096] ;
+    bool little = is_matrix_little_endian() ;
+    header.type_id = MatrixTypeId::unknown ;
+    if(descr.size() >= 3 and std::string("<>|=").find(descr[0]) != std::string::npos)
+    {   char kind = descr[1] ;
+        char* end = nullptr ;
+        unsigned long long size = strtoull(descr.c_str() + 2, &end, 10) ;
+        header.type_size = static_cast<uint32_t>(size) ;
+        header.swap = (descr[0] == '<' and not little) or (descr[0] == '>' and little) ;
+        if(*end == '\0')
+        {   if(kind == 'i' or kind == 'u')
+            {   header.type_id = get_matrix_integer_type_id(size, kind == 'i') ; }
+            else if(kind == 'f' and size == 4)
+            {   header.type_id = MatrixTypeId::float32 ; }
+            else if(kind == 'f' and size == 8)
+            {   header.type_id = MatrixTypeId::float64 ; }
+            else if(kind == 'f' and size == sizeof(long double))
+            {   header.type_id = MatrixTypeId::long_double ; }
+            else if(kind == 'S' and size == 1)
+            {   header.type_id = MatrixTypeId::character ; }
+        }
+    }
+    if(header.type_id == MatrixTypeId::unknown)
+    {   sprintf(msg, "Error! unsupported NumPy type '%s' in %s",
+                descr.substr(0, 64).c_str(),
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    // a single byte has no byte order
+    if(header.type_size == 1)
+    {   header.swap = false ; }
+}
+
+
+/*!
+ * \brief Encodes the header of a .npy file storing the values of
+ * type T of a matrix.
+ * \param dim the dimensions, as stored in the _dim vector.
+ * \return the bytes of the file up to the values.
+ */
+template<class T>
+std::vector<char> encode_matrix_npy_header(const std::vector<size_t>& dim)
+{   std::string dict = "{'descr': '" + get_matrix_npy_descr(matrix_type_id<T>::value, sizeof(T)) +
+                       "', 'fortran_order': False, 'shape': (" ;
+    // a matrix without dimensions has no value
+    std::vector<size_t> shape(dim.rbegin(), dim.rend()) ;
+    if(shape.empty())
+    {   shape.push_back(0) ; }
+    for(size_t i=0; i<shape.size(); i++)
+    {   dict += std::to_string(shape[i]) ;
+        dict += (shape.size() == 1) ? "," : (i+1 < shape.size() ? ", " : "") ;
+    }
+    dict += "), }" ;
+
+    // version 1.0 has 2 bytes of length, 2.0 has 4 bytes
+    size_t prefix = sizeof(matrix_npy_magic) + 2 + 2 ;
+    if(prefix + dict.size() + 1 > 65535)
+    {   prefix += 2 ; }
+    size_t size = ((prefix + dict.size() + 1 + matrix_npy_alignment - 1) / matrix_npy_alignment) * matrix_npy_alignment ;
+    dict.append(size - prefix - dict.size() - 1, ' ') ;
+    dict.push_back('\n') ;
+
+    std::vector<char> bytes(matrix_npy_magic, matrix_npy_magic + sizeof(matrix_npy_magic)) ;
+    if(prefix == sizeof(matrix_npy_magic) + 4)
+    {   bytes.push_back(1) ;
+        bytes.push_back(0) ;
+        append_matrix_le(bytes, static_cast<uint16_t>(dict.size())) ;
+    }
+    else
+    {   bytes.push_back(2) ;
+        bytes.push_back(0) ;
+        append_matrix_le(bytes, static_cast<uint32_t>(dict.size())) ;
+    }
+    bytes.insert(bytes.end(), dict.begin(), dict.end()) ;
+    return bytes ;
+}
+
+
+/*!
+ * \brief Gets the value of a key of the header dict of a .npy
+ * file.
+ * \param dict the header dict.
+ * \param key the key, without quotes.
+ * \return the value, without the spaces around it, an empty
+ * string if the key is missing.
+ */
+inline std::string get_matrix_npy_value(const std::string& dict, const std::string& key)
+{   size_t position = std::string::npos ;
+    for(char quote : {'\'', '"'})
+    {   position = dict.find(quote + key + quote) ;
+        if(position != std::string::npos)
+        {   break ; }
+    }
+    if(position == std::string::npos)
+    {   return "" ; }
+    position = dict.find(':', position + key.size() + 2) ;
+    if(position == std::string::npos)
+    {   return "" ; }
+    position = dict.find_first_not_of(" ", position + 1) ;
+    if(position == std::string::npos)
+    {   return "" ; }
+    // a tuple, a string or a word
+    size_t end ;
+    if(dict[position] == '(')
+    {   end = dict.find(')', position) ; }
+    else if(dict[position] == '\'' or dict[position] == '"')
+    {   end = dict.find(dict[position], position + 1) ; }
+    else
+    {   end = dict.find_first_of(",}", position) ;
+        if(end != std::string::npos)
+        {   end-- ; }
+    }
+    if(end == std::string::npos)
+    {   return "" ; }
+    std::string value = dict.substr(position, end - position + 1) ;
+    value.erase(value.find_last_not_of(" ") + 1) ;
+    return value ;
+}
+
+/*!
+ * \brief Reads the header of a .npy file, or of a .npy member of
+ * a .npz file.
+ * \param read a function read(void* dst, size_t n, uint64_t offset)
+ * copying the n bytes at the given offset of the file to dst,
+ * returning false if the file is too short.
+ * \param offset the offset of the .npy file.
+ * \param size the size of the .npy file.
+ * \param file_address the path to the file, for the messages.
+ * \param fortran_order where to store whether the values are in
+ * Fortran order.
+ * \return the header, the dimensions being those of the _dim
+ * vector (the shape reversed).
+ * \throw std::runtime_error if the header is invalid or if it
+ * describes more data than the .npy file contains.
+ */
+template<class F>
+MatrixBinaryHeader read_matrix_npy_header(F read,
+                                          uint64_t offset,
+                                          uint64_t size,
+                                          const std::string& file_address,
+                                          bool& fortran_order)
+{   char msg[4096] ;
+    char prefix[12] ;
+    if(size < 10 or not read(prefix, 10, offset) or memcmp(prefix, matrix_npy_magic, sizeof(matrix_npy_magic)) != 0)
+    {   sprintf(msg, "Error! %s is not a .npy file", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    int major = static_cast<unsigned char>(prefix[6]) ;
+    size_t dict_size ;
+    size_t prefix_size ;
+    if(major == 1)
+    {   dict_size   = get_matrix_le<uint16_t>(prefix + 8) ;
+        prefix_size = 10 ;
+    }
+    else if((major == 2 or major == 3) and size >= 12 and read(prefix + 10, 2, offset + 10))
+    {   dict_size   = get_matrix_le<uint32_t>(prefix + 8) ;
+        prefix_size = 12 ;
+    }
+    else
+    {   sprintf(msg, "Error! unsupported .npy format version (%d) in %s", major, file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    // any corrupted length ends here, before allocating
+    if(dict_size > size - prefix_size)
+    {   sprintf(msg, "Error! the .npy header is longer than the file in %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    std::string dict(dict_size, ' ') ;
+    if(dict_size != 0 and not read(&dict[0], dict_size, offset + prefix_size))
+    {   sprintf(msg, "Error! something occured while reading the .npy header in %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+
+    MatrixBinaryHeader header ;
+    std::string descr = get_matrix_npy_value(dict, "descr") ;
+    std::string order = get_matrix_npy_value(dict, "fortran_order") ;
+    std::string shape = get_matrix_npy_value(dict, "shape") ;
+    if(descr.size() < 2 or (descr[0] != '\'' and descr[0] != '"') or
+       (order != "True" and order != "False") or
+       shape.size() < 2 or shape[0] != '(')
+    {   sprintf(msg, "Error! invalid .npy header in %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    parse_matrix_npy_descr(descr.substr(1, descr.size() - 2), header, file_address) ;
+    fortran_order = (order == "True") ;
+    const char* p = shape.c_str() + 1 ;
+    while(true)
+    {   while(*p == ' ' or *p == ',')
+        {   p++ ; }
+        if(*p == ')')
+        {   break ; }
+        char* end = nullptr ;
+        unsigned long long d = strtoull(p, &end, 10) ;
+        if(end == p)
+        {   sprintf(msg, "Error! invalid .npy shape in %s", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        header.dim.push_back(static_cast<size_t>(d)) ;
+        p = end ;
+    }
+    std::reverse(header.dim.begin(), header.dim.end()) ;
+    header.data_offset = offset + prefix_size + dict_size ;
+    if(not get_matrix_binary_data_size(header.dim, header.type_size, header.data_size) or
+       header.data_size > size - prefix_size - dict_size)
+    {   sprintf(msg, "Error! the size of the data does not match the shape in %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    return header ;
+}
+
+
+/*!
+ * \brief A member of a zip archive.
+ */
+struct MatrixNpzMember
+{   /*!
+     * \brief The name of the member.
+     */
+    std::string name ;
+    /*!
+     * \brief The compression method, 0 if the member is
+     * stored.
+     */
+    uint16_t method ;
+    /*!
+     * \brief The size of the member, as stored.
+     */
+    uint64_t size ;
+    /*!
+     * \brief The offset of the local header of the member.
+     */
+    uint64_t header_offset ;
+} ;
+
+/*!
+ * \brief Lists the members of a zip archive, from its central
+ * directory. The zip64 archives are supported.
+ * \param read a function read(void* dst, size_t n, uint64_t offset)
+ * copying the n bytes at the given offset of the file to dst,
+ * returning false if the file is too short.
+ * \param file_size the size of the file.
+ * \param file_address the path to the file, for the messages.
+ * \return the members.
+ * \throw std::runtime_error if the archive is invalid.
+ */
+template<class F>
+std::vector<MatrixNpzMember> read_matrix_npz_members(F read,
+                                                     uint64_t file_size,
+                                                     const std::string& file_address)
+{   char msg[4096] ;
+    sprintf(msg, "Error! invalid zip archive %s", file_address.c_str()) ;
+
+    // the end record, followed by a comment of at most 65535 bytes
+    size_t tail_size = static_cast<size_t>(std::min(file_size, static_cast<uint64_t>(22 + 65535))) ;
+    std::vector<char> tail(tail_size) ;
+    if(tail_size < 22 or not read(tail.data(), tail_size, file_size - tail_size))
+    {   throw std::runtime_error(msg) ; }
+    size_t end = tail_size - 22 + 1 ;
+    do
+    {   end-- ; }
+    while(end > 0 and get_matrix_le<uint32_t>(tail.data() + end) != matrix_zip_end_signature) ;
+    if(get_matrix_le<uint32_t>(tail.data() + end) != matrix_zip_end_signature)
+    {   throw std::runtime_error(msg) ; }
+    uint64_t n_member = get_matrix_le<uint16_t>(tail.data() + end + 10) ;
+    uint64_t cd_size   = get_matrix_le<uint32_t>(tail.data() + end + 12) ;
+    uint64_t cd_offset = get_matrix_le<uint32_t>(tail.data() + end + 16) ;
+    uint64_t end_offset = file_size - tail_size + end ;
+    if(n_member == 0xffff or cd_size == 0xffffffff or cd_offset == 0xffffffff)
+    {   char locator[20] ;
+        char end_64[56] ;
+        if(end_offset < 20 or
+           not read(locator, sizeof(locator), end_offset - 20) or
+           get_matrix_le<uint32_t>(locator) != matrix_zip64_locator_signature or
+           not read(end_64, sizeof(end_64), get_matrix_le<uint64_t>(locator + 8)) or
+           get_matrix_le<uint32_t>(end_64) != matrix_zip64_end_signature)
+        {   throw std::runtime_error(msg) ; }
+        n_member  = get_matrix_le<uint64_t>(end_64 + 32) ;
+        cd_size   = get_matrix_le<uint64_t>(end_64 + 40) ;
+        cd_offset = get_matrix_le<uint64_t>(end_64 + 48) ;
+    }
+    if(cd_offset > file_size or cd_size > file_size - cd_offset)
+    {   throw std::runtime_error(msg) ; }
+
+    // the central directory
+    std::vector<char> cd(static_cast<size_t>(cd_size)) ;
+    if(cd_size != 0 and not read(cd.data(), cd.size(), cd_offset))
+    {   throw std::runtime_error(msg) ; }
+    std::vector<MatrixNpzMember> members ;
+    size_t position = 0 ;
+    for(uint64_t i=0; i<n_member; i++)
+    {   if(position + 46 > cd.size() or get_matrix_le<uint32_t>(cd.data() + position) != matrix_zip_central_signature)
+        {   throw std::runtime_error(msg) ; }
+        const char* record = cd.data() + position ;
+        size_t name_size    = get_matrix_le<uint16_t>(record + 28) ;
+        size_t extra_size   = get_matrix_le<uint16_t>(record + 30) ;
+        size_t comment_size = get_matrix_le<uint16_t>(record + 32) ;
+        if(position + 46 + name_size + extra_size + comment_size > cd.size())
+        {   throw std::runtime_error(msg) ; }
+        MatrixNpzMember member ;
+        member.name          = std::string(record + 46, name_size) ;
+        member.method        = get_matrix_le<uint16_t>(record + 10) ;
+        member.size          = get_matrix_le<uint32_t>(record + 20) ;
+        member.header_offset = get_matrix_le<uint32_t>(record + 42) ;
+        uint64_t size_uncompressed = get_matrix_le<uint32_t>(record + 24) ;
+        // the zip64 extra field has the 64 bits values of the
+        // fields set to 0xffffffff, in order
+        const char* extra = record + 46 + name_size ;
+        for(size_t j=0; j+4<=extra_size; )
+        {   uint16_t id   = get_matrix_le<uint16_t>(extra + j) ;
+            uint16_t size = get_matrix_le<uint16_t>(extra + j + 2) ;
+            if(id == 0x0001)
+            {   size_t k = j + 4 ;
+                if(size_uncompressed == 0xffffffff and k + 8 <= j + 4 + size)
+                {   k += 8 ; }
+                if(member.size == 0xffffffff and k + 8 <= j + 4 + size)
+                {   member.size = get_matrix_le<uint64_t>(extra + k) ;
+                    k += 8 ;
+                }
+                if(member.header_offset == 0xffffffff and k + 8 <= j + 4 + size)
+                {   member.header_offset = get_matrix_le<uint64_t>(extra + k) ; }
+            }
+            j += 4 + size ;
+        }
+        members.push_back(member) ;
+        position += 46 + name_size + extra_size + comment_size ;
+    }
+    return members ;
+}
+
+/*!
+ * \brief Locates the .npy file to read in a .npy or a .npz file.
+ * \param read a function read(void* dst, size_t n, uint64_t offset)
+ * copying the n bytes at the given offset of the file to dst,
+ * returning false if the file is too short.
+ * \param file_size the size of the file.
+ * \param name in a .npz file, the name of the array, with or
+ * without the .npy extension, or an empty string for the 1st
+ * array. It is ignored for a .npy file.
+ * \param file_address the path to the file, for the messages.
+ * \param fortran_order where to store whether the values are in
+ * Fortran order.
+ * \return the header of the .npy file.
+ * \throw std::runtime_error if the array cannot be found or is
+ * compressed, or if the file is invalid.
+ */
+template<class F>
+MatrixBinaryHeader read_matrix_npy_file_header(F read,
+                                               uint64_t file_size,
+                                               const std::string& name,
+                                               const std::string& file_address,
+                                               bool& fortran_order)
+{   char msg[4096] ;
+    char magic[4] ;
+    uint64_t offset = 0 ;
+    uint64_t size   = file_size ;
+    if(read(magic, sizeof(magic), 0) and get_matrix_le<uint32_t>(magic) == matrix_zip_local_signature)
+    {   std::vector<MatrixNpzMember> members = read_matrix_npz_members(read, file_size, file_address) ;
+        auto member = std::find_if(members.begin(), members.end(),
+                                   [&name](const MatrixNpzMember& m)
+                                   {   return name.empty() or m.name == name or m.name == name + ".npy" ; }) ;
+        if(member == members.end())
+        {   sprintf(msg, "Error! no array %s in %s", name.c_str(), file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        if(member->method != 0)
+        {   sprintf(msg, "Error! the array %s of %s is compressed", member->name.c_str(), file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        char local[30] ;
+        if(not read(local, sizeof(local), member->header_offset) or
+           get_matrix_le<uint32_t>(local) != matrix_zip_local_signature)
+        {   sprintf(msg, "Error! invalid zip archive %s", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        offset = member->header_offset + 30 + get_matrix_le<uint16_t>(local + 26) + get_matrix_le<uint16_t>(local + 28) ;
+        size   = member->size ;
+    }
+    return read_matrix_npy_header(read, offset, size, file_address, fortran_order) ;
+}
+
+
+/*!
+ * \brief Reorders the values of an array in Fortran order (the 1st
+ * index varying the fastest) in C order (the last index varying the
+ * fastest).
+ * \param src the values in Fortran order.
+ * \param dst where to store the values in C order.
+ * \param dim the dimensions, as stored in the _dim vector (the
+ * shape reversed).
+ */
+template<class T>
+void reorder_matrix_npy_fortran(const T* src, T* dst, const std::vector<size_t>& dim)
+{   size_t n = 1 ;
+    for(auto d : dim)
+    {   n *= d ; }
+    if(n == 0)
+    {   return ; }
+    // the strides in src of the indices of the _dim order
+    size_t n_dim = dim.size() ;
+    std::vector<size_t> stride(n_dim, 1) ;
+    for(size_t i=n_dim; i-->1; )
+    {   stride[i-1] = stride[i] * dim[i] ; }
+    std::vector<size_t> index(n_dim, 0) ;
+    size_t offset = 0 ;
+    for(size_t i=0; i<n; i++)
+    {   dst[i] = src[offset] ;
+        for(size_t k=0; k<n_dim; k++)
+        {   if(++index[k] < dim[k])
+            {   offset += stride[k] ;
+                break ;
+            }
+            offset -= (dim[k] - 1) * stride[k] ;
+            index[k] = 0 ;
+        }
+    }
+}
+
+
+/*!
+ * \brief Writes matrices as the arrays of a .npz file, without
+ * compression. The values of each array are aligned in the file,
+ * so that they can be mapped.
+ */
+class MatrixNpzWriter
+{
+    public:
+        /*!
+         * \brief Creates a file.
+         * \param file_address the path to the file.
+         * \throw std::runtime_error if the file cannot be created.
+         */
+        MatrixNpzWriter(const std::string& file_address) ;
+
+        MatrixNpzWriter(const MatrixNpzWriter& other) = delete ;
+
+        /*!
+         * \brief Destructor, closes the file, ignoring the
+         * errors. close() should be called to know whether
+         * the file was written.
+         */
+        ~MatrixNpzWriter() ;
+
+        MatrixNpzWriter& operator = (const MatrixNpzWriter& other) = delete ;
+
+        /*!
+         * \brief Writes a matrix as an array of the file.
+         * \param name the name of the array, the .npy extension
+         * is added.
+         * \param m the matrix (Matrix, Matrix2D, ...).
+         * \throw std::invalid_argument if an array already has
+         * this name.
+         * \throw std::runtime_error if the file is closed or if
+         * anything happens while writing it.
+         */
+        template<class M>
+        void add(const std::string& name, const M& m) ;
+
+        /*!
+         * \brief Writes the directory of the arrays and closes
+         * the file. Does nothing if the file is already closed.
+         * \throw std::runtime_error if anything happens while
+         * writing the file.
+         */
+        void close() ;
+
+    private:
+        /*!
+         * \brief Writes bytes at the end of the file.
+         * \param requests the bytes, their offsets being
+         * relative to the end of the file.
+         * \throw std::runtime_error if the bytes cannot be
+         * written.
+         */
+        void write(std::vector<MatrixIORequest> requests) ;
+
+        /*!
+         * \brief The path to the file and its descriptor, -1
+         * once closed.
+         */
+        std::string _file_address ;
+        int _fd ;
+        /*!
+         * \brief The size of the file written.
+         */
+        uint64_t _size = 0 ;
+        /*!
+         * \brief The arrays written.
+         */
+        std::vector<MatrixNpzMember> _members ;
+        std::vector<uint32_t> _crcs ;
+} ;
+
+
+inline MatrixNpzWriter::MatrixNpzWriter(const std::string& file_address)
+    : _file_address(file_address),
+      _fd(open(file_address.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666))
+{   if(this->_fd < 0)
+    {   char msg[4096] ;
+        sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+inline MatrixNpzWriter::~MatrixNpzWriter()
+{   try
+    {   this->close() ; }
+    catch(std::exception&)
+    {}
+}
+
+template<class M>
+void MatrixNpzWriter::add(const std::string& name, const M& m)
+{   typedef typename std::remove_const<typename std::remove_pointer<decltype(m.get_data_ptr())>::type>::type T ;
+    if(this->_fd < 0)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! %s is closed", this->_file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    std::string member_name = name + ".npy" ;
+    for(const auto& member : this->_members)
+    {   if(member.name == member_name)
+        {   throw std::invalid_argument("Error! an array already has this name") ; }
+    }
+
+    // the .npy file
+    std::vector<size_t> dim = m.get_dim() ;
+    if(dim.size() > 1)
+    {   std::swap(dim[0], dim[1]) ; }
+    std::vector<char> npy_header = encode_matrix_npy_header<T>(dim) ;
+    size_t data_size = m.get_data_size() * sizeof(T) ;
+    const char* data = (data_size == 0) ? nullptr : reinterpret_cast<const char*>(m.get_data_ptr()) ;
+    uint64_t size = npy_header.size() + data_size ;
+    uint32_t crc  = crc32_zip(npy_header.data(), npy_header.size()) ;
+    crc = crc32_zip(data, data_size, crc) ;
+
+    // the local header, the sizes are in a zip64 field if needed,
+    // and a padding field aligns the .npy file
+    bool zip64 = size >= 0xffffffff ;
+    std::vector<char> local ;
+    append_matrix_le<uint32_t>(local, matrix_zip_local_signature) ;
+    append_matrix_le<uint16_t>(local, zip64 ? 45 : 20) ;
+    append_matrix_le<uint16_t>(local, 0) ;           // flags
+    append_matrix_le<uint16_t>(local, 0) ;           // stored
+    append_matrix_le<uint16_t>(local, 0) ;           // time
+    append_matrix_le<uint16_t>(local, (0 << 9) | (1 << 5) | 1) ;  // 1980-01-01
+    append_matrix_le<uint32_t>(local, crc) ;
+    append_matrix_le<uint32_t>(local, zip64 ? 0xffffffff : static_cast<uint32_t>(size)) ;
+    append_matrix_le<uint32_t>(local, zip64 ? 0xffffffff : static_cast<uint32_t>(size)) ;
+    append_matrix_le<uint16_t>(local, static_cast<uint16_t>(member_name.size())) ;
+    append_matrix_le<uint16_t>(local, 0) ;           // extra size, set below
+    local.insert(local.end(), member_name.begin(), member_name.end()) ;
+    if(zip64)
+    {   append_matrix_le<uint16_t>(local, 0x0001) ;
+        append_matrix_le<uint16_t>(local, 16) ;
+        append_matrix_le<uint64_t>(local, size) ;
+        append_matrix_le<uint64_t>(local, size) ;
+    }
+    size_t padding = (matrix_npy_alignment - (this->_size + local.size()) % matrix_npy_alignment) % matrix_npy_alignment ;
+    if(padding != 0 and padding < 4)
+    {   padding += matrix_npy_alignment ; }
+    if(padding != 0)
+    {   append_matrix_le<uint16_t>(local, 0xa11e) ;
+        append_matrix_le<uint16_t>(local, static_cast<uint16_t>(padding - 4)) ;
+        local.insert(local.end(), padding - 4, 0) ;
+    }
+    uint16_t extra_size = static_cast<uint16_t>(local.size() - 30 - member_name.size()) ;
+    local[28] = static_cast<char>(extra_size & 0xff) ;
+    local[29] = static_cast<char>(extra_size >> 8) ;
+
+    MatrixNpzMember member ;
+    member.name          = member_name ;
+    member.method        = 0 ;
+    member.size          = size ;
+    member.header_offset = this->_size ;
+    std::vector<MatrixIORequest> requests = {MatrixIORequest{this->_fd, local.data(), local.size(), 0},
+                                             MatrixIORequest{this->_fd, npy_header.data(), npy_header.size(), local.size()}} ;
+    if(data_size != 0)
+    {   requests.push_back(MatrixIORequest{this->_fd, const_cast<char*>(data), data_size, local.size() + npy_header.size()}) ; }
+    this->write(requests) ;
+    this->_members.push_back(member) ;
+    this->_crcs.push_back(crc) ;
+}
+
+inline void MatrixNpzWriter::close()
+{   if(this->_fd < 0)
+    {   return ; }
+
+    // the central directory
+    std::vector<char> cd ;
+    for(size_t i=0; i<this->_members.size(); i++)
+    {   const MatrixNpzMember& member = this->_members[i] ;
+        bool zip64_size   = member.size >= 0xffffffff ;
+        bool zip64_offset = member.header_offset >= 0xffffffff ;
+        append_matrix_le<uint32_t>(cd, matrix_zip_central_signature) ;
+        append_matrix_le<uint16_t>(cd, 45) ;
+        append_matrix_le<uint16_t>(cd, (zip64_size or zip64_offset) ? 45 : 20) ;
+        append_matrix_le<uint16_t>(cd, 0) ;
+        append_matrix_le<uint16_t>(cd, 0) ;
+        append_matrix_le<uint16_t>(cd, 0) ;
+        append_matrix_le<uint16_t>(cd, (0 << 9) | (1 << 5) | 1) ;
+        append_matrix_le<uint32_t>(cd, this->_crcs[i]) ;
+        append_matrix_le<uint32_t>(cd, zip64_size ? 0xffffffff : static_cast<uint32_t>(member.size)) ;
+        append_matrix_le<uint32_t>(cd, zip64_size ? 0xffffffff : static_cast<uint32_t>(member.size)) ;
+        append_matrix_le<uint16_t>(cd, static_cast<uint16_t>(member.name.size())) ;
+        append_matrix_le<uint16_t>(cd, static_cast<uint16_t>((zip64_size ? 16 : 0) + (zip64_offset ? 8 : 0) +
+                                                             ((zip64_size or zip64_offset) ? 4 : 0))) ;
+        append_matrix_le<uint16_t>(cd, 0) ;          // comment size
+        append_matrix_le<uint16_t>(cd, 0) ;          // disk
+        append_matrix_le<uint16_t>(cd, 0) ;          // internal attributes
+        append_matrix_le<uint32_t>(cd, 0) ;          // external attributes
+        append_matrix_le<uint32_t>(cd, zip64_offset ? 0xffffffff : static_cast<uint32_t>(member.header_offset)) ;
+        cd.insert(cd.end(), member.name.begin(), member.name.end()) ;
+        if(zip64_size or zip64_offset)
+        {   append_matrix_le<uint16_t>(cd, 0x0001) ;
+            append_matrix_le<uint16_t>(cd, static_cast<uint16_t>((zip64_size ? 16 : 0) + (zip64_offset ? 8 : 0))) ;
+            if(zip64_size)
+            {   append_matrix_le<uint64_t>(cd, member.size) ;
+                append_matrix_le<uint64_t>(cd, member.size) ;
+            }
+            if(zip64_offset)
+            {   append_matrix_le<uint64_t>(cd, member.header_offset) ; }
+        }
+    }
+
+    // the end records, zip64 if needed
+    uint64_t cd_offset = this->_size ;
+    uint64_t n_member  = this->_members.size() ;
+    std::vector<char> end ;
+    if(cd_offset >= 0xffffffff or cd.size() >= 0xffffffff or n_member >= 0xffff)
+    {   uint64_t end_64_offset = cd_offset + cd.size() ;
+        append_matrix_le<uint32_t>(end, matrix_zip64_end_signature) ;
+        append_matrix_le<uint64_t>(end, 44) ;
+        append_matrix_le<uint16_t>(end, 45) ;
+        append_matrix_le<uint16_t>(end, 45) ;
+        append_matrix_le<uint32_t>(end, 0) ;
+        append_matrix_le<uint32_t>(end, 0) ;
+        append_matrix_le<uint64_t>(end, n_member) ;
+        append_matrix_le<uint64_t>(end, n_member) ;
+        append_matrix_le<uint64_t>(end, cd.size()) ;
+        append_matrix_le<uint64_t>(end, cd_offset) ;
+        append_matrix_le<uint32_t>(end, matrix_zip64_locator_signature) ;
+        append_matrix_le<uint32_t>(end, 0) ;
+        append_matrix_le<uint64_t>(end, end_64_offset) ;
+        append_matrix_le<uint32_t>(end, 1) ;
+    }
+    append_matrix_le<uint32_t>(end, matrix_zip_end_signature) ;
+    append_matrix_le<uint16_t>(end, 0) ;
+    append_matrix_le<uint16_t>(end, 0) ;
+    append_matrix_le<uint16_t>(end, static_cast<uint16_t>(std::min(n_member, static_cast<uint64_t>(0xffff)))) ;
+    append_matrix_le<uint16_t>(end, static_cast<uint16_t>(std::min(n_member, static_cast<uint64_t>(0xffff)))) ;
+    append_matrix_le<uint32_t>(end, static_cast<uint32_t>(std::min(static_cast<uint64_t>(cd.size()), static_cast<uint64_t>(0xffffffff)))) ;
+    append_matrix_le<uint32_t>(end, static_cast<uint32_t>(std::min(cd_offset, static_cast<uint64_t>(0xffffffff)))) ;
+    append_matrix_le<uint16_t>(end, 0) ;
+
+    this->write({MatrixIORequest{this->_fd, cd.data(), cd.size(), 0},
+                 MatrixIORequest{this->_fd, end.data(), end.size(), cd.size()}}) ;
+    int fd = this->_fd ;
+    this->_fd = -1 ;
+    if(::close(fd) != 0)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! something happened while writting data to %s", this->_file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+inline void MatrixNpzWriter::write(std::vector<MatrixIORequest> requests)
+{   uint64_t size = 0 ;
+    for(auto& request : requests)
+    {   size = std::max(size, request.offset + request.size) ;
+        request.offset += this->_size ;
+    }
+    if(not MatrixIOEngine::get_default().write(requests))
+    {   ::close(this->_fd) ;
+        this->_fd = -1 ;
+        char msg[4096] ;
+        sprintf(msg, "Error! something happened while writting data to %s", this->_file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    this->_size += size ;
+}
+
+#endif // MATRIXNPYFORMAT_HPP
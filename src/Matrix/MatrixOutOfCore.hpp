@@ -0,0 +1,880 @@
+#ifndef MATRIXOUTOFCORE_HPP
+#define MATRIXOUTOFCORE_HPP
+
+#include <vector>
+#include <string>
+#include <array>
+#include <limits>
+#include <numeric>     // accumulate()
+#include <functional>  // multiplies
+#include <utility>     // swap()
+#include <cstddef>     // size_t
+#include <cstdio>      // sprintf()
+#include <stdexcept>   // runtime_error, out_of_range, invalid_argument
+#include <type_traits> // enable_if
+
+#include "Matrix.hpp"
+#include "Matrix2D.hpp"
+#include "Matrix3D.hpp"
+#include "MatrixView.hpp"
+#include "MatrixChunkedFile.hpp"
+
+
+/*!
+ * The MatrixOutOfCore class is a matrix which values live in a
+ * chunked file (see MatrixChunkedFile.hpp) rather than in memory,
+ * for matrices larger than the memory.
+ *
+ * Only a bounded number of chunks are held in memory, in the cache
+ * of the file : accessing an element which chunk is not cached reads
+ * the chunk, evicting the least recently used one, which is written
+ * back if it was modified. The chunk of the last element accessed is
+ * remembered, so that accessing the elements close to each other
+ * only costs the computation of their offset. The accesses are thus
+ * fast as long as they are local, the chunk dimensions should follow
+ * the access pattern (for instance chunks of whole slices for slice
+ * by slice accesses).
+ *
+ * The elements are accessed with get(), set() and operator (), which
+ * returns a reference object, since the value may be evicted from
+ * memory before it is used. The whole matrix is read chunk by chunk
+ * with for_each_chunk() and modified chunk by chunk with
+ * modify_each_chunk(), as the scalar operators, only one chunk being
+ * in memory at a time. Only the latter marks the chunks as modified,
+ * so that reading a matrix never writes its file.
+ *
+ * The modifications are written to the file when the chunks are
+ * evicted, when flush() is called and when the matrix is destroyed.
+ * The file can then be read with Matrix::load() and
+ * Matrix::load_region(). A matrix cannot be copied and should not be
+ * used by several threads at once.
+ */
+template<class T>
+class MatrixOutOfCore
+{
+    public:
+        /*!
+         * \brief A reference to an element, which value is read
+         * when it is converted to T and written when a value is
+         * assigned to it.
+         */
+        class reference
+        {
+            public:
+                reference(MatrixOutOfCore<T>* matrix, size_t chunk, size_t offset) ;
+
+                operator T () const ;
+                reference& operator = (const T& value) ;
+                reference& operator = (const reference& other) ;
+                reference& operator += (const T& value) ;
+                reference& operator -= (const T& value) ;
+                reference& operator *= (const T& value) ;
+                reference& operator /= (const T& value) ;
+
+            private:
+                /*!
+                 * \brief The matrix, the chunk of the element and
+                 * its offset in the chunk.
+                 */
+                MatrixOutOfCore<T>* _matrix ;
+                size_t _chunk ;
+                size_t _offset ;
+        } ;
+
+        // constructors
+        MatrixOutOfCore() = delete ;
+
+        /*!
+         * \brief Constructs a matrix filled with 0 values,
+         * stored in a new chunked file. Only the chunks which
+         * are modified are written to the file.
+         * \param file_address the path to the file, any
+         * existing file is replaced.
+         * \param dim the dimensions, as (row, column, ...).
+         * \param chunk_dim the dimensions of the chunks, in the
+         * same order.
+         * \param cache_size the maximum number of chunks held
+         * in memory.
+         * \throw std::invalid_argument if the dimensions are
+         * invalid and std::runtime_error if the file cannot be
+         * written.
+         */
+        MatrixOutOfCore(const std::string& file_address,
+                        const std::vector<size_t>& dim,
+                        const std::vector<size_t>& chunk_dim,
+                        size_t cache_size=64) ;
+
+        /*!
+         * \brief Constructs a matrix stored in an existing
+         * chunked file, for instance written by
+         * Matrix::save_chunked().
+         * \param file_address the path to the file.
+         * \param read_only whether the file is only read, in
+         * which case modifying the elements throws an
+         * exception.
+         * \param cache_size the maximum number of chunks held
+         * in memory.
+         * \throw std::runtime_error if the file cannot be
+         * opened or if its values are not of type T.
+         */
+        MatrixOutOfCore(const std::string& file_address,
+                        bool read_only=false,
+                        size_t cache_size=64) ;
+
+        MatrixOutOfCore(const MatrixOutOfCore& other) = delete ;
+
+        /*!
+         * \brief Destructor. Writes the modified chunks to the
+         * file.
+         */
+        virtual ~MatrixOutOfCore() = default ;
+
+        // methods
+        /*!
+         * \brief Gets the number of dimensions.
+         * \return the number of dimensions.
+         */
+        size_t get_dim_size() const ;
+
+        /*!
+         * \brief Gets the dimensions, as (row, column, ...).
+         * \return the dimensions.
+         */
+        std::vector<size_t> get_dim() const ;
+
+        /*!
+         * \brief Gets the dimensions of the chunks, as (row,
+         * column, ...).
+         * \return the dimensions.
+         */
+        std::vector<size_t> get_chunk_dim() const ;
+
+        /*!
+         * \brief Gets the number of elements.
+         * \return the number of elements.
+         */
+        size_t get_data_size() const ;
+
+        /*!
+         * \brief Gets the element at the given offset, in the
+         * _data order of a Matrix of the same dimensions.
+         * \param offset the offset of the element.
+         * \throw std::out_of_range if the offset is out of
+         * range.
+         * \return the element.
+         */
+        T get(size_t offset) const ;
+
+        /*!
+         * \brief Gets the element at the given coordinates.
+         * \param coord the coordinates, as (row, column, ...).
+         * \throw std::out_of_range if the coordinates are out
+         * of range.
+         * \return the element.
+         */
+        T get(const std::vector<size_t>& coord) const ;
+
+        /*!
+         * \brief Sets the element at the given offset, in the
+         * _data order of a Matrix of the same dimensions.
+         * \param offset the offset of the element.
+         * \param value the new value.
+         * \throw std::out_of_range if the offset is out of
+         * range.
+         */
+        void set(size_t offset, T value) ;
+
+        /*!
+         * \brief Sets the element at the given coordinates.
+         * \param coord the coordinates, as (row, column, ...).
+         * \param value the new value.
+         * \throw std::out_of_range if the coordinates are out
+         * of range.
+         */
+        void set(const std::vector<size_t>& coord, T value) ;
+
+        /*!
+         * \brief Reads a region of the matrix, see
+         * MatrixChunkedFile::read_region().
+         */
+        void read_region(const std::vector<size_t>& origin,
+                         const std::vector<size_t>& extent,
+                         T* values) const ;
+
+        /*!
+         * \brief Writes a region of the matrix, see
+         * MatrixChunkedFile::write_region().
+         */
+        void write_region(const std::vector<size_t>& origin,
+                          const std::vector<size_t>& extent,
+                          const T* values) ;
+
+        /*!
+         * \brief Calls f(origin, view) on each chunk of the
+         * matrix, one after the other, in the order of the file.
+         * origin is the coordinates of the 1st element of the
+         * chunk, as (row, column, ...), and view a read-only
+         * MatrixView on the elements of the chunk, which remains
+         * valid until f returns.
+         * \param f the function to call.
+         */
+        template<class F>
+        void for_each_chunk(F f) const ;
+
+        /*!
+         * \brief Calls f(origin, view) on each chunk of the
+         * matrix, as for_each_chunk(), the elements being modified
+         * through the view. Each chunk is marked as modified and
+         * written back to the file.
+         * \param f the function to call.
+         * \throw std::runtime_error if the file is only read.
+         */
+        template<class F>
+        void modify_each_chunk(F f) ;
+
+        /*!
+         * \brief Writes the modified chunks to the file.
+         * \throw std::runtime_error if a chunk cannot be
+         * written.
+         */
+        void flush() ;
+
+        // operators
+        MatrixOutOfCore& operator = (const MatrixOutOfCore& other) = delete ;
+
+        /*!
+         * \brief Adds value to each element, chunk by chunk.
+         * \param value the value to add.
+         * \return a reference to the instance.
+         */
+        MatrixOutOfCore& operator += (T value) ;
+
+        /*!
+         * \brief Substracts value from each element, chunk by
+         * chunk.
+         * \param value the value to substract.
+         * \return a reference to the instance.
+         */
+        MatrixOutOfCore& operator -= (T value) ;
+
+        /*!
+         * \brief Multiplies each element by value, chunk by
+         * chunk.
+         * \param value the value to multiply the elements by.
+         * \return a reference to the instance.
+         */
+        MatrixOutOfCore& operator *= (T value) ;
+
+        /*!
+         * \brief Divides each element by value, chunk by chunk.
+         * \param value the value to divide the elements by.
+         * \throw std::invalid_argument if value is 0.
+         * \return a reference to the instance.
+         */
+        MatrixOutOfCore& operator /= (T value) ;
+
+        /*!
+         * \brief Gets a reference to the element at the given
+         * coordinates.
+         * \param coord the coordinates, as (row, column, ...).
+         * \throw std::out_of_range if the coordinates are out
+         * of range.
+         * \return a reference to the element.
+         */
+        reference operator () (const std::vector<size_t>& coord) ;
+
+        /*!
+         * \brief Gets the element at the given coordinates.
+         * \param coord the coordinates, as (row, column, ...).
+         * \throw std::out_of_range if the coordinates are out
+         * of range.
+         * \return the element.
+         */
+        T operator () (const std::vector<size_t>& coord) const ;
+
+        /*!
+         * \brief Gets a reference to the element at the given
+         * coordinates, given as (row, column, ...), as many as
+         * the matrix has dimensions.
+         * \throw std::out_of_range if the coordinates are out
+         * of range.
+         * \return a reference to the element.
+         */
+        template<class... Idx, class = typename std::enable_if<are_integral<Idx...>::value>::type>
+        reference operator () (Idx... coord) ;
+
+        /*!
+         * \brief Gets the element at the given coordinates,
+         * given as (row, column, ...).
+         * \throw std::out_of_range if the coordinates are out
+         * of range.
+         * \return the element.
+         */
+        template<class... Idx, class = typename std::enable_if<are_integral<Idx...>::value>::type>
+        T operator () (Idx... coord) const ;
+
+    protected:
+        /*!
+         * \brief Finds the chunk holding an element and the
+         * offset of the element in the chunk.
+         * \param coord the coordinates, as (row, column, ...).
+         * \param n the number of coordinates.
+         * \param chunk where to store the number of the chunk.
+         * \param offset where to store the offset.
+         * \throw std::out_of_range if the coordinates are out
+         * of range.
+         */
+        void locate(const size_t* coord, size_t n, size_t& chunk, size_t& offset) const ;
+
+        /*!
+         * \brief Finds the chunk holding the element at the
+         * given offset, in the _data order, and the offset of
+         * the element in the chunk.
+         * \throw std::out_of_range if the offset is out of
+         * range.
+         */
+        void locate(size_t data_offset, size_t& chunk, size_t& offset) const ;
+
+        /*!
+         * \brief Gets the values of a chunk, through the last
+         * chunk accessed if it is the same.
+         * \param chunk the number of the chunk.
+         * \param modify whether the values will be modified.
+         * \return the address of the values.
+         */
+        T* get_chunk_data(size_t chunk, bool modify) const ;
+
+        /*!
+         * \brief Forgets the last chunk accessed, before the
+         * cache is accessed otherwise.
+         */
+        void reset_last_chunk() const ;
+
+        /*!
+         * \brief Swaps the first two dimensions of coordinates
+         * or dimensions, from (row, column, ...) to the internal
+         * order or the opposite.
+         * \param coord the coordinates.
+         * \return the swapped coordinates.
+         */
+        static std::vector<size_t> swap_coord(const std::vector<size_t>& coord) ;
+
+        /*!
+         * \brief The file, its cache being modified by the
+         * read accesses.
+         */
+        mutable MatrixChunkedFile<T> _file ;
+        /*!
+         * \brief The dimensions of the matrix and of the chunks,
+         * in the internal order.
+         */
+        std::vector<size_t> _dim ;
+        std::vector<size_t> _chunk_dim ;
+        /*!
+         * \brief The partial products of the number of chunks
+         * along each dimension and of the chunk dimensions.
+         */
+        std::vector<size_t> _grid_prod ;
+        std::vector<size_t> _chunk_prod ;
+        /*!
+         * \brief The number of elements.
+         */
+        size_t _data_size ;
+        /*!
+         * \brief The last chunk accessed, the address of its
+         * values and whether it was accessed to be modified.
+         */
+        mutable size_t _last_chunk ;
+        mutable T* _last_data ;
+        mutable bool _last_modify ;
+
+    private:
+        /*!
+         * \brief Initialises the dimensions from the file.
+         */
+        void init() ;
+} ;
+
+
+/*!
+ * The Matrix3DOutOfCore class is a specialisation of the
+ * MatrixOutOfCore class for 3D matrices, which z slices can be
+ * read and written as Matrix2D.
+ */
+template<class T>
+class Matrix3DOutOfCore : public MatrixOutOfCore<T>
+{
+    public:
+        /*!
+         * \brief Constructs a matrix filled with 0 values,
+         * stored in a new chunked file.
+         * \param file_address the path to the file.
+         * \param dim1 the first dimension.
+         * \param dim2 the second dimension.
+         * \param dim3 the third dimension.
+         * \param chunk_dim the dimensions of the chunks.
+         * \param cache_size the maximum number of chunks held
+         * in memory.
+         */
+        Matrix3DOutOfCore(const std::string& file_address,
+                          size_t dim1, size_t dim2, size_t dim3,
+                          const std::vector<size_t>& chunk_dim,
+                          size_t cache_size=64) ;
+
+        /*!
+         * \brief Constructs a matrix stored in an existing
+         * chunked file.
+         * \param file_address the path to the file.
+         * \param read_only whether the file is only read.
+         * \param cache_size the maximum number of chunks held
+         * in memory.
+         * \throw std::runtime_error if the file cannot be
+         * opened or does not store a 3D matrix of type T.
+         */
+        Matrix3DOutOfCore(const std::string& file_address,
+                          bool read_only=false,
+                          size_t cache_size=64) ;
+
+        /*!
+         * \brief Reads a z slice.
+         * \param dim3 the index of the slice.
+         * \throw std::out_of_range if the slice does not exist.
+         * \return the slice.
+         */
+        Matrix2D<T> get_slice(size_t dim3) const ;
+
+        /*!
+         * \brief Writes a z slice.
+         * \param dim3 the index of the slice.
+         * \param slice the values of the slice.
+         * \throw std::out_of_range if the slice does not exist
+         * or if its dimensions do not match.
+         */
+        void set_slice(size_t dim3, const Matrix2D<T>& slice) ;
+} ;
+
+
+/*!
+ * The Matrix4DOutOfCore class is a specialisation of the
+ * MatrixOutOfCore class for 4D matrices, which slices along the
+ * 4th dimension can be read and written as Matrix3D.
+ */
+template<class T>
+class Matrix4DOutOfCore : public MatrixOutOfCore<T>
+{
+    public:
+        /*!
+         * \brief Constructs a matrix filled with 0 values,
+         * stored in a new chunked file.
+         * \param file_address the path to the file.
+         * \param dim1 the first dimension.
+         * \param dim2 the second dimension.
+         * \param dim3 the third dimension.
+         * \param dim4 the fourth dimension.
+         * \param chunk_dim the dimensions of the chunks.
+         * \param cache_size the maximum number of chunks held
+         * in memory.
+         */
+        Matrix4DOutOfCore(const std::string& file_address,
+                          size_t dim1, size_t dim2, size_t dim3, size_t dim4,
+                          const std::vector<size_t>& chunk_dim,
+                          size_t cache_size=64) ;
+
+        /*!
+         * \brief Constructs a matrix stored in an existing
+         * chunked file.
+         * \param file_address the path to the file.
+         * \param read_only whether the file is only read.
+         * \param cache_size the maximum number of chunks held
+         * in memory.
+         * \throw std::runtime_error if the file cannot be
+         * opened or does not store a 4D matrix of type T.
+         */
+        Matrix4DOutOfCore(const std::string& file_address,
+                          bool read_only=false,
+                          size_t cache_size=64) ;
+
+        /*!
+         * \brief Reads a slice along the 4th dimension.
+         * \param dim4 the index of the slice.
+         * \throw std::out_of_range if the slice does not exist.
+         * \return the slice.
+         */
+        Matrix3D<T> get_slice(size_t dim4) const ;
+
+        /*!
+         * \brief Writes a slice along the 4th dimension.
+         * \param dim4 the index of the slice.
+         * \param slice the values of the slice.
+         * \throw std::out_of_range if the slice does not exist
+         * or if its dimensions do not match.
+         */
+        void set_slice(size_t dim4, const Matrix3D<T>& slice) ;
+} ;
+
+
+/*!
+ * \brief Checks that the matrix stored in an out-of-core matrix
+ * file has the expected number of dimensions.
+ * \param m the matrix.
+ * \param dim_n the expected number of dimensions.
+ * \param file_address the path to the file, for the messages.
+ * \throw std::runtime_error if it has not.
+ */
+template<class T>
+void check_out_of_core_dim(const MatrixOutOfCore<T>& m, size_t dim_n, const std::string& file_address)
+{   if(m.get_dim_size() != dim_n)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! Invalid number of dimensions (%zu) found in %s",
+                m.get_dim_size(),
+                file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+
+template<class T>
+MatrixOutOfCore<T>::reference::reference(MatrixOutOfCore<T>* matrix, size_t chunk, size_t offset)
+    : _matrix(matrix), _chunk(chunk), _offset(offset)
+{}
+
+template<class T>
+MatrixOutOfCore<T>::reference::operator T () const
+{   return this->_matrix->get_chunk_data(this->_chunk, false)[this->_offset] ; }
+
+template<class T>
+typename MatrixOutOfCore<T>::reference& MatrixOutOfCore<T>::reference::operator = (const T& value)
+{   this->_matrix->get_chunk_data(this->_chunk, true)[this->_offset] = value ;
+    return *this ;
+}
+
+template<class T>
+typename MatrixOutOfCore<T>::reference& MatrixOutOfCore<T>::reference::operator = (const reference& other)
+{   return (*this) = static_cast<T>(other) ; }
+
+template<class T>
+typename MatrixOutOfCore<T>::reference& MatrixOutOfCore<T>::reference::operator += (const T& value)
+{   this->_matrix->get_chunk_data(this->_chunk, true)[this->_offset] += value ;
+    return *this ;
+}
+
+template<class T>
+typename MatrixOutOfCore<T>::reference& MatrixOutOfCore<T>::reference::operator -= (const T& value)
+{   this->_matrix->get_chunk_data(this->_chunk, true)[this->_offset] -= value ;
+    return *this ;
+}
+
+template<class T>
+typename MatrixOutOfCore<T>::reference& MatrixOutOfCore<T>::reference::operator *= (const T& value)
+{   this->_matrix->get_chunk_data(this->_chunk, true)[this->_offset] *= value ;
+    return *this ;
+}
+
+template<class T>
+typename MatrixOutOfCore<T>::reference& MatrixOutOfCore<T>::reference::operator /= (const T& value)
+{   this->_matrix->get_chunk_data(this->_chunk, true)[this->_offset] /= value ;
+    return *this ;
+}
+
+
+template<class T>
+MatrixOutOfCore<T>::MatrixOutOfCore(const std::string& file_address,
+                                    const std::vector<size_t>& dim,
+                                    const std::vector<size_t>& chunk_dim,
+                                    size_t cache_size)
+    : _file(file_address, dim, chunk_dim, cache_size)
+{   this->init() ; }
+
+template<class T>
+MatrixOutOfCore<T>::MatrixOutOfCore(const std::string& file_address,
+                                    bool read_only,
+                                    size_t cache_size)
+    : _file(file_address, read_only, cache_size)
+{   this->init() ; }
+
+template<class T>
+size_t MatrixOutOfCore<T>::get_dim_size() const
+{   return this->_dim.size() ; }
+
+template<class T>
+std::vector<size_t> MatrixOutOfCore<T>::get_dim() const
+{   return this->_file.get_dim() ; }
+
+template<class T>
+std::vector<size_t> MatrixOutOfCore<T>::get_chunk_dim() const
+{   return this->_file.get_chunk_dim() ; }
+
+template<class T>
+size_t MatrixOutOfCore<T>::get_data_size() const
+{   return this->_data_size ; }
+
+template<class T>
+T MatrixOutOfCore<T>::get(size_t offset) const
+{   size_t chunk, chunk_offset ;
+    this->locate(offset, chunk, chunk_offset) ;
+    return this->get_chunk_data(chunk, false)[chunk_offset] ;
+}
+
+template<class T>
+T MatrixOutOfCore<T>::get(const std::vector<size_t>& coord) const
+{   size_t chunk, chunk_offset ;
+    this->locate(coord.data(), coord.size(), chunk, chunk_offset) ;
+    return this->get_chunk_data(chunk, false)[chunk_offset] ;
+}
+
+template<class T>
+void MatrixOutOfCore<T>::set(size_t offset, T value)
+{   size_t chunk, chunk_offset ;
+    this->locate(offset, chunk, chunk_offset) ;
+    this->get_chunk_data(chunk, true)[chunk_offset] = value ;
+}
+
+template<class T>
+void MatrixOutOfCore<T>::set(const std::vector<size_t>& coord, T value)
+{   size_t chunk, chunk_offset ;
+    this->locate(coord.data(), coord.size(), chunk, chunk_offset) ;
+    this->get_chunk_data(chunk, true)[chunk_offset] = value ;
+}
+
+template<class T>
+void MatrixOutOfCore<T>::read_region(const std::vector<size_t>& origin,
+                                     const std::vector<size_t>& extent,
+                                     T* values) const
+{   this->reset_last_chunk() ;
+    this->_file.read_region(origin, extent, values) ;
+}
+
+template<class T>
+void MatrixOutOfCore<T>::write_region(const std::vector<size_t>& origin,
+                                      const std::vector<size_t>& extent,
+                                      const T* values)
+{   this->reset_last_chunk() ;
+    this->_file.write_region(origin, extent, values) ;
+}
+
+template<class T>
+template<class F>
+void MatrixOutOfCore<T>::modify_each_chunk(F f)
+{   std::vector<size_t> origin, extent ;
+    std::vector<size_t> strides = this->swap_coord(this->_chunk_prod) ;
+    for(size_t chunk=0; chunk<this->_file.get_chunk_number(); chunk++)
+    {   this->_file.get_chunk_region(chunk, origin, extent) ;
+        f(static_cast<const std::vector<size_t>&>(origin),
+          MatrixView<T>(this->get_chunk_data(chunk, true), extent, strides)) ;
+    }
+}
+
+template<class T>
+template<class F>
+void MatrixOutOfCore<T>::for_each_chunk(F f) const
+{   std::vector<size_t> origin, extent ;
+    std::vector<size_t> strides = this->swap_coord(this->_chunk_prod) ;
+    for(size_t chunk=0; chunk<this->_file.get_chunk_number(); chunk++)
+    {   this->_file.get_chunk_region(chunk, origin, extent) ;
+        f(static_cast<const std::vector<size_t>&>(origin),
+          MatrixView<const T>(this->get_chunk_data(chunk, false), extent, strides)) ;
+    }
+}
+
+template<class T>
+void MatrixOutOfCore<T>::flush()
+{   this->reset_last_chunk() ;
+    this->_file.flush() ;
+}
+
+template<class T>
+MatrixOutOfCore<T>& MatrixOutOfCore<T>::operator += (T value)
+{   this->modify_each_chunk([value](const std::vector<size_t>&, MatrixView<T> view)
+                            {   view += value ; }) ;
+    return *this ;
+}
+
+template<class T>
+MatrixOutOfCore<T>& MatrixOutOfCore<T>::operator -= (T value)
+{   this->modify_each_chunk([value](const std::vector<size_t>&, MatrixView<T> view)
+                            {   view -= value ; }) ;
+    return *this ;
+}
+
+template<class T>
+MatrixOutOfCore<T>& MatrixOutOfCore<T>::operator *= (T value)
+{   this->modify_each_chunk([value](const std::vector<size_t>&, MatrixView<T> view)
+                            {   view *= value ; }) ;
+    return *this ;
+}
+
+template<class T>
+MatrixOutOfCore<T>& MatrixOutOfCore<T>::operator /= (T value)
+{   if(value == static_cast<T>(0))
+    {   throw std::invalid_argument("division by 0!") ; }
+    this->modify_each_chunk([value](const std::vector<size_t>&, MatrixView<T> view)
+                            {   view /= value ; }) ;
+    return *this ;
+}
+
+template<class T>
+typename MatrixOutOfCore<T>::reference MatrixOutOfCore<T>::operator () (const std::vector<size_t>& coord)
+{   size_t chunk, chunk_offset ;
+    this->locate(coord.data(), coord.size(), chunk, chunk_offset) ;
+    return reference(this, chunk, chunk_offset) ;
+}
+
+template<class T>
+T MatrixOutOfCore<T>::operator () (const std::vector<size_t>& coord) const
+{   return this->get(coord) ; }
+
+template<class T>
+template<class... Idx, class>
+typename MatrixOutOfCore<T>::reference MatrixOutOfCore<T>::operator () (Idx... coord)
+{   std::array<size_t, sizeof...(Idx)> c = {{static_cast<size_t>(coord)...}} ;
+    size_t chunk, chunk_offset ;
+    this->locate(c.data(), c.size(), chunk, chunk_offset) ;
+    return reference(this, chunk, chunk_offset) ;
+}
+
+template<class T>
+template<class... Idx, class>
+T MatrixOutOfCore<T>::operator () (Idx... coord) const
+{   std::array<size_t, sizeof...(Idx)> c = {{static_cast<size_t>(coord)...}} ;
+    size_t chunk, chunk_offset ;
+    this->locate(c.data(), c.size(), chunk, chunk_offset) ;
+    return this->get_chunk_data(chunk, false)[chunk_offset] ;
+}
+
+template<class T>
+void MatrixOutOfCore<T>::locate(const size_t* coord, size_t n, size_t& chunk, size_t& offset) const
+{   if(n != this->_dim.size())
+    {   throw std::out_of_range("coordinates are out of range!") ; }
+    chunk  = 0 ;
+    offset = 0 ;
+    for(size_t i=0; i<n; i++)
+    {   // (row, column, ...) to (x, y, ...)
+        size_t c = (n > 1 and i < 2) ? coord[1-i] : coord[i] ;
+        if(c >= this->_dim[i])
+        {   throw std::out_of_range("coordinates are out of range!") ; }
+        chunk  += (c / this->_chunk_dim[i]) * this->_grid_prod[i] ;
+        offset += (c % this->_chunk_dim[i]) * this->_chunk_prod[i] ;
+    }
+}
+
+template<class T>
+void MatrixOutOfCore<T>::locate(size_t data_offset, size_t& chunk, size_t& offset) const
+{   if(data_offset >= this->_data_size)
+    {   throw std::out_of_range("offset is out of range!") ; }
+    chunk  = 0 ;
+    offset = 0 ;
+    for(size_t i=0; i<this->_dim.size(); i++)
+    {   size_t c     = data_offset % this->_dim[i] ;
+        data_offset /= this->_dim[i] ;
+        chunk  += (c / this->_chunk_dim[i]) * this->_grid_prod[i] ;
+        offset += (c % this->_chunk_dim[i]) * this->_chunk_prod[i] ;
+    }
+}
+
+template<class T>
+T* MatrixOutOfCore<T>::get_chunk_data(size_t chunk, bool modify) const
+{   if(chunk != this->_last_chunk or (modify and not this->_last_modify))
+    {   this->_last_chunk  = std::numeric_limits<size_t>::max() ;
+        this->_last_data   = this->_file.get_chunk_data(chunk, modify) ;
+        this->_last_chunk  = chunk ;
+        this->_last_modify = modify ;
+    }
+    return this->_last_data ;
+}
+
+template<class T>
+void MatrixOutOfCore<T>::reset_last_chunk() const
+{   this->_last_chunk  = std::numeric_limits<size_t>::max() ;
+    this->_last_data   = nullptr ;
+    this->_last_modify = false ;
+}
+
+template<class T>
+std::vector<size_t> MatrixOutOfCore<T>::swap_coord(const std::vector<size_t>& coord)
+{   std::vector<size_t> swapped = coord ;
+    if(swapped.size() > 1)
+    {   std::swap(swapped[0], swapped[1]) ; }
+    return swapped ;
+}
+
+template<class T>
+void MatrixOutOfCore<T>::init()
+{   this->_dim       = this->swap_coord(this->_file.get_dim()) ;
+    this->_chunk_dim = this->swap_coord(this->_file.get_chunk_dim()) ;
+    size_t n         = this->_dim.size() ;
+    this->_grid_prod  = std::vector<size_t>(n, 1) ;
+    this->_chunk_prod = std::vector<size_t>(n, 1) ;
+    for(size_t i=1; i<n; i++)
+    {   size_t grid_dim = (this->_dim[i-1] + this->_chunk_dim[i-1] - 1) / this->_chunk_dim[i-1] ;
+        this->_grid_prod[i]  = this->_grid_prod[i-1] * grid_dim ;
+        this->_chunk_prod[i] = this->_chunk_prod[i-1] * this->_chunk_dim[i-1] ;
+    }
+    this->_data_size = std::accumulate(this->_dim.begin(), this->_dim.end(), (size_t)1, std::multiplies<size_t>()) ;
+    this->reset_last_chunk() ;
+}
+
+
+template<class T>
+Matrix3DOutOfCore<T>::Matrix3DOutOfCore(const std::string& file_address,
+                                        size_t dim1, size_t dim2, size_t dim3,
+                                        const std::vector<size_t>& chunk_dim,
+                                        size_t cache_size)
+    : MatrixOutOfCore<T>(file_address, {dim1, dim2, dim3}, chunk_dim, cache_size)
+{}
+
+template<class T>
+Matrix3DOutOfCore<T>::Matrix3DOutOfCore(const std::string& file_address,
+                                        bool read_only,
+                                        size_t cache_size)
+    : MatrixOutOfCore<T>(file_address, read_only, cache_size)
+{   check_out_of_core_dim(*this, 3, file_address) ; }
+
+template<class T>
+Matrix2D<T> Matrix3DOutOfCore<T>::get_slice(size_t dim3) const
+{   std::vector<size_t> dim = this->get_dim() ;
+    Matrix2D<T> slice(dim[0], dim[1]) ;
+    this->read_region({0, 0, dim3}, {dim[0], dim[1], 1}, slice.get_data_ptr()) ;
+    return slice ;
+}
+
+template<class T>
+void Matrix3DOutOfCore<T>::set_slice(size_t dim3, const Matrix2D<T>& slice)
+{   std::vector<size_t> dim = this->get_dim() ;
+    if(slice.get_nrow() != dim[0] or slice.get_ncol() != dim[1])
+    {   throw std::out_of_range("the slice dimensions do not match!") ; }
+    this->write_region({0, 0, dim3}, {dim[0], dim[1], 1}, slice.get_data_ptr()) ;
+}
+
+
+template<class T>
+Matrix4DOutOfCore<T>::Matrix4DOutOfCore(const std::string& file_address,
+                                        size_t dim1, size_t dim2, size_t dim3, size_t dim4,
+                                        const std::vector<size_t>& chunk_dim,
+                                        size_t cache_size)
+    : MatrixOutOfCore<T>(file_address, {dim1, dim2, dim3, dim4}, chunk_dim, cache_size)
+{}
+
+template<class T>
+Matrix4DOutOfCore<T>::Matrix4DOutOfCore(const std::string& file_address,
+                                        bool read_only,
+                                        size_t cache_size)
+    : MatrixOutOfCore<T>(file_address, read_only, cache_size)
+{   check_out_of_core_dim(*this, 4, file_address) ; }
+
+template<class T>
+Matrix3D<T> Matrix4DOutOfCore<T>::get_slice(size_t dim4) const
+{   std::vector<size_t> dim = this->get_dim() ;
+    Matrix3D<T> slice(dim[0], dim[1], dim[2]) ;
+    this->read_region({0, 0, 0, dim4}, {dim[0], dim[1], dim[2], 1}, slice.get_data_ptr()) ;
+    return slice ;
+}
+
+template<class T>
+void Matrix4DOutOfCore<T>::set_slice(size_t dim4, const Matrix3D<T>& slice)
+{   std::vector<size_t> dim = this->get_dim() ;
+    if(slice.get_dim() != std::vector<size_t>({dim[0], dim[1], dim[2]}))
+    {   throw std::out_of_range("the slice dimensions do not match!") ; }
+    this->write_region({0, 0, 0, dim4}, {dim[0], dim[1], dim[2], 1}, slice.get_data_ptr()) ;
+}
+
+#endif // MATRIXOUTOFCORE_HPP
@@ -0,0 +1,556 @@
+#ifndef MATRIXSCRATCH_HPP
+#define MATRIXSCRATCH_HPP
+
+#include <vector>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>   // max()
+#include <cstddef>     // size_t, ptrdiff_t
+#include <cstdlib>     // free()
+#include <new>         // bad_alloc
+#include <limits>
+
+#include "MatrixAllocator.hpp"
+
+
+/*!
+ * Two allocators for the temporary matrices of the computations, which
+ * are created and destroyed over and over in the inner loops (results
+ * of expressions, of transpose(), of multiply(), ...) :
+ *
+ * - MatrixScratchAllocator draws the values from the arena of the
+ *   thread (MatrixScratchArena), a list of large blocks in which the
+ *   allocations are simply stacked. A MatrixScratchScope marks the
+ *   arena when it is created and releases everything allocated since
+ *   then when it is destroyed, the blocks being kept for the next
+ *   scope. The matrices using it should thus be destroyed before the
+ *   scope, in the thread which created them. Outside of any scope, the
+ *   values are allocated as by default.
+ *
+ *   {   MatrixScratchScope scope ;
+ *       Matrix2D<double, MatrixScratchAllocator<double>> t = a + b ;
+ *       ...
+ *   }
+ *
+ * - MatrixPoolAllocator gives the memory of the matrices destroyed to
+ *   the pool of the thread (MatrixBufferPool), which keeps the buffers
+ *   by byte size, so that the next matrix of the same size reuses one
+ *   instead of allocating it. The pool keeps at most a given number of
+ *   bytes, the buffers released the longest time ago being freed
+ *   first. The matrices using it have no constraint : a buffer
+ *   allocated by a thread can be freed or recycled by another one.
+ *
+ * Both align the values on 64 bytes, as the default allocator.
+ */
+
+
+/*!
+ * \brief A stack of allocations in large blocks of memory, one per
+ * thread.
+ */
+class MatrixScratchArena
+{
+    public:
+        /*!
+         * \brief A position in the arena.
+         */
+        struct Mark
+        {   size_t block ;
+            size_t offset ;
+        } ;
+
+        /*!
+         * \brief Creates an empty arena.
+         * \param block_size the minimal size of the blocks, in
+         * bytes.
+         */
+        MatrixScratchArena(size_t block_size = 1 << 24) ;
+
+        MatrixScratchArena(const MatrixScratchArena& other) = delete ;
+
+        /*!
+         * \brief Destructor, frees the blocks.
+         */
+        ~MatrixScratchArena() ;
+
+        MatrixScratchArena& operator = (const MatrixScratchArena& other) = delete ;
+
+        /*!
+         * \brief Returns the arena of the calling thread.
+         * \return the arena.
+         */
+        static MatrixScratchArena& get() ;
+
+        /*!
+         * \brief Allocates memory at the top of the arena, in the
+         * current block or in the next one large enough.
+         * \param size the number of bytes.
+         * \throw std::bad_alloc if a block cannot be allocated.
+         * \return the address of the memory, aligned on 64 bytes.
+         */
+        void* allocate(size_t size) ;
+
+        /*!
+         * \brief Whether an address belongs to a block of the arena.
+         * \param p the address.
+         * \return whether it belongs to the arena.
+         */
+        bool owns(const void* p) const ;
+
+        /*!
+         * \brief Gets the current top of the arena.
+         * \return the position.
+         */
+        Mark get_mark() const ;
+
+        /*!
+         * \brief Releases everything allocated since the given
+         * position, the blocks being kept.
+         * \param mark the position, returned by get_mark().
+         */
+        void reset(const Mark& mark) ;
+
+        /*!
+         * \brief Gets the number of scopes open on the arena.
+         * \return the number of scopes.
+         */
+        size_t get_scope_number() const ;
+
+        /*!
+         * \brief Gets the number of bytes allocated in the arena,
+         * up to its top.
+         * \return the number of bytes used.
+         */
+        size_t get_used_size() const ;
+
+        /*!
+         * \brief Gets the number of bytes of the blocks.
+         * \return the size of the blocks.
+         */
+        size_t get_capacity() const ;
+
+        /*!
+         * \brief Frees the blocks. Nothing should be allocated in
+         * the arena anymore.
+         */
+        void release() ;
+
+    private:
+        friend class MatrixScratchScope ;
+
+        /*!
+         * \brief The blocks, as (address, size).
+         */
+        std::vector<std::pair<char*, size_t>> _blocks ;
+        /*!
+         * \brief The top of the arena.
+         */
+        Mark _top ;
+        /*!
+         * \brief The minimal size of the blocks.
+         */
+        size_t _block_size ;
+        /*!
+         * \brief The number of scopes open.
+         */
+        size_t _n_scope ;
+} ;
+
+
+/*!
+ * \brief Opens a scope on the arena of the thread : everything
+ * allocated in the arena while the scope exists is released when it
+ * is destroyed. The scopes can be nested.
+ */
+class MatrixScratchScope
+{
+    public:
+        /*!
+         * \brief Marks the top of the arena of the calling thread.
+         */
+        MatrixScratchScope() ;
+
+        MatrixScratchScope(const MatrixScratchScope& other) = delete ;
+
+        /*!
+         * \brief Destructor, releases everything allocated in the
+         * arena since the scope was created.
+         */
+        ~MatrixScratchScope() ;
+
+        MatrixScratchScope& operator = (const MatrixScratchScope& other) = delete ;
+
+    private:
+        /*!
+         * \brief The arena and its top when the scope was created.
+         */
+        MatrixScratchArena& _arena ;
+        MatrixScratchArena::Mark _mark ;
+} ;
+
+
+/*!
+ * \brief The buffers released by the matrices of a thread, kept by
+ * byte size to be reused.
+ */
+class MatrixBufferPool
+{
+    public:
+        /*!
+         * \brief Creates an empty pool.
+         * \param max_size the maximal number of bytes kept.
+         */
+        MatrixBufferPool(size_t max_size = 1 << 28) ;
+
+        MatrixBufferPool(const MatrixBufferPool& other) = delete ;
+
+        /*!
+         * \brief Destructor, frees the buffers kept.
+         */
+        ~MatrixBufferPool() ;
+
+        MatrixBufferPool& operator = (const MatrixBufferPool& other) = delete ;
+
+        /*!
+         * \brief Returns the pool of the calling thread.
+         * \return the pool.
+         */
+        static MatrixBufferPool& get() ;
+
+        /*!
+         * \brief Returns a buffer of the given size, a buffer kept
+         * if any.
+         * \param size the number of bytes.
+         * \throw std::bad_alloc if the buffer cannot be allocated.
+         * \return the address of the buffer, aligned on 64 bytes.
+         */
+        void* allocate(size_t size) ;
+
+        /*!
+         * \brief Gives a buffer back to the pool, which keeps it
+         * unless it is larger than its maximal size. The oldest
+         * buffers kept are freed to make room for it.
+         * \param p the address of the buffer, returned by
+         * allocate() (in any thread).
+         * \param size the size of the buffer.
+         */
+        void deallocate(void* p, size_t size) ;
+
+        /*!
+         * \brief Gets the number of bytes of the buffers kept.
+         * \return the number of bytes.
+         */
+        size_t get_size() const ;
+
+        /*!
+         * \brief Sets the maximal number of bytes kept, freeing
+         * the oldest buffers if needed.
+         * \param max_size the number of bytes.
+         */
+        void set_max_size(size_t max_size) ;
+
+        /*!
+         * \brief Frees all the buffers kept.
+         */
+        void clear() ;
+
+    private:
+        /*!
+         * \brief Frees the oldest buffers until the pool holds at
+         * most the given number of bytes.
+         * \param size the number of bytes.
+         */
+        void shrink(size_t size) ;
+
+        /*!
+         * \brief The buffers kept (address and size), from the
+         * oldest to the most recently released.
+         */
+        std::list<std::pair<void*, size_t>> _lru ;
+        /*!
+         * \brief The buffers kept, by size, from the oldest to the
+         * most recently released.
+         */
+        std::unordered_map<size_t, std::deque<std::list<std::pair<void*, size_t>>::iterator>> _buffers ;
+        /*!
+         * \brief The number of bytes kept and the maximal one.
+         */
+        size_t _size ;
+        size_t _max_size ;
+} ;
+
+
+/*!
+ * \brief A standard allocator drawing the values from the arena of
+ * the thread within a MatrixScratchScope, and aligning them on 64
+ * bytes otherwise.
+ */
+template<class T>
+class MatrixScratchAllocator
+{
+    public:
+        typedef T value_type ;
+        typedef T* pointer ;
+        typedef const T* const_pointer ;
+        typedef T& reference ;
+        typedef const T& const_reference ;
+        typedef size_t size_type ;
+        typedef ptrdiff_t difference_type ;
+
+        template<class U>
+        struct rebind
+        {   typedef MatrixScratchAllocator<U> other ; } ;
+
+        MatrixScratchAllocator() = default ;
+
+        template<class U>
+        MatrixScratchAllocator(const MatrixScratchAllocator<U>&)
+        {}
+
+        /*!
+         * \brief Allocates the memory of n values, which are not
+         * constructed.
+         * \param n the number of values.
+         * \throw std::bad_alloc if the memory cannot be allocated.
+         * \return the address of the 1st value.
+         */
+        T* allocate(size_t n)
+        {   if(n > std::numeric_limits<size_t>::max() / sizeof(T))
+            {   throw std::bad_alloc() ; }
+            MatrixScratchArena& arena = MatrixScratchArena::get() ;
+            if(arena.get_scope_number() == 0)
+            {   return MatrixAlignedAllocator<T>().allocate(n) ; }
+            return static_cast<T*>(arena.allocate(n*sizeof(T))) ;
+        }
+
+        /*!
+         * \brief Releases the memory allocated by allocate().
+         * \param p the address of the 1st value.
+         * \param n the number of values.
+         */
+        void deallocate(T* p, size_t n)
+        {   // released with the scope
+            if(not MatrixScratchArena::get().owns(p))
+            {   MatrixAlignedAllocator<T>().deallocate(p, n) ; }
+        }
+
+        template<class U>
+        bool operator == (const MatrixScratchAllocator<U>&) const
+        {   return true ; }
+
+        template<class U>
+        bool operator != (const MatrixScratchAllocator<U>&) const
+        {   return false ; }
+} ;
+
+
+/*!
+ * \brief A standard allocator recycling the buffers through the pool
+ * of the thread.
+ */
+template<class T>
+class MatrixPoolAllocator
+{
+    public:
+        typedef T value_type ;
+        typedef T* pointer ;
+        typedef const T* const_pointer ;
+        typedef T& reference ;
+        typedef const T& const_reference ;
+        typedef size_t size_type ;
+        typedef ptrdiff_t difference_type ;
+
+        template<class U>
+        struct rebind
+        {   typedef MatrixPoolAllocator<U> other ; } ;
+
+        MatrixPoolAllocator() = default ;
+
+        template<class U>
+        MatrixPoolAllocator(const MatrixPoolAllocator<U>&)
+        {}
+
+        /*!
+         * \brief Allocates the memory of n values, which are not
+         * constructed.
+         * \param n the number of values.
+         * \throw std::bad_alloc if the memory cannot be allocated.
+         * \return the address of the 1st value.
+         */
+        T* allocate(size_t n)
+        {   if(n > std::numeric_limits<size_t>::max() / sizeof(T))
+            {   throw std::bad_alloc() ; }
+            return static_cast<T*>(MatrixBufferPool::get().allocate(n*sizeof(T))) ;
+        }
+
+        /*!
+         * \brief Releases the memory allocated by allocate().
+         * \param p the address of the 1st value.
+         * \param n the number of values.
+         */
+        void deallocate(T* p, size_t n)
+        {   MatrixBufferPool::get().deallocate(p, n*sizeof(T)) ; }
+
+        template<class U>
+        bool operator == (const MatrixPoolAllocator<U>&) const
+        {   return true ; }
+
+        template<class U>
+        bool operator != (const MatrixPoolAllocator<U>&) const
+        {   return false ; }
+} ;
+
+
+inline MatrixScratchArena::MatrixScratchArena(size_t block_size)
+    : _top{0, 0},
+      _block_size(std::max(block_size, matrix_default_alignment)),
+      _n_scope(0)
+{}
+
+inline MatrixScratchArena::~MatrixScratchArena()
+{   this->release() ; }
+
+inline MatrixScratchArena& MatrixScratchArena::get()
+{   static thread_local MatrixScratchArena arena ;
+    return arena ;
+}
+
+inline void* MatrixScratchArena::allocate(size_t size)
+{   // the allocations are rounded to keep the alignment
+    size = std::max(size, static_cast<size_t>(1)) ;
+    if(size > std::numeric_limits<size_t>::max() - matrix_default_alignment)
+    {   throw std::bad_alloc() ; }
+    size = ((size + matrix_default_alignment - 1) / matrix_default_alignment) * matrix_default_alignment ;
+    // the 1st block from the top large enough
+    while(this->_top.block < this->_blocks.size() and
+          this->_blocks[this->_top.block].second - this->_top.offset < size)
+    {   this->_top.block++ ;
+        this->_top.offset = 0 ;
+    }
+    if(this->_top.block == this->_blocks.size())
+    {   size_t block_size = std::max(size, this->_block_size) ;
+        char* block = reinterpret_cast<char*>(MatrixAlignedAllocator<char>().allocate(block_size)) ;
+        this->_blocks.push_back(std::make_pair(block, block_size)) ;
+    }
+    void* p = this->_blocks[this->_top.block].first + this->_top.offset ;
+    this->_top.offset += size ;
+    return p ;
+}
+
+inline bool MatrixScratchArena::owns(const void* p) const
+{   const char* c = static_cast<const char*>(p) ;
+    for(const auto& block : this->_blocks)
+    {   if(c >= block.first and c < block.first + block.second)
+        {   return true ; }
+    }
+    return false ;
+}
+
+inline MatrixScratchArena::Mark MatrixScratchArena::get_mark() const
+{   return this->_top ; }
+
+inline void MatrixScratchArena::reset(const Mark& mark)
+{   this->_top = mark ; }
+
+inline size_t MatrixScratchArena::get_scope_number() const
+{   return this->_n_scope ; }
+
+inline size_t MatrixScratchArena::get_used_size() const
+{   size_t size = this->_top.offset ;
+    for(size_t i=0; i<this->_top.block and i<this->_blocks.size(); i++)
+    {   size += this->_blocks[i].second ; }
+    return size ;
+}
+
+inline size_t MatrixScratchArena::get_capacity() const
+{   size_t size = 0 ;
+    for(const auto& block : this->_blocks)
+    {   size += block.second ; }
+    return size ;
+}
+
+inline void MatrixScratchArena::release()
+{   for(auto& block : this->_blocks)
+    {   MatrixAlignedAllocator<char>().deallocate(block.first, block.second) ; }
+    this->_blocks.clear() ;
+    this->_top = Mark{0, 0} ;
+}
+
+
+inline MatrixScratchScope::MatrixScratchScope()
+    : _arena(MatrixScratchArena::get()),
+      _mark(_arena.get_mark())
+{   this->_arena._n_scope++ ; }
+
+inline MatrixScratchScope::~MatrixScratchScope()
+{   this->_arena.reset(this->_mark) ;
+    this->_arena._n_scope-- ;
+}
+
+
+inline MatrixBufferPool::MatrixBufferPool(size_t max_size)
+    : _size(0),
+      _max_size(max_size)
+{}
+
+inline MatrixBufferPool::~MatrixBufferPool()
+{   this->clear() ; }
+
+inline MatrixBufferPool& MatrixBufferPool::get()
+{   static thread_local MatrixBufferPool pool ;
+    return pool ;
+}
+
+inline void* MatrixBufferPool::allocate(size_t size)
+{   auto buffers = this->_buffers.find(size) ;
+    if(buffers != this->_buffers.end() and not buffers->second.empty())
+    {   // the most recent one, likely still in the cache
+        auto buffer = buffers->second.back() ;
+        void* p = buffer->first ;
+        buffers->second.pop_back() ;
+        this->_lru.erase(buffer) ;
+        this->_size -= size ;
+        return p ;
+    }
+    return MatrixAlignedAllocator<char>().allocate(size) ;
+}
+
+inline void MatrixBufferPool::deallocate(void* p, size_t size)
+{   if(p == nullptr)
+    {   return ; }
+    if(size > this->_max_size)
+    {   free(p) ;
+        return ;
+    }
+    // the buffers kept are the most recent ones
+    this->shrink(this->_max_size - size) ;
+    this->_buffers[size].push_back(this->_lru.insert(this->_lru.end(), std::make_pair(p, size))) ;
+    this->_size += size ;
+}
+
+inline size_t MatrixBufferPool::get_size() const
+{   return this->_size ; }
+
+inline void MatrixBufferPool::set_max_size(size_t max_size)
+{   this->_max_size = max_size ;
+    this->shrink(max_size) ;
+}
+
+inline void MatrixBufferPool::clear()
+{   this->shrink(0) ;
+    this->_buffers.clear() ;
+}
+
+inline void MatrixBufferPool::shrink(size_t size)
+{   while(this->_size > size)
+    {   // the oldest buffer is also the oldest one of its size
+        std::pair<void*, size_t> buffer = this->_lru.front() ;
+        this->_buffers[buffer.second].pop_front() ;
+        this->_lru.pop_front() ;
+        free(buffer.first) ;
+        this->_size -= buffer.second ;
+    }
+}
+
+#endif // MATRIXSCRATCH_HPP
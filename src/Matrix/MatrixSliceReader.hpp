@@ -0,0 +1,328 @@
+#ifndef MATRIXSLICEREADER_HPP
+#define MATRIXSLICEREADER_HPP
+
+#include <vector>
+#include <string>
+#include <iterator>    // input_iterator_tag
+#include <algorithm>   // copy()
+#include <cstddef>     // size_t, ptrdiff_t
+
+#include "Matrix2D.hpp"
+#include "Matrix3D.hpp"
+#include "MatrixTextParser.hpp"
+
+
+/*!
+ * The slice readers read the text files of the Matrix3D and Matrix4D
+ * classes one slice at a time : a Matrix3DSliceReader returns the 2D
+ * slices of a Matrix3D file as Matrix2D and a Matrix4DSliceReader the
+ * 3D slices of a Matrix4D file as Matrix3D. The file is read through
+ * a block buffer and the values of each slice are parsed in the same
+ * matrix, so the memory used is one slice, whatever the size of the
+ * file.
+ *
+ * The slices are read with next() and accessed with get_slice(), or
+ * iterated over :
+ * for(const Matrix2D<double>& slice : Matrix3DSliceReader<double>(file))
+ * { ... }
+ * The matrix returned is overwritten by the next slice, it should be
+ * copied to be kept.
+ */
+
+
+/*!
+ * \brief The single pass iterator over the slices of a reader.
+ */
+template<class R, class S>
+class MatrixSliceIterator
+{
+    public:
+        typedef std::input_iterator_tag iterator_category ;
+        typedef S value_type ;
+        typedef std::ptrdiff_t difference_type ;
+        typedef const S* pointer ;
+        typedef const S& reference ;
+
+        /*!
+         * \brief Constructs an iterator on a reader.
+         * \param reader the reader, nullptr for the end.
+         */
+        MatrixSliceIterator(R* reader)
+            : _reader(reader)
+        {}
+
+        const S& operator * () const
+        {   return this->_reader->get_slice() ; }
+
+        const S* operator -> () const
+        {   return &(this->_reader->get_slice()) ; }
+
+        MatrixSliceIterator& operator ++ ()
+        {   if(not this->_reader->next())
+            {   this->_reader = nullptr ; }
+            return *this ;
+        }
+
+        bool operator == (const MatrixSliceIterator& other) const
+        {   return this->_reader == other._reader ; }
+
+        bool operator != (const MatrixSliceIterator& other) const
+        {   return this->_reader != other._reader ; }
+
+    private:
+        /*!
+         * \brief The reader, nullptr once all the slices have
+         * been read.
+         */
+        R* _reader ;
+} ;
+
+
+/*!
+ * \brief Reads the 2D slices of a Matrix3D text file one at a
+ * time.
+ */
+template<class T>
+class Matrix3DSliceReader
+{
+    public:
+        typedef MatrixSliceIterator<Matrix3DSliceReader<T>, Matrix2D<T>> iterator ;
+
+        /*!
+         * \brief Opens a file.
+         * \param file_address the path to the file.
+         * \param block_size the number of characters read at
+         * once.
+         * \throw std::runtime_error if the file cannot be opened
+         * or does not start with a slice header.
+         */
+        Matrix3DSliceReader(const std::string& file_address, size_t block_size = 1 << 22) ;
+
+        /*!
+         * \brief Reads the next slice.
+         * \throw std::runtime_error if the file is not well
+         * formatted or if the slice does not have the dimensions
+         * of the previous ones.
+         * \return whether a slice was read, false once all the
+         * slices have been read.
+         */
+        bool next() ;
+
+        /*!
+         * \brief Gets the slice read last.
+         * \return the slice.
+         */
+        const Matrix2D<T>& get_slice() const ;
+
+        /*!
+         * \brief Gets the index of the slice read last, along
+         * the 3rd dimension.
+         * \return the index of the slice.
+         */
+        size_t get_slice_index() const ;
+
+        /*!
+         * \brief Reads the 1st slice, if none has been read yet,
+         * and returns an iterator on it.
+         * \return the iterator.
+         */
+        iterator begin() ;
+
+        /*!
+         * \brief Gets the iterator past the last slice.
+         * \return the iterator.
+         */
+        iterator end() ;
+
+    private:
+        /*!
+         * \brief The parser of the file.
+         */
+        MatrixTextSliceParser<T> _parser ;
+        /*!
+         * \brief The slice read last, its values being
+         * overwritten by the next one.
+         */
+        Matrix2D<T> _slice ;
+} ;
+
+
+/*!
+ * \brief Reads the 3D slices of a Matrix4D text file one at a
+ * time.
+ */
+template<class T>
+class Matrix4DSliceReader
+{
+    public:
+        typedef MatrixSliceIterator<Matrix4DSliceReader<T>, Matrix3D<T>> iterator ;
+
+        /*!
+         * \brief Opens a file.
+         * \param file_address the path to the file.
+         * \param block_size the number of characters read at
+         * once.
+         * \throw std::runtime_error if the file cannot be opened
+         * or does not start with a slice header.
+         */
+        Matrix4DSliceReader(const std::string& file_address, size_t block_size = 1 << 22) ;
+
+        /*!
+         * \brief Reads the next slice.
+         * \throw std::runtime_error if the file is not well
+         * formatted or if the slice does not have the dimensions
+         * of the previous ones.
+         * \return whether a slice was read, false once all the
+         * slices have been read.
+         */
+        bool next() ;
+
+        /*!
+         * \brief Gets the slice read last.
+         * \return the slice.
+         */
+        const Matrix3D<T>& get_slice() const ;
+
+        /*!
+         * \brief Gets the index of the slice read last, along
+         * the 4th dimension.
+         * \return the index of the slice.
+         */
+        size_t get_slice_index() const ;
+
+        /*!
+         * \brief Reads the 1st slice, if none has been read yet,
+         * and returns an iterator on it.
+         * \return the iterator.
+         */
+        iterator begin() ;
+
+        /*!
+         * \brief Gets the iterator past the last slice.
+         * \return the iterator.
+         */
+        iterator end() ;
+
+    private:
+        /*!
+         * \brief The parser of the file.
+         */
+        MatrixTextSliceParser<T> _parser ;
+        /*!
+         * \brief The slice read last, its values being
+         * overwritten by the next one.
+         */
+        Matrix3D<T> _slice ;
+        /*!
+         * \brief The number of 3D slices read.
+         */
+        size_t _n_slice = 0 ;
+} ;
+
+
+template<class T>
+Matrix3DSliceReader<T>::Matrix3DSliceReader(const std::string& file_address, size_t block_size)
+    : _parser(file_address, 3, block_size)
+{}
+
+template<class T>
+bool Matrix3DSliceReader<T>::next()
+{   if(this->_parser.get_slice_number() > 0)
+    {   return this->_parser.next_slice(this->_slice.get_data_ptr()) ; }
+
+    // the 1st slice gives the dimensions
+    std::vector<T> values ;
+    if(not this->_parser.next_slice(values))
+    {   return false ; }
+    this->_slice = Matrix2D<T>(this->_parser.get_row_number(), this->_parser.get_row_len()) ;
+    std::copy(values.begin(), values.end(), this->_slice.get_data_ptr()) ;
+    return true ;
+}
+
+template<class T>
+const Matrix2D<T>& Matrix3DSliceReader<T>::get_slice() const
+{   return this->_slice ; }
+
+template<class T>
+size_t Matrix3DSliceReader<T>::get_slice_index() const
+{   return this->_parser.get_slice_number() - 1 ; }
+
+template<class T>
+typename Matrix3DSliceReader<T>::iterator Matrix3DSliceReader<T>::begin()
+{   if(this->_parser.get_slice_number() == 0 and not this->next())
+    {   return this->end() ; }
+    return iterator(this) ;
+}
+
+template<class T>
+typename Matrix3DSliceReader<T>::iterator Matrix3DSliceReader<T>::end()
+{   return iterator(nullptr) ; }
+
+
+template<class T>
+Matrix4DSliceReader<T>::Matrix4DSliceReader(const std::string& file_address, size_t block_size)
+    : _parser(file_address, 4, block_size)
+{}
+
+template<class T>
+bool Matrix4DSliceReader<T>::next()
+{   if(this->_parser.end())
+    {   return false ; }
+
+    // the 2D slices up to the next 3D slice header
+    if(this->_n_slice > 0)
+    {   std::vector<size_t> dim = this->_slice.get_dim() ;
+        size_t slice_size = dim[0] * dim[1] ;
+        for(size_t k=0; k<dim[2]; k++)
+        {   if((k > 0 and this->_parser.starts_slice_3d()) or
+               not this->_parser.next_slice(this->_slice.get_data_ptr() + k*slice_size))
+            {   this->_parser.throw_format_error("slice have variable dimensions") ; }
+        }
+        if(not this->_parser.end() and not this->_parser.starts_slice_3d())
+        {   this->_parser.throw_format_error("slice have variable dimensions") ; }
+        this->_n_slice++ ;
+        return true ;
+    }
+
+    // the 1st 3D slice gives the number of 2D slices
+    std::vector<T> values ;
+    size_t n_slice_2d = 0 ;
+    do
+    {   size_t n = values.size() ;
+        if(n_slice_2d == 0)
+        {   if(not this->_parser.next_slice(values))
+            {   return false ; }
+        }
+        else
+        {   values.resize(n + this->_parser.get_row_len()*this->_parser.get_row_number()) ;
+            if(not this->_parser.next_slice(values.data() + n))
+            {   this->_parser.throw_format_error("slice have variable dimensions") ; }
+        }
+        n_slice_2d++ ;
+    } while(not this->_parser.end() and not this->_parser.starts_slice_3d()) ;
+    this->_slice = Matrix3D<T>(this->_parser.get_row_number(), this->_parser.get_row_len(), n_slice_2d) ;
+    std::copy(values.begin(), values.end(), this->_slice.get_data_ptr()) ;
+    this->_n_slice++ ;
+    return true ;
+}
+
+template<class T>
+const Matrix3D<T>& Matrix4DSliceReader<T>::get_slice() const
+{   return this->_slice ; }
+
+template<class T>
+size_t Matrix4DSliceReader<T>::get_slice_index() const
+{   return this->_n_slice - 1 ; }
+
+template<class T>
+typename Matrix4DSliceReader<T>::iterator Matrix4DSliceReader<T>::begin()
+{   if(this->_n_slice == 0 and not this->next())
+    {   return this->end() ; }
+    return iterator(this) ;
+}
+
+template<class T>
+typename Matrix4DSliceReader<T>::iterator Matrix4DSliceReader<T>::end()
+{   return iterator(nullptr) ; }
+
+#endif // MATRIXSLICEREADER_HPP
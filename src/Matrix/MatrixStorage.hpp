@@ -0,0 +1,457 @@
+#ifndef MATRIXSTORAGE_HPP
+#define MATRIXSTORAGE_HPP
+
+#include <vector>
+#include <string>
+#include <utility>     // move()
+#include <cstddef>     // size_t
+#include <cstdio>      // sprintf()
+#include <cstring>     // strerror()
+#include <cerrno>      // errno
+#include <stdexcept>   // runtime_error
+
+#include <fcntl.h>     // open()
+#include <unistd.h>    // close(), ftruncate()
+#include <sys/mman.h>  // mmap(), munmap(), shm_open(), shm_unlink()
+#include <sys/stat.h>  // fstat()
+
+#include "MatrixAllocator.hpp"
+
+
+/*!
+ * The storage classes hold the values of a matrix. A matrix only
+ * needs a contiguous array of values and its length, which is what
+ * the MatrixStorage base class provides, whatever the memory the
+ * values actually live in :
+ * - MatrixHeapStorage owns a std::vector, this is the default. Its
+ *   memory comes from the allocator of the matrix, by default aligned
+ *   on 64 bytes (see MatrixAllocator.hpp).
+ * - MatrixMmapStorage maps a file in memory. The values are not
+ *   read when the storage is created, the pages are loaded lazily
+ *   by the OS when they are accessed for the first time.
+ * - MatrixShmStorage maps a POSIX shared memory object, which one
+ *   process creates and the other processes attach to, so that they
+ *   all access the same values in memory.
+ * The last two share the handling of the mapping, the values being
+ * a range of the mapped bytes (MatrixMappedStorage).
+ *
+ * The accessors of the base class are not virtual, accessing a value
+ * costs the same as accessing a std::vector. Only the destructor,
+ * which releases the memory, depends on the storage type.
+ */
+
+
+/*!
+ * \brief The ways a file can be mapped in memory.
+ * read_only     : the values cannot be modified, any attempt to do so
+ *                 crashes the program (SIGSEGV). The pages are shared
+ *                 with the page cache and with the other processes
+ *                 mapping the same file.
+ * copy_on_write : the values can be modified, the modified pages are
+ *                 privately copied by the OS on the first write. The
+ *                 file is never modified.
+ */
+enum class MatrixMapMode
+{   read_only,
+    copy_on_write
+} ;
+
+
+template<class T>
+class MatrixStorage
+{
+    public:
+        /*!
+         * \brief Destructor.
+         */
+        virtual ~MatrixStorage() = default ;
+
+        /*!
+         * \brief Gets the address of the 1st value.
+         * \return the address of the 1st value.
+         */
+        T* data()
+        {   return this->_ptr ; }
+
+        /*!
+         * \brief Gets the address of the 1st value.
+         * \return the address of the 1st value.
+         */
+        const T* data() const
+        {   return this->_ptr ; }
+
+        /*!
+         * \brief Gets the number of values stored.
+         * \return the number of values.
+         */
+        size_t size() const
+        {   return this->_size ; }
+
+        /*!
+         * \brief Returns a reference to the value at the
+         * given offset, without any check.
+         * \param i the offset of the value.
+         * \return a reference to the value.
+         */
+        T& operator [] (size_t i)
+        {   return this->_ptr[i] ; }
+
+        /*!
+         * \brief Returns a constant reference to the value at
+         * the given offset, without any check.
+         * \param i the offset of the value.
+         * \return a constant reference to the value.
+         */
+        const T& operator [] (size_t i) const
+        {   return this->_ptr[i] ; }
+
+        T* begin()
+        {   return this->_ptr ; }
+        T* end()
+        {   return this->_ptr + this->_size ; }
+        const T* begin() const
+        {   return this->_ptr ; }
+        const T* end() const
+        {   return this->_ptr + this->_size ; }
+
+    protected:
+        MatrixStorage() = default ;
+        MatrixStorage(const MatrixStorage& other) = delete ;
+        MatrixStorage& operator = (const MatrixStorage& other) = delete ;
+
+        /*!
+         * \brief The address of the 1st value.
+         */
+        T* _ptr = nullptr ;
+        /*!
+         * \brief The number of values.
+         */
+        size_t _size = 0 ;
+} ;
+
+
+/*!
+ * \brief A tag selecting the constructors which leave the values
+ * uninitialized, for the values which are all written right after
+ * the construction.
+ */
+struct MatrixUninitialized
+{} ;
+const MatrixUninitialized matrix_uninitialized = MatrixUninitialized() ;
+
+
+template<class T, class A = MatrixAlignedAllocator<T>>
+class MatrixHeapStorage : public MatrixStorage<T>
+{
+    public:
+        /*!
+         * \brief The type of the vector holding the values, its
+         * allocator allocates the memory with A but does not
+         * initialize the values constructed without any argument.
+         */
+        typedef std::vector<T, MatrixDefaultInitAllocator<A>> vector_type ;
+
+        /*!
+         * \brief Allocates n values, set to the given value.
+         * \param n the number of values.
+         * \param value the initial value.
+         */
+        MatrixHeapStorage(size_t n, T value = T())
+            : _values(n, value)
+        {   this->update() ; }
+
+        /*!
+         * \brief Allocates n values, which are not initialized.
+         * \param n the number of values.
+         */
+        MatrixHeapStorage(size_t n, MatrixUninitialized)
+            : _values(n)
+        {   this->update() ; }
+
+        /*!
+         * \brief Copies the values in the range [first,last).
+         * \param first the address of the 1st value.
+         * \param last the address past the last value.
+         */
+        MatrixHeapStorage(const T* first, const T* last)
+            : _values(first, last)
+        {   this->update() ; }
+
+        /*!
+         * \brief Takes over the values of a vector.
+         * \param values the values.
+         */
+        MatrixHeapStorage(vector_type&& values)
+            : _values(std::move(values))
+        {   this->update() ; }
+
+    private:
+        /*!
+         * \brief Updates the address and the size of the
+         * values from the vector.
+         */
+        void update()
+        {   this->_ptr  = this->_values.data() ;
+            this->_size = this->_values.size() ;
+        }
+
+        /*!
+         * \brief The values.
+         */
+        vector_type _values ;
+} ;
+
+
+template<class T>
+class MatrixMappedStorage : public MatrixStorage<T>
+{
+    public:
+        /*!
+         * \brief Destructor, unmaps the memory.
+         */
+        virtual ~MatrixMappedStorage()
+        {   if(this->_map != nullptr)
+            {   munmap(this->_map, this->_map_size) ;
+                this->_map = nullptr ;
+            }
+        }
+
+        /*!
+         * \brief Gets the address of the 1st byte mapped.
+         * \return the address of the 1st byte.
+         */
+        const char* get_bytes() const
+        {   return this->_map ; }
+
+        /*!
+         * \brief Gets the size of the memory mapped, in bytes.
+         * \return the size of the memory mapped.
+         */
+        size_t get_byte_size() const
+        {   return this->_map_size ; }
+
+        /*!
+         * \brief Sets the values of the storage to n values
+         * starting at the given byte of the memory mapped.
+         * \param byte_offset the position of the 1st value, in
+         * bytes.
+         * \param n the number of values.
+         * \throw std::runtime_error if the memory mapped is too
+         * short or if the values are not properly aligned for
+         * type T.
+         */
+        void set_range(size_t byte_offset, size_t n)
+        {   if(byte_offset > this->_map_size or
+               n > (this->_map_size - byte_offset) / sizeof(T))
+            {   throw std::runtime_error("error! the file is too short to contain the data") ; }
+            if(byte_offset % alignof(T) != 0)
+            {   throw std::runtime_error("error! the data are not aligned in the file") ; }
+            this->_ptr  = reinterpret_cast<T*>(this->_map + byte_offset) ;
+            this->_size = n ;
+        }
+
+    protected:
+        MatrixMappedStorage() = default ;
+
+        /*!
+         * \brief Maps a file descriptor in memory, with
+         * MAP_SHARED or MAP_PRIVATE and the given protection.
+         * The descriptor is closed, the mapping remaining valid.
+         * Nothing is mapped if the size is 0.
+         * \param fd the file descriptor.
+         * \param size the number of bytes to map.
+         * \param prot the protection of the pages.
+         * \param share MAP_SHARED or MAP_PRIVATE.
+         * \param address the name of the file, for the messages.
+         * \throw std::runtime_error if the memory cannot be
+         * mapped.
+         */
+        void map(int fd, size_t size, int prot, int share, const std::string& address)
+        {   this->_map_size = size ;
+            // an empty file cannot be mapped, there is simply nothing to access
+            if(this->_map_size == 0)
+            {   close(fd) ;
+                return ;
+            }
+            void* map = mmap(nullptr, this->_map_size, prot, share, fd, 0) ;
+            int error = errno ;
+            // the mapping remains valid once the file is closed
+            close(fd) ;
+            if(map == MAP_FAILED)
+            {   this->_map_size = 0 ;
+                char msg[4096] ;
+                sprintf(msg, "error! cannot map %s (%s)", address.c_str(), strerror(error)) ;
+                throw std::runtime_error(msg) ;
+            }
+            this->_map = static_cast<char*>(map) ;
+        }
+
+        /*!
+         * \brief The address of the mapping.
+         */
+        char* _map = nullptr ;
+        /*!
+         * \brief The size of the mapping, in bytes.
+         */
+        size_t _map_size = 0 ;
+} ;
+
+
+template<class T>
+class MatrixMmapStorage : public MatrixMappedStorage<T>
+{
+    public:
+        /*!
+         * \brief Maps the whole file in memory. Only the address
+         * space is reserved, no value is read. Initially, the
+         * storage contains no value, see set_range(). An empty
+         * file is not mapped, its size is 0.
+         * \param file_address the path to the file.
+         * \param mode how the file should be mapped.
+         * \throw std::runtime_error if the file cannot be opened
+         * or mapped.
+         */
+        MatrixMmapStorage(const std::string& file_address, MatrixMapMode mode)
+        {   // a private mapping can be written even if the file is opened read only
+            int fd = open(file_address.c_str(), O_RDONLY) ;
+            if(fd < 0)
+            {   char msg[4096] ;
+                sprintf(msg, "error! cannot open %s (%s)", file_address.c_str(), strerror(errno)) ;
+                throw std::runtime_error(msg) ;
+            }
+            struct stat file_stat ;
+            if(fstat(fd, &file_stat) != 0)
+            {   close(fd) ;
+                char msg[4096] ;
+                sprintf(msg, "error! cannot stat %s (%s)", file_address.c_str(), strerror(errno)) ;
+                throw std::runtime_error(msg) ;
+            }
+            int prot = (mode == MatrixMapMode::read_only) ? PROT_READ : (PROT_READ | PROT_WRITE) ;
+            int share = (mode == MatrixMapMode::read_only) ? MAP_SHARED : MAP_PRIVATE ;
+            this->map(fd, static_cast<size_t>(file_stat.st_size), prot, share, file_address) ;
+        }
+} ;
+
+
+template<class T>
+class MatrixShmStorage : public MatrixMappedStorage<T>
+{
+    public:
+        /*!
+         * \brief Creates a shared memory object of the given
+         * size, filled with zeros, and maps it for reading and
+         * writing. Initially, the storage contains no value, see
+         * set_range().
+         * \param name the name of the object, a leading '/' is
+         * added if missing.
+         * \param byte_size the size of the object, in bytes.
+         * \param persistent whether the object is kept once the
+         * storage is destroyed, until remove() is called. By
+         * default, the name is removed by the destructor, the
+         * memory being released when the last process attached
+         * to it unmaps it.
+         * \throw std::runtime_error if the object already exists
+         * or cannot be created.
+         */
+        MatrixShmStorage(const std::string& name, size_t byte_size, bool persistent)
+            : _name(get_name(name)),
+              _owner(not persistent)
+        {   int fd = shm_open(this->_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644) ;
+            if(fd < 0)
+            {   char msg[4096] ;
+                sprintf(msg, "error! cannot create the shared memory %s (%s)", this->_name.c_str(), strerror(errno)) ;
+                throw std::runtime_error(msg) ;
+            }
+            try
+            {   if(ftruncate(fd, static_cast<off_t>(byte_size)) != 0)
+                {   close(fd) ;
+                    char msg[4096] ;
+                    sprintf(msg, "error! cannot resize the shared memory %s (%s)", this->_name.c_str(), strerror(errno)) ;
+                    throw std::runtime_error(msg) ;
+                }
+                this->map(fd, byte_size, PROT_READ | PROT_WRITE, MAP_SHARED, this->_name) ;
+            }
+            catch(...)
+            {   shm_unlink(this->_name.c_str()) ;
+                throw ;
+            }
+        }
+
+        /*!
+         * \brief Maps an existing shared memory object for
+         * reading only. Modifying the values crashes the program
+         * (SIGSEGV). Initially, the storage contains no value, see
+         * set_range().
+         * \param name the name of the object, a leading '/' is
+         * added if missing.
+         * \throw std::runtime_error if the object does not exist
+         * or cannot be mapped.
+         */
+        explicit MatrixShmStorage(const std::string& name)
+            : _name(get_name(name)),
+              _owner(false)
+        {   int fd = shm_open(this->_name.c_str(), O_RDONLY, 0) ;
+            if(fd < 0)
+            {   char msg[4096] ;
+                sprintf(msg, "error! cannot open the shared memory %s (%s)", this->_name.c_str(), strerror(errno)) ;
+                throw std::runtime_error(msg) ;
+            }
+            struct stat shm_stat ;
+            if(fstat(fd, &shm_stat) != 0)
+            {   close(fd) ;
+                char msg[4096] ;
+                sprintf(msg, "error! cannot stat the shared memory %s (%s)", this->_name.c_str(), strerror(errno)) ;
+                throw std::runtime_error(msg) ;
+            }
+            this->map(fd, static_cast<size_t>(shm_stat.st_size), PROT_READ, MAP_SHARED, this->_name) ;
+        }
+
+        /*!
+         * \brief Destructor, unmaps the memory and, if the
+         * object was created by this storage and is not
+         * persistent, removes its name.
+         */
+        virtual ~MatrixShmStorage()
+        {   if(this->_owner)
+            {   shm_unlink(this->_name.c_str()) ; }
+        }
+
+        /*!
+         * \brief Gets the address of the 1st byte mapped, for
+         * writing. Only a storage which created the object can
+         * be written.
+         * \return the address of the 1st byte.
+         */
+        char* get_bytes_for_writing()
+        {   return this->_map ; }
+
+        /*!
+         * \brief Removes the name of a shared memory object, the
+         * memory being released when the last process attached to
+         * it unmaps it.
+         * \param name the name of the object.
+         * \return whether the object existed.
+         */
+        static bool remove(const std::string& name)
+        {   return shm_unlink(get_name(name).c_str()) == 0 ; }
+
+    private:
+        /*!
+         * \brief Gives the name of an object, with a leading '/'.
+         * \param name the name, with or without the '/'.
+         * \return the name with the '/'.
+         */
+        static std::string get_name(const std::string& name)
+        {   return (not name.empty() and name[0] == '/') ? name : "/" + name ; }
+
+        /*!
+         * \brief The name of the object.
+         */
+        std::string _name ;
+        /*!
+         * \brief Whether the name is removed by the destructor.
+         */
+        bool _owner ;
+} ;
+
+#endif // MATRIXSTORAGE_HPP
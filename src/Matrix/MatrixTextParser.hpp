@@ -0,0 +1,1044 @@
+#ifndef MATRIXTEXTPARSER_HPP
+#define MATRIXTEXTPARSER_HPP
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <limits>
+#include <type_traits> // is_integral, is_same
+#include <utility>     // pair
+#include <algorithm>   // min(), copy()
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t
+#include <cstdio>      // sprintf()
+#include <cstdlib>     // strtod_l()
+#include <cstring>     // memchr(), memmove()
+#include <cerrno>      // errno
+#include <stdexcept>   // runtime_error
+#include <locale.h>    // newlocale()
+
+#include "MatrixStorage.hpp"
+#include "ThreadPool.hpp"
+
+
+/*!
+ * The text formats of the Matrix2D, Matrix3D and Matrix4D classes
+ * are parsed line by line. Instead of extracting each line into a
+ * std::string and each value through a std::istringstream, the file
+ * is read by large blocks and the values are parsed directly from
+ * the block :
+ * - MatrixTextReader returns the lines of a file as ranges of
+ *   characters in its block buffer.
+ * - parse_text_line() parses all the values of such a line. The
+ *   integer and floating point values are converted without any
+ *   locale nor stream, the other types still go through a stream.
+ *
+ * - MatrixTextSliceParser reads the 2D slices of a Matrix3D or
+ *   Matrix4D file one at a time, in constant memory.
+ * - load_text_slices() loads a Matrix3D or Matrix4D file. The file
+ *   is mapped in memory, the slice headers are located and the 2D
+ *   slices are parsed in parallel, each one directly at its final
+ *   place in the data.
+ *
+ * The values are delimited exactly as operator >> does : the
+ * integers are made of an optional sign and digits, the floating
+ * point values of an optional sign, digits with an optional decimal
+ * point and an optional exponent, and a char value is any character
+ * that is not a space.
+ */
+
+
+/*!
+ * \brief Reads a text file line by line, by large blocks.
+ */
+class MatrixTextReader
+{
+    public:
+        /*!
+         * \brief Opens a file.
+         * \param file_address the path to the file.
+         * \param block_size the number of characters to read at
+         * once.
+         * \throw std::runtime_error if the file cannot be opened.
+         */
+        MatrixTextReader(const std::string& file_address, size_t block_size = 1 << 22)
+            : _file_address(file_address),
+              _file(file_address, std::ifstream::in | std::ifstream::binary),
+              _buffer(block_size)
+        {   if(this->_file.fail())
+            {   char msg[4096] ;
+                sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
+                throw std::runtime_error(msg) ;
+            }
+            this->_file.seekg(0, std::ifstream::end) ;
+            this->_file_size = static_cast<size_t>(this->_file.tellg()) ;
+            this->_file.seekg(0, std::ifstream::beg) ;
+        }
+
+        /*!
+         * \brief Gets the next line. As with std::getline(), the last
+         * line is returned even if it does not end with an eol char.
+         * \param begin where the address of the 1st character of the
+         * line is stored.
+         * \param end where the address past the last character of the
+         * line (the eol char is excluded) is stored.
+         * The line remains valid until the next call.
+         * \throw std::runtime_error if an error occures while reading.
+         * \return whether a line has been read, false when the whole
+         * file has been read.
+         */
+        bool getline(const char*& begin, const char*& end)
+        {   size_t searched = this->_pos ;
+            while(true)
+            {   const char* first = this->_buffer.data() + this->_pos ;
+                const char* eol = static_cast<const char*>(memchr(this->_buffer.data() + searched, '\n',
+                                                                  this->_len - searched)) ;
+                if(eol != nullptr)
+                {   begin = first ;
+                    end   = eol ;
+                    this->_pos = eol - this->_buffer.data() + 1 ;
+                    return true ;
+                }
+                searched = this->_len - this->_pos ;
+                if(not this->fill())
+                {   break ; }
+            }
+            // last line without eol char
+            if(this->_pos < this->_len)
+            {   begin = this->_buffer.data() + this->_pos ;
+                end   = this->_buffer.data() + this->_len ;
+                this->_pos = this->_len ;
+                return true ;
+            }
+            return false ;
+        }
+
+        /*!
+         * \brief Checks whether the whole file has been read, that
+         * is whether there is no character left after the last line.
+         * \return whether the whole file has been read.
+         */
+        bool eof()
+        {   if(this->_pos < this->_len)
+            {   return false ; }
+            return not this->fill() ;
+        }
+
+        /*!
+         * \brief Gets the size of the file.
+         * \return the size of the file, in bytes.
+         */
+        size_t get_file_size() const
+        {   return this->_file_size ; }
+
+        /*!
+         * \brief Estimates the number of values in the file, assuming
+         * that all the lines look like a given one.
+         * \param n_value the number of values in the line.
+         * \param line_length the length of the line, without the eol
+         * char.
+         * \return the estimated number of values in the file.
+         */
+        size_t estimate_value_number(size_t n_value, size_t line_length) const
+        {   return n_value * (this->_file_size / (line_length + 1) + 1) ; }
+
+    private:
+        /*!
+         * \brief Reads the next block, keeping the characters that
+         * have not been returned yet at the beginning of the buffer.
+         * The buffer is enlarged if these fill it.
+         * \throw std::runtime_error if an error occures while reading.
+         * \return whether characters were read.
+         */
+        bool fill()
+        {   if(this->_file_eof)
+            {   return false ; }
+            size_t n_left = this->_len - this->_pos ;
+            if(n_left > 0 and this->_pos > 0)
+            {   memmove(this->_buffer.data(), this->_buffer.data() + this->_pos, n_left) ; }
+            this->_pos = 0 ;
+            this->_len = n_left ;
+            if(this->_len == this->_buffer.size())
+            {   this->_buffer.resize(2*this->_buffer.size()) ; }
+            this->_file.read(this->_buffer.data() + this->_len, this->_buffer.size() - this->_len) ;
+            size_t n_read = static_cast<size_t>(this->_file.gcount()) ;
+            if(this->_file.bad())
+            {   char msg[4096] ;
+                sprintf(msg, "error! while reading %s", this->_file_address.c_str()) ;
+                throw std::runtime_error(msg) ;
+            }
+            if(this->_file.eof())
+            {   this->_file_eof = true ; }
+            this->_len += n_read ;
+            return n_read > 0 ;
+        }
+
+        /*!
+         * \brief The path to the file.
+         */
+        std::string _file_address ;
+        /*!
+         * \brief The file.
+         */
+        std::ifstream _file ;
+        /*!
+         * \brief The size of the file, in bytes.
+         */
+        size_t _file_size = 0 ;
+        /*!
+         * \brief The characters read.
+         */
+        std::vector<char> _buffer ;
+        /*!
+         * \brief The position of the 1st character not returned
+         * yet in the buffer.
+         */
+        size_t _pos = 0 ;
+        /*!
+         * \brief The number of characters in the buffer.
+         */
+        size_t _len = 0 ;
+        /*!
+         * \brief Whether the end of the file has been reached.
+         */
+        bool _file_eof = false ;
+} ;
+
+
+/*!
+ * \brief Checks whether a line is a slice header, that is n ','
+ * followed by characters that are not ',' (such as ",,0" for n=2).
+ * \param begin the address of the 1st character of the line.
+ * \param end the address past the last character of the line.
+ * \param n the number of ','.
+ * \return whether the line is a slice header.
+ */
+inline bool is_text_header(const char* begin, const char* end, size_t n)
+{   if(static_cast<size_t>(end - begin) < n)
+    {   return false ; }
+    for(size_t i=0; i<n; i++)
+    {   if(begin[i] != ',')
+        {   return false ; }
+    }
+    return memchr(begin + n, ',', end - begin - n) == nullptr ;
+}
+
+/*!
+ * \brief Checks whether a character is a space, in the "C" locale.
+ * \param c the character.
+ * \return whether the character is a space.
+ */
+inline bool is_text_space(char c)
+{   return c == ' ' or c == '\t' or c == '\r' or c == '\v' or c == '\f' or c == '\n' ; }
+
+/*!
+ * \brief Checks whether a character is a decimal digit.
+ * \param c the character.
+ * \return whether the character is a digit.
+ */
+inline bool is_text_digit(char c)
+{   return c >= '0' and c <= '9' ; }
+
+/*!
+ * \brief Gets the "C" locale, to convert the floating point
+ * values the fast path cannot handle independently of the
+ * global locale.
+ * \return the "C" locale.
+ */
+inline locale_t get_text_c_locale()
+{   static locale_t locale = newlocale(LC_ALL_MASK, "C", (locale_t)0) ;
+    return locale ;
+}
+
+
+/*!
+ * \brief The kinds of values, which are parsed differently.
+ */
+enum class text_value_kind
+{   character,
+    integer,
+    floating,
+    other
+} ;
+
+/*!
+ * \brief Gives the kind of a type of values.
+ */
+template<class T>
+struct text_value_kind_of
+{   static const text_value_kind value =
+        (std::is_same<T,char>::value or
+         std::is_same<T,signed char>::value or
+         std::is_same<T,unsigned char>::value) ? text_value_kind::character :
+        (std::is_integral<T>::value and not std::is_same<T,bool>::value) ? text_value_kind::integer :
+        (std::is_same<T,float>::value or std::is_same<T,double>::value or
+         std::is_same<T,long double>::value) ? text_value_kind::floating :
+        text_value_kind::other ;
+} ;
+
+
+/*!
+ * \brief Parses a value at the beginning of a range of characters
+ * (which does not start with a space). This is the generic version,
+ * which reads the value from a stream.
+ */
+template<class T, text_value_kind kind = text_value_kind_of<T>::value>
+struct text_value_parser
+{   /*!
+     * \brief Parses a value.
+     * \param p the address of the 1st character of the value, it is
+     * moved past the last character of the value.
+     * \param end the end of the characters available.
+     * \param value where to store the value.
+     * \return whether a value could be parsed.
+     */
+    static bool parse(const char*& p, const char* end, T& value)
+    {   std::istringstream stream(std::string(p, end)) ;
+        if(not (stream >> value))
+        {   return false ; }
+        std::streamoff n = stream.eof() ? static_cast<std::streamoff>(end - p) : static_cast<std::streamoff>(stream.tellg()) ;
+        p += n ;
+        return true ;
+    }
+} ;
+
+/*!
+ * \brief Characters, a value is any character that is not a space.
+ */
+template<class T>
+struct text_value_parser<T, text_value_kind::character>
+{   static bool parse(const char*& p, const char*, T& value)
+    {   value = static_cast<T>(*(p++)) ;
+        return true ;
+    }
+} ;
+
+/*!
+ * \brief Integers, in base 10, with an optional sign. As with
+ * operator >>, values out of the range of T are errors, except
+ * negative values for unsigned types which are wrapped.
+ */
+template<class T>
+struct text_value_parser<T, text_value_kind::integer>
+{   static bool parse(const char*& p, const char* end, T& value)
+    {   typedef typename std::make_unsigned<T>::type U ;
+        bool negative = false ;
+        if(*p == '-' or *p == '+')
+        {   negative = (*p == '-') ;
+            p++ ;
+        }
+        if(p == end or not is_text_digit(*p))
+        {   return false ; }
+        // the largest magnitude that can be stored
+        U max = std::is_signed<T>::value ?
+                    static_cast<U>(std::numeric_limits<T>::max()) + (negative ? 1 : 0) :
+                    std::numeric_limits<U>::max() ;
+        U x = 0 ;
+        for(; p != end and is_text_digit(*p); p++)
+        {   U digit = static_cast<U>(*p - '0') ;
+            if(x > (max - digit) / 10)
+            {   return false ; }
+            x = 10*x + digit ;
+        }
+        value = negative ? static_cast<T>(U(0) - x) : static_cast<T>(x) ;
+        return true ;
+    }
+} ;
+
+/*!
+ * \brief Floating point values. Most values are made of at most 19
+ * significant digits with a small exponent, they are converted exactly
+ * with a single product or division of two exact floating point values
+ * (Clinger's fast path). The other ones are converted by strtod_l() in
+ * the "C" locale.
+ * The fast path of float values is computed in double precision and
+ * rounded to float, which gives the correctly rounded value unless the
+ * double value lies exactly halfway between two float values.
+ */
+template<class T>
+struct text_value_parser<T, text_value_kind::floating>
+{   /*!
+     * \brief The type in which the fast path is computed.
+     */
+    typedef typename std::conditional<std::is_same<T,float>::value, double, T>::type F ;
+    /*!
+     * \brief The largest mantissa and power of 10 of the fast path,
+     * for which both are exactly represented by a F.
+     */
+    static const uint64_t mantissa_max = uint64_t(1) << 53 ;
+    static const int exponent_max = 22 ;
+
+    static bool parse(const char*& p, const char* end, T& value)
+    {   const char* first = p ;
+        bool negative = false ;
+        if(*p == '-' or *p == '+')
+        {   negative = (*p == '-') ;
+            p++ ;
+        }
+        // mantissa
+        uint64_t mantissa = 0 ;
+        int n_digit = 0 ;       // significant digits stored in the mantissa
+        int exponent = 0 ;
+        bool found_digit = false ;
+        bool exact = true ;     // whether all the significant digits fit in the mantissa
+        for(; p != end and is_text_digit(*p); p++)
+        {   found_digit = true ;
+            if(n_digit < 19)
+            {   mantissa = 10*mantissa + (*p - '0') ;
+                n_digit += (mantissa != 0) ;
+            }
+            else
+            {   exponent++ ;
+                exact = exact and *p == '0' ;
+            }
+        }
+        if(p != end and *p == '.')
+        {   p++ ;
+            for(; p != end and is_text_digit(*p); p++)
+            {   found_digit = true ;
+                if(n_digit < 19)
+                {   mantissa = 10*mantissa + (*p - '0') ;
+                    n_digit += (mantissa != 0) ;
+                    exponent-- ;
+                }
+                else
+                {   exact = exact and *p == '0' ; }
+            }
+        }
+        if(not found_digit)
+        {   return false ; }
+        // exponent
+        if(p != end and (*p == 'e' or *p == 'E'))
+        {   p++ ;
+            bool exp_negative = false ;
+            if(p != end and (*p == '-' or *p == '+'))
+            {   exp_negative = (*p == '-') ;
+                p++ ;
+            }
+            if(p == end or not is_text_digit(*p))
+            {   return false ; }
+            int exp = 0 ;
+            for(; p != end and is_text_digit(*p); p++)
+            {   if(exp < 100000)
+                {   exp = 10*exp + (*p - '0') ; }
+            }
+            exponent += exp_negative ? -exp : exp ;
+        }
+        // fast path
+        if(exact and mantissa <= mantissa_max and
+           exponent >= -exponent_max and exponent <= exponent_max)
+        {   F x = static_cast<F>(mantissa) ;
+            if(mantissa != 0)
+            {   static const F powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                           1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                           1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22} ;
+                x = exponent < 0 ? x / powers[-exponent] : x * powers[exponent] ;
+            }
+            if(is_exactly_rounded(x))
+            {   value = static_cast<T>(negative ? -x : x) ;
+                return true ;
+            }
+        }
+        // slow path, on a null terminated copy of the value
+        std::string str(first, p) ;
+        char* str_end = nullptr ;
+        errno = 0 ;
+        value = convert(str.c_str(), &str_end) ;
+        if(str_end != str.c_str() + str.size())
+        {   return false ; }
+        // overflow, as operator >> does
+        if(errno == ERANGE and (value > 1 or value < -1))
+        {   return false ; }
+        return true ;
+    }
+
+    private:
+        /*!
+         * \brief Checks whether a positive value computed by the fast
+         * path gives the correctly rounded T value once converted.
+         * This is always the case when T and F are the same type.
+         * \param x the value.
+         * \return whether the converted value is correctly rounded.
+         */
+        static bool is_exactly_rounded(F x)
+        {   if(std::is_same<T,F>::value or x == 0)
+            {   return true ; }
+            // only the normal float values are handled, the other bits of the
+            // mantissa should not be exactly 1 followed by 0's (halfway)
+            if(x < std::numeric_limits<T>::min() or x > std::numeric_limits<T>::max())
+            {   return false ; }
+            uint64_t bits ;
+            memcpy(&bits, &x, sizeof(bits)) ;
+            const uint64_t halfway = uint64_t(1) << (std::numeric_limits<T>::digits < 52 ? 52 - std::numeric_limits<T>::digits : 0) ;
+            return (bits & (2*halfway - 1)) != halfway ;
+        }
+
+        /*!
+         * \brief Converts a null terminated string in the "C" locale.
+         * \param str the string.
+         * \param str_end where the address past the last character
+         * converted is stored.
+         * \return the value.
+         */
+        static T convert(const char* str, char** str_end) ;
+} ;
+
+template<class T>
+const uint64_t text_value_parser<T, text_value_kind::floating>::mantissa_max ;
+template<class T>
+const int text_value_parser<T, text_value_kind::floating>::exponent_max ;
+
+template<>
+inline float text_value_parser<float, text_value_kind::floating>::convert(const char* str, char** str_end)
+{   return strtof_l(str, str_end, get_text_c_locale()) ; }
+
+template<>
+inline double text_value_parser<double, text_value_kind::floating>::convert(const char* str, char** str_end)
+{   return strtod_l(str, str_end, get_text_c_locale()) ; }
+
+template<>
+inline long double text_value_parser<long double, text_value_kind::floating>::convert(const char* str, char** str_end)
+{   return strtold_l(str, str_end, get_text_c_locale()) ; }
+
+
+/*!
+ * \brief Parses all the values of a line, separated by spaces, and
+ * appends them to a vector.
+ * \param begin the address of the 1st character of the line.
+ * \param end the address past the last character of the line.
+ * \param values where to append the values.
+ * \return whether the line could be parsed, false if it contains a
+ * value that cannot be converted to a T (the values before it have
+ * been appended).
+ */
+template<class T, class Alloc>
+bool parse_text_line(const char* begin, const char* end, std::vector<T,Alloc>& values)
+{   T value ;
+    const char* p = begin ;
+    while(true)
+    {   while(p != end and is_text_space(*p))
+        {   p++ ; }
+        if(p == end)
+        {   return true ; }
+        if(not text_value_parser<T>::parse(p, end, value))
+        {   return false ; }
+        values.push_back(value) ;
+    }
+}
+
+/*!
+ * \brief Parses all the values of a line, separated by spaces, and
+ * stores them in an array.
+ * \param begin the address of the 1st character of the line.
+ * \param end the address past the last character of the line.
+ * \param values where to store the values.
+ * \param n_max the maximum number of values to store.
+ * \param n where the number of values found is stored. If the line
+ * contains more than n_max values, the parsing stops after the
+ * (n_max+1)th value (which is not stored) and n is n_max+1.
+ * \return whether the line could be parsed, false if it contains a
+ * value that cannot be converted to a T.
+ */
+template<class T>
+bool parse_text_line(const char* begin, const char* end, T* values, size_t n_max, size_t& n)
+{   T value ;
+    const char* p = begin ;
+    n = 0 ;
+    while(n <= n_max)
+    {   while(p != end and is_text_space(*p))
+        {   p++ ; }
+        if(p == end)
+        {   return true ; }
+        if(not text_value_parser<T>::parse(p, end, value))
+        {   return false ; }
+        if(n < n_max)
+        {   values[n] = value ; }
+        n++ ;
+    }
+    return true ;
+}
+
+
+/*!
+ * \brief A slice header line (such as ",,0" or ",,,0") in a text
+ * file.
+ */
+struct text_header
+{   /*!
+     * \brief The offset of the 1st character of the line.
+     */
+    size_t begin ;
+    /*!
+     * \brief The offset of the eol char ending the line (or the
+     * size of the file for the last line).
+     */
+    size_t end ;
+    /*!
+     * \brief The number of ',' of the header, 2 for a 2D slice
+     * header and 3 for a 3D slice header.
+     */
+    size_t level ;
+} ;
+
+/*!
+ * \brief Finds all the slice header lines of a text file, up to a
+ * given level. As a header starts with ',', only the lines starting
+ * with ',' are inspected.
+ * \param data the content of the file.
+ * \param size the size of the file.
+ * \param level_max the largest number of ',' of a header.
+ * \return the headers, in the order of the file.
+ */
+inline std::vector<text_header> find_text_headers(const char* data, size_t size, size_t level_max)
+{   std::vector<text_header> headers ;
+    size_t pos = 0 ;
+    while(pos < size)
+    {   const char* comma = static_cast<const char*>(memchr(data + pos, ',', size - pos)) ;
+        if(comma == nullptr)
+        {   break ; }
+        size_t begin = comma - data ;
+        const char* eol = static_cast<const char*>(memchr(comma, '\n', size - begin)) ;
+        size_t end = (eol == nullptr) ? size : static_cast<size_t>(eol - data) ;
+        // the line starts with this ','
+        if(begin == 0 or data[begin-1] == '\n')
+        {   size_t level = 0 ;
+            while(begin + level < end and data[begin + level] == ',')
+            {   level++ ; }
+            if(level >= 2 and level <= level_max and is_text_header(data + begin, data + end, level))
+            {   headers.push_back({begin, end, level}) ; }
+        }
+        pos = end + 1 ;
+    }
+    return headers ;
+}
+
+/*!
+ * \brief Parses the lines of a 2D slice of a text file, which dimensions
+ * are not known yet, and appends the values to a vector.
+ * \param begin the address of the 1st character of the slice, after
+ * its header line.
+ * \param end the address past the last character of the slice.
+ * \param values where to append the values.
+ * \param row_len where the number of values per line is stored.
+ * \param n_row where the number of lines is stored.
+ * \param file_address the path to the file, for the error messages.
+ * \throw std::runtime_error if the slice is not well formatted.
+ */
+template<class T, class Alloc>
+void parse_text_slice(const char* begin, const char* end, std::vector<T,Alloc>& values,
+                      size_t& row_len, size_t& n_row, const std::string& file_address)
+{   row_len = 0 ;
+    n_row   = 0 ;
+    for(const char* line=begin; line<end; n_row++)
+    {   const char* eol = static_cast<const char*>(memchr(line, '\n', end - line)) ;
+        const char* line_end = (eol == nullptr) ? end : eol ;
+        char msg[4096] ;
+        if(line == line_end)
+        {   sprintf(msg, "format error! while reading %s (empty line)", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        size_t n = values.size() ;
+        if(not parse_text_line(line, line_end, values))
+        {   sprintf(msg, "format error! could not read a line in %s (incompatible data types)", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        n = values.size() - n ;
+        if(n_row == 0)
+        {   row_len = n ; }
+        else if(n != row_len)
+        {   sprintf(msg, "format error! slice have variable dimensions in %s", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        line = line_end + 1 ;
+    }
+}
+
+/*!
+ * \brief Parses the lines of a 2D slice of a text file, which should
+ * have the given dimensions, and stores the values in an array.
+ * \param begin the address of the 1st character of the slice, after
+ * its header line.
+ * \param end the address past the last character of the slice.
+ * \param values where to store the values, row_len*n_row values.
+ * \param row_len the number of values per line.
+ * \param n_row the number of lines.
+ * \param file_address the path to the file, for the error messages.
+ * \throw std::runtime_error if the slice is not well formatted or
+ * does not have the given dimensions.
+ */
+template<class T>
+void parse_text_slice(const char* begin, const char* end, T* values,
+                      size_t row_len, size_t n_row, const std::string& file_address)
+{   size_t row = 0 ;
+    for(const char* line=begin; line<end; row++)
+    {   const char* eol = static_cast<const char*>(memchr(line, '\n', end - line)) ;
+        const char* line_end = (eol == nullptr) ? end : eol ;
+        char msg[4096] ;
+        if(line == line_end)
+        {   sprintf(msg, "format error! while reading %s (empty line)", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        if(row == n_row)
+        {   sprintf(msg, "format error! slice have variable dimensions in %s", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        size_t n = 0 ;
+        if(not parse_text_line(line, line_end, values + row*row_len, row_len, n))
+        {   sprintf(msg, "format error! could not read a line in %s (incompatible data types)", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        if(n != row_len)
+        {   sprintf(msg, "format error! slice have variable dimensions in %s", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        line = line_end + 1 ;
+    }
+    if(row != n_row)
+    {   char msg[4096] ;
+        sprintf(msg, "format error! slice have variable dimensions in %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+/*!
+ * \brief Reads the 2D slices of a text file storing a Matrix3D or a
+ * Matrix4D one after the other, line by line, through the block
+ * buffer of a MatrixTextReader. Only one slice is held in memory at
+ * a time, whatever the size of the file.
+ * The format is checked as load_text_slices() does, as the slices
+ * are read.
+ */
+template<class T>
+class MatrixTextSliceParser
+{
+    public:
+        /*!
+         * \brief Opens a file and reads its 1st header(s).
+         * \param file_address the path to the file.
+         * \param dim_n the number of dimensions, 3 or 4.
+         * \param block_size the number of characters to read at
+         * once.
+         * \throw std::runtime_error if the file cannot be opened
+         * or does not start with a slice header.
+         */
+        MatrixTextSliceParser(const std::string& file_address, size_t dim_n, size_t block_size = 1 << 22)
+            : _file_address(file_address),
+              _file(file_address, block_size),
+              _dim_n(dim_n)
+        {   const char* line     = nullptr ;
+            const char* line_end = nullptr ;
+            // this file is empty or only contains one eol char and should be
+            // considered as empty -> no slice, not an error
+            if(not this->_file.getline(line, line_end) or
+               (line == line_end and this->_file.eof()))
+            {   return ; }
+            this->_next_level = this->get_header_level(line, line_end) ;
+            if(line == line_end)
+            {   this->throw_format_error("empty line") ; }
+            if(this->_next_level != dim_n - 1)
+            {   this->throw_format_error("first line is not a slice header") ; }
+        }
+
+        /*!
+         * \brief Reads the next 2D slice, which dimensions are not
+         * known yet (the 1st one), and appends its values to a vector.
+         * \param values where the values are appended.
+         * \throw std::runtime_error if the file is not well formatted.
+         * \return whether a slice was read, false at the end of the
+         * file.
+         */
+        template<class Alloc>
+        bool next_slice(std::vector<T,Alloc>& values)
+        {   if(not this->begin_slice())
+            {   return false ; }
+            const char* line     = nullptr ;
+            const char* line_end = nullptr ;
+            size_t n_row = 0 ;
+            while(this->next_line(line, line_end))
+            {   size_t n = values.size() ;
+                if(not parse_text_line(line, line_end, values))
+                {   this->throw_format_error("incompatible data types") ; }
+                n = values.size() - n ;
+                if(n_row == 0)
+                {   this->_row_len = n ; }
+                else if(n != this->_row_len)
+                {   this->throw_format_error("slice have variable dimensions") ; }
+                n_row++ ;
+            }
+            this->_n_row = n_row ;
+            this->_n_slice++ ;
+            return true ;
+        }
+
+        /*!
+         * \brief Reads the next 2D slice, which should have the
+         * dimensions of the 1st one, and stores its values in an
+         * array.
+         * \param values where to store the get_row_len()*get_row_number()
+         * values.
+         * \throw std::runtime_error if the file is not well formatted
+         * or if the slice does not have the dimensions of the 1st one.
+         * \return whether a slice was read, false at the end of the
+         * file.
+         */
+        bool next_slice(T* values)
+        {   if(not this->begin_slice())
+            {   return false ; }
+            const char* line     = nullptr ;
+            const char* line_end = nullptr ;
+            size_t row = 0 ;
+            while(this->next_line(line, line_end))
+            {   size_t n = 0 ;
+                if(row == this->_n_row)
+                {   this->throw_format_error("slice have variable dimensions") ; }
+                if(not parse_text_line(line, line_end, values + row*this->_row_len, this->_row_len, n))
+                {   this->throw_format_error("incompatible data types") ; }
+                if(n != this->_row_len)
+                {   this->throw_format_error("slice have variable dimensions") ; }
+                row++ ;
+            }
+            if(row != this->_n_row)
+            {   this->throw_format_error("slice have variable dimensions") ; }
+            this->_n_slice++ ;
+            return true ;
+        }
+
+        /*!
+         * \brief Checks whether the next 2D slice starts a new 3D
+         * slice, in a Matrix4D file.
+         * \return whether the next slice is the 1st of a 3D slice.
+         */
+        bool starts_slice_3d() const
+        {   return this->_next_level == 3 ; }
+
+        /*!
+         * \brief Checks whether all the slices have been read.
+         * \return whether there is no slice left.
+         */
+        bool end() const
+        {   return this->_next_level == 0 ; }
+
+        /*!
+         * \brief Gets the number of values per line of the slices.
+         * \return the number of values per line.
+         */
+        size_t get_row_len() const
+        {   return this->_row_len ; }
+
+        /*!
+         * \brief Gets the number of lines of the slices.
+         * \return the number of lines.
+         */
+        size_t get_row_number() const
+        {   return this->_n_row ; }
+
+        /*!
+         * \brief Gets the number of 2D slices read so far.
+         * \return the number of slices.
+         */
+        size_t get_slice_number() const
+        {   return this->_n_slice ; }
+
+        /*!
+         * \brief Throws an exception about the format of the file.
+         * \param what the error.
+         * \throw std::runtime_error always.
+         */
+        void throw_format_error(const char* what) const
+        {   char msg[4096] ;
+            sprintf(msg, "format error! while reading %s (%s)", this->_file_address.c_str(), what) ;
+            throw std::runtime_error(msg) ;
+        }
+
+    private:
+        /*!
+         * \brief Gets the level of a slice header line.
+         * \return the number of ',' of the header, 0 if the line is
+         * not a header of this file.
+         */
+        size_t get_header_level(const char* line, const char* line_end) const
+        {   for(size_t level=2; level<this->_dim_n; level++)
+            {   if(is_text_header(line, line_end, level))
+                {   return level ; }
+            }
+            return 0 ;
+        }
+
+        /*!
+         * \brief Consumes the header(s) introducing the next 2D
+         * slice.
+         * \return whether there is a slice left.
+         */
+        bool begin_slice()
+        {   if(this->_next_level == 0)
+            {   return false ; }
+            // a 3D slice header, the next line should be a 2D header
+            if(this->_next_level == 3)
+            {   const char* line     = nullptr ;
+                const char* line_end = nullptr ;
+                if(not this->_file.getline(line, line_end) or
+                   this->get_header_level(line, line_end) != 2)
+                {   this->throw_format_error("first line is not a slice header") ; }
+            }
+            this->_next_level = 2 ;
+            return true ;
+        }
+
+        /*!
+         * \brief Gets the next line of the current slice.
+         * \return whether a line was read, false at the end of the
+         * slice, the next header being consumed.
+         */
+        bool next_line(const char*& line, const char*& line_end)
+        {   if(not this->_file.getline(line, line_end))
+            {   this->_next_level = 0 ;
+                return false ;
+            }
+            if(line == line_end)
+            {   this->throw_format_error("empty line") ; }
+            size_t level = this->get_header_level(line, line_end) ;
+            if(level != 0)
+            {   this->_next_level = level ;
+                return false ;
+            }
+            return true ;
+        }
+
+        /*!
+         * \brief The path to the file, for the messages.
+         */
+        std::string _file_address ;
+        /*!
+         * \brief The file.
+         */
+        MatrixTextReader _file ;
+        /*!
+         * \brief The number of dimensions of the matrix stored.
+         */
+        size_t _dim_n ;
+        /*!
+         * \brief The level of the header which has been read
+         * last, 0 at the end of the file.
+         */
+        size_t _next_level = 0 ;
+        /*!
+         * \brief The dimensions of the slices.
+         */
+        size_t _row_len = 0 ;
+        size_t _n_row   = 0 ;
+        /*!
+         * \brief The number of 2D slices read.
+         */
+        size_t _n_slice = 0 ;
+} ;
+
+/*!
+ * \brief Loads a text file storing a Matrix3D (2D slices introduced by
+ * ",,k" headers) or a Matrix4D (3D slices introduced by ",,,k" headers,
+ * made of 2D slices).
+ * The file is mapped in memory and the headers are located first, which
+ * gives the position of each 2D slice in the data. The 1st 2D slice is
+ * parsed to get the slice dimensions, then all the other slices are
+ * parsed in parallel, each one at its final place.
+ * The format is checked as the sequential reading does : the file should
+ * start with a header, should not contain empty lines (but a file with
+ * only one eol char is an empty matrix) and all the slices should have
+ * the same dimensions.
+ * \param file_address the path to the file.
+ * \param dim_n the number of dimensions, 3 or 4.
+ * \param dim where the dimensions are stored, in the internal order
+ * (number of columns, of rows, ...).
+ * \param data where the values are stored.
+ * \param pool the threads to use.
+ * \throw std::runtime_error if the file cannot be read or is not well
+ * formatted.
+ */
+template<class T, class Alloc>
+void load_text_slices(const std::string& file_address, size_t dim_n,
+                      std::vector<size_t>& dim, std::vector<T,Alloc>& data, ThreadPool& pool)
+{   dim  = std::vector<size_t>(dim_n, 0) ;
+    data = std::vector<T,Alloc>() ;
+    MatrixMmapStorage<char> file(file_address, MatrixMapMode::read_only) ;
+    const char* bytes = file.get_bytes() ;
+    size_t size       = file.get_byte_size() ;
+
+    // this file is empty or only contains one eol char and should be
+    // considered as empty -> returns empty matrix not an error
+    if(size == 0 or (size == 1 and bytes[0] == '\n'))
+    {   return ; }
+
+    std::vector<text_header> headers = find_text_headers(bytes, size, dim_n - 1) ;
+    char msg[4096] ;
+    if(bytes[0] == '\n')
+    {   sprintf(msg, "format error! while reading %s (empty line)", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    // 1st line in file should be a header of the highest level
+    if(headers.empty() or headers[0].begin != 0 or headers[0].level != dim_n - 1)
+    {   sprintf(msg, "format error! first line is not a slice header in %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+
+    // the 2D slices, as (begin, end) offsets, and the number of 3D slices
+    std::vector<std::pair<size_t,size_t>> slices ;
+    size_t n_slice_3d = 0 ;
+    size_t n_slice_2d_per_3d = 0 ;  // for 4D files
+    size_t n_slice_2d_cur = 0 ;
+    for(size_t i=0; i<headers.size(); i++)
+    {   size_t next = (i+1 < headers.size()) ? headers[i+1].begin : size ;
+        size_t begin = std::min(headers[i].end + 1, size) ;
+        if(headers[i].level == 2)
+        {   slices.push_back(std::make_pair(begin, next)) ;
+            n_slice_2d_cur++ ;
+            continue ;
+        }
+        // a 3D slice header, the 1st line of the 3D slice should be a 2D header
+        if(begin != next)
+        {   sprintf(msg, "format error! first line is not a slice header in %s", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        if(n_slice_3d == 1)
+        {   n_slice_2d_per_3d = n_slice_2d_cur ; }
+        else if(n_slice_3d > 1 and n_slice_2d_cur != n_slice_2d_per_3d)
+        {   sprintf(msg, "format error! slice have variable dimensions in %s", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        n_slice_2d_cur = 0 ;
+        n_slice_3d++ ;
+    }
+    if(dim_n == 4)
+    {   if(n_slice_3d > 1 and n_slice_2d_cur != n_slice_2d_per_3d)
+        {   sprintf(msg, "format error! slice have variable dimensions in %s", file_address.c_str()) ;
+            throw std::runtime_error(msg) ;
+        }
+        n_slice_2d_per_3d = n_slice_2d_cur ;
+        dim[2] = n_slice_2d_per_3d ;
+        dim[3] = n_slice_3d ;
+    }
+    else
+    {   dim[2] = slices.size() ; }
+    if(slices.empty())
+    {   return ; }
+
+    // the 1st slice gives the dimensions
+    std::vector<T> slice ;
+    size_t row_len = 0, n_row = 0 ;
+    parse_text_slice(bytes + slices[0].first, bytes + slices[0].second, slice, row_len, n_row, file_address) ;
+    dim[0] = row_len ;
+    dim[1] = n_row ;
+    size_t slice_size = row_len * n_row ;
+    data = std::vector<T,Alloc>(slices.size() * slice_size) ;
+    std::copy(slice.begin(), slice.end(), data.begin()) ;
+
+    // the other ones are parsed in parallel, at their place
+    pool.parallel_for(1, slices.size(),
+                      [&](size_t from, size_t to)
+                      {   for(size_t i=from; i<to; i++)
+                          {   parse_text_slice(bytes + slices[i].first, bytes + slices[i].second,
+                                               data.data() + i*slice_size, row_len, n_row, file_address) ;
+                          }
+                      }) ;
+}
+
+#endif // MATRIXTEXTPARSER_HPP
@@ -0,0 +1,513 @@
+#ifndef MATRIXTEXTWRITER_HPP
+#define MATRIXTEXTWRITER_HPP
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>     // setw()
+#include <locale>
+#include <limits>
+#include <type_traits> // make_unsigned
+#include <algorithm>   // min()
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t
+#include <cstdio>      // snprintf()
+#include <cstring>     // memcpy()
+#include <cmath>       // isfinite()
+#include <locale.h>    // uselocale()
+
+#include "MatrixTextParser.hpp"
+#include "ThreadPool.hpp"
+
+
+/*!
+ * The text representations of the matrices (see print()) are
+ * formatted into large buffers which are written to the stream at
+ * once, instead of sending each value to the stream with a
+ * std::setw() and flushing the stream after each row :
+ * - the integers are converted directly, and so are the floating
+ *   point values, rounded exactly as snprintf() with "%.*f" does,
+ *   which is what the stream does itself with std::fixed. The
+ *   values that are too large, or have too many decimals, go
+ *   through snprintf() in the "C" locale. The chars are copied.
+ * - the other types, and the streams with other formatting flags or
+ *   another locale, still go through a std::ostringstream with the
+ *   formatting of the stream, but one per chunk of lines.
+ * - the chunks of lines can be formatted in parallel, they are
+ *   written in order.
+ *
+ * The output is identical, byte for byte, to the one obtained by
+ * sending each value to the stream.
+ */
+
+
+/*!
+ * \brief Formats a value in a range of characters, the way
+ * a stream in the "C" locale, with std::fixed, does. This is
+ * the generic version, which goes through a stream.
+ */
+template<class T, text_value_kind kind = text_value_kind_of<T>::value>
+struct text_value_formatter
+{   /*!
+     * \brief Formats a value.
+     * \param buffer where to write the characters.
+     * \param size the number of characters available.
+     * \param value the value.
+     * \param precision the number of decimals.
+     * \return the number of characters of the value, which
+     * are written only if there are less than size.
+     */
+    static size_t format(char* buffer, size_t size, const T& value, int precision)
+    {   std::ostringstream stream ;
+        stream.imbue(std::locale::classic()) ;
+        stream << std::setprecision(precision) << std::fixed << value ;
+        std::string str = stream.str() ;
+        if(str.size() < size)
+        {   std::copy(str.begin(), str.end(), buffer) ; }
+        return str.size() ;
+    }
+} ;
+
+/*!
+ * \brief Chars, the character itself.
+ */
+template<class T>
+struct text_value_formatter<T, text_value_kind::character>
+{   static size_t format(char* buffer, size_t size, const T& value, int)
+    {   if(size > 1)
+        {   buffer[0] = static_cast<char>(value) ; }
+        return 1 ;
+    }
+} ;
+
+/*!
+ * \brief Integers, the digits are written from the last
+ * one.
+ */
+template<class T>
+struct text_value_formatter<T, text_value_kind::integer>
+{   static size_t format(char* buffer, size_t size, const T& value, int)
+    {   typedef typename std::make_unsigned<T>::type U ;
+        // the sign and the digits of the largest value
+        char digits[std::numeric_limits<U>::digits10 + 3] ;
+        char* end = digits + sizeof(digits) ;
+        char* p   = end ;
+        // the absolute value, computed without overflow
+        U u = (value < 0) ? static_cast<U>(U(0) - static_cast<U>(value)) : static_cast<U>(value) ;
+        do
+        {   *(--p) = static_cast<char>('0' + u % 10) ;
+            u /= 10 ;
+        } while(u != 0) ;
+        if(value < 0)
+        {   *(--p) = '-' ; }
+        size_t n = static_cast<size_t>(end - p) ;
+        if(n < size)
+        {   std::copy(p, end, buffer) ; }
+        return n ;
+    }
+} ;
+
+/*!
+ * \brief Formats a double in fixed notation, without any
+ * locale, rounded as printf() does : the exact binary value
+ * is rounded to the nearest, ties to even. The value is
+ * m * 2^e, the digits are those of m * 10^precision / 2^-e
+ * computed with 128 bits integers.
+ * \param buffer where to write the characters, at least 64
+ * characters should be available.
+ * \param value the value.
+ * \param precision the number of decimals.
+ * \return the number of characters written, 0 if the value
+ * could not be formatted this way (not finite, too large or
+ * too many decimals).
+ */
+inline size_t format_text_fixed(char* buffer, double value, int precision)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128_t ;
+    static const uint64_t powers[] = {1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull,
+                                      1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+                                      10000000000ull, 100000000000ull, 1000000000000ull,
+                                      10000000000000ull, 100000000000000ull, 1000000000000000ull,
+                                      10000000000000000ull, 100000000000000000ull,
+                                      1000000000000000000ull, 10000000000000000000ull} ;
+    if(precision < 0 or precision > 19 or not std::isfinite(value))
+    {   return 0 ; }
+    uint64_t bits ;
+    memcpy(&bits, &value, sizeof(bits)) ;
+    bool negative     = (bits >> 63) != 0 ;
+    int exponent      = static_cast<int>((bits >> 52) & 0x7ff) ;
+    uint64_t mantissa = bits & ((1ull << 52) - 1) ;
+    // subnormal values have no implicit leading bit
+    if(exponent == 0)
+    {   exponent = 1 ; }
+    else
+    {   mantissa |= (1ull << 52) ; }
+    int shift = exponent - 1075 ;
+
+    uint128_t q ;
+    if(shift >= 0)
+    {   if(shift > 11)
+        {   return 0 ; }
+        q = static_cast<uint128_t>(mantissa << shift) * powers[precision] ;
+    }
+    else
+    {   // n < 2^117, if shift <= -118 the value rounds to 0
+        uint128_t n = static_cast<uint128_t>(mantissa) * powers[precision] ;
+        int k = -shift ;
+        if(k >= 118)
+        {   q = 0 ; }
+        else
+        {   q = n >> k ;
+            uint128_t r    = n - (q << k) ;
+            uint128_t half = static_cast<uint128_t>(1) << (k - 1) ;
+            if(r > half or (r == half and (q & 1) != 0))
+            {   q++ ; }
+        }
+    }
+    if((q >> 64) != 0)
+    {   return 0 ; }
+
+    // the digits, with at least one before the decimal point
+    char digits[24] ;
+    char* end = digits + sizeof(digits) ;
+    char* p   = end ;
+    uint64_t u = static_cast<uint64_t>(q) ;
+    do
+    {   *(--p) = static_cast<char>('0' + u % 10) ;
+        u /= 10 ;
+    } while(u != 0) ;
+    while(end - p < precision + 1)
+    {   *(--p) = '0' ; }
+    char* c = buffer ;
+    if(negative)
+    {   *(c++) = '-' ; }
+    char* point = end - precision ;
+    c = std::copy(p, point, c) ;
+    if(precision > 0)
+    {   *(c++) = '.' ;
+        c = std::copy(point, end, c) ;
+    }
+    return static_cast<size_t>(c - buffer) ;
+#else
+    (void)buffer ; (void)value ; (void)precision ;
+    return 0 ;
+#endif
+}
+
+/*!
+ * \brief Floating point values, directly if possible, by
+ * snprintf() otherwise. The "C" locale should be used by
+ * the calling thread.
+ */
+template<class T>
+struct text_value_formatter<T, text_value_kind::floating>
+{   static size_t format(char* buffer, size_t size, const T& value, int precision)
+    {   if(size >= 64)
+        {   size_t n = format_text_fixed(buffer, static_cast<double>(value), precision) ;
+            if(n != 0)
+            {   return n ; }
+        }
+        return static_cast<size_t>(snprintf(buffer, size, "%.*f", precision, static_cast<double>(value))) ;
+    }
+} ;
+
+template<>
+inline size_t text_value_formatter<long double, text_value_kind::floating>::format(char* buffer,
+                                                                                 size_t size,
+                                                                                 const long double& value,
+                                                                                 int precision)
+{   return static_cast<size_t>(snprintf(buffer, size, "%.*Lf", precision, value)) ; }
+
+
+/*!
+ * \brief Writes the values of a matrix on a stream, the way
+ * the print() methods do. The values are written in the order
+ * they are stored, by lines of values :
+ * - 0 dimension : the values follow each other, without any
+ *   end of line (Matrix::print()).
+ * - 2 dimensions : one line per row (Matrix2D::print()).
+ * - 3 dimensions : one line per row, each 2D slice is preceded
+ *   by a ",,<z>" header (Matrix3D::print()).
+ * - 4 dimensions : the same and each 3D slice is preceded by a
+ *   ",,,<a>" header (Matrix4D::print()).
+ * Each value is followed by the separator, each line but the
+ * last one by an end of line.
+ */
+template<class T>
+class MatrixTextWriter
+{
+    public:
+        /*!
+         * \brief Prepares the writing of a matrix on a stream.
+         * The stream formatting (flags, precision, fill, locale)
+         * is the one of the stream when the writer is created.
+         * \param stream the stream.
+         * \param dim the dimensions of the matrix, as stored
+         * internally ({ncol, nrow, ...}).
+         * \param n_dim the dimensionality of the layout (0, 2,
+         * 3 or 4).
+         * \param width the minimum number of characters of each
+         * value.
+         * \param sep the character written after each value.
+         * \param chunk_size the approximate number of values to
+         * format per buffer.
+         */
+        MatrixTextWriter(std::ostream& stream,
+                         const std::vector<size_t>& dim,
+                         size_t n_dim,
+                         size_t width,
+                         char sep,
+                         size_t chunk_size=(1 << 16)) ;
+
+        /*!
+         * \brief Formats the values, chunk after chunk, and
+         * writes them on the stream. The stream is not flushed.
+         * \param data the address of the 1st value.
+         */
+        void write(const T* data) ;
+
+        /*!
+         * \brief Formats the values, several chunks at a time in
+         * parallel, and writes them on the stream, in order. The
+         * stream is not flushed.
+         * \param data the address of the 1st value.
+         * \param pool the threads to use.
+         */
+        void write(const T* data, ThreadPool& pool) ;
+
+    private:
+        /*!
+         * \brief Formats and writes the values, n_buffer chunks
+         * at a time.
+         * \param data the address of the 1st value.
+         * \param pool the threads to use, or nullptr.
+         * \param n_buffer the number of chunks formatted at once.
+         */
+        void write(const T* data, ThreadPool* pool, size_t n_buffer) ;
+
+        /*!
+         * \brief Formats the lines in [from,to) directly.
+         * \param buffer where to append the characters.
+         * \param data the address of the 1st value.
+         * \param from the index of the 1st line.
+         * \param to the index past the last line.
+         */
+        void format_lines(std::string& buffer, const T* data, size_t from, size_t to) const ;
+
+        /*!
+         * \brief Formats the lines in [from,to) through a stream
+         * with the formatting of the stream written to.
+         * \param buffer where to append the characters.
+         * \param data the address of the 1st value.
+         * \param from the index of the 1st line.
+         * \param to the index past the last line.
+         */
+        void format_lines_stream(std::string& buffer, const T* data, size_t from, size_t to) const ;
+
+        /*!
+         * \brief Appends a value, followed by the separator.
+         * \param buffer where to append the characters.
+         * \param value the value.
+         */
+        void append_value(std::string& buffer, const T& value) const ;
+
+        /*!
+         * \brief Appends a slice header followed by an end of
+         * line.
+         * \param buffer where to append the characters.
+         * \param prefix the commas of the header.
+         * \param index the index of the slice.
+         */
+        void append_header(std::string& buffer, const char* prefix, size_t index) const ;
+
+        /*!
+         * \brief The stream written to.
+         */
+        std::ostream& _stream ;
+        /*!
+         * \brief The matrix dimensions, as stored internally.
+         */
+        std::vector<size_t> _dim ;
+        /*!
+         * \brief The dimensionality of the layout.
+         */
+        size_t _n_dim ;
+        /*!
+         * \brief The number of lines and of values per line.
+         */
+        size_t _n_line ;
+        size_t _line_size ;
+        /*!
+         * \brief The number of lines per chunk.
+         */
+        size_t _chunk_line ;
+        /*!
+         * \brief The value format.
+         */
+        size_t _width ;
+        char _sep ;
+        char _fill ;
+        int _precision ;
+        /*!
+         * \brief The width of the stream before the writing,
+         * which applies to the 1st thing written.
+         */
+        std::streamsize _stream_width ;
+        /*!
+         * \brief Whether the values can be formatted directly or
+         * should go through a stream.
+         */
+        bool _direct ;
+} ;
+
+
+template<class T>
+MatrixTextWriter<T>::MatrixTextWriter(std::ostream& stream,
+                                      const std::vector<size_t>& dim,
+                                      size_t n_dim,
+                                      size_t width,
+                                      char sep,
+                                      size_t chunk_size)
+    : _stream(stream),
+      _dim(dim),
+      _n_dim(n_dim),
+      _width(width),
+      _sep(sep),
+      _fill(stream.fill()),
+      _precision(static_cast<int>(stream.precision())),
+      _stream_width(stream.width())
+{   size_t n_value = 1 ;
+    for(auto d : dim)
+    {   n_value *= d ; }
+    if(dim.empty())
+    {   n_value = 0 ; }
+    // every value is a line of its own, without end of line
+    if(n_dim == 0)
+    {   this->_line_size = 1 ; }
+    else
+    {   this->_line_size = dim[0] ; }
+    this->_n_line = (this->_line_size == 0) ? 0 : n_value / this->_line_size ;
+    this->_chunk_line = std::max(static_cast<size_t>(1), chunk_size / std::max(static_cast<size_t>(1), this->_line_size)) ;
+
+    // anything else than what print() sets goes through a stream
+    std::ios::fmtflags flags = stream.flags() ;
+    std::ios::fmtflags others = std::ios::showpos | std::ios::showpoint | std::ios::showbase |
+                                std::ios::uppercase | std::ios::boolalpha ;
+    this->_direct = text_value_kind_of<T>::value != text_value_kind::other and
+                    (flags & std::ios::adjustfield) == std::ios::left and
+                    (flags & std::ios::basefield) == std::ios::dec and
+                    (flags & std::ios::floatfield) == std::ios::fixed and
+                    (flags & others) == 0 and
+                    this->_stream_width == 0 and
+                    stream.getloc() == std::locale::classic() ;
+}
+
+template<class T>
+void MatrixTextWriter<T>::write(const T* data)
+{   this->write(data, nullptr, 1) ; }
+
+template<class T>
+void MatrixTextWriter<T>::write(const T* data, ThreadPool& pool)
+{   this->write(data, &pool, pool.get_thread_number()) ; }
+
+template<class T>
+void MatrixTextWriter<T>::write(const T* data, ThreadPool* pool, size_t n_buffer)
+{   // the buffers keep their capacity from one round to the next
+    std::vector<std::string> buffers(n_buffer) ;
+    size_t round_line = n_buffer * this->_chunk_line ;
+    for(size_t from=0; from<this->_n_line; from+=round_line)
+    {   size_t to = std::min(from + round_line, this->_n_line) ;
+        size_t n_chunk = (to - from + this->_chunk_line - 1) / this->_chunk_line ;
+        auto format_chunks = [&](size_t chunk_from, size_t chunk_to)
+                             {   for(size_t i=chunk_from; i<chunk_to; i++)
+                                 {   size_t line_from = from + i*this->_chunk_line ;
+                                     size_t line_to   = std::min(line_from + this->_chunk_line, to) ;
+                                     buffers[i].clear() ;
+                                     if(this->_direct)
+                                     {   this->format_lines(buffers[i], data, line_from, line_to) ; }
+                                     else
+                                     {   this->format_lines_stream(buffers[i], data, line_from, line_to) ; }
+                                 }
+                             } ;
+        if(pool == nullptr)
+        {   format_chunks(0, n_chunk) ; }
+        else
+        {   pool->parallel_for(0, n_chunk, format_chunks, n_chunk) ; }
+        for(size_t i=0; i<n_chunk; i++)
+        {   this->_stream.write(buffers[i].data(), buffers[i].size()) ; }
+    }
+    // the width only applied to the 1st thing written
+    if(this->_n_line != 0)
+    {   this->_stream.width(0) ; }
+}
+
+template<class T>
+void MatrixTextWriter<T>::format_lines(std::string& buffer, const T* data, size_t from, size_t to) const
+{   // snprintf() should not depend on the global locale
+    locale_t locale = uselocale(get_text_c_locale()) ;
+    buffer.reserve((to - from) * this->_line_size * (this->_width + 1)) ;
+    for(size_t line=from; line<to; line++)
+    {   if(this->_n_dim >= 3 and line % this->_dim[1] == 0)
+        {   if(this->_n_dim == 4 and line % (this->_dim[1]*this->_dim[2]) == 0)
+            {   this->append_header(buffer, ",,,", line / (this->_dim[1]*this->_dim[2])) ; }
+            this->append_header(buffer, ",,", (line / this->_dim[1]) % this->_dim[2]) ;
+        }
+        const T* value = data + line*this->_line_size ;
+        for(size_t i=0; i<this->_line_size; i++)
+        {   this->append_value(buffer, value[i]) ; }
+        if(this->_n_dim != 0 and line+1 < this->_n_line)
+        {   buffer.push_back('\n') ; }
+    }
+    uselocale(locale) ;
+}
+
+template<class T>
+void MatrixTextWriter<T>::format_lines_stream(std::string& buffer, const T* data, size_t from, size_t to) const
+{   std::ostringstream stream ;
+    stream.copyfmt(this->_stream) ;
+    stream.width(from == 0 ? this->_stream_width : 0) ;
+    for(size_t line=from; line<to; line++)
+    {   if(this->_n_dim >= 3 and line % this->_dim[1] == 0)
+        {   if(this->_n_dim == 4 and line % (this->_dim[1]*this->_dim[2]) == 0)
+            {   stream << ",,," << line / (this->_dim[1]*this->_dim[2]) << '\n' ; }
+            stream << ",," << (line / this->_dim[1]) % this->_dim[2] << '\n' ;
+        }
+        const T* value = data + line*this->_line_size ;
+        for(size_t i=0; i<this->_line_size; i++)
+        {   stream << std::setw(this->_width) << value[i] << this->_sep ; }
+        if(this->_n_dim != 0 and line+1 < this->_n_line)
+        {   stream << '\n' ; }
+    }
+    buffer += stream.str() ;
+}
+
+template<class T>
+void MatrixTextWriter<T>::append_value(std::string& buffer, const T& value) const
+{   char str[128] ;
+    size_t n = text_value_formatter<T>::format(str, sizeof(str), value, this->_precision) ;
+    if(n < sizeof(str))
+    {   buffer.append(str, n) ; }
+    // a huge value, in fixed notation
+    else
+    {   std::vector<char> str_long(n + 1) ;
+        text_value_formatter<T>::format(str_long.data(), str_long.size(), value, this->_precision) ;
+        buffer.append(str_long.data(), n) ;
+    }
+    // left aligned
+    if(n < this->_width)
+    {   buffer.append(this->_width - n, this->_fill) ; }
+    buffer.push_back(this->_sep) ;
+}
+
+template<class T>
+void MatrixTextWriter<T>::append_header(std::string& buffer, const char* prefix, size_t index) const
+{   char str[32] ;
+    size_t n = text_value_formatter<size_t>::format(str, sizeof(str), index, 0) ;
+    buffer += prefix ;
+    buffer.append(str, n) ;
+    buffer.push_back('\n') ;
+}
+
+#endif // MATRIXTEXTWRITER_HPP
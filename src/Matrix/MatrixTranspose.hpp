@@ -0,0 +1,262 @@
+#ifndef MATRIXTRANSPOSE_HPP
+#define MATRIXTRANSPOSE_HPP
+
+#include <vector>
+#include <algorithm>   // min(), copy()
+#include <type_traits> // is_arithmetic
+#include <utility>     // swap()
+
+#include "ThreadPool.hpp"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+/*!
+ * The transposition of matrices stored contiguously in row major order
+ * (which is how the Matrix2D class stores its data).
+ *
+ * A naive transposition reads (or writes) one of the matrices column by
+ * column, which makes nearly every access a cache and TLB miss on large
+ * matrices. Instead, the matrices are cut into square blocks small enough
+ * for a source block and a destination block to stay in the L1 cache, and
+ * each block is itself cut into tiles transposed within registers :
+ * - 8 x 8 tiles of 4 bytes values (float, int, ...) and 4 x 4 tiles of 8
+ *   bytes values (double, long, ...) are transposed with AVX shuffles when
+ *   the code is compiled for AVX2 or AVX-512.
+ * - other tiles are transposed by a scalar loop.
+ * The rows of blocks are distributed among the threads of a pool.
+ */
+
+
+/*!
+ * \brief Transposes a square tile of values, the generic
+ * version uses a scalar loop.
+ */
+template<class T, size_t bytes = (std::is_arithmetic<T>::value ? sizeof(T) : 0)>
+struct transpose_tile
+{   static const size_t size = 8 ;
+
+    /*!
+     * \brief Writes the transpose of the tile at src into
+     * the tile at dst.
+     * \param src the address of the 1st value of the source
+     * tile.
+     * \param lds the row length of the source matrix.
+     * \param dst the address of the 1st value of the
+     * destination tile.
+     * \param ldd the row length of the destination matrix.
+     */
+    static void run(const T* src, size_t lds, T* dst, size_t ldd)
+    {   for(size_t i=0; i<size; i++)
+        {   for(size_t j=0; j<size; j++)
+            {   dst[j*ldd + i] = src[i*lds + j] ; }
+        }
+    }
+} ;
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+/*!
+ * \brief Transposes a 8 x 8 tile of 4 bytes values in
+ * AVX registers.
+ */
+template<class T>
+struct transpose_tile<T, 4>
+{   static const size_t size = 8 ;
+
+    static void run(const T* src, size_t lds, T* dst, size_t ldd)
+    {   const float* s = reinterpret_cast<const float*>(src) ;
+        float* d = reinterpret_cast<float*>(dst) ;
+        __m256 r0 = _mm256_loadu_ps(s) ;
+        __m256 r1 = _mm256_loadu_ps(s +   lds) ;
+        __m256 r2 = _mm256_loadu_ps(s + 2*lds) ;
+        __m256 r3 = _mm256_loadu_ps(s + 3*lds) ;
+        __m256 r4 = _mm256_loadu_ps(s + 4*lds) ;
+        __m256 r5 = _mm256_loadu_ps(s + 5*lds) ;
+        __m256 r6 = _mm256_loadu_ps(s + 6*lds) ;
+        __m256 r7 = _mm256_loadu_ps(s + 7*lds) ;
+        // interleave pairs of rows
+        __m256 t0 = _mm256_unpacklo_ps(r0, r1) ;
+        __m256 t1 = _mm256_unpackhi_ps(r0, r1) ;
+        __m256 t2 = _mm256_unpacklo_ps(r2, r3) ;
+        __m256 t3 = _mm256_unpackhi_ps(r2, r3) ;
+        __m256 t4 = _mm256_unpacklo_ps(r4, r5) ;
+        __m256 t5 = _mm256_unpackhi_ps(r4, r5) ;
+        __m256 t6 = _mm256_unpacklo_ps(r6, r7) ;
+        __m256 t7 = _mm256_unpackhi_ps(r6, r7) ;
+        // 4 x 4 transposes within each 128 bits lane
+        r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1,0,1,0)) ;
+        r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3,2,3,2)) ;
+        r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1,0,1,0)) ;
+        r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3,2,3,2)) ;
+        r4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1,0,1,0)) ;
+        r5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3,2,3,2)) ;
+        r6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1,0,1,0)) ;
+        r7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3,2,3,2)) ;
+        // exchange the lanes
+        _mm256_storeu_ps(d,         _mm256_permute2f128_ps(r0, r4, 0x20)) ;
+        _mm256_storeu_ps(d +   ldd, _mm256_permute2f128_ps(r1, r5, 0x20)) ;
+        _mm256_storeu_ps(d + 2*ldd, _mm256_permute2f128_ps(r2, r6, 0x20)) ;
+        _mm256_storeu_ps(d + 3*ldd, _mm256_permute2f128_ps(r3, r7, 0x20)) ;
+        _mm256_storeu_ps(d + 4*ldd, _mm256_permute2f128_ps(r0, r4, 0x31)) ;
+        _mm256_storeu_ps(d + 5*ldd, _mm256_permute2f128_ps(r1, r5, 0x31)) ;
+        _mm256_storeu_ps(d + 6*ldd, _mm256_permute2f128_ps(r2, r6, 0x31)) ;
+        _mm256_storeu_ps(d + 7*ldd, _mm256_permute2f128_ps(r3, r7, 0x31)) ;
+    }
+} ;
+
+/*!
+ * \brief Transposes a 4 x 4 tile of 8 bytes values in
+ * AVX registers.
+ */
+template<class T>
+struct transpose_tile<T, 8>
+{   static const size_t size = 4 ;
+
+    static void run(const T* src, size_t lds, T* dst, size_t ldd)
+    {   const double* s = reinterpret_cast<const double*>(src) ;
+        double* d = reinterpret_cast<double*>(dst) ;
+        __m256d r0 = _mm256_loadu_pd(s) ;
+        __m256d r1 = _mm256_loadu_pd(s +   lds) ;
+        __m256d r2 = _mm256_loadu_pd(s + 2*lds) ;
+        __m256d r3 = _mm256_loadu_pd(s + 3*lds) ;
+        // interleave pairs of rows
+        __m256d t0 = _mm256_unpacklo_pd(r0, r1) ;
+        __m256d t1 = _mm256_unpackhi_pd(r0, r1) ;
+        __m256d t2 = _mm256_unpacklo_pd(r2, r3) ;
+        __m256d t3 = _mm256_unpackhi_pd(r2, r3) ;
+        // exchange the lanes
+        _mm256_storeu_pd(d,         _mm256_permute2f128_pd(t0, t2, 0x20)) ;
+        _mm256_storeu_pd(d +   ldd, _mm256_permute2f128_pd(t1, t3, 0x20)) ;
+        _mm256_storeu_pd(d + 2*ldd, _mm256_permute2f128_pd(t0, t2, 0x31)) ;
+        _mm256_storeu_pd(d + 3*ldd, _mm256_permute2f128_pd(t1, t3, 0x31)) ;
+    }
+} ;
+
+template<class T>
+const size_t transpose_tile<T, 4>::size ;
+template<class T>
+const size_t transpose_tile<T, 8>::size ;
+#endif
+
+template<class T, size_t bytes>
+const size_t transpose_tile<T, bytes>::size ;
+
+/*!
+ * \brief The blocking parameters. The block size is a multiple
+ * of all the tile sizes. Matrices smaller than the parallel
+ * threshold (in number of values) are transposed by the calling
+ * thread only.
+ */
+struct transpose_blocking
+{   static const size_t size = 64 ;
+    static const size_t parallel_min = 1 << 16 ;
+} ;
+
+/*!
+ * \brief Writes the transpose of a nrow x ncol block of a matrix
+ * into a ncol x nrow block of another matrix, tile by tile.
+ * \param nrow the number of rows of the source block.
+ * \param ncol the number of columns of the source block.
+ * \param src the address of the 1st value of the source block.
+ * \param lds the row length of the source matrix.
+ * \param dst the address of the 1st value of the destination
+ * block, the blocks should not overlap.
+ * \param ldd the row length of the destination matrix.
+ */
+template<class T>
+void transpose_block(size_t nrow, size_t ncol, const T* src, size_t lds, T* dst, size_t ldd)
+{   const size_t TS = transpose_tile<T>::size ;
+    size_t nrow_tiles = nrow - nrow % TS ;
+    size_t ncol_tiles = ncol - ncol % TS ;
+
+    for(size_t i=0; i<nrow_tiles; i+=TS)
+    {   for(size_t j=0; j<ncol_tiles; j+=TS)
+        {   transpose_tile<T>::run(src + i*lds + j, lds, dst + j*ldd + i, ldd) ; }
+    }
+    // the values which do not fill a whole tile
+    for(size_t i=0; i<nrow; i++)
+    {   for(size_t j=(i < nrow_tiles ? ncol_tiles : 0); j<ncol; j++)
+        {   dst[j*ldd + i] = src[i*lds + j] ; }
+    }
+}
+
+/*!
+ * \brief Writes the transpose of a nrow x ncol matrix into a
+ * ncol x nrow matrix, both stored contiguously in row major
+ * order. Each block is transposed into a buffer which is then
+ * copied row by row, because writing the tiles directly at
+ * their destination accesses rows distant from a power of 2
+ * (for common matrix sizes) which compete for the same cache
+ * sets.
+ * \param nrow the number of rows of the source matrix.
+ * \param ncol the number of columns of the source matrix.
+ * \param src the values of the source matrix.
+ * \param dst where to write the values of the transpose, it
+ * should not overlap with src.
+ * \param pool the threads to use.
+ */
+template<class T>
+void transpose_data(size_t nrow, size_t ncol, const T* src, T* dst, ThreadPool& pool)
+{   const size_t B = transpose_blocking::size ;
+    size_t n_block_rows = (nrow + B - 1)/B ;
+    size_t n_chunks = (nrow*ncol < transpose_blocking::parallel_min) ? 1 : 0 ;
+
+    pool.parallel_for(0, n_block_rows,
+                      [&](size_t from, size_t to)
+                      {   std::vector<T> buffer(B*B) ;
+                          for(size_t block=from; block<to; block++)
+                          {   size_t i  = block*B ;
+                              size_t mr = std::min(B, nrow - i) ;
+                              for(size_t j=0; j<ncol; j+=B)
+                              {   size_t nr = std::min(B, ncol - j) ;
+                                  transpose_block(mr, nr, src + i*ncol + j, ncol, buffer.data(), B) ;
+                                  T* dst_block = dst + j*nrow + i ;
+                                  for(size_t jj=0; jj<nr; jj++)
+                                  {   std::copy(buffer.data() + jj*B, buffer.data() + jj*B + mr, dst_block + jj*nrow) ; }
+                              }
+                          }
+                      },
+                      n_chunks) ;
+}
+
+/*!
+ * \brief Transposes in place a n x n matrix stored contiguously
+ * in row major order. The blocks above the diagonal are
+ * exchanged with their symmetric, through a buffer, while being
+ * transposed.
+ * \param n the number of rows and columns of the matrix.
+ * \param data the values of the matrix.
+ * \param pool the threads to use.
+ */
+template<class T>
+void transpose_square_in_place(size_t n, T* data, ThreadPool& pool)
+{   const size_t B = transpose_blocking::size ;
+    size_t n_block_rows = (n + B - 1)/B ;
+    // the rows of blocks have decreasing amounts of work, hence one chunk each
+    size_t n_chunks = (n*n < transpose_blocking::parallel_min) ? 1 : n_block_rows ;
+
+    pool.parallel_for(0, n_block_rows,
+                      [&](size_t from, size_t to)
+                      {   std::vector<T> buffer(B*B) ;
+                          for(size_t block=from; block<to; block++)
+                          {   size_t i  = block*B ;
+                              size_t mr = std::min(B, n - i) ;
+                              for(size_t j=i; j<n; j+=B)
+                              {   size_t nr = std::min(B, n - j) ;
+                                  T* upper = data + i*n + j ;
+                                  T* lower = data + j*n + i ;
+                                  // upper -> buffer, lower -> upper, buffer -> lower
+                                  transpose_block(mr, nr, upper, n, buffer.data(), B) ;
+                                  if(i != j)
+                                  {   transpose_block(nr, mr, lower, n, upper, n) ; }
+                                  for(size_t jj=0; jj<nr; jj++)
+                                  {   std::copy(buffer.data() + jj*B, buffer.data() + jj*B + mr, lower + jj*n) ; }
+                              }
+                          }
+                      },
+                      n_chunks) ;
+}
+
+#endif // MATRIXTRANSPOSE_HPP
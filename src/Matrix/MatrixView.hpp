@@ -0,0 +1,661 @@
+#ifndef MATRIXVIEW_HPP
+#define MATRIXVIEW_HPP
+
+#include <array>
+#include <vector>
+#include <iterator>    // forward_iterator_tag
+#include <cstddef>     // ptrdiff_t
+#include <type_traits> // remove_const, is_const
+#include <stdexcept>   // out_of_range, invalid_argument
+#include <cassert>     // assert()
+
+#include "MatrixKernels.hpp"
+
+
+/*!
+ * \brief The MatrixView class gives access to a part of the data of a
+ * matrix, without copying them. A view is made of the address of its
+ * 1st element, its dimensions and its strides (the distance, in number
+ * of elements, between two consecutive elements along each dimension).
+ * Rows, columns, sub-blocks and slices of matrices are thus described
+ * by views which are cheap to create and to copy.
+ *
+ * As for the matrices, the coordinates are given as (row, column, ...)
+ * and the elements are iterated in the order in which a matrix of the
+ * same dimensions would store them (along the columns first, then along
+ * the rows, then along the 3rd dimension, etc.).
+ *
+ * A view does not own the data, it is valid as long as the matrix it
+ * was created from exists and its dimensions are not modified. A view
+ * is a reference to the data : the constness of the view does not
+ * apply to the elements. A MatrixView<const T> only gives a read access
+ * to them.
+ *
+ * Views have at most max_dim dimensions.
+ */
+template<class T>
+class MatrixView
+{
+    public:
+        /*!
+         * \brief The type of the elements.
+         */
+        typedef typename std::remove_const<T>::type value_type ;
+
+        /*!
+         * \brief The maximum number of dimensions of a view.
+         */
+        static const size_t max_dim = 8 ;
+
+        /*!
+         * \brief Iterates over the elements of a view, in the
+         * storage order of a matrix of the same dimensions.
+         */
+        class iterator
+        {
+            public:
+                typedef std::forward_iterator_tag iterator_category ;
+                typedef typename MatrixView<T>::value_type value_type ;
+                typedef std::ptrdiff_t difference_type ;
+                typedef T* pointer ;
+                typedef T& reference ;
+
+                /*!
+                 * \brief Constructs an iterator on the given view.
+                 * \param view the view, which should outlive the
+                 * iterator.
+                 * \param index the index of the element pointed
+                 * to, either 0 or the number of elements (end).
+                 */
+                iterator(const MatrixView<T>* view, size_t index) ;
+
+                T& operator * () const ;
+                T* operator -> () const ;
+                iterator& operator ++ () ;
+                iterator operator ++ (int) ;
+                bool operator == (const iterator& other) const ;
+                bool operator != (const iterator& other) const ;
+
+            private:
+                /*!
+                 * \brief The view iterated.
+                 */
+                const MatrixView<T>* _view ;
+                /*!
+                 * \brief The address of the current element.
+                 */
+                T* _ptr ;
+                /*!
+                 * \brief The index of the current element, in
+                 * iteration order.
+                 */
+                size_t _index ;
+                /*!
+                 * \brief The coordinates of the current element.
+                 */
+                std::array<size_t,max_dim> _coord ;
+        } ;
+
+        // constructors
+        /*!
+         * \brief Default constructor, constructs an empty view.
+         */
+        MatrixView() = default ;
+
+        /*!
+         * \brief Constructs a view.
+         * \param data the address of the 1st element.
+         * \param dim the dimensions, as (row, column, ...).
+         * \param strides the strides, as (row, column, ...).
+         * \throw std::invalid_argument if the dimensions and the
+         * strides do not have the same length or if the view would
+         * have more than max_dim dimensions.
+         */
+        MatrixView(T* data, const std::vector<size_t>& dim, const std::vector<size_t>& strides) ;
+
+        /*!
+         * \brief Constructs a read-only view from a read-write
+         * view.
+         * \param other the view of interest.
+         */
+        template<class U, class = typename std::enable_if<std::is_same<const U, T>::value>::type>
+        MatrixView(const MatrixView<U>& other) ;
+
+        // methods
+        /*!
+         * \brief Gets the number of dimensions.
+         * \return the number of dimensions.
+         */
+        size_t get_dim_size() const ;
+
+        /*!
+         * \brief Gets the dimensions.
+         * \return the dimensions, as (row, column, ...).
+         */
+        std::vector<size_t> get_dim() const ;
+
+        /*!
+         * \brief Gets the strides.
+         * \return the strides, as (row, column, ...).
+         */
+        std::vector<size_t> get_strides() const ;
+
+        /*!
+         * \brief Gets the number of elements in the view.
+         * \return the number of elements.
+         */
+        size_t get_data_size() const ;
+
+        /*!
+         * \brief Gets the address of the 1st element.
+         * \return the address of the 1st element.
+         */
+        T* get_data_ptr() const ;
+
+        /*!
+         * \brief Checks whether the elements are stored
+         * contiguously, in iteration order.
+         * \return whether the elements are contiguous.
+         */
+        bool is_contiguous() const ;
+
+        /*!
+         * \brief Gets the element at the given coordinates.
+         * \param coord the coordinates, as (row, column, ...).
+         * \throw std::out_of_range if the coordinates are out
+         * of range.
+         * \return the element.
+         */
+        value_type get(const std::vector<size_t>& coord) const ;
+
+        /*!
+         * \brief Sets the element at the given coordinates.
+         * \param coord the coordinates, as (row, column, ...).
+         * \param value the new value.
+         * \throw std::out_of_range if the coordinates are out
+         * of range.
+         */
+        void set(const std::vector<size_t>& coord, value_type value) const ;
+
+        /*!
+         * \brief Creates a view on a slice of the view, that is
+         * with one dimension less.
+         * \param dim the dimension along which to slice, the
+         * slice keeps all the other dimensions (0 for a row, 1
+         * for a column, etc).
+         * \param index the index of the slice along this dimension.
+         * \throw std::out_of_range if the dimension or the index
+         * is out of range.
+         * \return a view on the slice.
+         */
+        MatrixView slice(size_t dim, size_t index) const ;
+
+        /*!
+         * \brief Creates a view on a sub-block of the view.
+         * \param from the coordinates of the 1st element of the
+         * sub-block, as (row, column, ...).
+         * \param dim the dimensions of the sub-block.
+         * \throw std::invalid_argument if the number of coordinates
+         * or of dimensions is wrong, std::out_of_range if the block
+         * does not fit within the view.
+         * \return a view on the sub-block.
+         */
+        MatrixView block(const std::vector<size_t>& from, const std::vector<size_t>& dim) const ;
+
+        /*!
+         * \brief Copies the elements of the view in a vector, in
+         * iteration order.
+         * \return the elements.
+         */
+        std::vector<value_type> to_vector() const ;
+
+        /*!
+         * \brief Sets all the elements to the given value.
+         * \param value the value.
+         * \return a reference to the instance.
+         */
+        MatrixView& fill(value_type value) ;
+
+        /*!
+         * \brief Copies the elements of an other view into the
+         * elements of this view.
+         * \param other a view with the same dimensions, which
+         * does not overlap with this view.
+         * \throw std::invalid_argument if the dimensions differ.
+         * \return a reference to the instance.
+         */
+        MatrixView& assign(const MatrixView<const value_type>& other) ;
+
+        /*!
+         * \brief Returns an iterator to the 1st element.
+         * \return an iterator to the 1st element.
+         */
+        iterator begin() const ;
+
+        /*!
+         * \brief Returns an iterator past the last element.
+         * \return an iterator past the last element.
+         */
+        iterator end() const ;
+
+        // operators
+        /*!
+         * \brief Returns a reference to the element at the given
+         * coordinates, as (row, column, ...). This method does not
+         * perform any check on the coordinates, only their number
+         * is asserted in the debug builds.
+         * \param coord as many coordinates as the view has dimensions.
+         * \return a reference to this element.
+         */
+        template<class... Idx>
+        T& operator () (Idx... coord) const ;
+
+        /*!
+         * \brief Adds value to each element.
+         * \param value the value to add.
+         * \return a reference to the instance.
+         */
+        MatrixView& operator += (value_type value) ;
+
+        /*!
+         * \brief Substracts value to each element.
+         * \param value the value to substract.
+         * \return a reference to the instance.
+         */
+        MatrixView& operator -= (value_type value) ;
+
+        /*!
+         * \brief Multiplies each element by value.
+         * \param value the value to multiply the elements by.
+         * \return a reference to the instance.
+         */
+        MatrixView& operator *= (value_type value) ;
+
+        /*!
+         * \brief Divides each element by value.
+         * \param value the value to divide the elements by.
+         * \throw std::invalid_argument if value is 0.
+         * \return a reference to the instance.
+         */
+        MatrixView& operator /= (value_type value) ;
+
+        /*!
+         * \brief Comparison operator, returns true if both
+         * views have the same dimensions and elements.
+         * \param other an other view.
+         * \return whether the views have the same dimensions
+         * and elements.
+         */
+        bool operator == (const MatrixView<const value_type>& other) const ;
+
+        /*!
+         * \brief Comparison operator, returns true if the
+         * views have different dimensions or elements.
+         * \param other an other view.
+         * \return whether the views are different.
+         */
+        bool operator != (const MatrixView<const value_type>& other) const ;
+
+    private:
+        template<class U>
+        friend class MatrixView ;
+
+        // methods
+        /*!
+         * \brief Gives the dimension which is at the given
+         * position in the iteration order.
+         * \param i the position, the 1st one being the fastest
+         * varying dimension.
+         * \return the dimension.
+         */
+        size_t iteration_dim(size_t i) const ;
+
+        /*!
+         * \brief Calls f(address, length, stride) on each line
+         * of elements along the fastest varying dimension.
+         * \param f the function to call.
+         */
+        template<class F>
+        void for_each_line(F f) const ;
+
+        /*!
+         * \brief Applies an element-wise operation between the
+         * elements and a value, using the kernels on contiguous
+         * lines.
+         * \param value the value.
+         */
+        template<class Op>
+        void apply_value(value_type value) ;
+
+        // fields
+        /*!
+         * \brief The address of the 1st element.
+         */
+        T* _data = nullptr ;
+        /*!
+         * \brief The number of dimensions.
+         */
+        size_t _dim_size = 0 ;
+        /*!
+         * \brief The number of elements.
+         */
+        size_t _data_size = 0 ;
+        /*!
+         * \brief The dimensions, as (row, column, ...).
+         */
+        std::array<size_t,max_dim> _dim = {} ;
+        /*!
+         * \brief The strides, as (row, column, ...).
+         */
+        std::array<size_t,max_dim> _strides = {} ;
+} ;
+
+
+// method implementation
+template<class T>
+const size_t MatrixView<T>::max_dim ;
+
+template<class T>
+MatrixView<T>::MatrixView(T* data, const std::vector<size_t>& dim, const std::vector<size_t>& strides)
+    : _data(data), _dim_size(dim.size()), _data_size(dim.size() == 0 ? 0 : 1)
+{   if(dim.size() != strides.size())
+    {   throw std::invalid_argument("the dimensions and the strides do not have the same length!") ; }
+    if(dim.size() > max_dim)
+    {   throw std::invalid_argument("a view cannot have so many dimensions!") ; }
+    for(size_t i=0; i<this->_dim_size; i++)
+    {   this->_dim[i]      = dim[i] ;
+        this->_strides[i]  = strides[i] ;
+        this->_data_size  *= dim[i] ;
+    }
+}
+
+template<class T>
+template<class U, class>
+MatrixView<T>::MatrixView(const MatrixView<U>& other)
+    : _data(other._data),
+      _dim_size(other._dim_size),
+      _data_size(other._data_size),
+      _dim(other._dim),
+      _strides(other._strides)
+{}
+
+template<class T>
+size_t MatrixView<T>::get_dim_size() const
+{   return this->_dim_size ; }
+
+template<class T>
+std::vector<size_t> MatrixView<T>::get_dim() const
+{   return std::vector<size_t>(this->_dim.begin(), this->_dim.begin() + this->_dim_size) ; }
+
+template<class T>
+std::vector<size_t> MatrixView<T>::get_strides() const
+{   return std::vector<size_t>(this->_strides.begin(), this->_strides.begin() + this->_dim_size) ; }
+
+template<class T>
+size_t MatrixView<T>::get_data_size() const
+{   return this->_data_size ; }
+
+template<class T>
+T* MatrixView<T>::get_data_ptr() const
+{   return this->_data ; }
+
+template<class T>
+bool MatrixView<T>::is_contiguous() const
+{   size_t stride = 1 ;
+    for(size_t i=0; i<this->_dim_size; i++)
+    {   size_t d = this->iteration_dim(i) ;
+        if(this->_dim[d] > 1 and this->_strides[d] != stride)
+        {   return false ; }
+        stride *= this->_dim[d] ;
+    }
+    return true ;
+}
+
+template<class T>
+typename MatrixView<T>::value_type MatrixView<T>::get(const std::vector<size_t>& coord) const
+{   if(coord.size() != this->_dim_size)
+    {   throw std::out_of_range("coordinates are out of range!") ; }
+    size_t offset = 0 ;
+    for(size_t i=0; i<this->_dim_size; i++)
+    {   if(coord[i] >= this->_dim[i])
+        {   throw std::out_of_range("coordinates are out of range!") ; }
+        offset += coord[i] * this->_strides[i] ;
+    }
+    return this->_data[offset] ;
+}
+
+template<class T>
+void MatrixView<T>::set(const std::vector<size_t>& coord, value_type value) const
+{   static_assert(not std::is_const<T>::value, "cannot modify the elements of a read-only view") ;
+    if(coord.size() != this->_dim_size)
+    {   throw std::out_of_range("coordinates are out of range!") ; }
+    size_t offset = 0 ;
+    for(size_t i=0; i<this->_dim_size; i++)
+    {   if(coord[i] >= this->_dim[i])
+        {   throw std::out_of_range("coordinates are out of range!") ; }
+        offset += coord[i] * this->_strides[i] ;
+    }
+    this->_data[offset] = value ;
+}
+
+template<class T>
+MatrixView<T> MatrixView<T>::slice(size_t dim, size_t index) const
+{   if(dim >= this->_dim_size or index >= this->_dim[dim])
+    {   throw std::out_of_range("slice is out of range!") ; }
+    MatrixView<T> view(*this) ;
+    view._data += index * this->_strides[dim] ;
+    view._dim_size -= 1 ;
+    view._data_size = (view._dim_size == 0) ? 0 : this->_data_size / this->_dim[dim] ;
+    for(size_t i=dim; i<view._dim_size; i++)
+    {   view._dim[i]     = this->_dim[i+1] ;
+        view._strides[i] = this->_strides[i+1] ;
+    }
+    view._dim[view._dim_size]     = 0 ;
+    view._strides[view._dim_size] = 0 ;
+    return view ;
+}
+
+template<class T>
+MatrixView<T> MatrixView<T>::block(const std::vector<size_t>& from, const std::vector<size_t>& dim) const
+{   if(from.size() != this->_dim_size or dim.size() != this->_dim_size)
+    {   throw std::invalid_argument("the block does not have the same number of dimensions as the view!") ; }
+    MatrixView<T> view(*this) ;
+    view._data_size = 1 ;
+    for(size_t i=0; i<this->_dim_size; i++)
+    {   if(from[i] + dim[i] > this->_dim[i])
+        {   throw std::out_of_range("block is out of range!") ; }
+        // an empty block may start at the end of a dimension
+        if(dim[i] > 0)
+        {   view._data += from[i] * this->_strides[i] ; }
+        view._dim[i]     = dim[i] ;
+        view._data_size *= dim[i] ;
+    }
+    return view ;
+}
+
+template<class T>
+std::vector<typename MatrixView<T>::value_type> MatrixView<T>::to_vector() const
+{   std::vector<value_type> values ;
+    values.reserve(this->_data_size) ;
+    for(const auto& value : *this)
+    {   values.push_back(value) ; }
+    return values ;
+}
+
+template<class T>
+MatrixView<T>& MatrixView<T>::fill(value_type value)
+{   static_assert(not std::is_const<T>::value, "cannot modify the elements of a read-only view") ;
+    this->for_each_line([value](T* p, size_t n, size_t stride)
+                        {   for(size_t i=0; i<n; i++, p+=stride)
+                            {   *p = value ; }
+                        }) ;
+    return *this ;
+}
+
+template<class T>
+MatrixView<T>& MatrixView<T>::assign(const MatrixView<const value_type>& other)
+{   static_assert(not std::is_const<T>::value, "cannot modify the elements of a read-only view") ;
+    if(this->get_dim() != other.get_dim())
+    {   throw std::invalid_argument("views have different dimensions!") ; }
+    auto it = other.begin() ;
+    for(auto& value : *this)
+    {   value = *it ;
+        ++it ;
+    }
+    return *this ;
+}
+
+template<class T>
+typename MatrixView<T>::iterator MatrixView<T>::begin() const
+{   return iterator(this, 0) ; }
+
+template<class T>
+typename MatrixView<T>::iterator MatrixView<T>::end() const
+{   return iterator(this, this->_data_size) ; }
+
+template<class T>
+template<class... Idx>
+T& MatrixView<T>::operator () (Idx... coord) const
+{   static_assert(sizeof...(Idx) > 0 and sizeof...(Idx) <= max_dim, "wrong number of coordinates") ;
+    assert(sizeof...(Idx) == this->_dim_size and "the number of coordinates should be equal to the number of dimensions") ;
+    const size_t coord_array[] = {static_cast<size_t>(coord)...} ;
+    size_t offset = 0 ;
+    for(size_t i=0; i<sizeof...(Idx); i++)
+    {   offset += coord_array[i] * this->_strides[i] ; }
+    return this->_data[offset] ;
+}
+
+template<class T>
+MatrixView<T>& MatrixView<T>::operator += (value_type value)
+{   this->template apply_value<kernel_add>(value) ;
+    return *this ;
+}
+
+template<class T>
+MatrixView<T>& MatrixView<T>::operator -= (value_type value)
+{   this->template apply_value<kernel_sub>(value) ;
+    return *this ;
+}
+
+template<class T>
+MatrixView<T>& MatrixView<T>::operator *= (value_type value)
+{   this->template apply_value<kernel_mul>(value) ;
+    return *this ;
+}
+
+template<class T>
+MatrixView<T>& MatrixView<T>::operator /= (value_type value)
+{   if(value == static_cast<value_type>(0))
+    {   throw std::invalid_argument("division by 0!") ; }
+    this->template apply_value<kernel_div>(value) ;
+    return *this ;
+}
+
+template<class T>
+bool MatrixView<T>::operator == (const MatrixView<const value_type>& other) const
+{   if(this->get_dim() != other.get_dim())
+    {   return false ; }
+    auto it = other.begin() ;
+    for(const auto& value : *this)
+    {   if(value != *it)
+        {   return false ; }
+        ++it ;
+    }
+    return true ;
+}
+
+template<class T>
+bool MatrixView<T>::operator != (const MatrixView<const value_type>& other) const
+{   return not ((*this) == other) ; }
+
+template<class T>
+size_t MatrixView<T>::iteration_dim(size_t i) const
+{   // columns first, then rows
+    if(this->_dim_size > 1 and i < 2)
+    {   return 1 - i ; }
+    return i ;
+}
+
+template<class T>
+template<class F>
+void MatrixView<T>::for_each_line(F f) const
+{   if(this->_data_size == 0)
+    {   return ; }
+    size_t d0     = this->iteration_dim(0) ;
+    size_t length = this->_dim[d0] ;
+    size_t stride = this->_strides[d0] ;
+    size_t n_line = this->_data_size / length ;
+    std::array<size_t,max_dim> coord = {} ;
+    T* line = this->_data ;
+    for(size_t n=0; n<n_line; n++)
+    {   f(line, length, stride) ;
+        // next line
+        for(size_t i=1; i<this->_dim_size; i++)
+        {   size_t d = this->iteration_dim(i) ;
+            line += this->_strides[d] ;
+            if(++coord[d] < this->_dim[d])
+            {   break ; }
+            line -= this->_strides[d] * this->_dim[d] ;
+            coord[d] = 0 ;
+        }
+    }
+}
+
+template<class T>
+template<class Op>
+void MatrixView<T>::apply_value(value_type value)
+{   static_assert(not std::is_const<T>::value, "cannot modify the elements of a read-only view") ;
+    this->for_each_line([value](T* p, size_t n, size_t stride)
+                        {   if(stride == 1)
+                            {   elementwise_kernel<Op, value_type>::run(p, value, p, n) ; }
+                            else
+                            {   for(size_t i=0; i<n; i++, p+=stride)
+                                {   *p = Op::apply(*p, value) ; }
+                            }
+                        }) ;
+}
+
+
+template<class T>
+MatrixView<T>::iterator::iterator(const MatrixView<T>* view, size_t index)
+    : _view(view), _ptr(view->_data), _index(index), _coord()
+{}
+
+template<class T>
+T& MatrixView<T>::iterator::operator * () const
+{   return *(this->_ptr) ; }
+
+template<class T>
+T* MatrixView<T>::iterator::operator -> () const
+{   return this->_ptr ; }
+
+template<class T>
+typename MatrixView<T>::iterator& MatrixView<T>::iterator::operator ++ ()
+{   this->_index++ ;
+    for(size_t i=0; i<this->_view->_dim_size; i++)
+    {   size_t d = this->_view->iteration_dim(i) ;
+        this->_ptr += this->_view->_strides[d] ;
+        if(++this->_coord[d] < this->_view->_dim[d])
+        {   break ; }
+        this->_ptr -= this->_view->_strides[d] * this->_view->_dim[d] ;
+        this->_coord[d] = 0 ;
+    }
+    return *this ;
+}
+
+template<class T>
+typename MatrixView<T>::iterator MatrixView<T>::iterator::operator ++ (int)
+{   iterator it(*this) ;
+    ++(*this) ;
+    return it ;
+}
+
+template<class T>
+bool MatrixView<T>::iterator::operator == (const iterator& other) const
+{   return this->_index == other._index ; }
+
+template<class T>
+bool MatrixView<T>::iterator::operator != (const iterator& other) const
+{   return this->_index != other._index ; }
+
+#endif // MATRIXVIEW_HPP
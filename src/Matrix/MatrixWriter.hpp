@@ -0,0 +1,414 @@
+#ifndef MATRIXWRITER_HPP
+#define MATRIXWRITER_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>      // ofstream
+#include <algorithm>    // max()
+#include <utility>      // swap()
+#include <iomanip>      // setprecision(), fixed
+#include <stdexcept>    // runtime_error, invalid_argument
+#include <cstdio>       // sprintf()
+#include <cstdint>
+
+#include "Matrix2D.hpp"
+#include "Matrix3D.hpp"
+#include "MatrixBinaryFormat.hpp"
+#include "MatrixTextWriter.hpp"
+
+
+/*!
+ * The matrix writers write the files of the Matrix3D and Matrix4D
+ * classes one slice at a time, so that a matrix produced slice after
+ * slice does not need to be held in memory : a Matrix3DWriter takes
+ * the 2D slices of a Matrix3D as Matrix2D and a Matrix4DWriter the 3D
+ * slices of a Matrix4D as Matrix3D. The slices are appended to the
+ * file, through a buffer, and the file is completed by close() :
+ * - text format : the file is the one written by print() (and read
+ *   by the constructors) for the whole matrix, each slice is
+ *   preceded by its ",,<z>" (",,,<a>") header.
+ * - binary format : the file is the one written by save() (see
+ *   MatrixBinaryFormat.hpp), its header, which contains the
+ *   dimensions, is written again once the number of slices is
+ *   known.
+ * All the slices must have the same dimensions.
+ */
+
+
+/*!
+ * \brief The formats of the files written.
+ */
+enum class MatrixWriterFormat
+{   text,
+    binary
+} ;
+
+
+/*!
+ * \brief Writes the slices of a matrix, one after the other, in
+ * a file.
+ */
+template<class T>
+class MatrixWriter
+{
+    public:
+        MatrixWriter(const MatrixWriter& other) = delete ;
+
+        MatrixWriter& operator = (const MatrixWriter& other) = delete ;
+
+        /*!
+         * \brief Destructor, closes the file, ignoring the
+         * errors. close() should be called to know whether
+         * the file was written.
+         */
+        virtual ~MatrixWriter() ;
+
+        /*!
+         * \brief Writes what remains in the buffer and, for
+         * the binary format, the header with the final
+         * dimensions, and closes the file. Does nothing if
+         * the file is already closed.
+         * \throw std::runtime_error if anything happens while
+         * writing the file.
+         */
+        void close() ;
+
+        /*!
+         * \brief Gets the number of slices written.
+         * \return the number of slices.
+         */
+        size_t get_slice_number() const ;
+
+    protected:
+        /*!
+         * \brief Opens a file.
+         * \param file_address the path to the file.
+         * \param n_dim the number of dimensions of the matrix,
+         * 3 or 4.
+         * \param format the format of the file.
+         * \param precision the number of decimals of the values,
+         * in the text format.
+         * \param width the minimum number of characters of each
+         * value, in the text format.
+         * \param sep the character written after each value, in
+         * the text format.
+         * \param checksum whether to store a checksum of the
+         * values, in the binary format.
+         * \param buffer_size the size of the buffer, in bytes.
+         * \throw std::runtime_error if the file cannot be opened.
+         */
+        MatrixWriter(const std::string& file_address,
+                     size_t n_dim,
+                     MatrixWriterFormat format,
+                     size_t precision,
+                     size_t width,
+                     char sep,
+                     bool checksum,
+                     size_t buffer_size) ;
+
+        /*!
+         * \brief Appends a slice to the file.
+         * \param dim the dimensions of the slice, as stored
+         * internally ({ncol, nrow, ...}).
+         * \param data the address of the 1st value of the slice.
+         * \throw std::invalid_argument if the slice is empty or
+         * does not have the dimensions of the previous ones.
+         * \throw std::runtime_error if the file is closed or if
+         * anything happens while writing it.
+         */
+        void write_values(const std::vector<size_t>& dim, const T* data) ;
+
+    private:
+        /*!
+         * \brief Throws an exception if the file is not in a
+         * good state.
+         * \param what what was written.
+         * \throw std::runtime_error if the file is not in a good
+         * state.
+         */
+        void check_file(const char* what) ;
+
+        /*!
+         * \brief The path to the file.
+         */
+        std::string _file_address ;
+        /*!
+         * \brief The buffer of the file stream, and the stream.
+         */
+        std::vector<char> _buffer ;
+        std::ofstream _file ;
+        /*!
+         * \brief The number of dimensions of the matrix.
+         */
+        size_t _n_dim ;
+        /*!
+         * \brief The format of the file and the format of the
+         * values.
+         */
+        MatrixWriterFormat _format ;
+        size_t _width ;
+        char _sep ;
+        /*!
+         * \brief The binary header, completed on close.
+         */
+        MatrixBinaryHeader _header ;
+        /*!
+         * \brief The dimensions of the slices, as stored
+         * internally, and the number of slices written.
+         */
+        std::vector<size_t> _slice_dim ;
+        size_t _n_slice = 0 ;
+} ;
+
+
+/*!
+ * \brief Writes a Matrix3D file, one 2D slice at a time.
+ */
+template<class T>
+class Matrix3DWriter : public MatrixWriter<T>
+{
+    public:
+        /*!
+         * \brief Opens a file.
+         * \param file_address the path to the file.
+         * \param format the format of the file.
+         * \param precision the number of decimals of the values,
+         * in the text format (see print()).
+         * \param width the minimum number of characters of each
+         * value, in the text format.
+         * \param sep the character written after each value, in
+         * the text format.
+         * \param checksum whether to store a checksum of the
+         * values, in the binary format (see save()).
+         * \param buffer_size the size of the buffer, in bytes.
+         * \throw std::runtime_error if the file cannot be opened.
+         */
+        Matrix3DWriter(const std::string& file_address,
+                       MatrixWriterFormat format = MatrixWriterFormat::text,
+                       size_t precision = 4,
+                       size_t width = 8,
+                       char sep = ' ',
+                       bool checksum = false,
+                       size_t buffer_size = 1 << 22) ;
+
+        /*!
+         * \brief Appends a 2D slice, the next one along the 3rd
+         * dimension.
+         * \param slice the slice.
+         * \throw std::invalid_argument if the slice is empty or
+         * does not have the dimensions of the previous ones.
+         * \throw std::runtime_error if the file is closed or if
+         * anything happens while writing it.
+         */
+        void write_slice(const Matrix2D<T>& slice) ;
+} ;
+
+
+/*!
+ * \brief Writes a Matrix4D file, one 3D slice at a time.
+ */
+template<class T>
+class Matrix4DWriter : public MatrixWriter<T>
+{
+    public:
+        /*!
+         * \brief Opens a file.
+         * \param file_address the path to the file.
+         * \param format the format of the file.
+         * \param precision the number of decimals of the values,
+         * in the text format (see print()).
+         * \param width the minimum number of characters of each
+         * value, in the text format.
+         * \param sep the character written after each value, in
+         * the text format.
+         * \param checksum whether to store a checksum of the
+         * values, in the binary format (see save()).
+         * \param buffer_size the size of the buffer, in bytes.
+         * \throw std::runtime_error if the file cannot be opened.
+         */
+        Matrix4DWriter(const std::string& file_address,
+                       MatrixWriterFormat format = MatrixWriterFormat::text,
+                       size_t precision = 4,
+                       size_t width = 8,
+                       char sep = ' ',
+                       bool checksum = false,
+                       size_t buffer_size = 1 << 22) ;
+
+        /*!
+         * \brief Appends a 3D slice, the next one along the 4th
+         * dimension.
+         * \param slice the slice.
+         * \throw std::invalid_argument if the slice is empty or
+         * does not have the dimensions of the previous ones.
+         * \throw std::runtime_error if the file is closed or if
+         * anything happens while writing it.
+         */
+        void write_slice(const Matrix3D<T>& slice) ;
+} ;
+
+
+template<class T>
+MatrixWriter<T>::MatrixWriter(const std::string& file_address,
+                              size_t n_dim,
+                              MatrixWriterFormat format,
+                              size_t precision,
+                              size_t width,
+                              char sep,
+                              bool checksum,
+                              size_t buffer_size)
+    : _file_address(file_address),
+      _buffer(std::max(buffer_size, static_cast<size_t>(1))),
+      _n_dim(n_dim),
+      _format(format),
+      _width(width),
+      _sep(sep)
+{   // the buffer must be set before opening
+    this->_file.rdbuf()->pubsetbuf(this->_buffer.data(), this->_buffer.size()) ;
+    this->_file.open(file_address, std::ofstream::out | std::ofstream::binary) ;
+    if(this->_file.fail())
+    {   char msg[4096] ;
+        sprintf(msg, "error! cannot open %s", file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+
+    if(format == MatrixWriterFormat::text)
+    {   this->_file.setf(std::ios::left) ;
+        this->_file << std::setprecision(precision) << std::fixed ;
+    }
+    // the header has the size of the final one, the dimensions
+    // being null until the file is closed
+    else
+    {   this->_header = make_matrix_binary_header<T>(std::vector<size_t>(n_dim, 0)) ;
+        this->_header.has_crc = checksum ;
+        std::vector<char> header_bytes = encode_matrix_binary_header(this->_header) ;
+        this->_file.write(header_bytes.data(), header_bytes.size()) ;
+        this->check_file("dimensions") ;
+    }
+}
+
+template<class T>
+MatrixWriter<T>::~MatrixWriter()
+{   try
+    {   this->close() ; }
+    catch(std::exception&)
+    {}
+}
+
+template<class T>
+void MatrixWriter<T>::close()
+{   if(not this->_file.is_open())
+    {   return ; }
+
+    if(this->_format == MatrixWriterFormat::binary)
+    {   std::vector<size_t> dim = this->_slice_dim ;
+        if(dim.empty())
+        {   dim.assign(this->_n_dim - 1, 0) ; }
+        dim.push_back(this->_n_slice) ;
+        this->_header.dim       = dim ;
+        this->_header.data_size = this->_header.get_value_number() * sizeof(T) ;
+        std::vector<char> header_bytes = encode_matrix_binary_header(this->_header) ;
+        this->_file.seekp(0) ;
+        this->_file.write(header_bytes.data(), header_bytes.size()) ;
+    }
+    this->_file.close() ;
+    if(this->_file.fail())
+    {   char msg[4096] ;
+        sprintf(msg, "Error! something happened while writting data to %s",
+                this->_file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+template<class T>
+size_t MatrixWriter<T>::get_slice_number() const
+{   return this->_n_slice ; }
+
+template<class T>
+void MatrixWriter<T>::write_values(const std::vector<size_t>& dim, const T* data)
+{   if(not this->_file.is_open())
+    {   char msg[4096] ;
+        sprintf(msg, "Error! %s is closed", this->_file_address.c_str()) ;
+        throw std::runtime_error(msg) ;
+    }
+    size_t n_value = 1 ;
+    for(auto d : dim)
+    {   n_value *= d ; }
+    if(dim.empty() or n_value == 0)
+    {   throw std::invalid_argument("Error! the slice is empty") ; }
+    if(this->_n_slice == 0)
+    {   this->_slice_dim = dim ; }
+    else if(dim != this->_slice_dim)
+    {   throw std::invalid_argument("Error! the slice does not have the dimensions of the previous ones") ; }
+
+    if(this->_format == MatrixWriterFormat::text)
+    {   // the end of the last line of the previous slice and
+        // the header of the slice
+        if(this->_n_slice != 0)
+        {   this->_file << '\n' ; }
+        this->_file << std::string(this->_n_dim - 1, ',') << this->_n_slice << '\n' ;
+        MatrixTextWriter<T>(this->_file, dim, this->_n_dim - 1, this->_width, this->_sep).write(data) ;
+    }
+    else
+    {   const char* bytes = reinterpret_cast<const char*>(data) ;
+        if(this->_header.has_crc)
+        {   this->_header.crc = crc32c(bytes, n_value*sizeof(T), this->_header.crc) ; }
+        this->_file.write(bytes, n_value*sizeof(T)) ;
+    }
+    this->check_file("data") ;
+    this->_n_slice++ ;
+}
+
+template<class T>
+void MatrixWriter<T>::check_file(const char* what)
+{   if(not this->_file)
+    {   char msg[4096] ;
+        sprintf(msg, "Error! something happened while writting %s to %s",
+                what, this->_file_address.c_str()) ;
+        this->_file.close() ;
+        throw std::runtime_error(msg) ;
+    }
+}
+
+
+template<class T>
+Matrix3DWriter<T>::Matrix3DWriter(const std::string& file_address,
+                                  MatrixWriterFormat format,
+                                  size_t precision,
+                                  size_t width,
+                                  char sep,
+                                  bool checksum,
+                                  size_t buffer_size)
+    : MatrixWriter<T>(file_address, 3, format, precision, width, sep, checksum, buffer_size)
+{}
+
+template<class T>
+void Matrix3DWriter<T>::write_slice(const Matrix2D<T>& slice)
+{   std::vector<size_t> dim = slice.get_dim() ;
+    if(dim.size() > 1)
+    {   std::swap(dim[0], dim[1]) ; }
+    // an empty matrix has no data
+    this->write_values(dim, slice.get_data_size() == 0 ? nullptr : slice.get_data_ptr()) ;
+}
+
+
+template<class T>
+Matrix4DWriter<T>::Matrix4DWriter(const std::string& file_address,
+                                  MatrixWriterFormat format,
+                                  size_t precision,
+                                  size_t width,
+                                  char sep,
+                                  bool checksum,
+                                  size_t buffer_size)
+    : MatrixWriter<T>(file_address, 4, format, precision, width, sep, checksum, buffer_size)
+{}
+
+template<class T>
+void Matrix4DWriter<T>::write_slice(const Matrix3D<T>& slice)
+{   std::vector<size_t> dim = slice.get_dim() ;
+    if(dim.size() > 1)
+    {   std::swap(dim[0], dim[1]) ; }
+    // an empty matrix has no data
+    this->write_values(dim, slice.get_data_size() == 0 ? nullptr : slice.get_data_ptr()) ;
+}
+
+#endif // MATRIXWRITER_HPP
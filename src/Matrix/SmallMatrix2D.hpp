@@ -0,0 +1,595 @@
+#ifndef SMALLMATRIX2D_HPP
+#define SMALLMATRIX2D_HPP
+
+#include <array>
+#include <vector>
+#include <initializer_list>
+#include <algorithm>  // copy(), fill(), equal()
+#include <iostream>
+#include <iomanip>    // setprecision(), fixed
+#include <cstdio>     // sprintf()
+#include <stdexcept>  // out_of_range, invalid_argument
+
+#include "Matrix2D.hpp"
+#include "MatrixKernels.hpp"
+#include "MatrixTextWriter.hpp"
+
+
+/*!
+ * The SmallMatrix2D class is a compact 2D matrix for the tiny
+ * matrices processed by millions (3x3, 4x4, ...). Its values are
+ * stored within the object, in an array of Capacity values, and its
+ * dimensions are two integers, so that constructing, copying and
+ * computing such matrices never allocates memory : a Matrix2D needs
+ * a vector for its values, one for its dimensions, one for their
+ * products and two for its row and column offsets.
+ *
+ * The dimensions are given at run time and the number of values
+ * (nrow x ncol) should not exceed Capacity. The values are stored in
+ * row-major order, as in a Matrix2D, and the two classes convert into
+ * each other.
+ *
+ * SmallMatrix2D<double, 9> m(3, 3, {1, 0, 0,
+ *                                   0, 1, 0,
+ *                                   0, 0, 1}) ;
+ * Matrix2D<double> m2(m.to_matrix2d()) ;
+ */
+template<class T, size_t Capacity = 16>
+class SmallMatrix2D
+{
+    static_assert(Capacity > 0, "the capacity should not be null") ;
+
+    public:
+        typedef T value_type ;
+
+        /*!
+         * \brief The maximal number of values.
+         */
+        static const size_t capacity = Capacity ;
+
+        // constructors
+        /*!
+         * \brief Constructs a null matrix (0x0 dimensions).
+         */
+        SmallMatrix2D() ;
+        /*!
+         * \brief Constructs a matrix with the given dimensions,
+         * filled with 0 values.
+         * \param nrow the number of rows.
+         * \param ncol the number of columns.
+         * \throw std::invalid_argument if the matrix has more than
+         * Capacity values.
+         */
+        SmallMatrix2D(size_t nrow, size_t ncol) ;
+        /*!
+         * \brief Constructs a matrix with the given dimensions and
+         * initialize the values to the given value.
+         * \param nrow the number of rows.
+         * \param ncol the number of columns.
+         * \param value the value to initialize the matrix content
+         * with.
+         * \throw std::invalid_argument if the matrix has more than
+         * Capacity values.
+         */
+        SmallMatrix2D(size_t nrow, size_t ncol, T value) ;
+        /*!
+         * \brief Constructs a matrix with the given dimensions and
+         * values.
+         * \param nrow the number of rows.
+         * \param ncol the number of columns.
+         * \param values the values, row by row.
+         * \throw std::invalid_argument if the matrix has more than
+         * Capacity values or if the number of values is not
+         * nrow x ncol.
+         */
+        SmallMatrix2D(size_t nrow, size_t ncol, std::initializer_list<T> values) ;
+        /*!
+         * \brief Constructs a matrix from the values of a Matrix2D.
+         * \param other the matrix to copy the values from.
+         * \throw std::invalid_argument if the matrix has more than
+         * Capacity values.
+         */
+        template<class A>
+        explicit SmallMatrix2D(const Matrix2D<T,A>& other) ;
+
+        // methods
+        /*!
+         * \brief Copies the values into a Matrix2D.
+         * \return the matrix.
+         */
+        template<class A = MatrixAlignedAllocator<T>>
+        Matrix2D<T,A> to_matrix2d() const ;
+
+        /*!
+         * \brief Gets the element at the given coordinates.
+         * \param row the row number of the element.
+         * \param col the column number of the element.
+         * \throw std::out_of_range exception if the coordinates
+         * are out of range.
+         * \return the element.
+         */
+        T get(size_t row, size_t col) const ;
+
+        /*!
+         * \brief Sets the element at the given coordinates
+         * to the given value.
+         * \param row the row number of the element to set.
+         * \param col the column number of the element to set.
+         * \param value the new value.
+         * \throw std::out_of_range exception if the coordinates
+         * are out of range.
+         */
+        void set(size_t row, size_t col, T value) ;
+
+        /*!
+         * \brief Gets the number of rows.
+         * \return the number of rows.
+         */
+        size_t get_nrow() const ;
+        /*!
+         * \brief Gets the number of columns.
+         * \return the number of columns.
+         */
+        size_t get_ncol() const ;
+        /*!
+         * \brief Gets the dimensions, as {nrow, ncol}.
+         * \return the dimensions.
+         */
+        std::vector<size_t> get_dim() const ;
+        /*!
+         * \brief Gets the number of values.
+         * \return the number of values.
+         */
+        size_t get_data_size() const ;
+
+        /*!
+         * \brief Gives the address of the values.
+         * \return the address of the 1st value.
+         */
+        T* get_data_ptr() ;
+        const T* get_data_ptr() const ;
+
+        /*!
+         * \brief Produces a nice representation of the matrix on the given
+         * stream.
+         * \param stream the stream.
+         * \param precision the rounding precision.
+         * \param width the column width in number of characters.
+         * \param sep the character separator.
+         */
+        void print(std::ostream& stream, size_t precision=4, size_t width=8, char sep=' ') const ;
+
+        // operators
+        /*!
+         * \brief Gets the element at the given coordinates, which
+         * are not checked.
+         * \param row the row number of the element.
+         * \param col the column number of the element.
+         * \return a reference to this element.
+         */
+        T& operator () (size_t row, size_t col) ;
+        const T& operator () (size_t row, size_t col) const ;
+
+        /*!
+         * \brief Modifies each value of the matrix with the
+         * given value.
+         * \param value the value.
+         * \return a reference to the instance.
+         */
+        SmallMatrix2D& operator += (T value) ;
+        SmallMatrix2D& operator -= (T value) ;
+        SmallMatrix2D& operator *= (T value) ;
+
+        /*!
+         * \brief Divides each value of the matrix by the given
+         * value.
+         * \param value the value.
+         * \throw std::invalid_argument if the value is 0, the
+         * matrix being left unchanged.
+         * \return a reference to the instance.
+         */
+        SmallMatrix2D& operator /= (T value) ;
+
+        /*!
+         * \brief Modifies each value of the matrix with the
+         * value of the other matrix at the same coordinates.
+         * \param other the other matrix.
+         * \throw std::invalid_argument if the matrices do not
+         * have the same dimensions.
+         * \return a reference to the instance.
+         */
+        SmallMatrix2D& operator += (const SmallMatrix2D& other) ;
+        SmallMatrix2D& operator -= (const SmallMatrix2D& other) ;
+        SmallMatrix2D& operator *= (const SmallMatrix2D& other) ;
+
+        /*!
+         * \brief Divides each value of the matrix by the value
+         * of the other matrix at the same coordinates.
+         * \param other the other matrix.
+         * \throw std::invalid_argument if the matrices do not
+         * have the same dimensions or if a value of the other
+         * matrix is 0, the matrix being left unchanged.
+         * \return a reference to the instance.
+         */
+        SmallMatrix2D& operator /= (const SmallMatrix2D& other) ;
+
+        /*!
+         * \brief Checks whether two matrices have the same
+         * dimensions and values.
+         * \param other the other matrix.
+         * \return whether the matrices are equal.
+         */
+        bool operator == (const SmallMatrix2D& other) const ;
+        bool operator != (const SmallMatrix2D& other) const ;
+
+    private:
+        /*!
+         * \brief Checks the number of values of a matrix.
+         * \param nrow the number of rows.
+         * \param ncol the number of columns.
+         * \throw std::invalid_argument if the matrix has more than
+         * Capacity values.
+         */
+        static void check_size(size_t nrow, size_t ncol) ;
+
+        /*!
+         * \brief Checks that the other matrix has the same dimensions.
+         * \param other the other matrix.
+         * \throw std::invalid_argument if the dimensions differ.
+         */
+        void check_dim(const SmallMatrix2D& other) const ;
+
+        /*!
+         * \brief The dimensions.
+         */
+        size_t _nrow ;
+        size_t _ncol ;
+        /*!
+         * \brief The values, row by row, the first nrow x ncol
+         * ones are used.
+         */
+        std::array<T, Capacity> _data ;
+} ;
+
+template<class T, size_t Capacity>
+const size_t SmallMatrix2D<T,Capacity>::capacity ;
+
+/*!
+ * \brief Produces a nice representation of the matrix on the given
+ * stream.
+ * \param stream the stream.
+ * \param m the matrix.
+ * \return the stream.
+ */
+template<class T, size_t Capacity>
+std::ostream& operator << (std::ostream& stream, const SmallMatrix2D<T,Capacity>& m) ;
+
+/*!
+ * \brief Computes the matrix resulting from an operation on each value
+ * of a matrix and the value of the other matrix at the same coordinates,
+ * or the given value.
+ * \throw std::invalid_argument if the matrices do not have the same
+ * dimensions or if dividing by 0.
+ * \return the resulting matrix.
+ */
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator + (SmallMatrix2D<T,Capacity> m1, const SmallMatrix2D<T,Capacity>& m2) ;
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator - (SmallMatrix2D<T,Capacity> m1, const SmallMatrix2D<T,Capacity>& m2) ;
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator * (SmallMatrix2D<T,Capacity> m1, const SmallMatrix2D<T,Capacity>& m2) ;
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator / (SmallMatrix2D<T,Capacity> m1, const SmallMatrix2D<T,Capacity>& m2) ;
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator + (SmallMatrix2D<T,Capacity> m, T value) ;
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator - (SmallMatrix2D<T,Capacity> m, T value) ;
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator * (SmallMatrix2D<T,Capacity> m, T value) ;
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator / (SmallMatrix2D<T,Capacity> m, T value) ;
+
+/*!
+ * \brief Computes the transpose of a matrix.
+ * \param m the matrix.
+ * \throw std::invalid_argument if the transpose would have more
+ * than Capacity values.
+ * \return the transpose of m.
+ */
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> transpose(const SmallMatrix2D<T,Capacity>& m) ;
+
+/*!
+ * \brief Computes the matrix product of two matrices, with a
+ * naive loop, the fastest for such sizes.
+ * \param m1 the left matrix.
+ * \param m2 the right matrix.
+ * \throw std::invalid_argument if the number of columns of m1
+ * is not equal to the number of rows of m2 or if the product
+ * has more than Capacity values.
+ * \return the matrix product of m1 and m2.
+ */
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> multiply(const SmallMatrix2D<T,Capacity>& m1, const SmallMatrix2D<T,Capacity>& m2) ;
+
+
+// method implementation
+template<class T, size_t Capacity>
+std::ostream& operator << (std::ostream& stream, const SmallMatrix2D<T,Capacity>& m)
+{   m.print(stream) ;
+    return stream ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator + (SmallMatrix2D<T,Capacity> m1, const SmallMatrix2D<T,Capacity>& m2)
+{   return m1 += m2 ; }
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator - (SmallMatrix2D<T,Capacity> m1, const SmallMatrix2D<T,Capacity>& m2)
+{   return m1 -= m2 ; }
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator * (SmallMatrix2D<T,Capacity> m1, const SmallMatrix2D<T,Capacity>& m2)
+{   return m1 *= m2 ; }
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator / (SmallMatrix2D<T,Capacity> m1, const SmallMatrix2D<T,Capacity>& m2)
+{   return m1 /= m2 ; }
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator + (SmallMatrix2D<T,Capacity> m, T value)
+{   return m += value ; }
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator - (SmallMatrix2D<T,Capacity> m, T value)
+{   return m -= value ; }
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator * (SmallMatrix2D<T,Capacity> m, T value)
+{   return m *= value ; }
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> operator / (SmallMatrix2D<T,Capacity> m, T value)
+{   return m /= value ; }
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> transpose(const SmallMatrix2D<T,Capacity>& m)
+{   size_t nrow = m.get_nrow() ;
+    size_t ncol = m.get_ncol() ;
+    SmallMatrix2D<T,Capacity> m2(ncol, nrow) ;
+    for(size_t i=0; i<nrow; i++)
+    {   for(size_t j=0; j<ncol; j++)
+        {   m2(j,i) = m(i,j) ; }
+    }
+    return m2 ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity> multiply(const SmallMatrix2D<T,Capacity>& m1, const SmallMatrix2D<T,Capacity>& m2)
+{   if(m1.get_ncol() != m2.get_nrow())
+    {   char msg[4096] ;
+        sprintf(msg, "error! cannot multiply a %zu x %zu matrix by a %zu x %zu matrix!",
+                m1.get_nrow(), m1.get_ncol(), m2.get_nrow(), m2.get_ncol()) ;
+        throw std::invalid_argument(msg) ;
+    }
+    size_t nrow = m1.get_nrow() ;
+    size_t ncol = m2.get_ncol() ;
+    size_t n    = m1.get_ncol() ;
+    SmallMatrix2D<T,Capacity> m3(nrow, ncol) ;
+    for(size_t i=0; i<nrow; i++)
+    {   for(size_t k=0; k<n; k++)
+        {   T value = m1(i,k) ;
+            for(size_t j=0; j<ncol; j++)
+            {   m3(i,j) += value * m2(k,j) ; }
+        }
+    }
+    return m3 ;
+}
+
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>::SmallMatrix2D()
+    : _nrow(0),
+      _ncol(0),
+      _data()
+{}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>::SmallMatrix2D(size_t nrow, size_t ncol)
+    : SmallMatrix2D<T,Capacity>(nrow, ncol, static_cast<T>(0))
+{}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>::SmallMatrix2D(size_t nrow, size_t ncol, T value)
+    : _nrow(nrow),
+      _ncol(ncol),
+      _data()
+{   check_size(nrow, ncol) ;
+    std::fill(this->_data.begin(), this->_data.begin() + nrow*ncol, value) ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>::SmallMatrix2D(size_t nrow, size_t ncol, std::initializer_list<T> values)
+    : _nrow(nrow),
+      _ncol(ncol),
+      _data()
+{   check_size(nrow, ncol) ;
+    if(values.size() != nrow*ncol)
+    {   char msg[4096] ;
+        sprintf(msg, "error! %zu values given for a %zu x %zu matrix!",
+                values.size(), nrow, ncol) ;
+        throw std::invalid_argument(msg) ;
+    }
+    std::copy(values.begin(), values.end(), this->_data.begin()) ;
+}
+
+template<class T, size_t Capacity>
+template<class A>
+SmallMatrix2D<T,Capacity>::SmallMatrix2D(const Matrix2D<T,A>& other)
+    : _nrow(other.get_nrow()),
+      _ncol(other.get_ncol()),
+      _data()
+{   check_size(this->_nrow, this->_ncol) ;
+    const T* data = other.get_data_ptr() ;
+    std::copy(data, data + this->_nrow*this->_ncol, this->_data.begin()) ;
+}
+
+template<class T, size_t Capacity>
+template<class A>
+Matrix2D<T,A> SmallMatrix2D<T,Capacity>::to_matrix2d() const
+{   Matrix2D<T,A> m(this->_nrow, this->_ncol) ;
+    std::copy(this->_data.begin(), this->_data.begin() + this->_nrow*this->_ncol, m.get_data_ptr()) ;
+    return m ;
+}
+
+template<class T, size_t Capacity>
+T SmallMatrix2D<T,Capacity>::get(size_t row, size_t col) const
+{   if(row >= this->_nrow or col >= this->_ncol)
+    {   throw std::out_of_range("coordinates are out of range!") ; }
+    return this->_data[row*this->_ncol + col] ;
+}
+
+template<class T, size_t Capacity>
+void SmallMatrix2D<T,Capacity>::set(size_t row, size_t col, T value)
+{   if(row >= this->_nrow or col >= this->_ncol)
+    {   throw std::out_of_range("coordinates are out of range!") ; }
+    this->_data[row*this->_ncol + col] = value ;
+}
+
+template<class T, size_t Capacity>
+size_t SmallMatrix2D<T,Capacity>::get_nrow() const
+{   return this->_nrow ; }
+
+template<class T, size_t Capacity>
+size_t SmallMatrix2D<T,Capacity>::get_ncol() const
+{   return this->_ncol ; }
+
+template<class T, size_t Capacity>
+std::vector<size_t> SmallMatrix2D<T,Capacity>::get_dim() const
+{   return {this->_nrow, this->_ncol} ; }
+
+template<class T, size_t Capacity>
+size_t SmallMatrix2D<T,Capacity>::get_data_size() const
+{   return this->_nrow * this->_ncol ; }
+
+template<class T, size_t Capacity>
+T* SmallMatrix2D<T,Capacity>::get_data_ptr()
+{   return this->_data.data() ; }
+
+template<class T, size_t Capacity>
+const T* SmallMatrix2D<T,Capacity>::get_data_ptr() const
+{   return this->_data.data() ; }
+
+template<class T, size_t Capacity>
+void SmallMatrix2D<T,Capacity>::print(std::ostream& stream, size_t precision, size_t width, char sep) const
+{   stream.setf(std::ios::left) ;
+    stream << std::setprecision(precision) << std::fixed ;
+    // the dimensions as stored by Matrix
+    std::vector<size_t> dim = {this->_ncol, this->_nrow} ;
+    MatrixTextWriter<T>(stream, dim, 2, width, sep).write(this->get_data_ptr()) ;
+}
+
+template<class T, size_t Capacity>
+T& SmallMatrix2D<T,Capacity>::operator () (size_t row, size_t col)
+{   return this->_data[row*this->_ncol + col] ; }
+
+template<class T, size_t Capacity>
+const T& SmallMatrix2D<T,Capacity>::operator () (size_t row, size_t col) const
+{   return this->_data[row*this->_ncol + col] ; }
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>& SmallMatrix2D<T,Capacity>::operator += (T value)
+{   for(size_t i=0; i<this->get_data_size(); i++)
+    {   this->_data[i] += value ; }
+    return *this ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>& SmallMatrix2D<T,Capacity>::operator -= (T value)
+{   for(size_t i=0; i<this->get_data_size(); i++)
+    {   this->_data[i] -= value ; }
+    return *this ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>& SmallMatrix2D<T,Capacity>::operator *= (T value)
+{   for(size_t i=0; i<this->get_data_size(); i++)
+    {   this->_data[i] *= value ; }
+    return *this ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>& SmallMatrix2D<T,Capacity>::operator /= (T value)
+{   if(value == static_cast<T>(0))
+    {   throw std::invalid_argument("division by 0!") ; }
+    for(size_t i=0; i<this->get_data_size(); i++)
+    {   this->_data[i] /= value ; }
+    return *this ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>& SmallMatrix2D<T,Capacity>::operator += (const SmallMatrix2D& other)
+{   this->check_dim(other) ;
+    for(size_t i=0; i<this->get_data_size(); i++)
+    {   this->_data[i] += other._data[i] ; }
+    return *this ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>& SmallMatrix2D<T,Capacity>::operator -= (const SmallMatrix2D& other)
+{   this->check_dim(other) ;
+    for(size_t i=0; i<this->get_data_size(); i++)
+    {   this->_data[i] -= other._data[i] ; }
+    return *this ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>& SmallMatrix2D<T,Capacity>::operator *= (const SmallMatrix2D& other)
+{   this->check_dim(other) ;
+    for(size_t i=0; i<this->get_data_size(); i++)
+    {   this->_data[i] *= other._data[i] ; }
+    return *this ;
+}
+
+template<class T, size_t Capacity>
+SmallMatrix2D<T,Capacity>& SmallMatrix2D<T,Capacity>::operator /= (const SmallMatrix2D& other)
+{   this->check_dim(other) ;
+    if(kernel_has_zero(other._data.data(), other.get_data_size()))
+    {   throw std::invalid_argument("division by 0!") ; }
+    for(size_t i=0; i<this->get_data_size(); i++)
+    {   this->_data[i] /= other._data[i] ; }
+    return *this ;
+}
+
+template<class T, size_t Capacity>
+bool SmallMatrix2D<T,Capacity>::operator == (const SmallMatrix2D& other) const
+{   return this->_nrow == other._nrow and
+           this->_ncol == other._ncol and
+           std::equal(this->_data.begin(), this->_data.begin() + this->get_data_size(), other._data.begin()) ;
+}
+
+template<class T, size_t Capacity>
+bool SmallMatrix2D<T,Capacity>::operator != (const SmallMatrix2D& other) const
+{   return not (*this == other) ; }
+
+template<class T, size_t Capacity>
+void SmallMatrix2D<T,Capacity>::check_size(size_t nrow, size_t ncol)
+{   if(ncol != 0 and nrow > Capacity / ncol)
+    {   char msg[4096] ;
+        sprintf(msg, "error! a %zu x %zu matrix exceeds the capacity of %zu values!",
+                nrow, ncol, Capacity) ;
+        throw std::invalid_argument(msg) ;
+    }
+}
+
+template<class T, size_t Capacity>
+void SmallMatrix2D<T,Capacity>::check_dim(const SmallMatrix2D& other) const
+{   if(this->_nrow != other._nrow or this->_ncol != other._ncol)
+    {   char msg[4096] ;
+        sprintf(msg, "error! the dimensions differ : %zu x %zu and %zu x %zu!",
+                this->_nrow, this->_ncol, other._nrow, other._ncol) ;
+        throw std::invalid_argument(msg) ;
+    }
+}
+
+#endif // SMALLMATRIX2D_HPP
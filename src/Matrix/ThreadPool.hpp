@@ -0,0 +1,249 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>      // make_shared()
+#include <algorithm>   // min()
+#include <stdexcept>   // runtime_error
+
+
+/*!
+ * \brief The ThreadPool class is a fixed size pool of threads
+ * executing the jobs they are given, in the order they are
+ * given.
+ *
+ * A default pool, with one thread per core, is shared by all the
+ * matrix routines running in parallel (see get_default()) and an
+ * I/O pool by the asynchronous file accesses (see get_io()).
+ *
+ * The parallel_for() method splits a range of indices in as many
+ * chunks as the pool has threads and waits for all of them to be
+ * processed. When it is called from a job already running in the
+ * same pool, the range is processed sequentially by the calling
+ * thread instead, which avoids that all the threads of the pool
+ * wait for each other.
+ */
+class ThreadPool
+{
+    public:
+        // constructors
+        ThreadPool() = delete ;
+
+        /*!
+         * \brief Constructs a pool with the given number of
+         * threads.
+         * \param n_threads the number of threads, if 0 one
+         * thread is created.
+         */
+        ThreadPool(size_t n_threads) ;
+
+        ThreadPool(const ThreadPool& other) = delete ;
+
+        /*!
+         * \brief Destructor. Waits for all the jobs submitted
+         * to be done and joins the threads.
+         */
+        ~ThreadPool() ;
+
+        // methods
+        /*!
+         * \brief Returns the pool shared by the matrix routines,
+         * which has one thread per core.
+         * \return the default pool.
+         */
+        static ThreadPool& get_default() ;
+
+        /*!
+         * \brief Returns the pool shared by the asynchronous
+         * file reads and writes (see MatrixAsync.hpp). Its
+         * threads mostly wait for the disk, so that it is
+         * separate from the default pool.
+         * \return the I/O pool.
+         */
+        static ThreadPool& get_io() ;
+
+        /*!
+         * \brief Gets the number of threads of the pool.
+         * \return the number of threads.
+         */
+        size_t get_thread_number() const ;
+
+        /*!
+         * \brief Submits a job to the pool.
+         * \param f the function to run, it should take no
+         * argument.
+         * \return a future giving access to the value
+         * returned by f (or the exception it throwed).
+         */
+        template<class F>
+        std::future<typename std::result_of<F()>::type> add_job(F f) ;
+
+        /*!
+         * \brief Calls f(from_i, to_i) on consecutive chunks
+         * [from_i, to_i) covering [from, to), in parallel, and
+         * waits for all the calls to return. If any call throws
+         * an exception, the first one is rethrown once all the
+         * calls returned.
+         * \param from the 1st index of the range.
+         * \param to the past-the-end index of the range.
+         * \param f the function to call on each chunk.
+         * \param n_chunks the number of chunks, by default the
+         * number of threads.
+         */
+        template<class F>
+        void parallel_for(size_t from, size_t to, F f, size_t n_chunks=0) ;
+
+        ThreadPool& operator = (const ThreadPool& other) = delete ;
+
+    private:
+        /*!
+         * \brief The routine run by each thread, picks the jobs
+         * in the queue and runs them until the pool is destroyed.
+         */
+        void run() ;
+
+        /*!
+         * \brief Returns the pool running the calling thread, if
+         * any.
+         * \return a reference to the pointer to the pool running
+         * the calling thread, nullptr if the thread does not
+         * belong to a pool.
+         */
+        static ThreadPool*& current_pool() ;
+
+        /*!
+         * \brief The threads.
+         */
+        std::vector<std::thread> _threads ;
+        /*!
+         * \brief The jobs waiting to be run.
+         */
+        std::queue<std::function<void()>> _jobs ;
+        /*!
+         * \brief Protects the job queue and the stop flag.
+         */
+        std::mutex _mutex ;
+        /*!
+         * \brief Signals the threads that a job is available
+         * or that the pool is being destroyed.
+         */
+        std::condition_variable _cv ;
+        /*!
+         * \brief Whether the pool is being destroyed.
+         */
+        bool _stop ;
+} ;
+
+
+inline ThreadPool::ThreadPool(size_t n_threads)
+    : _stop(false)
+{   if(n_threads == 0)
+    {   n_threads = 1 ; }
+    for(size_t i=0; i<n_threads; i++)
+    {   this->_threads.push_back(std::thread(&ThreadPool::run, this)) ; }
+}
+
+inline ThreadPool::~ThreadPool()
+{   {   std::unique_lock<std::mutex> lock(this->_mutex) ;
+        this->_stop = true ;
+    }
+    this->_cv.notify_all() ;
+    for(auto& thread : this->_threads)
+    {   thread.join() ; }
+}
+
+inline ThreadPool& ThreadPool::get_default()
+{   static ThreadPool pool(std::thread::hardware_concurrency()) ;
+    return pool ;
+}
+
+inline ThreadPool& ThreadPool::get_io()
+{   static ThreadPool pool(4) ;
+    return pool ;
+}
+
+inline size_t ThreadPool::get_thread_number() const
+{   return this->_threads.size() ; }
+
+template<class F>
+std::future<typename std::result_of<F()>::type> ThreadPool::add_job(F f)
+{   typedef typename std::result_of<F()>::type return_type ;
+    auto task = std::make_shared<std::packaged_task<return_type()>>(f) ;
+    std::future<return_type> future = task->get_future() ;
+    {   std::unique_lock<std::mutex> lock(this->_mutex) ;
+        if(this->_stop)
+        {   throw std::runtime_error("error! cannot add a job to a stopped pool") ; }
+        this->_jobs.push([task]() { (*task)() ; }) ;
+    }
+    this->_cv.notify_one() ;
+    return future ;
+}
+
+template<class F>
+void ThreadPool::parallel_for(size_t from, size_t to, F f, size_t n_chunks)
+{   if(to <= from)
+    {   return ; }
+    if(n_chunks == 0)
+    {   n_chunks = this->get_thread_number() ; }
+    n_chunks = std::min(n_chunks, to - from) ;
+
+    // nested call or nothing to share
+    if(n_chunks == 1 or current_pool() == this)
+    {   f(from, to) ;
+        return ;
+    }
+
+    // the calling thread processes the 1st chunk itself
+    size_t chunk_size = (to - from) / n_chunks ;
+    size_t remainder  = (to - from) % n_chunks ;
+    std::vector<std::future<void>> futures ;
+    size_t chunk_from = from + chunk_size + (remainder > 0) ;
+    for(size_t i=1; i<n_chunks; i++)
+    {   size_t chunk_to = chunk_from + chunk_size + (i < remainder) ;
+        futures.push_back(this->add_job([&f, chunk_from, chunk_to]() { f(chunk_from, chunk_to) ; })) ;
+        chunk_from = chunk_to ;
+    }
+    std::exception_ptr error = nullptr ;
+    try
+    {   f(from, from + chunk_size + (remainder > 0)) ; }
+    catch(...)
+    {   error = std::current_exception() ; }
+    for(auto& future : futures)
+    {   try
+        {   future.get() ; }
+        catch(...)
+        {   if(error == nullptr)
+            {   error = std::current_exception() ; }
+        }
+    }
+    if(error != nullptr)
+    {   std::rethrow_exception(error) ; }
+}
+
+inline void ThreadPool::run()
+{   current_pool() = this ;
+    while(true)
+    {   std::function<void()> job ;
+        {   std::unique_lock<std::mutex> lock(this->_mutex) ;
+            this->_cv.wait(lock, [this]() { return this->_stop or not this->_jobs.empty() ; }) ;
+            if(this->_stop and this->_jobs.empty())
+            {   return ; }
+            job = std::move(this->_jobs.front()) ;
+            this->_jobs.pop() ;
+        }
+        job() ;
+    }
+}
+
+inline ThreadPool*& ThreadPool::current_pool()
+{   static thread_local ThreadPool* pool = nullptr ;
+    return pool ;
+}
+
+#endif // THREADPOOL_HPP
@@ -1,11 +1,34 @@
 #include <UnitTest++/UnitTest++.h>
 #include <numeric> // accumulate()
+#include <type_traits> // is_trivially_copyable, is_convertible
+#include <unistd.h>   // fork(), getpid()
+#include <sys/wait.h> // waitpid()
+#include <sys/stat.h> // stat()
+#include <sys/resource.h> // setrlimit()
+#include <csignal>    // SIGABRT
 
 
 #include "Matrix/Matrix.hpp"
 #include "Matrix/Matrix2D.hpp"
 #include "Matrix/Matrix3D.hpp"
 #include "Matrix/Matrix4D.hpp"
+#include "Matrix/MatrixN.hpp"
+#include "Matrix/SmallMatrix2D.hpp"
+#include "Matrix/FixedMatrix.hpp"
+#include "Matrix/MatrixTextParser.hpp"
+#include "Matrix/MatrixTextWriter.hpp"
+#include "Matrix/MatrixBinaryFormat.hpp"
+#include "Matrix/MatrixChunkedFile.hpp"
+#include "Matrix/MatrixOutOfCore.hpp"
+#include "Matrix/MatrixSliceReader.hpp"
+#include "Matrix/MatrixWriter.hpp"
+#include "Matrix/MatrixAsync.hpp"
+#include "Matrix/MatrixIOEngine.hpp"
+#include "Matrix/MatrixNpyFormat.hpp"
+#include "Matrix/MatrixAllocator.hpp"
+#include "Matrix/MatrixScratch.hpp"
+#include "Matrix/MatrixKernels.hpp"
+#include "Matrix/ThreadPool.hpp"
 
 /*!
  * \brief Given a matrix and an offset, this methods converts
@@ -51,6 +74,58 @@ std::ostream& operator << (std::ostream& stream, const std::vector<T>& v)
     return stream ;
 }
 
+/*!
+ * \brief Compares the kernels of an operation to the scalar
+ * kernels, on arrays of any length up to n_max starting at any
+ * offset up to offset_max, so that the SIMD loops, their
+ * remainder and the unaligned loads and stores are covered.
+ * The values following the results should be left unchanged.
+ * \param kernel_arrays the kernel between two arrays.
+ * \param kernel_value the kernel between an array and a value.
+ * \param n_max the maximum length of the arrays.
+ * \param offset_max the maximum offset of the arrays.
+ * \return the number of values which differ.
+ */
+template<class Op, class T>
+size_t count_kernel_errors(void (*kernel_arrays)(const T*, const T*, T*, size_t),
+                           void (*kernel_value)(const T*, T, T*, size_t),
+                           size_t n_max,
+                           size_t offset_max)
+{   size_t size = n_max + offset_max + 1 ;
+    std::vector<T> a(size), b(size), out(size), expected(size) ;
+    for(size_t i=0; i<size; i++)
+    {   a[i] = static_cast<T>(3*static_cast<int>(i) - 50) ;
+        b[i] = static_cast<T>(i % 7 + 1) ;
+    }
+    T value = static_cast<T>(3) ;
+
+    size_t errors = 0 ;
+    for(size_t offset=0; offset<=offset_max; offset++)
+    {   // the operands and the results start at different offsets
+        const T* pa = a.data() + offset ;
+        const T* pb = b.data() + (offset*3) % (offset_max+1) ;
+        T* pout     = out.data() + (offset*5) % (offset_max+1) ;
+        T* pexp     = expected.data() + (offset*5) % (offset_max+1) ;
+        for(size_t n=0; n<=n_max; n++)
+        {   for(int k=0; k<2; k++)
+            {   std::fill(out.begin(), out.end(), static_cast<T>(-1)) ;
+                std::fill(expected.begin(), expected.end(), static_cast<T>(-1)) ;
+                if(k == 0)
+                {   kernel_arrays(pa, pb, pout, n) ;
+                    elementwise_kernel<Op,T,false>::run(pa, pb, pexp, n) ;
+                }
+                else
+                {   kernel_value(pa, value, pout, n) ;
+                    elementwise_kernel<Op,T,false>::run(pa, value, pexp, n) ;
+                }
+                for(size_t i=0; i<size; i++)
+                {   errors += (out[i] != expected[i]) ; }
+            }
+        }
+    }
+    return errors ;
+}
+
 
 
 // Matrix test suite
@@ -315,6 +390,55 @@ SUITE(Matrix)
         }
     }
 
+    // tests that a moved-from matrix is empty and can be used again
+    TEST(move)
+    {   Matrix<int> m1({2,3,4}, 1), m2({5,5}, 2) ;
+        m2 = std::move(m1) ;
+        CHECK_EQUAL(std::vector<size_t>({2,3,4}), m2.get_dim()) ;
+        CHECK_EQUAL(24, m2.get_data_size()) ;
+        CHECK_EQUAL(std::vector<size_t>({0,0,0}), m1.get_dim()) ;
+        CHECK_EQUAL(0, m1.get_data_size()) ;
+        CHECK_THROW(m1.get({0,0,0}), std::out_of_range) ;
+        std::ostringstream stream ;
+        stream << m1 ;
+        m1 = m2 ;
+        CHECK_EQUAL(m2, m1) ;
+        Matrix<int> m3(std::move(m1)) ;
+        CHECK_EQUAL(m2, m3) ;
+        CHECK_EQUAL(0, m1.get_data_size()) ;
+        m1 = Matrix<int>({2}, 3) ;
+        CHECK_EQUAL(3, m1.get({1})) ;
+        // moved onto itself
+        Matrix<int>& m3_ref = m3 ;
+        m3 = std::move(m3_ref) ;
+        CHECK_EQUAL(m2, m3) ;
+
+        // the offsets of the moved-from 2D, 3D and 4D matrices
+        Matrix2D<int> n1(3, 4, 1), n2(2, 2) ;
+        n2 = std::move(n1) ;
+        CHECK_EQUAL(1, n2(2, 3)) ;
+        CHECK_EQUAL(0, n1.get_nrow()) ;
+        CHECK_EQUAL(0, n1.get_data_size()) ;
+        CHECK_THROW(n1.get(0, 0), std::out_of_range) ;
+        n1 = Matrix2D<int>(4, 5, 2) ;
+        CHECK_EQUAL(2, n1(3, 4)) ;
+        Matrix3D<int> p1(2, 3, 4, 1), p2(std::move(p1)) ;
+        CHECK_EQUAL(0, p1.get_data_size()) ;
+        CHECK_THROW(p1.get(0, 0, 0), std::out_of_range) ;
+        p1 = p2 ;
+        CHECK_EQUAL(1, p1(1, 2, 3)) ;
+        Matrix4D<int> q1(2, 3, 4, 5, 1), q2(1, 1, 1, 1) ;
+        q2 = std::move(q1) ;
+        CHECK_EQUAL(1, q2(1, 2, 3, 4)) ;
+        CHECK_EQUAL(0, q1.get_data_size()) ;
+        q1 = q2 ;
+        CHECK_EQUAL(1, q1(1, 2, 3, 4)) ;
+        MatrixN<int,3> r1({2, 3, 4}, 1), r2(std::move(r1)) ;
+        CHECK_EQUAL((std::array<size_t,3>({0,0,0})), r1.get_dim_array()) ;
+        r1 = r2 ;
+        CHECK_EQUAL(1, r1(1, 2, 3)) ;
+    }
+
     // test the + operator
     TEST(operator_addition)
     {   std::vector<size_t> dim_1, dim_2, dim_3 ;
@@ -675,6 +799,187 @@ SUITE(Matrix)
         }
     }
 
+    // tests the element-wise +, -, * and / operators between two matrices
+    TEST(operator_elementwise)
+    {   // dimensions which are not multiple of any SIMD register width
+        std::vector<std::vector<size_t>> dims = {{0}, {1}, {37}, {3,5}, {3,5,7}, {2,3,4,5}, {4,0,2}} ;
+
+        for(const auto& dim : dims)
+        {   Matrix<int>    m1(dim), m2(dim) ;
+            Matrix<double> m3(dim), m4(dim) ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   m1.set(j, 2*j) ;
+                m2.set(j, j+1) ;
+                m3.set(j, 2.*j) ;
+                m4.set(j, j+1.) ;
+            }
+
+            Matrix<int>    m_add = m1 + m2, m_sub = m1 - m2, m_mul = m1 * m2, m_div = m1 / m2 ;
+            Matrix<double> m_addd = m3 + m4, m_subd = m3 - m4, m_muld = m3 * m4, m_divd = m3 / m4 ;
+            CHECK_EQUAL(true, m_add.get_dim() == dim) ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   CHECK_EQUAL(int(2*j + j+1), m_add.get(j)) ;
+                CHECK_EQUAL(int(2*j) - int(j+1), m_sub.get(j)) ;
+                CHECK_EQUAL(int(2*j*(j+1)), m_mul.get(j)) ;
+                CHECK_EQUAL(int(2*j/(j+1)), m_div.get(j)) ;
+                CHECK_EQUAL(2.*j + j+1., m_addd.get(j)) ;
+                CHECK_EQUAL(2.*j - (j+1.), m_subd.get(j)) ;
+                CHECK_EQUAL(2.*j * (j+1.), m_muld.get(j)) ;
+                CHECK_EQUAL(2.*j / (j+1.), m_divd.get(j)) ;
+            }
+        }
+
+        // dimensions differ
+        Matrix<int> m1({3,4}), m2({4,3}), m3({3,4,1}) ;
+        CHECK_THROW(m1 + m2, std::invalid_argument) ;
+        CHECK_THROW(m1 - m3, std::invalid_argument) ;
+        CHECK_THROW(m1 * m2, std::invalid_argument) ;
+        CHECK_THROW(m1 / m3, std::invalid_argument) ;
+
+        // division by 0, detected at evaluation
+        Matrix<int> m4({3,4}, 1) ;
+        CHECK_THROW(Matrix<int>(m4 / m1), std::invalid_argument) ;
+    }
+
+    // tests the element-wise +=, -=, *= and /= operators between two matrices
+    TEST(operator_elementwise_equal)
+    {   std::vector<std::vector<size_t>> dims = {{0}, {1}, {37}, {3,5}, {3,5,7}, {2,3,4,5}, {4,0,2}} ;
+
+        for(const auto& dim : dims)
+        {   Matrix<double> m1(dim, 6.), m2(dim, 3.) ;
+            m1 += m2 ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   CHECK_EQUAL(9., m1.get(j)) ; }
+            m1 -= m2 ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   CHECK_EQUAL(6., m1.get(j)) ; }
+            m1 *= m2 ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   CHECK_EQUAL(18., m1.get(j)) ; }
+            m1 /= m2 ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   CHECK_EQUAL(6., m1.get(j)) ; }
+            // with itself
+            m1 += m1 ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   CHECK_EQUAL(12., m1.get(j)) ; }
+        }
+
+        // dimensions differ
+        Matrix<int> m1({3,4}), m2({4,3}), m3({3,4}) ;
+        CHECK_THROW(m1 += m2, std::invalid_argument) ;
+        CHECK_THROW(m1 -= m2, std::invalid_argument) ;
+        CHECK_THROW(m1 *= m2, std::invalid_argument) ;
+        // division by 0
+        CHECK_THROW(m1 /= m3, std::invalid_argument) ;
+    }
+
+    // tests chained operations, which are evaluated lazily in a single pass
+    TEST(expression)
+    {   std::vector<std::vector<size_t>> dims = {{0}, {1}, {37}, {3,5}, {3,5,7}, {2,3,4,5}, {4,0,2}} ;
+
+        for(const auto& dim : dims)
+        {   Matrix<double> m1(dim), m2(dim), m3(dim) ;
+            Matrix<int>    m4(dim), m5(dim) ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   m1.set(j, j) ;
+                m2.set(j, 2.*j) ;
+                m3.set(j, j+1.) ;
+                m4.set(j, j) ;
+                m5.set(j, j+1) ;
+            }
+
+            // construction
+            Matrix<double> m6 = m1 * 2. + m2 - m3 / 2. ;
+            Matrix<int>    m7 = (m4 + m5) * m5 - 1 ;
+            CHECK_EQUAL(true, m6.get_dim() == dim) ;
+            CHECK_EQUAL(true, m7.get_dim() == dim) ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   CHECK_EQUAL(j*2. + 2.*j - (j+1.)/2., m6.get(j)) ;
+                CHECK_EQUAL(int((2*j+1)*(j+1) - 1), m7.get(j)) ;
+            }
+
+            // assignment involving the matrix itself
+            m1 = m1 * m1 + m1 / m3 ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   CHECK_EQUAL(double(j)*j + j/(j+1.), m1.get(j)) ; }
+
+            // compound assignment
+            m4 += m5 * m5 ;
+            m4 -= m5 * 2 ;
+            for(size_t j=0; j<m4.get_data_size(); j++)
+            {   CHECK_EQUAL(int(j + (j+1)*(j+1) - 2*(j+1)), m4.get(j)) ; }
+
+            // assignment to a matrix of other dimensions
+            Matrix<double> m8({2,2}) ;
+            m8 = m2 + m3 ;
+            CHECK_EQUAL(true, m8.get_dim() == dim) ;
+            for(size_t j=0; j<m8.get_data_size(); j++)
+            {   CHECK_EQUAL(3.*j + 1., m8.get(j)) ; }
+        }
+
+        // dimension errors are detected when the expression is built
+        Matrix<int> m1({3,4}, 1), m2({4,3}, 1), m3({3,4}, 0) ;
+        CHECK_THROW(m1 + m1 * m2, std::invalid_argument) ;
+        CHECK_THROW((m1 + m1) / 0, std::invalid_argument) ;
+
+        // divisions by 0 when it is evaluated
+        CHECK_THROW(Matrix<int>((m1 + m1) / m3), std::invalid_argument) ;
+        CHECK_THROW(m1 /= m1 - m1, std::invalid_argument) ;
+        for(size_t j=0; j<m1.get_data_size(); j++)
+        {   CHECK_EQUAL(1, m1.get(j)) ; }
+        // whether the 0 falls in a SIMD register or in the remainder
+        for(size_t zero : {size_t(0), size_t(5), size_t(36)})
+        {   Matrix<double> m4({37}, 1.), m5({37}, 2.) ;
+            m5.set(zero, 0.) ;
+            CHECK_THROW(Matrix<double>(m4 / m5), std::invalid_argument) ;
+            CHECK_THROW(Matrix<double>(m4 / (m5 * 2.)), std::invalid_argument) ;
+            // the destination is left unchanged
+            Matrix<double> m6({37}, 7.), m7({2,2}, 7.) ;
+            CHECK_THROW(m6 = m4 / m5, std::invalid_argument) ;
+            CHECK_THROW(m6 /= m5 * 2., std::invalid_argument) ;
+            CHECK_THROW(m6 += m4 / m5, std::invalid_argument) ;
+            CHECK_THROW(m4 = m4 / m5, std::invalid_argument) ;
+            CHECK_THROW(m7 = m4 / m5, std::invalid_argument) ;
+            CHECK_EQUAL(Matrix<double>({37}, 7.), m6) ;
+            CHECK_EQUAL(Matrix<double>({37}, 1.), m4) ;
+            CHECK_EQUAL(Matrix<double>({2,2}, 7.), m7) ;
+        }
+        // whether the divisor is a matrix or an expression evaluated
+        // by chunks, and the 0 in a nested division
+        for(size_t zero : {size_t(0), size_t(255), size_t(256), size_t(600)})
+        {   Matrix<double> m4({601}, 1.), m5({601}, 2.) ;
+            m5.set(zero, 0.) ;
+            CHECK_THROW(m4 /= m5, std::invalid_argument) ;
+            CHECK_THROW(m4 = m4 / (m5 + m5), std::invalid_argument) ;
+            CHECK_THROW(m4 = m4 / (m4 / m5), std::invalid_argument) ;
+            CHECK_THROW(m4 = (m4 / m5) / m4, std::invalid_argument) ;
+            CHECK_EQUAL(Matrix<double>({601}, 1.), m4) ;
+            // no 0, the instance is read and written in place
+            m5.set(zero, 4.) ;
+            m4 = m4 / (m5 - m4) ;
+            for(size_t j=0; j<m4.get_data_size(); j++)
+            {   CHECK_EQUAL(j == zero ? 1./3. : 1., m4.get(j)) ; }
+        }
+
+        // an expression is only converted to a matrix with its number
+        // of dimensions, or to any matrix if it is not known
+        static_assert(std::is_convertible<MatrixScalarExpression<Matrix2D<int>,kernel_add>, Matrix2D<int>>::value,
+                      "a 2D expression should be converted to Matrix2D") ;
+        static_assert(not std::is_convertible<MatrixScalarExpression<Matrix2D<int>,kernel_add>, Matrix3D<int>>::value,
+                      "a 2D expression should not be converted to Matrix3D") ;
+        static_assert(not std::is_convertible<MatrixBinaryExpression<Matrix3D<int>,Matrix<int>,kernel_add>, Matrix2D<int>>::value,
+                      "a 3D expression should not be converted to Matrix2D") ;
+        static_assert(not std::is_convertible<MatrixScalarExpression<Matrix4D<int>,kernel_add>, MatrixN<int,3>>::value,
+                      "a 4D expression should not be converted to MatrixN<int,3>") ;
+        static_assert(std::is_convertible<MatrixBinaryExpression<Matrix<int>,Matrix<int>,kernel_add>, Matrix3D<int>>::value,
+                      "an expression of unknown dimensions should be converted to Matrix3D") ;
+        static_assert(std::is_convertible<MatrixScalarExpression<Matrix3D<int>,kernel_add>, Matrix<int>>::value,
+                      "expressions should be converted to Matrix") ;
+        Matrix<int> m6({2,3,4}, 1) ;
+        CHECK_THROW(Matrix2D<int> m7 = m6 + 1, std::invalid_argument) ;
+    }
+
     // tests the copy constuctor, not before because it uses the == operator to
     // check that the content of two matrices are equal.
     TEST(constructor_copy)
@@ -756,6 +1061,134 @@ SUITE(Matrix)
             {   CHECK_EQUAL(m3.get(j), m3(convert_to_coord(m3, j))) ; }
         }
     }
+
+    // tests the () operator taking the coordinates as separate arguments
+    TEST(parenthesis_operator_variadic)
+    {   Matrix<int> m1({7}), m2({3,4}), m3({3,4,5}), m4({3,4,5,2}) ;
+        for(size_t j=0; j<m1.get_data_size(); j++)
+        {   m1.set(j,j) ;
+            CHECK_EQUAL(m1(convert_to_coord(m1, j)), m1(j)) ;
+        }
+        for(size_t j=0; j<m2.get_data_size(); j++)
+        {   m2.set(j,j) ;
+            std::vector<size_t> c = convert_to_coord(m2, j) ;
+            CHECK_EQUAL(m2(c), m2(c[0], c[1])) ;
+        }
+        for(size_t j=0; j<m3.get_data_size(); j++)
+        {   m3.set(j,j) ;
+            std::vector<size_t> c = convert_to_coord(m3, j) ;
+            CHECK_EQUAL(m3(c), m3(c[0], c[1], c[2])) ;
+        }
+        for(size_t j=0; j<m4.get_data_size(); j++)
+        {   m4.set(j,j) ;
+            std::vector<size_t> c = convert_to_coord(m4, j) ;
+            CHECK_EQUAL(m4(c), m4(c[0], c[1], c[2], c[3])) ;
+            // write access, with any integral type
+            m4(static_cast<int>(c[0]), c[1], c[2], static_cast<unsigned char>(c[3])) = -1 ;
+            CHECK_EQUAL(-1, m4.get(j)) ;
+        }
+        // coordinates equal to a dimension are out of range
+        CHECK_THROW(m3.get({3,0,0}), std::out_of_range) ;
+        CHECK_THROW(m3.set({0,4,0}, 1), std::out_of_range) ;
+    }
+
+#ifndef NDEBUG
+    // tests that a wrong number of coordinates is asserted
+    TEST(parenthesis_operator_variadic_count)
+    {   Matrix<int> m({3,4}) ;
+        for(int n_coord : {1, 3})
+        {   pid_t pid = fork() ;
+            if(pid == 0)
+            {   // no core dump nor message from the child
+                struct rlimit limit = {0, 0} ;
+                setrlimit(RLIMIT_CORE, &limit) ;
+                close(STDERR_FILENO) ;
+                int value = n_coord == 1 ? m(2) : m(2, 3, 1) ;
+                _exit(value == 0 ? 0 : 1) ;
+            }
+            int status = 0 ;
+            waitpid(pid, &status, 0) ;
+            CHECK(WIFSIGNALED(status) and WTERMSIG(status) == SIGABRT) ;
+        }
+    }
+#endif
+}
+
+
+SUITE(MatrixKernels)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixKernels tests..." << std::endl ; }
+
+    // the vectorized kernels are only selected when the tests are
+    // compiled for AVX2 or AVX-512, as the unittests_avx2 program
+    TEST(vectorized)
+    {
+#if defined(__AVX512F__) || defined(__AVX2__)
+        bool simd = true ;
+#else
+        bool simd = false ;
+#endif
+        CHECK_EQUAL(simd, bool(kernel_add::vectorized<int>::value)) ;
+        CHECK_EQUAL(simd, bool(kernel_sub::vectorized<float>::value)) ;
+        CHECK_EQUAL(simd, bool(kernel_mul::vectorized<double>::value)) ;
+        CHECK_EQUAL(simd, bool(kernel_div::vectorized<float>::value)) ;
+        CHECK_EQUAL(simd, bool(kernel_div::vectorized<double>::value)) ;
+        CHECK_EQUAL(false, bool(kernel_div::vectorized<int>::value)) ;
+        CHECK_EQUAL(false, bool(kernel_add::vectorized<long>::value)) ;
+    }
+
+    // tests the kernels against the scalar kernels, 70 values
+    // filling several registers of 16 values and the offsets
+    // covering any misalignment of a 64 bytes register
+    TEST(kernels)
+    {   size_t n_max = 70, offset_max = 16 ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_add,int>(kernel_add_arrays<int>, kernel_add_value<int>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_sub,int>(kernel_sub_arrays<int>, kernel_sub_value<int>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_mul,int>(kernel_mul_arrays<int>, kernel_mul_value<int>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_div,int>(kernel_div_arrays<int>, kernel_div_value<int>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_add,float>(kernel_add_arrays<float>, kernel_add_value<float>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_sub,float>(kernel_sub_arrays<float>, kernel_sub_value<float>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_mul,float>(kernel_mul_arrays<float>, kernel_mul_value<float>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_div,float>(kernel_div_arrays<float>, kernel_div_value<float>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_add,double>(kernel_add_arrays<double>, kernel_add_value<double>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_sub,double>(kernel_sub_arrays<double>, kernel_sub_value<double>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_mul,double>(kernel_mul_arrays<double>, kernel_mul_value<double>, n_max, offset_max))) ;
+        CHECK_EQUAL(0, (count_kernel_errors<kernel_div,double>(kernel_div_arrays<double>, kernel_div_value<double>, n_max, offset_max))) ;
+        // in place
+        std::vector<float> a(37, 2.f), b(37, 4.f) ;
+        kernel_div_arrays(a.data() + 1, b.data() + 1, a.data() + 1, 36) ;
+        kernel_mul_value(a.data() + 1, 3.f, a.data() + 1, 36) ;
+        CHECK_EQUAL(2.f, a[0]) ;
+        for(size_t i=1; i<a.size(); i++)
+        {   CHECK_EQUAL(1.5f, a[i]) ; }
+    }
+
+    // tests the evaluation of the expressions, register by register
+    // and on the remainder, against a scalar evaluation
+    TEST(expression)
+    {   for(size_t n=0; n<=40; n++)
+        {   Matrix2D<int>    m1(3, n), m2(3, n) ;
+            Matrix2D<float>  m3(3, n), m4(3, n) ;
+            Matrix2D<double> m5(3, n), m6(3, n) ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   m1.set(j, 3*static_cast<int>(j) - 50) ;
+                m2.set(j, j % 7 + 1) ;
+                m3.set(j, 0.5f*j - 10.f) ;
+                m4.set(j, j % 5 + 1.f) ;
+                m5.set(j, 0.25*j - 7.) ;
+                m6.set(j, j % 3 + 1.) ;
+            }
+            Matrix2D<int>    r1 = m1 * 2 + m2 - m1 / m2 ;
+            Matrix2D<float>  r2 = m3 * 2.f + m4 - m3 / m4 ;
+            Matrix2D<double> r3 = (m5 - m6) * m6 / (m6 + 1.) ;
+            for(size_t j=0; j<m1.get_data_size(); j++)
+            {   CHECK_EQUAL(m1.get(j) * 2 + m2.get(j) - m1.get(j) / m2.get(j), r1.get(j)) ;
+                CHECK_EQUAL(m3.get(j) * 2.f + m4.get(j) - m3.get(j) / m4.get(j), r2.get(j)) ;
+                CHECK_EQUAL((m5.get(j) - m6.get(j)) * m6.get(j) / (m6.get(j) + 1.), r3.get(j)) ;
+            }
+        }
+    }
 }
 
 
@@ -795,6 +1228,27 @@ SUITE(Matrix2D)
         }
     }
 
+    // tests the contructor without initialization
+    TEST(constructor_uninitialized)
+    {   for(size_t i=0; i<10; i++)
+        {   for(size_t j=0; j<10; j++)
+            {   std::vector<size_t> dim = {i,j} ;
+                Matrix2D<int> m(i,j,matrix_uninitialized) ;
+                CHECK_EQUAL(dim.size(), m.get_dim_size()) ;
+                CHECK_ARRAY_EQUAL(dim, m.get_dim(), dim.size()) ;
+                CHECK_EQUAL(std::accumulate(begin(dim), end(dim), 1, std::multiplies<int>()),
+                            m.get_data_size()) ;
+                // the offsets are set
+                for(size_t r=0; r<i; r++)
+                {   for(size_t c=0; c<j; c++)
+                    {   m(r,c) = r*j + c ; }
+                }
+                for(size_t k=0; k<m.get_data_size(); k++)
+                {   CHECK_EQUAL(k, m.get(k)) ; }
+            }
+        }
+    }
+
     // tests the copy constructor
     TEST(constructor_copy)
     {
@@ -1276,6 +1730,255 @@ SUITE(Matrix2D)
         // division by 0
         CHECK_THROW(m9 / 0, std::invalid_argument) ;
     }
+
+    // tests the element-wise operators between two matrices
+    TEST(operator_elementwise)
+    {   Matrix2D<double> m1(7, 9), m2(7, 9) ;
+        for(size_t j=0; j<m1.get_data_size(); j++)
+        {   m1.set(j, 2.*j) ;
+            m2.set(j, j+1.) ;
+        }
+        Matrix2D<double> m3 = m1 + m2, m4 = m1 - m2, m5 = m1 * m2, m6 = m1 / m2 ;
+        for(size_t j=0; j<m1.get_data_size(); j++)
+        {   CHECK_EQUAL(2.*j + j+1., m3.get(j)) ;
+            CHECK_EQUAL(2.*j - (j+1.), m4.get(j)) ;
+            CHECK_EQUAL(2.*j * (j+1.), m5.get(j)) ;
+            CHECK_EQUAL(2.*j / (j+1.), m6.get(j)) ;
+        }
+        // in place
+        m3 -= m2 ;
+        CHECK_EQUAL(m1, m3) ;
+        m5 /= m2 ;
+        CHECK_EQUAL(m1, m5) ;
+
+        // dimensions differ
+        Matrix2D<double> m7(9, 7) ;
+        CHECK_THROW(m1 + m7, std::invalid_argument) ;
+        CHECK_THROW(m1 *= m7, std::invalid_argument) ;
+    }
+
+    // tests the matrix product against a naive implementation
+    TEST(multiply)
+    {   // sizes which are not multiple of any blocking parameter
+        std::vector<std::vector<size_t>> sizes = {{1, 1, 1},
+                                                  {7, 13, 5},
+                                                  {37, 300, 301},
+                                                  {100, 3, 270},
+                                                  {6, 17, 1}} ;
+        ThreadPool pool(3) ;
+        for(const auto& size : sizes)
+        {   size_t m = size[0], k = size[1], n = size[2] ;
+            Matrix2D<int> a(m, k), b(k, n), c(m, n, 0) ;
+            Matrix2D<double> a2(m, k), b2(k, n), c2(m, n, 0.) ;
+            for(size_t i=0; i<a.get_data_size(); i++)
+            {   a.set(i, static_cast<int>(i % 11) - 5) ;
+                a2.set(i, 0.25 * a.get(i)) ;
+            }
+            for(size_t i=0; i<b.get_data_size(); i++)
+            {   b.set(i, static_cast<int>(i % 7) - 3) ;
+                b2.set(i, 0.5 * b.get(i)) ;
+            }
+            for(size_t i=0; i<m; i++)
+            {   for(size_t j=0; j<n; j++)
+                {   for(size_t l=0; l<k; l++)
+                    {   c(i,j)  += a(i,l) * b(l,j) ;
+                        c2(i,j) += a2(i,l) * b2(l,j) ;
+                    }
+                }
+            }
+            CHECK_EQUAL(c, multiply(a, b)) ;
+            CHECK_EQUAL(c, multiply(a, b, pool)) ;
+            // values are exactly representable
+            CHECK_EQUAL(c2, multiply(a2, b2)) ;
+        }
+
+        // empty inner dimension
+        Matrix2D<double> m1(4, 0), m2(0, 5) ;
+        CHECK_EQUAL(Matrix2D<double>(4, 5, 0.), multiply(m1, m2)) ;
+
+        // dimensions do not match
+        Matrix2D<double> m3(4, 5), m4(4, 5) ;
+        CHECK_THROW(multiply(m3, m4), std::invalid_argument) ;
+    }
+
+    // tests the transposition against a naive implementation
+    template<class T>
+    void check_transpose(size_t nrow, size_t ncol)
+    {   Matrix2D<T> m(nrow, ncol), t(ncol, nrow) ;
+        for(size_t i=0; i<nrow; i++)
+        {   for(size_t j=0; j<ncol; j++)
+            {   m(i,j) = static_cast<T>((i*ncol + j) % 101) ;
+                t(j,i) = m(i,j) ;
+            }
+        }
+        CHECK_EQUAL(t, transpose(m)) ;
+        transpose_in_place(m) ;
+        CHECK_EQUAL(t, m) ;
+    }
+
+    TEST(transpose)
+    {   // square and rectangular, with partial tiles and blocks, the
+        // largest ones being transposed in parallel
+        std::vector<std::vector<size_t>> sizes = {{0, 5},
+                                                  {1, 1},
+                                                  {5, 5},
+                                                  {8, 8},
+                                                  {3, 200},
+                                                  {130, 67},
+                                                  {129, 129},
+                                                  {300, 300},
+                                                  {257, 301}} ;
+        for(const auto& size : sizes)
+        {   check_transpose<int>(size[0], size[1]) ;
+            check_transpose<float>(size[0], size[1]) ;
+            check_transpose<double>(size[0], size[1]) ;
+            check_transpose<long long>(size[0], size[1]) ;
+            check_transpose<char>(size[0], size[1]) ;
+        }
+    }
+
+    // tests the views on rows, columns and blocks
+    TEST(views)
+    {   Matrix2D<int> m(5, 7) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i) ; }
+        const Matrix2D<int>& m_const = m ;
+
+        // rows and columns, read through iterators and coordinates
+        for(size_t i=0; i<m.get_nrow(); i++)
+        {   MatrixView<const int> row = m_const.get_row_view(i) ;
+            CHECK_EQUAL(1, row.get_dim_size()) ;
+            CHECK_EQUAL(m.get_ncol(), row.get_data_size()) ;
+            CHECK_EQUAL(true, row.is_contiguous()) ;
+            CHECK_EQUAL(m.get_row(i), row.to_vector()) ;
+            for(size_t j=0; j<m.get_ncol(); j++)
+            {   CHECK_EQUAL(m(i,j), row(j)) ; }
+        }
+        for(size_t i=0; i<m.get_ncol(); i++)
+        {   MatrixView<int> col = m.get_col_view(i) ;
+            CHECK_EQUAL(m.get_nrow(), col.get_data_size()) ;
+            CHECK_EQUAL(false, col.is_contiguous()) ;
+            CHECK_EQUAL(m.get_col(i), col.to_vector()) ;
+            CHECK_EQUAL(m.get(2,i), col.get({2})) ;
+        }
+        CHECK_THROW(m.get_row_view(5), std::out_of_range) ;
+        CHECK_THROW(m.get_col_view(7), std::out_of_range) ;
+
+        // blocks
+        MatrixView<int> block = m.get_block_view(1, 2, 3, 4) ;
+        std::vector<size_t> dim = {3, 4} ;
+        CHECK_ARRAY_EQUAL(dim, block.get_dim(), 2) ;
+        std::vector<int> values ;
+        for(size_t i=1; i<4; i++)
+        {   for(size_t j=2; j<6; j++)
+            {   values.push_back(m(i,j)) ;
+                CHECK_EQUAL(m(i,j), block(i-1, j-2)) ;
+            }
+        }
+        CHECK_EQUAL(values, block.to_vector()) ;
+        CHECK_EQUAL(values, std::vector<int>(block.begin(), block.end())) ;
+        CHECK_THROW(block.get({3,0}), std::out_of_range) ;
+        CHECK_THROW(m.get_block_view(3, 2, 3, 4), std::out_of_range) ;
+        CHECK_EQUAL(0, m.get_block_view(5, 7, 0, 0).get_data_size()) ;
+
+        // writes through the views
+        Matrix2D<int> m2(m) ;
+        block *= 2 ;
+        block += 1 ;
+        for(size_t i=0; i<m.get_nrow(); i++)
+        {   for(size_t j=0; j<m.get_ncol(); j++)
+            {   bool in_block = i>=1 and i<4 and j>=2 and j<6 ;
+                CHECK_EQUAL(in_block ? 2*m2(i,j)+1 : m2(i,j), m(i,j)) ;
+            }
+        }
+        m.get_col_view(0).fill(-1) ;
+        CHECK_EQUAL(std::vector<int>(5, -1), m.get_col(0)) ;
+        m.get_row_view(4).set({6}, 100) ;
+        CHECK_EQUAL(100, m(4,6)) ;
+        for(auto& x : m.get_row_view(0))
+        {   x = 3 ; }
+        CHECK_EQUAL(std::vector<int>(7, 3), m.get_row(0)) ;
+        m.get_col_view(1) /= 3 ;
+        CHECK_EQUAL(1, m(0,1)) ;
+        CHECK_THROW(m.get_col_view(1) /= 0, std::invalid_argument) ;
+
+        // copies between views
+        m.get_block_view(0, 0, 2, 2).assign(m2.get_block_view(3, 5, 2, 2)) ;
+        CHECK_EQUAL(true, m.get_block_view(0, 0, 2, 2) == m2.get_block_view(3, 5, 2, 2)) ;
+        CHECK_EQUAL(true, m.get_block_view(0, 0, 2, 2) != m2.get_block_view(0, 0, 2, 2)) ;
+        CHECK_THROW(m.get_row_view(0).assign(m.get_col_view(0)), std::invalid_argument) ;
+    }
+
+#ifndef NDEBUG
+    // tests that a wrong number of coordinates of a view is asserted
+    TEST(views_parenthesis_operator_count)
+    {   Matrix2D<int> m(5, 7) ;
+        MatrixView<int> block = m.get_block_view(1, 2, 3, 4) ;
+        for(int n_coord : {1, 3})
+        {   pid_t pid = fork() ;
+            if(pid == 0)
+            {   // no core dump nor message from the child
+                struct rlimit limit = {0, 0} ;
+                setrlimit(RLIMIT_CORE, &limit) ;
+                close(STDERR_FILENO) ;
+                int value = n_coord == 1 ? block(2) : block(2, 3, 1) ;
+                _exit(value == 0 ? 0 : 1) ;
+            }
+            int status = 0 ;
+            waitpid(pid, &status, 0) ;
+            CHECK(WIFSIGNALED(status) and WTERMSIG(status) == SIGABRT) ;
+        }
+    }
+#endif
+
+    // tests mapping binary files in memory
+    TEST(map)
+    {   std::string file_address = "./src/Unittests/data/matrix2d_out.bin" ;
+        Matrix2D<double> m(13, 7) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i/3.) ; }
+        m.save(file_address) ;
+
+        // read only
+        Matrix2D<double> m2 ;
+        m2.map(file_address) ;
+        CHECK_EQUAL(m, m2) ;
+        CHECK_EQUAL(m.get_row(12), m2.get_row(12)) ;
+        CHECK_EQUAL(m(5,3), m2(5,3)) ;
+        // copies are in memory and can be modified
+        Matrix2D<double> m3(m2) ;
+        m3(0,0) = -1. ;
+        CHECK_EQUAL(m, m2) ;
+        CHECK_EQUAL(-1., m3(0,0)) ;
+
+        // copy on write, the file is not modified
+        Matrix2D<double> m4 ;
+        m4.map(file_address, MatrixMapMode::copy_on_write) ;
+        CHECK_EQUAL(m, m4) ;
+        m4 += 1. ;
+        m4.set(2, 5, -3.) ;
+        CHECK_EQUAL(m(1,1) + 1., m4(1,1)) ;
+        CHECK_EQUAL(-3., m4(2,5)) ;
+        CHECK_EQUAL(m, m2) ;
+        Matrix2D<double> m5 ;
+        m5.load(file_address) ;
+        CHECK_EQUAL(m, m5) ;
+
+        // through a Matrix reference, the offsets follow the dimensions
+        Matrix2D<double> m7(2, 2) ;
+        Matrix<double>& m7_base = m7 ;
+        m7_base.map(file_address, 2, MatrixMapMode::read_only) ;
+        CHECK_EQUAL(m(12,6), m7(12,6)) ;
+        CHECK_EQUAL(m.get_row(12), m7.get_row(12)) ;
+        CHECK_THROW(m7_base.map(file_address, 3, MatrixMapMode::read_only), std::invalid_argument) ;
+
+        // invalid files
+        Matrix3D<double> m6 ;
+        CHECK_THROW(m6.map(file_address), std::runtime_error) ;
+        CHECK_THROW(m2.map("./src/Unittests/data/does_not_exist.bin"), std::runtime_error) ;
+        CHECK_EQUAL(m, m2) ;
+        remove(file_address.c_str()) ;
+    }
 }
 
 
@@ -1415,6 +2118,33 @@ SUITE(Matrix3D)
         CHECK_ARRAY_EQUAL(v_int, m_double.get_data(), v_int.size()) ;
     }
 
+    // tests loading files with different numbers of threads
+    TEST(constructor_file_parallel)
+    {   std::string file_address = "./src/Unittests/data/matrix3d_out.mat" ;
+        Matrix3D<double> m(7, 5, 23) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i/4.) ; }
+        std::ofstream file(file_address) ;
+        file << m << std::endl ;
+        file.close() ;
+        for(size_t n_threads=1; n_threads<6; n_threads+=2)
+        {   ThreadPool pool(n_threads) ;
+            CHECK_EQUAL(m, Matrix3D<double>(file_address, pool)) ;
+        }
+
+        // the last slice has a missing row, a column or an extra row
+        std::vector<std::string> contents = {",,0\n1 2\n3 4\n,,1\n5 6\n",
+                                             ",,0\n1 2\n3 4\n,,1\n5 6\n7\n",
+                                             ",,0\n1 2\n3 4\n,,1\n5 6\n7 8\n9 10\n",
+                                             ",,0\n1 2\n3 4\n,,1\n"} ;
+        for(const auto& content : contents)
+        {   file.open(file_address) ;
+            file << content ;
+            file.close() ;
+            CHECK_THROW(Matrix3D<int>(file_address, ThreadPool::get_default()), std::runtime_error) ;
+        }
+    }
+
     // tests get()
     TEST(get)
     {   int n = 999 ;
@@ -1631,6 +2361,93 @@ SUITE(Matrix3D)
         // division by 0
         CHECK_THROW(m9 / 0, std::invalid_argument) ;
     }
+
+    // tests the construction and assignment from expressions
+    TEST(expression)
+    {   Matrix3D<int> m1(4, 5, 6), m2(4, 5, 6) ;
+        for(size_t j=0; j<m1.get_data_size(); j++)
+        {   m1.set(j, j) ;
+            m2.set(j, 1) ;
+        }
+        Matrix3D<int> m3 = m1 * 2 + m2 ;
+        Matrix3D<int> m4(1, 1, 1) ;
+        m4 = m3 - m1 ;
+        for(size_t i=0; i<4; i++)
+        {   for(size_t j=0; j<5; j++)
+            {   for(size_t k=0; k<6; k++)
+                {   CHECK_EQUAL(2*m1(i,j,k) + 1, m3(i,j,k)) ;
+                    CHECK_EQUAL(m1(i,j,k) + 1, m4(i,j,k)) ;
+                }
+            }
+        }
+        // not a 3D matrix
+        Matrix<int> m5({4, 5}) ;
+        CHECK_THROW(Matrix3D<int> m6(m5 + 1), std::invalid_argument) ;
+        CHECK_THROW(m4 = m5 * 2, std::invalid_argument) ;
+    }
+
+    // tests the element-wise operators between two matrices
+    TEST(operator_elementwise)
+    {   Matrix3D<double> m1(7, 9, 3), m2(7, 9, 3) ;
+        for(size_t j=0; j<m1.get_data_size(); j++)
+        {   m1.set(j, 2.*j) ;
+            m2.set(j, j+1.) ;
+        }
+        Matrix3D<double> m3 = m1 + m2, m4 = m1 - m2, m5 = m1 * m2, m6 = m1 / m2 ;
+        for(size_t j=0; j<m1.get_data_size(); j++)
+        {   CHECK_EQUAL(2.*j + j+1., m3.get(j)) ;
+            CHECK_EQUAL(2.*j - (j+1.), m4.get(j)) ;
+            CHECK_EQUAL(2.*j * (j+1.), m5.get(j)) ;
+            CHECK_EQUAL(2.*j / (j+1.), m6.get(j)) ;
+        }
+        // in place
+        m3 -= m2 ;
+        CHECK_EQUAL(m1, m3) ;
+        m5 /= m2 ;
+        CHECK_EQUAL(m1, m5) ;
+
+        // dimensions differ
+        Matrix3D<double> m7(7, 3, 9) ;
+        CHECK_THROW(m1 + m7, std::invalid_argument) ;
+        CHECK_THROW(m1 *= m7, std::invalid_argument) ;
+    }
+
+    // tests the views on the 3rd dimension slices
+    TEST(slice_view)
+    {   Matrix3D<double> m(3, 4, 5) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i) ; }
+        for(size_t k=0; k<5; k++)
+        {   MatrixView<double> slice = m.get_slice_view(k) ;
+            std::vector<size_t> dim = {3, 4} ;
+            CHECK_ARRAY_EQUAL(dim, slice.get_dim(), 2) ;
+            CHECK_EQUAL(true, slice.is_contiguous()) ;
+            for(size_t i=0; i<3; i++)
+            {   for(size_t j=0; j<4; j++)
+                {   CHECK_EQUAL(m(i,j,k), slice(i,j)) ; }
+            }
+            // the elements are iterated in storage order
+            size_t n = k*12 ;
+            for(const auto& x : slice)
+            {   CHECK_EQUAL(static_cast<double>(n++), x) ; }
+        }
+        CHECK_THROW(m.get_slice_view(5), std::out_of_range) ;
+
+        // rows along the 3rd dimension, and writes
+        MatrixView<double> line = m.get_view().slice(0, 1).slice(0, 2) ;
+        CHECK_EQUAL(5, line.get_data_size()) ;
+        for(size_t k=0; k<5; k++)
+        {   CHECK_EQUAL(m(1,2,k), line(k)) ; }
+        m.get_slice_view(2) -= 1000. ;
+        CHECK_EQUAL(24. - 1000., m(0,0,2)) ;
+        CHECK_EQUAL(23., m(2,3,1)) ;
+        CHECK_EQUAL(36., m(0,0,3)) ;
+
+        const Matrix3D<double>& m_const = m ;
+        MatrixView<const double> block = m_const.get_view().block({1,1,1}, {2,2,3}) ;
+        CHECK_EQUAL(12, block.get_data_size()) ;
+        CHECK_EQUAL(m(2,2,3), block(1,1,2)) ;
+    }
 }
 
 
@@ -1808,6 +2625,34 @@ SUITE(Matrix4D)
         CHECK_ARRAY_EQUAL(v_dbl, m_dbl.get_data(), v_dbl.size()) ;
     }
 
+    // tests loading files with different numbers of threads
+    TEST(constructor_file_parallel)
+    {   std::string file_address = "./src/Unittests/data/matrix4d_out.mat" ;
+        Matrix4D<int> m(3, 6, 5, 7) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i) ; }
+        std::ofstream file(file_address) ;
+        file << m << std::endl ;
+        file.close() ;
+        for(size_t n_threads=1; n_threads<6; n_threads+=2)
+        {   ThreadPool pool(n_threads) ;
+            CHECK_EQUAL(m, Matrix4D<int>(file_address, pool)) ;
+        }
+
+        // the 3D slices have different numbers of 2D slices or a 2D slice
+        // has a different number of rows
+        std::vector<std::string> contents = {",,,0\n,,0\n1 2\n,,1\n3 4\n,,,1\n,,0\n5 6\n",
+                                             ",,,0\n,,0\n1 2\n,,,1\n,,0\n5 6\n,,1\n7 8\n",
+                                             ",,,0\n,,0\n1 2\n,,,1\n,,0\n5 6\n7 8\n",
+                                             ",,,0\n1 2\n,,0\n1 2\n"} ;
+        for(const auto& content : contents)
+        {   file.open(file_address) ;
+            file << content ;
+            file.close() ;
+            CHECK_THROW(Matrix4D<int>(file_address, ThreadPool::get_default()), std::runtime_error) ;
+        }
+    }
+
     // tests get()
     TEST(get)
     {   int n = 999 ;
@@ -2012,5 +2857,2280 @@ SUITE(Matrix4D)
         // division by 0
         CHECK_THROW(m9 / 0, std::invalid_argument) ;
     }
+
+    // tests the element-wise operators between two matrices
+    TEST(operator_elementwise)
+    {   Matrix4D<double> m1(7, 9, 3, 2), m2(7, 9, 3, 2) ;
+        for(size_t j=0; j<m1.get_data_size(); j++)
+        {   m1.set(j, 2.*j) ;
+            m2.set(j, j+1.) ;
+        }
+        Matrix4D<double> m3 = m1 + m2, m4 = m1 - m2, m5 = m1 * m2, m6 = m1 / m2 ;
+        for(size_t j=0; j<m1.get_data_size(); j++)
+        {   CHECK_EQUAL(2.*j + j+1., m3.get(j)) ;
+            CHECK_EQUAL(2.*j - (j+1.), m4.get(j)) ;
+            CHECK_EQUAL(2.*j * (j+1.), m5.get(j)) ;
+            CHECK_EQUAL(2.*j / (j+1.), m6.get(j)) ;
+        }
+        // in place
+        m3 -= m2 ;
+        CHECK_EQUAL(m1, m3) ;
+        m5 /= m2 ;
+        CHECK_EQUAL(m1, m5) ;
+
+        // dimensions differ
+        Matrix4D<double> m7(7, 9, 2, 3) ;
+        CHECK_THROW(m1 + m7, std::invalid_argument) ;
+        CHECK_THROW(m1 *= m7, std::invalid_argument) ;
+    }
+
+    // tests the views on the 3D and 2D slices
+    TEST(slice_view)
+    {   Matrix4D<int> m(3, 4, 5, 2) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i) ; }
+        for(size_t l=0; l<2; l++)
+        {   MatrixView<int> slice = m.get_slice_view(l) ;
+            std::vector<size_t> dim = {3, 4, 5} ;
+            CHECK_ARRAY_EQUAL(dim, slice.get_dim(), 3) ;
+            for(size_t k=0; k<5; k++)
+            {   MatrixView<int> slice2 = m.get_slice_view(k, l) ;
+                CHECK_EQUAL(12, slice2.get_data_size()) ;
+                for(size_t i=0; i<3; i++)
+                {   for(size_t j=0; j<4; j++)
+                    {   CHECK_EQUAL(m(i,j,k,l), slice(i,j,k)) ;
+                        CHECK_EQUAL(m(i,j,k,l), slice2(i,j)) ;
+                    }
+                }
+            }
+            // the elements are iterated in storage order
+            int n = l*60 ;
+            for(const auto& x : slice)
+            {   CHECK_EQUAL(n++, x) ; }
+        }
+        CHECK_THROW(m.get_slice_view(2), std::out_of_range) ;
+        CHECK_THROW(m.get_slice_view(5, 0), std::out_of_range) ;
+
+        // writes
+        m.get_slice_view(1) *= -1 ;
+        m.get_slice_view(3, 0).fill(7) ;
+        CHECK_EQUAL(-(3*4*5 + 5), m(1,1,0,1)) ;
+        CHECK_EQUAL(7, m(2,3,3,0)) ;
+        CHECK_EQUAL(3*4*4, m(0,0,4,0)) ;
+    }
+
+    // tests mapping binary files in memory
+    TEST(map)
+    {   std::string file_address = "./src/Unittests/data/matrix4d_out.bin" ;
+        Matrix4D<int> m(3, 4, 5, 2) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i) ; }
+        m.save(file_address) ;
+
+        Matrix4D<int> m2 ;
+        m2.map(file_address) ;
+        CHECK_EQUAL(m, m2) ;
+        CHECK_EQUAL(m(2,3,4,1), m2(2,3,4,1)) ;
+        CHECK_EQUAL(m(1,2,3,0), m2.get_slice_view(3, 0)(1,2)) ;
+
+        Matrix4D<int> m3 ;
+        m3.map(file_address, MatrixMapMode::copy_on_write) ;
+        m3.get_slice_view(1) *= -1 ;
+        CHECK_EQUAL(-m(2,3,4,1), m3(2,3,4,1)) ;
+        CHECK_EQUAL(m, m2) ;
+
+        MatrixN<int,4> m4 ;
+        m4.map(file_address) ;
+        CHECK_EQUAL(m(2,1,3,1), m4(2,1,3,1)) ;
+        CHECK_THROW(Matrix2D<int>().map(file_address), std::runtime_error) ;
+
+        // through a Matrix reference, the offsets follow the dimensions
+        Matrix4D<int> m5(1, 1, 1, 1) ;
+        Matrix<int>& m5_base = m5 ;
+        m5_base.map(file_address, 4, MatrixMapMode::read_only) ;
+        CHECK_EQUAL(m(2,3,4,1), m5(2,3,4,1)) ;
+        CHECK_THROW(m5_base.map(file_address, 3, MatrixMapMode::read_only), std::invalid_argument) ;
+        std::string file_address_3d = "./src/Unittests/data/matrix3d_out.bin" ;
+        Matrix3D<int> m6(3, 4, 5), m7(1, 1, 1) ;
+        for(size_t i=0; i<m6.get_data_size(); i++)
+        {   m6.set(i, i) ; }
+        m6.save(file_address_3d) ;
+        Matrix<int>& m7_base = m7 ;
+        m7_base.map(file_address_3d, 3, MatrixMapMode::read_only) ;
+        CHECK_EQUAL(m6(2,3,4), m7(2,3,4)) ;
+        remove(file_address_3d.c_str()) ;
+        remove(file_address.c_str()) ;
+    }
+}
+
+
+SUITE(MatrixN)
+{   // displays message
+    TEST(message)
+    {   std::cout << "Starting MatrixN tests..." << std::endl ; }
+
+    // tests contructor
+    TEST(constructor)
+    {   MatrixN<int,3> m1({2,3,4}), m2({2,3,4}, 7) ;
+        std::vector<size_t> dim = {2,3,4} ;
+        CHECK_EQUAL(3, m1.get_dim_size()) ;
+        CHECK_ARRAY_EQUAL(dim, m1.get_dim(), 3) ;
+        CHECK_ARRAY_EQUAL(dim, m1.get_dim_array(), 3) ;
+        CHECK_EQUAL(24, m1.get_data_size()) ;
+        CHECK_EQUAL(Matrix<int>(dim, 0), m1) ;
+        CHECK_EQUAL(Matrix<int>(dim, 7), m2) ;
+
+        // conversions from matrices with N dimensions only
+        Matrix3D<int> m3(2,3,4,5) ;
+        MatrixN<int,3> m4(m3) ;
+        CHECK_EQUAL(m3, m4) ;
+        CHECK_THROW((MatrixN<int,2>(m3)), std::invalid_argument) ;
+    }
+
+    // tests the strides
+    TEST(strides)
+    {   MatrixN<int,1> m1({5}) ;
+        MatrixN<int,2> m2({5,6}) ;
+        MatrixN<int,4> m4({5,6,7,8}) ;
+        std::vector<size_t> strides1 = {1} ;
+        std::vector<size_t> strides2 = {6,1} ;
+        std::vector<size_t> strides4 = {6,1,30,210} ;
+        CHECK_ARRAY_EQUAL(strides1, m1.get_strides(), 1) ;
+        CHECK_ARRAY_EQUAL(strides2, m2.get_strides(), 2) ;
+        CHECK_ARRAY_EQUAL(strides4, m4.get_strides(), 4) ;
+    }
+
+    // tests the () operator against the other matrix classes
+    TEST(parenthesis_operator)
+    {   Matrix2D<int> m2(4,5) ;
+        Matrix3D<int> m3(4,5,6) ;
+        Matrix4D<int> m4(4,5,6,3) ;
+        for(size_t j=0; j<m4.get_data_size(); j++)
+        {   m4.set(j,j) ;
+            if(j < m2.get_data_size())
+            {   m2.set(j,j) ; }
+            if(j < m3.get_data_size())
+            {   m3.set(j,j) ; }
+        }
+        MatrixN<int,2> n2(m2) ;
+        MatrixN<int,3> n3(m3) ;
+        MatrixN<int,4> n4(m4) ;
+        for(size_t i=0; i<4; i++)
+        {   for(size_t j=0; j<5; j++)
+            {   CHECK_EQUAL(m2(i,j), n2(i,j)) ;
+                for(size_t k=0; k<6; k++)
+                {   CHECK_EQUAL(m3(i,j,k), n3(i,j,k)) ;
+                    for(size_t l=0; l<3; l++)
+                    {   CHECK_EQUAL(m4(i,j,k,l), n4(i,j,k,l)) ;
+                        CHECK_EQUAL(m4.get(i,j,k,l), n4.get_data_ptr()[n4.get_offset(i,j,k,l)]) ;
+                    }
+                }
+            }
+        }
+        // write access
+        n3(1,2,3) = -1 ;
+        CHECK_EQUAL(-1, n3.get({1,2,3})) ;
+    }
+
+    // tests that the strides follow the dimensions of the matrices loaded
+    TEST(load)
+    {   std::string file_address = "./src/Unittests/data/matrixn_out.bin" ;
+        Matrix3D<int> m(2,3,4) ;
+        for(size_t j=0; j<m.get_data_size(); j++)
+        {   m.set(j,j) ; }
+        m.save(file_address) ;
+
+        MatrixN<int,3> n1({4,4,4}), n2({1,1,1}), n3({5,2,1}) ;
+        Matrix<int>& n3_base = n3 ;
+        n1.load(file_address) ;
+        n2.load(file_address, 3) ;
+        n3_base.load(file_address, 3) ;
+        for(const MatrixN<int,3>* n : {&n1, &n2, &n3})
+        {   CHECK_EQUAL((std::array<size_t,3>({2,3,4})), n->get_dim_array()) ;
+            CHECK_EQUAL(23, (*n)(1,2,3)) ;
+            for(size_t i=0; i<2; i++)
+            {   for(size_t j=0; j<3; j++)
+                {   for(size_t k=0; k<4; k++)
+                    {   CHECK_EQUAL(m(i,j,k), (*n)(i,j,k)) ; }
+                }
+            }
+        }
+        MatrixN<int,3> n4({4,4,4}) ;
+        n4.map(file_address) ;
+        CHECK_EQUAL(23, n4(1,2,3)) ;
+        CHECK_THROW(n4.load(file_address, 2), std::invalid_argument) ;
+        remove(file_address.c_str()) ;
+    }
+
+    // tests the expressions and assignments
+    TEST(expression)
+    {   MatrixN<double,3> m1({2,3,4}, 1.), m2({2,3,4}, 2.) ;
+        MatrixN<double,3> m3 = m1 + m2 * 2. ;
+        CHECK_EQUAL((MatrixN<double,3>({2,3,4}, 5.)), m3) ;
+        m3 = m1 ;
+        CHECK_EQUAL(m1, m3) ;
+        m3 = MatrixN<double,3>({3,3,3}, 2.) - m2(0,0,0) ;
+        CHECK_EQUAL(0., m3(2,2,2)) ;
+        CHECK_EQUAL(1, m3.get_strides()[2] / 9) ;
+        MatrixN<double,2> m4({2,2}) ;
+        CHECK_THROW(m4 = m1 + m2, std::invalid_argument) ;
+    }
+}
+
+
+SUITE(MatrixTextParser)
+{   // displays message
+    TEST(message)
+    {   std::cout << "Starting MatrixTextParser tests..." << std::endl ; }
+
+    // tests reading lines, with blocks smaller than the lines
+    TEST(reader)
+    {   std::string file_address = "./src/Unittests/data/matrix_text_out.mat" ;
+        std::vector<std::string> lines = {",,0", "", "1 2 3 4 5 6 7 8 9 10 11 12", "  ", "a", "last"} ;
+        for(size_t last_eol=0; last_eol<2; last_eol++)
+        {   std::ofstream file(file_address) ;
+            for(size_t i=0; i<lines.size(); i++)
+            {   file << lines[i] ;
+                if(i+1 < lines.size() or last_eol)
+                {   file << std::endl ; }
+            }
+            file.close() ;
+            for(size_t block_size=1; block_size<32; block_size+=5)
+            {   MatrixTextReader reader(file_address, block_size) ;
+                const char* line = nullptr ;
+                const char* line_end = nullptr ;
+                for(const auto& l : lines)
+                {   CHECK_EQUAL(false, reader.eof()) ;
+                    CHECK_EQUAL(true, reader.getline(line, line_end)) ;
+                    CHECK_EQUAL(l, std::string(line, line_end)) ;
+                }
+                CHECK_EQUAL(true, reader.eof()) ;
+                CHECK_EQUAL(false, reader.getline(line, line_end)) ;
+            }
+        }
+        CHECK_THROW(MatrixTextReader("./src/Unittests/data/foo.mat"), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+
+    // tests parsing values, the results should be the same as with operator >>
+    TEST(parse)
+    {   std::string str = "0 -0 1. -1.5 .25 3.14159265358979323846 1e10 -2.5E-3 1e22 1e23 "
+                          "123456789012345678901234567890 0.1 0.7 1e-320 4.9e-324 "
+                          "1.7976931348623157e308 +42 9007199254740993 1234.5678e-2" ;
+        std::vector<double> values ;
+        CHECK_EQUAL(true, parse_text_line(str.data(), str.data() + str.size(), values)) ;
+        std::istringstream stream(str) ;
+        double x ;
+        size_t n = 0 ;
+        while(stream >> x)
+        {   CHECK_EQUAL(x, values[n++]) ; }
+        CHECK_EQUAL(n, values.size()) ;
+        // floats
+        str = "0 -0 1. -1.5 .25 3.14159265358979323846 1e10 -2.5E-3 1e22 16777217 "
+              "0.1 0.7 3.4028234e38 1.17549435e-38 +42 1234.5678e-2" ;
+        std::vector<float> values_f ;
+        CHECK_EQUAL(true, parse_text_line(str.data(), str.data() + str.size(), values_f)) ;
+        std::istringstream stream_f(str) ;
+        float y ;
+        n = 0 ;
+        while(stream_f >> y)
+        {   CHECK_EQUAL(y, values_f[n++]) ; }
+        CHECK_EQUAL(n, values_f.size()) ;
+
+        // integers, with a value per row and column of a 2D matrix
+        str = " 12\t-3  +4 2147483647 -2147483648\r" ;
+        std::vector<int> values_i ;
+        std::vector<int> expected_i = {12, -3, 4, 2147483647, -2147483648} ;
+        CHECK_EQUAL(true, parse_text_line(str.data(), str.data() + str.size(), values_i)) ;
+        CHECK_EQUAL(expected_i, values_i) ;
+
+        // characters
+        str = "A C\tGT" ;
+        std::vector<char> values_c ;
+        std::vector<char> expected_c = {'A', 'C', 'G', 'T'} ;
+        CHECK_EQUAL(true, parse_text_line(str.data(), str.data() + str.size(), values_c)) ;
+        CHECK_EQUAL(expected_c, values_c) ;
+
+        // values that cannot be read
+        std::vector<std::string> errors_i = {"1.5", "2SA", "-", "2147483648", "1 a"} ;
+        for(const auto& e : errors_i)
+        {   CHECK_EQUAL(false, parse_text_line(e.data(), e.data() + e.size(), values_i)) ; }
+        std::vector<std::string> errors_d = {".", "1e", "1e+", "e5", "inf", "1e400", "-", "1,5"} ;
+        for(const auto& e : errors_d)
+        {   CHECK_EQUAL(false, parse_text_line(e.data(), e.data() + e.size(), values)) ; }
+    }
+
+    // tests the slice header detection
+    TEST(header)
+    {   std::vector<std::string> headers = {",,0", ",,", ",, 12"} ;
+        std::vector<std::string> others  = {",,,0", ",0", "", "1,,", ",,0,"} ;
+        for(const auto& h : headers)
+        {   CHECK_EQUAL(true, is_text_header(h.data(), h.data() + h.size(), 2)) ; }
+        for(const auto& h : others)
+        {   CHECK_EQUAL(false, is_text_header(h.data(), h.data() + h.size(), 2)) ; }
+        std::string h = ",,,3" ;
+        CHECK_EQUAL(true, is_text_header(h.data(), h.data() + h.size(), 3)) ;
+    }
+}
+
+
+/*!
+ * \brief Writes the values of a matrix on a stream the way the
+ * print() methods used to, value by value, as a reference.
+ * \param stream the stream.
+ * \param m the matrix.
+ * \param n_dim the dimensionality of the layout (0, 2, 3 or 4).
+ * \param precision the rounding precision.
+ * \param width the column width in number of characters.
+ * \param sep the character separator.
+ */
+template<class T>
+void print_reference(std::ostream& stream, const Matrix<T>& m, size_t n_dim, size_t precision, size_t width, char sep)
+{   stream.setf(std::ios::left) ;
+    stream << std::setprecision(precision) << std::fixed ;
+    if(n_dim == 0)
+    {   for(size_t i=0; i<m.get_data_size(); i++)
+        {   stream << std::setw(width) << m.get(i) << sep ; }
+        return ;
+    }
+    std::vector<size_t> dim = m.get_dim() ;
+    dim.resize(4, 1) ;
+    size_t n = 0 ;
+    for(size_t a=0; a<dim[3]; a++)
+    {   if(n_dim == 4)
+        {   stream << ",,," << a << std::endl ; }
+        for(size_t z=0; z<dim[2]; z++)
+        {   if(n_dim >= 3)
+            {   stream << ",," << z << std::endl ; }
+            for(size_t x=0; x<dim[0]; x++)
+            {   for(size_t y=0; y<dim[1]; y++, n++)
+                {   stream << std::setw(width) << m.get(n) << sep ; }
+                if(n < m.get_data_size())
+                {   stream << std::endl ; }
+            }
+        }
+    }
+}
+
+
+SUITE(MatrixTextWriter)
+{   // displays message
+    TEST(message)
+    {   std::cout << "Starting MatrixTextWriter tests..." << std::endl ; }
+
+    // tests that print() gives the same output as value by value
+    TEST(print)
+    {   ThreadPool pool(3) ;
+        std::vector<double> values_d = {0., -1.5, 3.14159265, 1e300, -0.00001, 12345.678, 2.5, 0.125} ;
+        std::vector<int> values_i = {0, -1, 7, 2147483647, -2147483648, 42, 1000, -99} ;
+        std::vector<std::vector<size_t>> formats = {{4, 8}, {0, 0}, {2, 3}, {6, 12}} ;
+
+        Matrix2D<double> m2_d(7, 5) ;
+        Matrix3D<double> m3_d(4, 3, 5) ;
+        Matrix4D<double> m4_d(3, 2, 3, 4) ;
+        Matrix2D<int>    m2_i(7, 5) ;
+        Matrix3D<int>    m3_i(4, 3, 5) ;
+        Matrix4D<int>    m4_i(3, 2, 3, 4) ;
+        for(size_t i=0; i<m2_d.get_data_size(); i++)
+        {   m2_d.set(i, values_d[i % values_d.size()] * i) ;
+            m2_i.set(i, values_i[i % values_i.size()]) ;
+        }
+        for(size_t i=0; i<m3_d.get_data_size(); i++)
+        {   m3_d.set(i, values_d[i % values_d.size()] / (i+1)) ;
+            m3_i.set(i, values_i[i % values_i.size()]) ;
+        }
+        for(size_t i=0; i<m4_d.get_data_size(); i++)
+        {   m4_d.set(i, values_d[i % values_d.size()] - i) ;
+            m4_i.set(i, values_i[i % values_i.size()] / 3) ;
+        }
+        std::vector<std::pair<const Matrix<double>*, size_t>> matrices_d = {{&m2_d, 2}, {&m3_d, 3}, {&m4_d, 4}, {&m4_d, 0}} ;
+        std::vector<std::pair<const Matrix<int>*, size_t>> matrices_i = {{&m2_i, 2}, {&m3_i, 3}, {&m4_i, 4}, {&m4_i, 0}} ;
+
+        for(const auto& format : formats)
+        {   for(const auto& m : matrices_d)
+            {   std::ostringstream expected, serial, parallel ;
+                print_reference(expected, *m.first, m.second, format[0], format[1], ' ') ;
+                if(m.second == 0)
+                {   m.first->Matrix<double>::print(serial, format[0], format[1], ' ') ;
+                    m.first->Matrix<double>::print(parallel, pool, format[0], format[1], ' ') ;
+                }
+                else
+                {   m.first->print(serial, format[0], format[1], ' ') ;
+                    m.first->print(parallel, pool, format[0], format[1], ' ') ;
+                }
+                CHECK_EQUAL(expected.str(), serial.str()) ;
+                CHECK_EQUAL(expected.str(), parallel.str()) ;
+            }
+            for(const auto& m : matrices_i)
+            {   std::ostringstream expected, serial, parallel ;
+                print_reference(expected, *m.first, m.second, format[0], format[1], '\t') ;
+                if(m.second == 0)
+                {   m.first->Matrix<int>::print(serial, format[0], format[1], '\t') ;
+                    m.first->Matrix<int>::print(parallel, pool, format[0], format[1], '\t') ;
+                }
+                else
+                {   m.first->print(serial, format[0], format[1], '\t') ;
+                    m.first->print(parallel, pool, format[0], format[1], '\t') ;
+                }
+                CHECK_EQUAL(expected.str(), serial.str()) ;
+                CHECK_EQUAL(expected.str(), parallel.str()) ;
+            }
+        }
+
+        // chunks of a few lines, in several rounds
+        for(size_t chunk_size=1; chunk_size<20; chunk_size+=3)
+        {   std::ostringstream expected, serial, parallel ;
+            print_reference(expected, m4_d, 4, 4, 8, ' ') ;
+            serial.setf(std::ios::left) ;
+            serial << std::setprecision(4) << std::fixed ;
+            parallel.copyfmt(serial) ;
+            // the internal dimensions, {ncol, nrow, ...}
+            std::vector<size_t> dim = m4_d.get_dim() ;
+            std::swap(dim[0], dim[1]) ;
+            MatrixTextWriter<double>(serial, dim, 4, 8, ' ', chunk_size).write(m4_d.get_data_ptr()) ;
+            MatrixTextWriter<double>(parallel, dim, 4, 8, ' ', chunk_size).write(m4_d.get_data_ptr(), pool) ;
+            CHECK_EQUAL(expected.str(), serial.str()) ;
+            CHECK_EQUAL(expected.str(), parallel.str()) ;
+        }
+
+        // empty matrices
+        std::ostringstream empty ;
+        Matrix2D<int>(0, 3).print(empty) ;
+        Matrix3D<int>(2, 0, 3).print(empty, pool) ;
+        Matrix4D<int>(2, 1, 3, 0).print(empty) ;
+        CHECK_EQUAL(std::string(), empty.str()) ;
+    }
+
+    // tests the chars and the stream formats that are not formatted directly
+    TEST(print_stream)
+    {   ThreadPool pool(2) ;
+        Matrix3D<char> m3_c(2, 3, 2) ;
+        Matrix2D<double> m2_d(3, 4) ;
+        for(size_t i=0; i<m3_c.get_data_size(); i++)
+        {   m3_c.set(i, "ACGT"[i % 4]) ; }
+        for(size_t i=0; i<m2_d.get_data_size(); i++)
+        {   m2_d.set(i, i * 1.25 - 4.) ; }
+
+        std::ostringstream expected, serial, parallel ;
+        print_reference(expected, m3_c, 3, 4, 3, ',') ;
+        m3_c.print(serial, 4, 3, ',') ;
+        m3_c.print(parallel, pool, 4, 3, ',') ;
+        CHECK_EQUAL(expected.str(), serial.str()) ;
+        CHECK_EQUAL(expected.str(), parallel.str()) ;
+
+
+        // other flags, another fill character and a width set before
+        std::vector<std::ostringstream> streams(3) ;
+        for(auto& stream : streams)
+        {   stream << std::showpos << std::setfill('_') << std::setw(6) ; }
+        print_reference(streams[0], m2_d, 2, 2, 9, ' ') ;
+        m2_d.print(streams[1], 2, 9, ' ') ;
+        m2_d.print(streams[2], pool, 2, 9, ' ') ;
+        CHECK_EQUAL(streams[0].str(), streams[1].str()) ;
+        CHECK_EQUAL(streams[0].str(), streams[2].str()) ;
+        CHECK_EQUAL(0, streams[1].width()) ;
+    }
+}
+
+
+SUITE(MatrixBinaryFormat)
+{   // displays message
+    TEST(message)
+    {   std::cout << "Starting MatrixBinaryFormat tests..." << std::endl ; }
+
+    // tests the checksum
+    TEST(crc32c)
+    {   std::string str = "123456789" ;
+        CHECK_EQUAL(0xE3069283u, crc32c(str.data(), str.size())) ;
+        CHECK_EQUAL(0u, crc32c(str.data(), 0)) ;
+        // bit by bit, for all the lengths and alignments
+        std::vector<unsigned char> bytes(100) ;
+        for(size_t i=0; i<bytes.size(); i++)
+        {   bytes[i] = static_cast<unsigned char>(i*37 + 11) ; }
+        for(size_t from=0; from<9; from++)
+        {   for(size_t n=0; n+from<=bytes.size(); n+=7)
+            {   uint32_t crc = 0xFFFFFFFF ;
+                for(size_t i=from; i<from+n; i++)
+                {   crc ^= bytes[i] ;
+                    for(int k=0; k<8; k++)
+                    {   crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78 : (crc >> 1) ; }
+                }
+                CHECK_EQUAL(~crc, crc32c(bytes.data() + from, n)) ;
+                // in two parts
+                CHECK_EQUAL(~crc, crc32c(bytes.data() + from + n/2, n - n/2, crc32c(bytes.data() + from, n/2))) ;
+            }
+        }
+    }
+
+    // tests the header and the alignment of the values
+    TEST(header)
+    {   std::string file_address = "./src/Unittests/data/matrix_binary_out.bin" ;
+        Matrix3D<double> m(4, 3, 2) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i*0.5) ; }
+        m.save(file_address) ;
+
+        std::ifstream file(file_address, std::ifstream::binary) ;
+        std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()) ;
+        CHECK_EQUAL(matrix_binary_alignment + m.get_data_size()*sizeof(double), bytes.size()) ;
+        CHECK_EQUAL(std::string(matrix_binary_magic, 8), std::string(bytes.data(), 8)) ;
+        size_t position = 0 ;
+        MatrixBinaryHeader header = read_matrix_binary_header<double>([&](void* dst, size_t n)
+                                                                      {   memcpy(dst, bytes.data() + position, n) ;
+                                                                          position += n ;
+                                                                          return true ;
+                                                                      },
+                                                                      file_address) ;
+        CHECK_EQUAL(2u, header.version) ;
+        CHECK_EQUAL(false, header.swap) ;
+        CHECK(header.type_id == MatrixTypeId::float64) ;
+        CHECK_EQUAL(8u, header.type_size) ;
+        CHECK_EQUAL(false, header.has_crc) ;
+        CHECK_EQUAL(matrix_binary_alignment, header.data_offset) ;
+        CHECK_EQUAL(m.get_data_size()*sizeof(double), header.data_size) ;
+        std::vector<size_t> dim = {3, 4, 2} ;
+        CHECK_EQUAL(dim, header.dim) ;
+
+        // the mapped values are aligned on a page
+        Matrix3D<double> m2 ;
+        m2.map(file_address) ;
+        CHECK_EQUAL(m, m2) ;
+        CHECK_EQUAL(0u, reinterpret_cast<uintptr_t>(m2.get_data_ptr()) % matrix_binary_alignment) ;
+
+        remove(file_address.c_str()) ;
+
+        // an unsupported version
+        file_address = "./src/Unittests/data/matrix_binary_out_2.bin" ;
+        uint32_t version = 3 ;
+        memcpy(bytes.data() + 12, &version, sizeof(version)) ;
+        std::ofstream file_out(file_address, std::ofstream::binary) ;
+        file_out.write(bytes.data(), bytes.size()) ;
+        file_out.close() ;
+        CHECK_THROW(m2.load(file_address), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+
+    // tests reading files in the legacy layout
+    TEST(legacy)
+    {   std::string file_address = "./src/Unittests/data/matrix_binary_out_2.bin" ;
+        Matrix2D<int> m(5, 3) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, static_cast<int>(i) - 7) ; }
+        std::ofstream file(file_address, std::ofstream::binary) ;
+        std::vector<size_t> dim = {3, 5} ;
+        size_t dim_size = dim.size() ;
+        file.write(reinterpret_cast<const char*>(&dim_size), sizeof(size_t)) ;
+        file.write(reinterpret_cast<const char*>(dim.data()), dim.size()*sizeof(size_t)) ;
+        file.write(reinterpret_cast<const char*>(m.get_data_ptr()), m.get_data_size()*sizeof(int)) ;
+        file.close() ;
+
+        Matrix2D<int> m2, m3 ;
+        m2.load(file_address) ;
+        CHECK_EQUAL(m, m2) ;
+        m3.map(file_address) ;
+        CHECK_EQUAL(m, m3) ;
+        CHECK_THROW(Matrix3D<int>().load(file_address), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+
+    // tests loading values of another type
+    TEST(widening)
+    {   std::string file_address = "./src/Unittests/data/matrix_binary_out_2.bin" ;
+        Matrix2D<int16_t> m_s(4, 6) ;
+        Matrix2D<float> m_f(4, 6) ;
+        for(size_t i=0; i<m_s.get_data_size(); i++)
+        {   m_s.set(i, static_cast<int16_t>(i*1000) - 12000) ;
+            m_f.set(i, i / 3.f) ;
+        }
+
+        m_s.save(file_address) ;
+        Matrix2D<int> m_i ;
+        Matrix2D<double> m_d ;
+        m_i.load(file_address) ;
+        m_d.load(file_address) ;
+        for(size_t i=0; i<m_s.get_data_size(); i++)
+        {   CHECK_EQUAL(static_cast<int>(m_s.get(i)), m_i.get(i)) ;
+            CHECK_EQUAL(static_cast<double>(m_s.get(i)), m_d.get(i)) ;
+        }
+        CHECK_THROW(Matrix2D<int8_t>().load(file_address), std::runtime_error) ;
+        CHECK_THROW(Matrix2D<uint32_t>().load(file_address), std::runtime_error) ;
+        CHECK_THROW(Matrix2D<char>().load(file_address), std::runtime_error) ;
+        CHECK_THROW(m_i.map(file_address), std::runtime_error) ;
+
+        m_f.save(file_address) ;
+        m_d.load(file_address) ;
+        for(size_t i=0; i<m_f.get_data_size(); i++)
+        {   CHECK_EQUAL(static_cast<double>(m_f.get(i)), m_d.get(i)) ; }
+        CHECK_THROW(m_i.load(file_address), std::runtime_error) ;
+        m_d.save(file_address) ;
+        CHECK_THROW(m_f.load(file_address), std::runtime_error) ;
+
+        CHECK_EQUAL(true,  is_matrix_type_widening(MatrixTypeId::uint16, MatrixTypeId::int32)) ;
+        CHECK_EQUAL(true,  is_matrix_type_widening(MatrixTypeId::int32, MatrixTypeId::float64)) ;
+        CHECK_EQUAL(false, is_matrix_type_widening(MatrixTypeId::int32, MatrixTypeId::float32)) ;
+        CHECK_EQUAL(false, is_matrix_type_widening(MatrixTypeId::int64, MatrixTypeId::uint64)) ;
+        remove(file_address.c_str()) ;
+    }
+
+    // tests loading a file written with the other byte order
+    TEST(swap)
+    {   std::string file_address = "./src/Unittests/data/matrix_binary_out_2.bin" ;
+        Matrix2D<int> m(3, 7) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, static_cast<int>(i*100003) - 5) ; }
+
+        // the header and the values with their bytes reversed
+        MatrixBinaryHeader header = make_matrix_binary_header<int>({7, 3}) ;
+        std::vector<char> bytes = encode_matrix_binary_header(header) ;
+        // 6 uint32 fields from byte 8, 3 uint64 fields and 2 dimensions from byte 32
+        for(size_t i=8; i<32; i+=4)
+        {   std::reverse(bytes.begin() + i, bytes.begin() + i + 4) ; }
+        for(size_t i=32; i<matrix_binary_header_size + 2*8; i+=8)
+        {   std::reverse(bytes.begin() + i, bytes.begin() + i + 8) ; }
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   int value = swap_matrix_bytes(m.get(i)) ;
+            const char* p = reinterpret_cast<const char*>(&value) ;
+            bytes.insert(bytes.end(), p, p + sizeof(int)) ;
+        }
+        std::ofstream file(file_address, std::ofstream::binary) ;
+        file.write(bytes.data(), bytes.size()) ;
+        file.close() ;
+
+        Matrix2D<int> m2 ;
+        m2.load(file_address) ;
+        CHECK_EQUAL(m, m2) ;
+        Matrix2D<long long> m3 ;
+        m3.load(file_address) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   CHECK_EQUAL(static_cast<long long>(m.get(i)), m3.get(i)) ; }
+        CHECK_THROW(m2.map(file_address), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+
+    // tests the runs of values making a region
+    TEST(runs)
+    {   // internal dimensions {ncol, nrow, z}
+        std::vector<size_t> dim = {4, 3, 2} ;
+        std::vector<MatrixBinaryRun> runs = get_matrix_binary_runs(dim, {1, 0, 0}, {2, 3, 2}) ;
+        CHECK_EQUAL(6u, runs.size()) ;
+        for(size_t i=0; i<runs.size(); i++)
+        {   CHECK_EQUAL(1 + 4*i, runs[i].file_offset) ;
+            CHECK_EQUAL(2*i, runs[i].region_offset) ;
+            CHECK_EQUAL(2u, runs[i].size) ;
+        }
+        // entire rows are merged, and so are entire slices
+        runs = get_matrix_binary_runs(dim, {0, 1, 0}, {4, 2, 2}) ;
+        CHECK_EQUAL(2u, runs.size()) ;
+        CHECK_EQUAL(4u, runs[0].file_offset) ;
+        CHECK_EQUAL(16u, runs[1].file_offset) ;
+        CHECK_EQUAL(8u, runs[1].size) ;
+        runs = get_matrix_binary_runs(dim, {0, 0, 1}, {4, 3, 1}) ;
+        CHECK_EQUAL(1u, runs.size()) ;
+        CHECK_EQUAL(12u, runs[0].file_offset) ;
+        CHECK_EQUAL(12u, runs[0].size) ;
+        CHECK_EQUAL(0u, get_matrix_binary_runs(dim, {0, 0, 0}, {4, 0, 2}).size()) ;
+    }
+
+    // tests loading regions of the matrices
+    TEST(load_region)
+    {   std::string file_address = "./src/Unittests/data/matrix_binary_out_2.bin" ;
+        Matrix3D<int> m(5, 4, 6) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, static_cast<int>(i*7) - 50) ; }
+        m.save(file_address) ;
+
+        // z slices
+        for(size_t z=0; z<6; z++)
+        {   Matrix3D<int> m2 ;
+            m2.load_region(file_address, {0, 0, z}, {5, 4, 1}) ;
+            CHECK_EQUAL(Matrix3D<int>(5, 4, 1).get_dim(), m2.get_dim()) ;
+            for(size_t i=0; i<5; i++)
+            {   for(size_t j=0; j<4; j++)
+                {   CHECK_EQUAL(m(i,j,z), m2(i,j,0)) ; }
+            }
+        }
+        // blocks, loaded as double
+        std::vector<std::vector<size_t>> origins = {{0, 0, 0}, {1, 2, 3}, {4, 0, 2}, {2, 1, 0}} ;
+        std::vector<std::vector<size_t>> extents = {{5, 4, 6}, {3, 2, 2}, {1, 4, 4}, {2, 3, 6}} ;
+        for(size_t k=0; k<origins.size(); k++)
+        {   Matrix3D<double> m2 ;
+            m2.load_region(file_address, origins[k], extents[k]) ;
+            CHECK_EQUAL(extents[k], m2.get_dim()) ;
+            for(size_t i=0; i<extents[k][0]; i++)
+            {   for(size_t j=0; j<extents[k][1]; j++)
+                {   for(size_t z=0; z<extents[k][2]; z++)
+                    {   CHECK_EQUAL(m(origins[k][0]+i, origins[k][1]+j, origins[k][2]+z), m2(i,j,z)) ; }
+                }
+            }
+        }
+        Matrix3D<int> m3 ;
+        m3.load_region(file_address, {0, 0, 0}, {5, 4, 6}) ;
+        CHECK_EQUAL(m, m3) ;
+        MatrixN<int,3> m4 ;
+        m4.load_region(file_address, {1, 1, 1}, {1, 1, 1}) ;
+        CHECK_EQUAL(m(1,1,1), m4(0,0,0)) ;
+        // through a Matrix reference, the offsets follow the dimensions
+        Matrix3D<int> m7(1, 1, 1) ;
+        Matrix<int>& m7_base = m7 ;
+        m7_base.load_region(file_address, 3, {1, 2, 3}, {4, 2, 3}) ;
+        CHECK_EQUAL(m(4,3,5), m7(3,1,2)) ;
+        CHECK_THROW(m7_base.load_region(file_address, 2, {0, 0}, {1, 1}), std::invalid_argument) ;
+
+        // the runs read one by one or all at once
+        std::vector<MatrixBinaryRun> runs = get_matrix_binary_runs({4, 5, 6}, {1, 1, 1}, {2, 3, 4}) ;
+        MatrixBinaryHeader header = make_matrix_binary_header<int>({4, 5, 6}) ;
+        int fd = open(file_address.c_str(), O_RDONLY) ;
+        std::vector<int> values_1(24), values_2(24) ;
+        CHECK_EQUAL(true, read_matrix_binary_runs(fd, header, runs, values_1.data(), 0, 0)) ;
+        CHECK_EQUAL(true, read_matrix_binary_runs(fd, header, runs, values_2.data())) ;
+        close(fd) ;
+        CHECK_EQUAL(values_1, values_2) ;
+        CHECK_EQUAL(m(1,1,1), values_1[0]) ;
+        CHECK_EQUAL(m(3,2,4), values_1[23]) ;
+
+        // invalid regions
+        CHECK_THROW(m3.load_region(file_address, {0, 0, 0}, {6, 4, 6}), std::out_of_range) ;
+        CHECK_THROW(m3.load_region(file_address, {0, 0, 7}, {1, 1, 0}), std::out_of_range) ;
+        CHECK_THROW(m3.load_region(file_address, {0, 0}, {1, 1}), std::out_of_range) ;
+        CHECK_THROW(Matrix2D<int>().load_region(file_address, {0, 0}, {1, 1}), std::runtime_error) ;
+        CHECK_THROW(m3.load_region("./src/Unittests/data/does_not_exist.bin", {0, 0, 0}, {1, 1, 1}), std::runtime_error) ;
+        CHECK_EQUAL(m, m3) ;
+
+        // a region of a 4D matrix
+        Matrix4D<float> m5(3, 4, 5, 2) ;
+        for(size_t i=0; i<m5.get_data_size(); i++)
+        {   m5.set(i, i * 0.5f) ; }
+        m5.save(file_address) ;
+        Matrix4D<float> m6 ;
+        m6.load_region(file_address, {0, 0, 0, 1}, {3, 4, 5, 1}) ;
+        CHECK_EQUAL(Matrix4D<float>(3, 4, 5, 1).get_dim(), m6.get_dim()) ;
+        for(size_t i=0; i<m6.get_data_size(); i++)
+        {   CHECK_EQUAL(m5.get(i + m6.get_data_size()), m6.get(i)) ; }
+        Matrix4D<float> m8(1, 1, 1, 1) ;
+        Matrix<float>& m8_base = m8 ;
+        m8_base.load_region(file_address, 4, {1, 1, 1, 0}, {2, 3, 4, 2}) ;
+        CHECK_EQUAL(m5(2,3,4,1), m8(1,2,3,1)) ;
+        // a 2D region, loaded through a Matrix reference
+        Matrix2D<float> m9(1, 1) ;
+        Matrix<float>& m9_base = m9 ;
+        Matrix2D<float> m10(3, 4) ;
+        for(size_t i=0; i<m10.get_data_size(); i++)
+        {   m10.set(i, i * 0.25f) ; }
+        m10.save(file_address) ;
+        m9_base.load_region(file_address, 2, {1, 1}, {2, 3}) ;
+        CHECK_EQUAL(m10(2,3), m9(1,2)) ;
+        remove(file_address.c_str()) ;
+    }
+
+    // tests the checksum of the values
+    TEST(checksum)
+    {   std::string file_address = "./src/Unittests/data/matrix_binary_out_2.bin" ;
+        Matrix4D<float> m(2, 3, 4, 5) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i * 0.25f) ; }
+        m.save(file_address, true) ;
+        Matrix4D<float> m2 ;
+        m2.load(file_address) ;
+        CHECK_EQUAL(m, m2) ;
+        Matrix4D<double> m3 ;
+        m3.load(file_address) ;
+
+        // a value modified
+        std::fstream file(file_address, std::fstream::in | std::fstream::out | std::fstream::binary) ;
+        file.seekp(matrix_binary_alignment + 17) ;
+        file.put('\x7f') ;
+        file.close() ;
+        CHECK_THROW(m2.load(file_address), std::runtime_error) ;
+        CHECK_THROW(m3.load(file_address), std::runtime_error) ;
+        CHECK_EQUAL(m, m2) ;
+        // mapping does not read the values
+        m2.map(file_address) ;
+        CHECK(m != m2) ;
+        remove(file_address.c_str()) ;
+    }
+
+    TEST(invalid)
+    {   // a text file, read as a legacy file
+        Matrix2D<int> m ;
+        CHECK_THROW(m.load("./src/Unittests/data/matrix2d_int1.mat"), std::runtime_error) ;
+        CHECK_THROW(m.map("./src/Unittests/data/matrix2d_int1.mat"), std::runtime_error) ;
+        Matrix<int> m_any ;
+        CHECK_THROW(m_any.load("./src/Unittests/data/matrix2d_int1.mat", 0), std::runtime_error) ;
+
+        // dimensions which number of bytes overflows
+        std::string file_address = "./src/Unittests/data/matrix_binary_out_3.bin" ;
+        MatrixBinaryHeader header = make_matrix_binary_header<double>({1, 1}) ;
+        header.dim = {std::numeric_limits<size_t>::max() / 4, 4} ;
+        header.data_size = header.get_value_number() * sizeof(double) ;
+        std::vector<char> bytes = encode_matrix_binary_header(header) ;
+        std::ofstream file(file_address, std::ofstream::binary) ;
+        file.write(bytes.data(), bytes.size()) ;
+        file.close() ;
+        CHECK_THROW(m.load(file_address), std::runtime_error) ;
+        Matrix2D<double> m_double ;
+        CHECK_THROW(m_double.load(file_address), std::runtime_error) ;
+        CHECK_THROW(m_double.map(file_address), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+}
+
+SUITE(MatrixChunkedFile)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixChunkedFile tests..." << std::endl ; }
+
+    TEST(copy_block)
+    {   // a 2x3 block of a 4x5 matrix, copied to a 3x4 matrix
+        std::vector<int> src(20), dst(12, -1) ;
+        std::iota(src.begin(), src.end(), 0) ;
+        copy_matrix_block(src.data(), {4, 5}, {1, 2}, dst.data(), {3, 4}, {0, 1}, {2, 3}) ;
+        std::vector<int> expected = {-1, -1, -1, 9, 10, -1, 13, 14, -1, 17, 18, -1} ;
+        CHECK_EQUAL(expected, dst) ;
+    }
+
+    TEST(region)
+    {   std::string file_address = "./src/Unittests/data/matrix_chunked_out.bin" ;
+        Matrix3D<int> m(5, 7, 3) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, static_cast<int>(i*3) - 20) ; }
+
+        {   MatrixChunkedFile<int> file(file_address, {5, 7, 3}, {2, 3, 2}, 2) ;
+            CHECK_EQUAL(3, file.get_dim_size()) ;
+            CHECK_EQUAL(std::vector<size_t>({5, 7, 3}), file.get_dim()) ;
+            CHECK_EQUAL(std::vector<size_t>({2, 3, 2}), file.get_chunk_dim()) ;
+            CHECK_EQUAL(3*3*2, file.get_chunk_number()) ;
+            CHECK_EQUAL(12, file.get_chunk_data_size()) ;
+            // nothing written yet
+            CHECK_EQUAL(0, file.get({4, 6, 2})) ;
+            file.write_region({0, 0, 0}, {5, 7, 3}, m.get_data_ptr()) ;
+            CHECK_EQUAL(m(4, 6, 2), file.get({4, 6, 2})) ;
+        }
+
+        // blocks, through a small cache
+        MatrixChunkedFile<int> file(file_address, true, 1) ;
+        CHECK_EQUAL(std::vector<size_t>({5, 7, 3}), file.get_dim()) ;
+        std::vector<std::vector<size_t>> origins = {{0, 0, 0}, {1, 2, 1}, {4, 0, 2}, {2, 1, 0}, {3, 3, 3}} ;
+        std::vector<std::vector<size_t>> extents = {{5, 7, 3}, {3, 4, 2}, {1, 7, 1}, {2, 5, 3}, {2, 4, 0}} ;
+        for(size_t k=0; k<origins.size(); k++)
+        {   Matrix3D<int> m2(extents[k][0], extents[k][1], extents[k][2]) ;
+            file.read_region(origins[k], extents[k], m2.get_data_ptr()) ;
+            for(size_t i=0; i<extents[k][0]; i++)
+            {   for(size_t j=0; j<extents[k][1]; j++)
+                {   for(size_t z=0; z<extents[k][2]; z++)
+                    {   CHECK_EQUAL(m(origins[k][0]+i, origins[k][1]+j, origins[k][2]+z), m2(i,j,z)) ; }
+                }
+            }
+        }
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   CHECK_EQUAL(m.get(i), file.get(convert_to_coord(m, i))) ; }
+
+        // invalid accesses
+        int value = 0 ;
+        CHECK_THROW(file.get({5, 0, 0}), std::out_of_range) ;
+        CHECK_THROW(file.get({0, 0}), std::out_of_range) ;
+        CHECK_THROW(file.read_region({0, 0, 1}, {5, 7, 3}, m.get_data_ptr()), std::out_of_range) ;
+        CHECK_THROW(file.read_chunk(18, &value), std::out_of_range) ;
+        CHECK_THROW(file.set({0, 0, 0}, 1), std::runtime_error) ;
+        CHECK_THROW(MatrixChunkedFile<int>(file_address, {5, 7}, {2, 3, 2}), std::invalid_argument) ;
+        CHECK_THROW(MatrixChunkedFile<int>(file_address, {5, 7, 3}, {2, 0, 2}), std::invalid_argument) ;
+        {   // the chunks are not wider than the matrix
+            MatrixChunkedFile<int> file2(file_address + ".2", {5, 7, 3}, {8, 3, 4}) ;
+            CHECK_EQUAL(std::vector<size_t>({5, 3, 3}), file2.get_chunk_dim()) ;
+        }
+        remove((file_address + ".2").c_str()) ;
+        CHECK_THROW(MatrixChunkedFile<float>(file_address, true), std::runtime_error) ;
+        CHECK_THROW(MatrixChunkedFile<int>("./src/Unittests/data/matrix2d_int1.mat", true), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+
+    TEST(corrupt_header)
+    {   std::string file_address = "./src/Unittests/data/matrix_chunked_out.bin" ;
+        size_t huge = std::numeric_limits<size_t>::max() / 2 ;
+        // dimensions whose product overflows, many more chunks than
+        // the index holds, chunks wider than the matrix and offsets
+        // beyond the end of the file
+        std::vector<std::vector<uint64_t>> dims = {{huge, huge, 3, 1, 1, 1},
+                                                   {huge, 5, 3, 2, 3, 2},
+                                                   {1 << 20, 5, 3, 2, 3, 2},
+                                                   {7, 5, 3, 2, 3, 1 << 30}} ;
+        std::vector<uint64_t> offsets = {1 << 30, 4096} ;
+        // a chunk in the header, a chunk beyond the end of the file
+        // and a chunk crossing the end of the file
+        std::vector<uint64_t> chunk_offsets = {64, 1 << 30, matrix_binary_alignment + 4} ;
+        for(size_t k=0; k<dims.size()+1+chunk_offsets.size(); k++)
+        {   {   MatrixChunkedFile<int> file(file_address, {5, 7, 3}, {2, 3, 2}) ;
+                file.set({0, 0, 0}, 1) ;
+            }
+            std::fstream file(file_address, std::ios::in | std::ios::out | std::ios::binary) ;
+            if(k < dims.size())
+            {   file.seekp(matrix_chunked_header_size) ;
+                file.write(reinterpret_cast<const char*>(dims[k].data()), dims[k].size()*sizeof(uint64_t)) ;
+            }
+            else if(k == dims.size())
+            {   file.seekp(matrix_chunked_header_size - offsets.size()*sizeof(uint64_t)) ;
+                file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size()*sizeof(uint64_t)) ;
+            }
+            else
+            {   // the index of the 1st chunk
+                uint64_t offset = chunk_offsets[k-dims.size()-1] ;
+                file.seekp(matrix_chunked_header_size + 6*sizeof(uint64_t)) ;
+                file.write(reinterpret_cast<const char*>(&offset), sizeof(offset)) ;
+            }
+            file.close() ;
+            CHECK_THROW(MatrixChunkedFile<int>(file_address, true), std::runtime_error) ;
+        }
+        CHECK_THROW(MatrixChunkedFile<int>(file_address, {huge, 5, 3}, {1, 1, 1}), std::invalid_argument) ;
+        remove(file_address.c_str()) ;
+    }
+
+    TEST(update)
+    {   std::string file_address = "./src/Unittests/data/matrix_chunked_out.bin" ;
+        Matrix2D<double> m(6, 8, 0.) ;
+
+        // the chunks are only allocated when written
+        {   MatrixChunkedFile<double> file(file_address, {6, 8}, {4, 4}, 1) ;
+            file.set({0, 0}, 1.5) ;
+            file.set({5, 7}, 2.5) ;
+            file.set({1, 1}, 3.5) ;
+        }
+        m(0, 0) = 1.5 ;
+        m(5, 7) = 2.5 ;
+        m(1, 1) = 3.5 ;
+        std::ifstream size_file(file_address, std::ifstream::binary | std::ifstream::ate) ;
+        CHECK_EQUAL(matrix_binary_alignment + 2*16*sizeof(double), static_cast<size_t>(size_file.tellg())) ;
+        size_file.close() ;
+
+        // partial updates, the other values are kept
+        {   MatrixChunkedFile<double> file(file_address) ;
+            std::vector<double> values = {10., 11., 12., 13., 14., 15.} ;
+            file.write_region({2, 3}, {3, 2}, values.data()) ;
+            for(size_t i=0; i<3; i++)
+            {   for(size_t j=0; j<2; j++)
+                {   m(2+i, 3+j) = values[i*2+j] ; }
+            }
+            // a whole chunk, the padding included
+            std::vector<double> chunk(16) ;
+            file.read_chunk(1, chunk.data()) ;
+            CHECK_EQUAL(0., chunk[0]) ;
+            CHECK_EQUAL(0., chunk[15]) ;
+            std::iota(chunk.begin(), chunk.end(), 100.) ;
+            file.write_chunk(1, chunk.data()) ;
+            for(size_t i=0; i<4; i++)
+            {   for(size_t j=0; j<4; j++)
+                {   m(i, 4+j) = chunk[i*4+j] ; }
+            }
+            file.flush() ;
+        }
+        Matrix2D<double> m2 ;
+        m2.load(file_address) ;
+        CHECK_EQUAL(m, m2) ;
+        remove(file_address.c_str()) ;
+    }
+
+    TEST(save_chunked)
+    {   std::string file_address = "./src/Unittests/data/matrix_chunked_out.bin" ;
+        Matrix4D<float> m(3, 4, 5, 2) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i * 0.5f) ; }
+        m.save_chunked(file_address, {2, 2, 2, 1}) ;
+        CHECK_EQUAL(true, is_matrix_chunked_file(file_address)) ;
+        Matrix4D<float> m2 ;
+        m2.load(file_address) ;
+        CHECK_EQUAL(m, m2) ;
+        Matrix4D<float> m3 ;
+        m3.load_region(file_address, {0, 0, 0, 1}, {3, 4, 5, 1}) ;
+        CHECK_EQUAL(Matrix4D<float>(3, 4, 5, 1).get_dim(), m3.get_dim()) ;
+        for(size_t i=0; i<m3.get_data_size(); i++)
+        {   CHECK_EQUAL(m.get(i + m3.get_data_size()), m3.get(i)) ; }
+        MatrixN<float,4> m4 ;
+        m4.load_region(file_address, {1, 2, 3, 1}, {1, 1, 1, 1}) ;
+        CHECK_EQUAL(m(1, 2, 3, 1), m4(0, 0, 0, 0)) ;
+        CHECK_THROW(m3.load_region(file_address, {0, 0, 0, 1}, {3, 4, 5, 2}), std::out_of_range) ;
+        CHECK_THROW(Matrix3D<float>().load(file_address), std::runtime_error) ;
+        CHECK_THROW(Matrix4D<double>().load(file_address), std::runtime_error) ;
+
+        Matrix3D<int> m5(4, 3, 2) ;
+        for(size_t i=0; i<m5.get_data_size(); i++)
+        {   m5.set(i, static_cast<int>(i)) ; }
+        m5.save_chunked(file_address, {4, 3, 2}) ;
+        Matrix3D<int> m6 ;
+        m6.load(file_address) ;
+        CHECK_EQUAL(m5, m6) ;
+        CHECK_THROW(m5.save_chunked(file_address, {4, 3}), std::invalid_argument) ;
+        remove(file_address.c_str()) ;
+    }
+}
+
+SUITE(MatrixOutOfCore)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixOutOfCore tests..." << std::endl ; }
+
+    TEST(access)
+    {   std::string file_address = "./src/Unittests/data/matrix_chunked_out.bin" ;
+        Matrix3D<int> m(5, 6, 4) ;
+        {   // a cache of 2 chunks out of 18
+            Matrix3DOutOfCore<int> m2(file_address, 5, 6, 4, {2, 4, 2}, 2) ;
+            CHECK_EQUAL(m.get_dim(), m2.get_dim()) ;
+            CHECK_EQUAL(std::vector<size_t>({2, 4, 2}), m2.get_chunk_dim()) ;
+            CHECK_EQUAL(m.get_data_size(), m2.get_data_size()) ;
+            CHECK_EQUAL(0, m2(4, 5, 3)) ;
+            for(size_t k=0; k<4; k++)
+            {   for(size_t i=0; i<5; i++)
+                {   for(size_t j=0; j<6; j++)
+                    {   int value = static_cast<int>(i*100 + j*10 + k) ;
+                        m(i, j, k)  = value ;
+                        m2(i, j, k) = value ;
+                    }
+                }
+            }
+            for(size_t i=0; i<m.get_data_size(); i++)
+            {   CHECK_EQUAL(m.get(i), m2.get(i)) ;
+                CHECK_EQUAL(m.get(i), m2.get(convert_to_coord(m, i))) ;
+            }
+            m(1, 2, 3) = m(4, 5, 0) ;
+            m2(1, 2, 3) = m2(4, 5, 0) ;
+            m(0, 1, 2) += 7 ;
+            m2(0, 1, 2) += 7 ;
+            m.set(11, -3) ;
+            m2.set(11, -3) ;
+            m.set({4, 0, 1}, -4) ;
+            m2.set({4, 0, 1}, -4) ;
+            CHECK_EQUAL(m(1, 2, 3), m2(1, 2, 3)) ;
+
+            // slices
+            Matrix2D<int> slice = m2.get_slice(2) ;
+            for(size_t i=0; i<5; i++)
+            {   for(size_t j=0; j<6; j++)
+                {   CHECK_EQUAL(m(i, j, 2), slice(i, j)) ; }
+            }
+            slice += 1000 ;
+            m2.set_slice(1, slice) ;
+            for(size_t i=0; i<5; i++)
+            {   for(size_t j=0; j<6; j++)
+                {   m(i, j, 1) = slice(i, j) ; }
+            }
+            CHECK_THROW(m2.set_slice(1, Matrix2D<int>(6, 5)), std::out_of_range) ;
+            CHECK_THROW(m2(5, 0, 0), std::out_of_range) ;
+            CHECK_THROW(m2(0, 0), std::out_of_range) ;
+            CHECK_THROW(m2.get(m.get_data_size()), std::out_of_range) ;
+        }
+        Matrix3D<int> m3 ;
+        m3.load(file_address) ;
+        CHECK_EQUAL(m, m3) ;
+
+        // read only
+        const Matrix3DOutOfCore<int> m4(file_address, true, 1) ;
+        CHECK_EQUAL(m(2, 3, 1), m4(2, 3, 1)) ;
+        CHECK_THROW(Matrix3DOutOfCore<int>(file_address, true).set(0, 1), std::runtime_error) ;
+        CHECK_THROW(Matrix4DOutOfCore<int>(file_address, true), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+
+    TEST(chunks)
+    {   std::string file_address = "./src/Unittests/data/matrix_chunked_out.bin" ;
+        Matrix4D<double> m(3, 4, 5, 2) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i * 0.5) ; }
+        m.save_chunked(file_address, {2, 3, 5, 1}) ;
+
+        {   Matrix4DOutOfCore<double> m2(file_address, false, 1) ;
+            // the chunks cover each element once
+            Matrix4D<int> count(3, 4, 5, 2, 0) ;
+            double sum = 0. ;
+            m2.for_each_chunk([&](const std::vector<size_t>& origin, MatrixView<const double> view)
+                              {   std::vector<size_t> dim = view.get_dim() ;
+                                  for(size_t i=0; i<dim[0]; i++)
+                                  {   for(size_t j=0; j<dim[1]; j++)
+                                      {   for(size_t k=0; k<dim[2]; k++)
+                                          {   size_t a = origin[3] ;
+                                              count(origin[0]+i, origin[1]+j, origin[2]+k, a) += 1 ;
+                                              CHECK_EQUAL(m(origin[0]+i, origin[1]+j, origin[2]+k, a), view(i, j, k, 0)) ;
+                                          }
+                                      }
+                                  }
+                                  for(double value : view)
+                                  {   sum += value ; }
+                              }) ;
+            CHECK_EQUAL(Matrix4D<int>(3, 4, 5, 2, 1), count) ;
+            CHECK_EQUAL(0.5 * (m.get_data_size() - 1) * m.get_data_size() / 2., sum) ;
+
+            // scalar operators
+            m2 += 1. ;
+            m2 *= 4. ;
+            m2 -= 2. ;
+            m2 /= 2. ;
+            m  += 1. ;
+            m  *= 4. ;
+            m  -= 2. ;
+            m  /= 2. ;
+            CHECK_THROW(m2 /= 0., std::invalid_argument) ;
+
+            Matrix3D<double> slice = m2.get_slice(1) ;
+            for(size_t i=0; i<slice.get_data_size(); i++)
+            {   CHECK_EQUAL(m.get(i + slice.get_data_size()), slice.get(i)) ; }
+            CHECK_THROW(m2.get_slice(2), std::out_of_range) ;
+        }
+        Matrix4D<double> m3 ;
+        m3.load(file_address) ;
+        CHECK_EQUAL(m, m3) ;
+
+        // reading a matrix does not write its chunks
+        {   Matrix4DOutOfCore<double> m4(file_address, true, 1) ;
+            double sum = 0. ;
+            m4.for_each_chunk([&](const std::vector<size_t>&, MatrixView<const double> view)
+                              {   for(double value : view)
+                                  {   sum += value ; }
+                              }) ;
+            std::vector<double> values = m.get_data() ;
+            CHECK_EQUAL(std::accumulate(values.begin(), values.end(), 0.), sum) ;
+            CHECK_THROW(m4.modify_each_chunk([](const std::vector<size_t>&, MatrixView<double>) {}),
+                        std::runtime_error) ;
+            CHECK_THROW(m4 += 1., std::runtime_error) ;
+        }
+        remove(file_address.c_str()) ;
+
+        {   MatrixOutOfCore<double> m5(file_address, {64, 64}, {32, 32}, 1) ;
+            struct stat status ;
+            stat(file_address.c_str(), &status) ;
+            blkcnt_t n_block = status.st_blocks ;
+            double sum = 1. ;
+            m5.for_each_chunk([&](const std::vector<size_t>&, MatrixView<const double> view)
+                              {   for(double value : view)
+                                  {   sum += value ; }
+                              }) ;
+            m5.flush() ;
+            CHECK_EQUAL(1., sum) ;
+            stat(file_address.c_str(), &status) ;
+            CHECK_EQUAL(n_block, status.st_blocks) ;
+        }
+        remove(file_address.c_str()) ;
+    }
+}
+
+/*!
+ * \brief Reads a Matrix3D or Matrix4D text file with a slice
+ * reader and concatenates the values of the slices.
+ * \param file_address the path to the file.
+ * \param dim where the dimensions of the slices are stored.
+ * \param n_slice where the number of slices is stored.
+ * \return the values.
+ */
+template<class R>
+std::vector<int> read_slices(const std::string& file_address, std::vector<size_t>& dim, size_t& n_slice)
+{   std::vector<int> values ;
+    n_slice = 0 ;
+    R reader(file_address, 16) ;
+    for(const auto& slice : reader)
+    {   CHECK_EQUAL(n_slice, reader.get_slice_index()) ;
+        dim = slice.get_dim() ;
+        for(size_t i=0; i<slice.get_data_size(); i++)
+        {   values.push_back(slice.get(i)) ; }
+        n_slice++ ;
+    }
+    return values ;
+}
+
+SUITE(MatrixSliceReader)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixSliceReader tests..." << std::endl ; }
+
+    TEST(reader_3d)
+    {   // the slices are those loaded by the constructor, or the same errors are found
+        for(size_t i=1; i<=14; i++)
+        {   std::string file_address = "./src/Unittests/data/matrix3d_int" + std::to_string(i) + ".mat" ;
+            std::vector<size_t> dim ;
+            size_t n_slice = 0 ;
+            Matrix3D<int> m ;
+            try
+            {   m = Matrix3D<int>(file_address) ; }
+            catch(std::runtime_error& e)
+            {   CHECK_THROW(read_slices<Matrix3DSliceReader<int>>(file_address, dim, n_slice), std::runtime_error) ;
+                continue ;
+            }
+            std::vector<int> values = read_slices<Matrix3DSliceReader<int>>(file_address, dim, n_slice) ;
+            CHECK_EQUAL(m.get_dim()[2], n_slice) ;
+            CHECK_EQUAL(m.get_data(), values) ;
+            if(n_slice > 0)
+            {   CHECK_EQUAL(std::vector<size_t>({m.get_dim()[0], m.get_dim()[1]}), dim) ; }
+        }
+
+        // next() and get_slice()
+        Matrix3D<double> m("./src/Unittests/data/matrix3d_double.mat") ;
+        Matrix3DSliceReader<double> reader("./src/Unittests/data/matrix3d_double.mat") ;
+        for(size_t k=0; k<m.get_dim()[2]; k++)
+        {   CHECK_EQUAL(true, reader.next()) ;
+            const Matrix2D<double>& slice = reader.get_slice() ;
+            for(size_t i=0; i<slice.get_nrow(); i++)
+            {   for(size_t j=0; j<slice.get_ncol(); j++)
+                {   CHECK_EQUAL(m(i, j, k), slice(i, j)) ; }
+            }
+        }
+        CHECK_EQUAL(false, reader.next()) ;
+        CHECK_THROW(Matrix3DSliceReader<int>("./src/Unittests/data/does_not_exist.mat"), std::runtime_error) ;
+    }
+
+    TEST(reader_4d)
+    {   for(size_t i=1; i<=20; i++)
+        {   std::string file_address = "./src/Unittests/data/matrix4d_int" + std::to_string(i) + ".mat" ;
+            std::vector<size_t> dim ;
+            size_t n_slice = 0 ;
+            Matrix4D<int> m ;
+            try
+            {   m = Matrix4D<int>(file_address) ; }
+            catch(std::runtime_error& e)
+            {   CHECK_THROW(read_slices<Matrix4DSliceReader<int>>(file_address, dim, n_slice), std::runtime_error) ;
+                continue ;
+            }
+            std::vector<int> values = read_slices<Matrix4DSliceReader<int>>(file_address, dim, n_slice) ;
+            CHECK_EQUAL(m.get_dim()[3], n_slice) ;
+            CHECK_EQUAL(m.get_data(), values) ;
+            if(n_slice > 0)
+            {   CHECK_EQUAL(std::vector<size_t>({m.get_dim()[0], m.get_dim()[1], m.get_dim()[2]}), dim) ; }
+        }
+
+        // next() and get_slice()
+        Matrix4D<double> m("./src/Unittests/data/matrix4d_double1.mat") ;
+        Matrix4DSliceReader<double> reader("./src/Unittests/data/matrix4d_double1.mat") ;
+        for(size_t l=0; l<m.get_dim()[3]; l++)
+        {   CHECK_EQUAL(true, reader.next()) ;
+            const Matrix3D<double>& slice = reader.get_slice() ;
+            CHECK_EQUAL(std::vector<size_t>({m.get_dim()[0], m.get_dim()[1], m.get_dim()[2]}), slice.get_dim()) ;
+            for(size_t i=0; i<slice.get_dim()[0]; i++)
+            {   for(size_t j=0; j<slice.get_dim()[1]; j++)
+                {   for(size_t k=0; k<slice.get_dim()[2]; k++)
+                    {   CHECK_EQUAL(m(i, j, k, l), slice(i, j, k)) ; }
+                }
+            }
+        }
+        CHECK_EQUAL(false, reader.next()) ;
+        CHECK_EQUAL(false, reader.next()) ;
+
+        // empty files do not have any slice
+        for(const char* file_address : {"./src/Unittests/data/matrix4d_int19.mat",
+                                         "./src/Unittests/data/matrix4d_int20.mat"})
+        {   Matrix4DSliceReader<int> reader_empty(file_address) ;
+            CHECK_EQUAL(false, reader_empty.next()) ;
+            CHECK_EQUAL(false, reader_empty.next()) ;
+        }
+    }
+}
+
+
+/*!
+ * \brief Reads all the bytes of a file.
+ * \param file_address the path to the file.
+ * \return the bytes.
+ */
+std::string read_file_bytes(const std::string& file_address)
+{   std::ifstream file(file_address, std::ifstream::binary) ;
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()) ;
+}
+
+SUITE(MatrixWriter)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixWriter tests..." << std::endl ; }
+
+    TEST(text)
+    {   std::string file_address = "./src/Unittests/data/matrix_writer_out.mat" ;
+
+        // 3D, the file is the one of print()
+        Matrix3D<double> m3(3, 4, 5) ;
+        for(size_t i=0; i<m3.get_data_size(); i++)
+        {   m3.set(i, i*0.25 - 3.) ; }
+        std::ostringstream stream_3d ;
+        m3.print(stream_3d, 3, 9, ',') ;
+        {   Matrix3DWriter<double> writer(file_address, MatrixWriterFormat::text, 3, 9, ',', false, 64) ;
+            for(size_t k=0; k<m3.get_dim()[2]; k++)
+            {   Matrix2D<double> slice(3, 4) ;
+                for(size_t i=0; i<3; i++)
+                {   for(size_t j=0; j<4; j++)
+                    {   slice(i, j) = m3(i, j, k) ; }
+                }
+                writer.write_slice(slice) ;
+            }
+            CHECK_EQUAL(5, writer.get_slice_number()) ;
+            CHECK_THROW(writer.write_slice(Matrix2D<double>(4, 3)), std::invalid_argument) ;
+            CHECK_THROW(writer.write_slice(Matrix2D<double>()), std::invalid_argument) ;
+            writer.close() ;
+            CHECK_THROW(writer.write_slice(Matrix2D<double>(3, 4)), std::runtime_error) ;
+        }
+        CHECK_EQUAL(stream_3d.str(), read_file_bytes(file_address)) ;
+
+        // 4D, the file being closed by the destructor
+        Matrix4D<int> m4(2, 3, 2, 3) ;
+        for(size_t i=0; i<m4.get_data_size(); i++)
+        {   m4.set(i, static_cast<int>(i) - 10) ; }
+        std::ostringstream stream_4d ;
+        m4.print(stream_4d) ;
+        {   Matrix4DWriter<int> writer(file_address) ;
+            for(size_t a=0; a<m4.get_dim()[3]; a++)
+            {   Matrix3D<int> slice(2, 3, 2) ;
+                for(size_t i=0; i<2; i++)
+                {   for(size_t j=0; j<3; j++)
+                    {   for(size_t k=0; k<2; k++)
+                        {   slice(i, j, k) = m4(i, j, k, a) ; }
+                    }
+                }
+                writer.write_slice(slice) ;
+            }
+        }
+        CHECK_EQUAL(stream_4d.str(), read_file_bytes(file_address)) ;
+        CHECK_EQUAL(m4.get_data(), Matrix4D<int>(file_address).get_data()) ;
+
+        // no slice, an empty file
+        {   Matrix3DWriter<int> writer(file_address) ; }
+        CHECK_EQUAL(std::string(), read_file_bytes(file_address)) ;
+        remove(file_address.c_str()) ;
+
+        CHECK_THROW(Matrix3DWriter<int>("./src/Unittests/does_not_exist/matrix.mat"), std::runtime_error) ;
+    }
+
+    TEST(binary)
+    {   std::string file_address     = "./src/Unittests/data/matrix_writer_out.bin" ;
+        std::string file_address_ref = "./src/Unittests/data/matrix_writer_ref.bin" ;
+
+        // 3D, the file is the one of save()
+        Matrix3D<float> m3(4, 3, 6) ;
+        for(size_t i=0; i<m3.get_data_size(); i++)
+        {   m3.set(i, i*1.5f) ; }
+        for(bool checksum : {false, true})
+        {   m3.save(file_address_ref, checksum) ;
+            Matrix3DWriter<float> writer(file_address, MatrixWriterFormat::binary, 4, 8, ' ', checksum, 100) ;
+            for(size_t k=0; k<m3.get_dim()[2]; k++)
+            {   Matrix2D<float> slice(4, 3) ;
+                for(size_t i=0; i<4; i++)
+                {   for(size_t j=0; j<3; j++)
+                    {   slice(i, j) = m3(i, j, k) ; }
+                }
+                writer.write_slice(slice) ;
+            }
+            writer.close() ;
+            CHECK_EQUAL(read_file_bytes(file_address_ref), read_file_bytes(file_address)) ;
+        }
+        Matrix3D<float> m3_load ;
+        m3_load.load(file_address) ;
+        CHECK_EQUAL(m3.get_dim(), m3_load.get_dim()) ;
+        CHECK_EQUAL(m3.get_data(), m3_load.get_data()) ;
+
+        // 4D
+        Matrix4D<double> m4(3, 2, 4, 2) ;
+        for(size_t i=0; i<m4.get_data_size(); i++)
+        {   m4.set(i, i*0.1) ; }
+        m4.save(file_address_ref) ;
+        {   Matrix4DWriter<double> writer(file_address, MatrixWriterFormat::binary) ;
+            for(size_t a=0; a<m4.get_dim()[3]; a++)
+            {   Matrix3D<double> slice(3, 2, 4) ;
+                for(size_t i=0; i<3; i++)
+                {   for(size_t j=0; j<2; j++)
+                    {   for(size_t k=0; k<4; k++)
+                        {   slice(i, j, k) = m4(i, j, k, a) ; }
+                    }
+                }
+                writer.write_slice(slice) ;
+            }
+        }
+        CHECK_EQUAL(read_file_bytes(file_address_ref), read_file_bytes(file_address)) ;
+
+        // no slice, an empty matrix
+        {   Matrix4DWriter<double> writer(file_address, MatrixWriterFormat::binary) ; }
+        m4.load(file_address) ;
+        CHECK_EQUAL(std::vector<size_t>(4, 0), m4.get_dim()) ;
+        CHECK_EQUAL(0, m4.get_data_size()) ;
+        remove(file_address.c_str()) ;
+        remove(file_address_ref.c_str()) ;
+    }
 }
 
+
+SUITE(MatrixAsync)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixAsync tests..." << std::endl ; }
+
+    TEST(load_save)
+    {   // several files written and read at the same time
+        std::vector<Matrix3D<double>> matrices ;
+        std::vector<std::string> file_addresses ;
+        std::vector<std::future<void>> saved ;
+        for(size_t n=0; n<6; n++)
+        {   Matrix3D<double> m(n+1, 3, 2) ;
+            for(size_t i=0; i<m.get_data_size(); i++)
+            {   m.set(i, n*100. + i) ; }
+            matrices.push_back(m) ;
+            file_addresses.push_back("./src/Unittests/data/matrix_async_out" + std::to_string(n) + ".bin") ;
+            saved.push_back(save_async(m, file_addresses.back(), n % 2 == 0)) ;
+        }
+        for(auto& future : saved)
+        {   future.get() ; }
+        std::vector<std::future<Matrix3D<double>>> loaded ;
+        for(const auto& file_address : file_addresses)
+        {   loaded.push_back(load_async<Matrix3D<double>>(file_address)) ; }
+        for(size_t n=0; n<loaded.size(); n++)
+        {   Matrix3D<double> m = loaded[n].get() ;
+            CHECK_EQUAL(matrices[n].get_dim(), m.get_dim()) ;
+            CHECK_EQUAL(matrices[n].get_data(), m.get_data()) ;
+        }
+
+        // text files, in another pool
+        ThreadPool pool(2) ;
+        Matrix4D<double> m4 = load_async<Matrix4D<double>>("./src/Unittests/data/matrix4d_double1.mat",
+                                                           MatrixWriterFormat::text,
+                                                           pool).get() ;
+        CHECK_EQUAL(Matrix4D<double>("./src/Unittests/data/matrix4d_double1.mat").get_data(), m4.get_data()) ;
+
+        // the errors are thrown by get()
+        std::future<Matrix3D<double>> missing = load_async<Matrix3D<double>>("./src/Unittests/data/does_not_exist.bin") ;
+        CHECK_THROW(missing.get(), std::runtime_error) ;
+        std::future<Matrix2D<double>> wrong_dim = load_async<Matrix2D<double>>(file_addresses[0]) ;
+        CHECK_THROW(wrong_dim.get(), std::runtime_error) ;
+        std::future<void> not_saved = save_async(matrices[0], "./src/Unittests/does_not_exist/matrix.bin") ;
+        CHECK_THROW(not_saved.get(), std::runtime_error) ;
+        for(const auto& file_address : file_addresses)
+        {   remove(file_address.c_str()) ; }
+    }
+
+    TEST(prefetcher)
+    {   std::vector<std::string> file_addresses ;
+        std::vector<Matrix2D<int>> matrices ;
+        for(size_t n=0; n<5; n++)
+        {   Matrix2D<int> m(n+2, 4, static_cast<int>(n)) ;
+            matrices.push_back(m) ;
+            file_addresses.push_back("./src/Unittests/data/matrix_async_out" + std::to_string(n) + ".bin") ;
+            m.save(file_addresses.back()) ;
+        }
+        for(size_t n_ahead : {0, 1, 3, 10})
+        {   MatrixPrefetcher<Matrix2D<int>> prefetcher(file_addresses, n_ahead) ;
+            size_t n = 0 ;
+            for(; prefetcher.has_next(); n++)
+            {   CHECK_EQUAL(n, prefetcher.get_file_index()) ;
+                Matrix2D<int> m = prefetcher.next() ;
+                CHECK_EQUAL(matrices[n].get_dim(), m.get_dim()) ;
+                CHECK_EQUAL(matrices[n].get_data(), m.get_data()) ;
+            }
+            CHECK_EQUAL(file_addresses.size(), n) ;
+            CHECK_THROW(prefetcher.next(), std::out_of_range) ;
+        }
+
+        // a file which cannot be read does not stop the next ones
+        std::vector<std::string> file_addresses_missing = {file_addresses[0],
+                                                           "./src/Unittests/data/does_not_exist.bin",
+                                                           file_addresses[1]} ;
+        MatrixPrefetcher<Matrix2D<int>> prefetcher(file_addresses_missing) ;
+        CHECK_EQUAL(matrices[0].get_data(), prefetcher.next().get_data()) ;
+        CHECK_THROW(prefetcher.next(), std::runtime_error) ;
+        CHECK_EQUAL(matrices[1].get_data(), prefetcher.next().get_data()) ;
+        CHECK_EQUAL(false, prefetcher.has_next()) ;
+
+        // text files
+        MatrixPrefetcher<Matrix2D<int>> prefetcher_text({"./src/Unittests/data/matrix2d_int1.mat"}, 2, MatrixWriterFormat::text) ;
+        CHECK_EQUAL(Matrix2D<int>("./src/Unittests/data/matrix2d_int1.mat").get_data(), prefetcher_text.next().get_data()) ;
+        for(const auto& file_address : file_addresses)
+        {   remove(file_address.c_str()) ; }
+    }
+}
+
+
+SUITE(MatrixIOEngine)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixIOEngine tests..." << std::endl ; }
+
+    TEST(read_write)
+    {   std::string file_address_1 = "./src/Unittests/data/matrix_io_out1.bin" ;
+        std::string file_address_2 = "./src/Unittests/data/matrix_io_out2.bin" ;
+        std::vector<char> bytes(100000) ;
+        for(size_t i=0; i<bytes.size(); i++)
+        {   bytes[i] = static_cast<char>((i*7919) % 251) ; }
+
+        // io_uring if available and pread(), small blocks and
+        // queues so that the blocks wait for each other
+        for(bool io_uring : {true, false})
+        {   MatrixIOEngine engine(3, 5000, io_uring) ;
+            CHECK_EQUAL(8192, engine.get_block_size()) ;
+            int fd_1 = open(file_address_1.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666) ;
+            int fd_2 = open(file_address_2.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666) ;
+            CHECK_EQUAL(true, engine.write(fd_1, bytes.data(), bytes.size(), 0)) ;
+            CHECK_EQUAL(true, engine.write({MatrixIORequest{fd_2, bytes.data() + 10, 50000, 0},
+                                            MatrixIORequest{fd_2, bytes.data() + 60000, 30001, 50000}})) ;
+
+            std::vector<char> values(bytes.size(), 0) ;
+            CHECK_EQUAL(true, engine.read(fd_1, values.data(), bytes.size(), 0)) ;
+            CHECK(bytes == values) ;
+            // several files at once
+            std::vector<char> values_1(999), values_2(35001) ;
+            CHECK_EQUAL(true, engine.read({MatrixIORequest{fd_1, values_1.data(), values_1.size(), 12345},
+                                           MatrixIORequest{fd_2, values_2.data(), values_2.size(), 45000}})) ;
+            CHECK(std::vector<char>(bytes.begin() + 12345, bytes.begin() + 12345 + 999) == values_1) ;
+            CHECK(std::vector<char>(bytes.begin() + 45010, bytes.begin() + 50010) == std::vector<char>(values_2.begin(), values_2.begin() + 5000)) ;
+            CHECK(std::vector<char>(bytes.begin() + 60000, bytes.begin() + 90001) == std::vector<char>(values_2.begin() + 5000, values_2.end())) ;
+            // past the end of the file
+            CHECK_EQUAL(false, engine.read(fd_1, values.data(), 10, bytes.size() - 5)) ;
+            CHECK_EQUAL(false, engine.read(-1, values.data(), 10, 0)) ;
+            close(fd_1) ;
+            close(fd_2) ;
+
+            // O_DIRECT, if the file system supports it, the
+            // reads being unaligned
+            MatrixIOEngine::set_direct(true) ;
+            int fd = MatrixIOEngine::open_read(file_address_1) ;
+            MatrixIOEngine::set_direct(false) ;
+            CHECK(fd >= 0) ;
+            std::vector<char> values_3(70002) ;
+            CHECK_EQUAL(true, engine.read(fd, values_3.data() + 1, 70001, 29999)) ;
+            CHECK(std::vector<char>(bytes.begin() + 29999, bytes.end()) == std::vector<char>(values_3.begin() + 1, values_3.end())) ;
+            CHECK_EQUAL(false, engine.read(fd, values_3.data(), 10, bytes.size() - 5)) ;
+            close(fd) ;
+        }
+        remove(file_address_1.c_str()) ;
+        remove(file_address_2.c_str()) ;
+    }
+
+    TEST(load_direct)
+    {   std::string file_address = "./src/Unittests/data/matrix_io_out.bin" ;
+        Matrix3D<double> m(37, 21, 11) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i*0.5) ; }
+        m.save(file_address, true) ;
+        MatrixIOEngine::set_direct(true) ;
+        Matrix3D<double> m_load ;
+        m_load.load(file_address) ;
+        Matrix3D<double> m_region ;
+        m_region.load_region(file_address, {3, 2, 1}, {30, 7, 9}) ;
+        MatrixIOEngine::set_direct(false) ;
+        CHECK_EQUAL(m.get_data(), m_load.get_data()) ;
+        for(size_t i=0; i<30; i++)
+        {   for(size_t j=0; j<7; j++)
+            {   for(size_t k=0; k<9; k++)
+                {   CHECK_EQUAL(m(i+3, j+2, k+1), m_region(i, j, k)) ; }
+            }
+        }
+        remove(file_address.c_str()) ;
+    }
+}
+
+
+SUITE(MatrixNpy)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixNpy tests..." << std::endl ; }
+
+    TEST(header)
+    {   // the shape is (rows, columns), in C order, and the values
+        // start at a multiple of 64 bytes
+        std::vector<char> header = encode_matrix_npy_header<double>({3, 2}) ;
+        std::string dict = "{'descr': '<f8', 'fortran_order': False, 'shape': (2, 3), }" ;
+        CHECK_EQUAL(std::string("\x93NUMPY\x01\x00\x76\x00", 10) + dict + std::string(58, ' ') + "\n",
+                    std::string(header.begin(), header.end())) ;
+        header = encode_matrix_npy_header<int32_t>({5}) ;
+        CHECK_EQUAL(128, header.size()) ;
+        CHECK_EQUAL("{'descr': '<i4', 'fortran_order': False, 'shape': (5,), }",
+                    std::string(header.begin() + 10, header.begin() + 10 + 57)) ;
+        header = encode_matrix_npy_header<char>({4, 3, 2, 1}) ;
+        CHECK_EQUAL("{'descr': '|S1', 'fortran_order': False, 'shape': (1, 2, 3, 4), }",
+                    std::string(header.begin() + 10, header.begin() + 10 + 65)) ;
+        // the checksum of the zip files
+        CHECK_EQUAL(0xCBF43926, crc32_zip("123456789", 9)) ;
+        CHECK_EQUAL(0xCBF43926, crc32_zip("6789", 4, crc32_zip("12345", 5))) ;
+    }
+
+    TEST(save_load)
+    {   std::string file_address = "./src/Unittests/data/matrix_npy_out.npy" ;
+        Matrix2D<double> m2(3, 4) ;
+        Matrix3D<int> m3(3, 4, 5) ;
+        Matrix4D<float> m4(2, 3, 4, 5) ;
+        MatrixN<short,5> m5({2, 3, 1, 2, 3}) ;
+        for(size_t i=0; i<m2.get_data_size(); i++)
+        {   m2.set(i, i*0.5) ; }
+        for(size_t i=0; i<m3.get_data_size(); i++)
+        {   m3.set(i, static_cast<int>(i) - 30) ; }
+        for(size_t i=0; i<m4.get_data_size(); i++)
+        {   m4.set(i, i*0.25f) ; }
+        for(size_t i=0; i<m5.get_data_size(); i++)
+        {   m5.set(i, static_cast<short>(i)) ; }
+
+        m2.save_npy(file_address) ;
+        CHECK_EQUAL(128 + 12*8, read_file_bytes(file_address).size()) ;
+        Matrix2D<double> m2_load ;
+        m2_load.load_npy(file_address) ;
+        CHECK_EQUAL(m2, m2_load) ;
+        Matrix2D<double> m2_map ;
+        m2_map.map_npy(file_address) ;
+        CHECK_EQUAL(m2, m2_map) ;
+        Matrix3D<double> m_wrong ;
+        CHECK_THROW(m_wrong.load_npy(file_address), std::runtime_error) ;
+
+        m3.save_npy(file_address) ;
+        Matrix3D<int> m3_load ;
+        m3_load.map_npy(file_address, MatrixMapMode::copy_on_write) ;
+        CHECK_EQUAL(m3, m3_load) ;
+        CHECK_EQUAL(m3(2, 1, 4), m3_load(2, 1, 4)) ;
+        // the values are widened but cannot be mapped
+        Matrix3D<double> m3_double ;
+        m3_double.load_npy(file_address) ;
+        CHECK_EQUAL(m3.get_dim(), m3_double.get_dim()) ;
+        CHECK_EQUAL(-30.0, m3_double(0, 0, 0)) ;
+        CHECK_EQUAL(29.0, m3_double(2, 3, 4)) ;
+        CHECK_THROW(m3_double.map_npy(file_address), std::runtime_error) ;
+
+        m4.save_npy(file_address) ;
+        Matrix4D<float> m4_load ;
+        m4_load.load_npy(file_address) ;
+        CHECK_EQUAL(m4, m4_load) ;
+        // through a Matrix reference, the offsets follow the dimensions
+        Matrix4D<float> m4_base(1, 1, 1, 1) ;
+        Matrix<float>& m4_base_ref = m4_base ;
+        m4_base_ref.load_npy(file_address, 4) ;
+        CHECK_EQUAL(m4(1,2,3,4), m4_base(1,2,3,4)) ;
+        m4_base = Matrix4D<float>(1, 1, 1, 1) ;
+        m4_base_ref.map_npy(file_address, 4, MatrixMapMode::read_only) ;
+        CHECK_EQUAL(m4(1,2,3,4), m4_base(1,2,3,4)) ;
+        CHECK_THROW(m4_base_ref.load_npy(file_address, 3), std::invalid_argument) ;
+        m3.save_npy(file_address) ;
+        Matrix3D<int> m3_base(1, 1, 1) ;
+        Matrix<int>& m3_base_ref = m3_base ;
+        m3_base_ref.map_npy(file_address, 3, MatrixMapMode::read_only) ;
+        CHECK_EQUAL(m3(2,1,4), m3_base(2,1,4)) ;
+        m2.save_npy(file_address) ;
+        Matrix2D<double> m2_base(1, 1) ;
+        Matrix<double>& m2_base_ref = m2_base ;
+        m2_base_ref.load_npy(file_address, 2) ;
+        CHECK_EQUAL(m2(2,3), m2_base(2,3)) ;
+        m2_base = Matrix2D<double>(1, 1) ;
+        m2_base_ref.map_npy(file_address, 2, MatrixMapMode::read_only) ;
+        CHECK_EQUAL(m2(2,3), m2_base(2,3)) ;
+        CHECK_THROW(m2_base_ref.map_npy(file_address, 1, MatrixMapMode::read_only), std::invalid_argument) ;
+
+        m5.save_npy(file_address) ;
+        MatrixN<short,5> m5_load ;
+        m5_load.load_npy(file_address) ;
+        CHECK_EQUAL(m5.get_data(), m5_load.get_data()) ;
+        CHECK_EQUAL(m5(1, 2, 0, 1, 2), m5_load(1, 2, 0, 1, 2)) ;
+        remove(file_address.c_str()) ;
+    }
+
+    TEST(fortran_order)
+    {   std::string file_address = "./src/Unittests/data/matrix_npy_out.npy" ;
+        // a 2x3 array of little endian int16 in Fortran order
+        std::string dict = "{'descr': '<i2', 'fortran_order': True, 'shape': (2, 3)}\n" ;
+        std::string bytes = std::string("\x93NUMPY\x01\x00", 8) ;
+        bytes.push_back(static_cast<char>(dict.size())) ;
+        bytes.push_back(0) ;
+        bytes += dict ;
+        for(int value : {0, 10, 1, 11, 2, 12})
+        {   bytes.push_back(static_cast<char>(value)) ;
+            bytes.push_back(0) ;
+        }
+        std::ofstream(file_address, std::ios::binary) << bytes ;
+
+        Matrix2D<int> m ;
+        m.load_npy(file_address) ;
+        CHECK_EQUAL((std::vector<size_t>{2, 3}), m.get_dim()) ;
+        CHECK_EQUAL((std::vector<int>{0, 1, 2, 10, 11, 12}), m.get_data()) ;
+        Matrix2D<short> m_short ;
+        CHECK_THROW(m_short.map_npy(file_address), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+
+    TEST(npz)
+    {   std::string file_address = "./src/Unittests/data/matrix_npz_out.npz" ;
+        Matrix2D<double> m2(7, 3) ;
+        Matrix3D<int> m3(3, 4, 5) ;
+        for(size_t i=0; i<m2.get_data_size(); i++)
+        {   m2.set(i, i*0.5) ; }
+        for(size_t i=0; i<m3.get_data_size(); i++)
+        {   m3.set(i, static_cast<int>(i)) ; }
+        {   MatrixNpzWriter writer(file_address) ;
+            writer.add("m2", m2) ;
+            writer.add("m3", m3) ;
+            CHECK_THROW(writer.add("m2", m2), std::invalid_argument) ;
+            writer.close() ;
+            CHECK_THROW(writer.add("m4", m2), std::runtime_error) ;
+        }
+
+        Matrix2D<double> m2_load ;
+        m2_load.load_npy(file_address) ;
+        CHECK_EQUAL(m2, m2_load) ;
+        Matrix3D<int> m3_load ;
+        m3_load.load_npy(file_address, "m3.npy") ;
+        CHECK_EQUAL(m3, m3_load) ;
+        // the values of the members are aligned
+        Matrix2D<double> m2_map ;
+        m2_map.map_npy(file_address, MatrixMapMode::read_only, "m2") ;
+        CHECK_EQUAL(m2, m2_map) ;
+        Matrix3D<int> m3_map ;
+        m3_map.map_npy(file_address, MatrixMapMode::read_only, "m3") ;
+        CHECK_EQUAL(m3, m3_map) ;
+        CHECK_THROW(m3_map.load_npy(file_address, "m4"), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+
+    TEST(invalid)
+    {   std::string file_address = "./src/Unittests/data/matrix_npy_out.npy" ;
+        // a version 1 file of 2x3 bytes, given its header and its
+        // number of values
+        auto make_file = [&file_address](const std::string& dict, size_t n)
+                         {   std::string bytes = std::string("\x93NUMPY\x01\x00", 8) ;
+                             bytes.push_back(static_cast<char>(dict.size())) ;
+                             bytes.push_back(0) ;
+                             bytes += dict + std::string(n, '\x01') ;
+                             std::ofstream(file_address, std::ios::binary) << bytes ;
+                         } ;
+        Matrix2D<unsigned char> m ;
+        make_file("{'descr': '|u1', 'fortran_order': False, 'shape': (2, 3)}\n", 6) ;
+        m.load_npy(file_address) ;
+        CHECK_EQUAL((std::vector<size_t>{2, 3}), m.get_dim()) ;
+        m.map_npy(file_address) ;
+        CHECK_EQUAL(1, m(1, 2)) ;
+
+        // a binary file
+        CHECK_THROW(m.load_npy("./src/Unittests/data/matrix2d_int1.mat"), std::runtime_error) ;
+        CHECK_THROW(m.map_npy("./src/Unittests/data/matrix2d_int1.mat"), std::runtime_error) ;
+
+        // truncated values
+        make_file("{'descr': '|u1', 'fortran_order': False, 'shape': (2, 3)}\n", 5) ;
+        CHECK_THROW(m.load_npy(file_address), std::runtime_error) ;
+        CHECK_THROW(m.map_npy(file_address), std::runtime_error) ;
+
+        // a shape which number of values overflows
+        make_file("{'descr': '|u1', 'fortran_order': False, 'shape': (4611686018427387904, 4)}\n", 6) ;
+        CHECK_THROW(m.load_npy(file_address), std::runtime_error) ;
+        CHECK_THROW(m.map_npy(file_address), std::runtime_error) ;
+        CHECK_EQUAL((std::vector<size_t>{2, 3}), m.get_dim()) ;
+
+        // a version 2 header longer than the file
+        std::string bytes = std::string("\x93NUMPY\x02\x00\xff\xff\xff\xff", 12) + "{'descr': '|u1'" ;
+        std::ofstream(file_address, std::ios::binary) << bytes ;
+        CHECK_THROW(m.load_npy(file_address), std::runtime_error) ;
+        CHECK_THROW(m.map_npy(file_address), std::runtime_error) ;
+
+        // a truncated prefix
+        std::ofstream(file_address, std::ios::binary) << std::string("\x93NUMPY\x01", 7) ;
+        CHECK_THROW(m.load_npy(file_address), std::runtime_error) ;
+        remove(file_address.c_str()) ;
+    }
+}
+
+
+SUITE(MatrixShared)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixShared tests..." << std::endl ; }
+
+    TEST(create_attach)
+    {   std::string name = "/matrix_cpp_unittests_" + std::to_string(getpid()) ;
+        Matrix4D<double> m(3, 4, 5, 6) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i*0.5) ; }
+        Matrix4D<double> m_copy(m) ;
+        m.create_shared(name) ;
+        CHECK_EQUAL(m_copy, m) ;
+        CHECK_THROW(Matrix2D<double>(2, 2).create_shared(name), std::runtime_error) ;
+
+        // the values are shared, not copied
+        Matrix4D<double> m_attached ;
+        m_attached.attach_shared(name) ;
+        CHECK_EQUAL(m, m_attached) ;
+        CHECK(m.get_data_ptr() != m_attached.get_data_ptr()) ;
+        m(2, 3, 4, 5) = -1. ;
+        CHECK_EQUAL(-1., m_attached(2, 3, 4, 5)) ;
+        Matrix3D<double> m_wrong ;
+        CHECK_THROW(m_wrong.attach_shared(name), std::runtime_error) ;
+        Matrix4D<float> m_float ;
+        CHECK_THROW(m_float.attach_shared(name), std::runtime_error) ;
+        // through a Matrix reference, the offsets follow the dimensions
+        Matrix4D<double> m_base(1, 1, 1, 1) ;
+        Matrix<double>& m_base_ref = m_base ;
+        m_base_ref.attach_shared(name, 4) ;
+        CHECK_EQUAL(-1., m_base(2, 3, 4, 5)) ;
+        CHECK_THROW(m_base_ref.attach_shared(name, 3), std::invalid_argument) ;
+
+        // from another process
+        pid_t pid = fork() ;
+        if(pid == 0)
+        {   Matrix4D<double> m_child ;
+            m_child.attach_shared(name) ;
+            _exit((m_child(2, 3, 4, 5) == -1. and m_child(1, 2, 3, 4) == m_copy(1, 2, 3, 4)) ? 0 : 1) ;
+        }
+        int status = -1 ;
+        waitpid(pid, &status, 0) ;
+        CHECK_EQUAL(0, status) ;
+
+        // the name is removed with the values of the creator,
+        // the attached matrices remain valid
+        m = Matrix4D<double>() ;
+        CHECK_THROW(Matrix4D<double>().attach_shared(name), std::runtime_error) ;
+        CHECK_EQUAL(-1., m_attached(2, 3, 4, 5)) ;
+        CHECK_EQUAL(false, Matrix<double>::remove_shared(name)) ;
+    }
+
+    TEST(persistent)
+    {   std::string name = "matrix_cpp_unittests_persistent_" + std::to_string(getpid()) ;
+        {   Matrix2D<int> m(3, 4, 7) ;
+            m.create_shared(name, true) ;
+        }
+        Matrix2D<int> m_attached ;
+        m_attached.attach_shared(name) ;
+        CHECK_EQUAL(Matrix2D<int>(3, 4, 7), m_attached) ;
+        Matrix2D<int> m_base(1, 1) ;
+        Matrix<int>& m_base_ref = m_base ;
+        m_base_ref.attach_shared(name, 2) ;
+        CHECK_EQUAL(7, m_base(2, 3)) ;
+        CHECK_EQUAL(std::vector<int>(4, 7), m_base.get_row(2)) ;
+        // the object has the layout of a binary file
+        Matrix2D<int> m_file ;
+        m_file.load("/dev/shm/" + name) ;
+        CHECK_EQUAL(m_attached, m_file) ;
+        CHECK_EQUAL(true, Matrix<int>::remove_shared(name)) ;
+        CHECK_THROW(m_file.attach_shared(name), std::runtime_error) ;
+    }
+}
+
+
+/*!
+ * \brief An allocator counting the values allocated.
+ */
+template<class T>
+struct counting_allocator : public std::allocator<T>
+{   template<class U>
+    struct rebind
+    {   typedef counting_allocator<U> other ; } ;
+
+    counting_allocator() = default ;
+
+    template<class U>
+    counting_allocator(const counting_allocator<U>&)
+    {}
+
+    T* allocate(size_t n)
+    {   get_count() += n ;
+        return std::allocator<T>::allocate(n) ;
+    }
+
+    static size_t& get_count()
+    {   static size_t count = 0 ;
+        return count ;
+    }
+} ;
+
+SUITE(MatrixAllocator)
+{
+    TEST(message)
+    {   std::cout << "Starting MatrixAllocator tests..." << std::endl ; }
+
+    TEST(aligned)
+    {   // the values are aligned whatever the number of values
+        for(size_t n : {1, 3, 17, 1000})
+        {   Matrix2D<double> m2(n, 3, 1.) ;
+            Matrix3D<char> m3(n, 1, 1) ;
+            Matrix4D<int> m4(2, n, 1, 3) ;
+            CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m2.get_data_ptr()) % matrix_default_alignment) ;
+            CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m3.get_data_ptr()) % matrix_default_alignment) ;
+            CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m4.get_data_ptr()) % matrix_default_alignment) ;
+            Matrix2D<double> m_copy(m2 + m2) ;
+            CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m_copy.get_data_ptr()) % matrix_default_alignment) ;
+        }
+        Matrix2D<float, MatrixAlignedAllocator<float, 4096>> m(5, 5) ;
+        CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m.get_data_ptr()) % 4096) ;
+        Matrix3D<double> m_text("./src/Unittests/data/matrix3d_double.mat") ;
+        CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m_text.get_data_ptr()) % matrix_default_alignment) ;
+    }
+
+    TEST(custom)
+    {   typedef counting_allocator<double> allocator ;
+        size_t count = allocator::get_count() ;
+        Matrix2D<double, allocator> m2(3, 4, 2.) ;
+        CHECK(allocator::get_count() >= count + 12) ;
+        Matrix2D<double, allocator> m2_sum(m2 + m2 * 2.) ;
+        CHECK_EQUAL(6., m2_sum(2, 3)) ;
+        CHECK(allocator::get_count() >= count + 24) ;
+
+        // the files are read in memory of the allocator
+        std::string file_address = "./src/Unittests/data/matrix_allocator_out.bin" ;
+        Matrix3D<double> m3(2, 3, 4) ;
+        for(size_t i=0; i<m3.get_data_size(); i++)
+        {   m3.set(i, i*0.5) ; }
+        m3.save(file_address) ;
+        count = allocator::get_count() ;
+        Matrix3D<double, allocator> m3_load ;
+        m3_load.load(file_address) ;
+        CHECK(allocator::get_count() >= count + 24) ;
+        CHECK_EQUAL(m3.get_data(), m3_load.get_data()) ;
+        remove(file_address.c_str()) ;
+
+        Matrix4D<int, std::allocator<int>> m4(2, 2, 2, 2, 1) ;
+        Matrix4D<int, std::allocator<int>> m4_copy(m4) ;
+        CHECK_EQUAL(m4, m4_copy) ;
+    }
+
+    TEST(pages)
+    {   // the large matrices are aligned on huge pages, the small
+        // ones as by default
+        typedef MatrixPageAllocator<double> allocator ;
+        Matrix2D<double, allocator> m_small(10, 10, 1.) ;
+        Matrix3D<double, allocator> m_large(512, 256, 3, 2.) ;
+        CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m_small.get_data_ptr()) % matrix_default_alignment) ;
+        CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m_large.get_data_ptr()) % matrix_huge_page_size) ;
+        CHECK_EQUAL(2., m_large(511, 255, 2)) ;
+        Matrix3D<double, allocator> m_sum(m_large + m_large) ;
+        CHECK_EQUAL(4., m_sum(100, 200, 1)) ;
+        m_large = Matrix3D<double, allocator>(1, 1, 1, 5.) ;
+        CHECK_EQUAL(5., m_large(0, 0, 0)) ;
+
+        Matrix2D<int, MatrixPageAllocator<int, matrix_page_interleave>> m_interleaved(1024, 1024, 7) ;
+        CHECK_EQUAL(7, m_interleaved(1023, 1023)) ;
+        Matrix2D<int, MatrixPageAllocator<int, matrix_page_huge | matrix_page_interleave | matrix_page_first_touch>> m_all(1024, 1024, 8) ;
+        CHECK_EQUAL(8, m_all(512, 0)) ;
+    }
+
+    TEST(scratch)
+    {   typedef MatrixScratchAllocator<double> allocator ;
+        MatrixScratchArena& arena = MatrixScratchArena::get() ;
+        size_t used = arena.get_used_size() ;
+        // outside of a scope, the values are allocated as by default
+        Matrix2D<double, allocator> m(4, 5, 1.) ;
+        CHECK(not arena.owns(m.get_data_ptr())) ;
+        CHECK_EQUAL(used, arena.get_used_size()) ;
+
+        const double* data = nullptr ;
+        for(size_t i=0; i<3; i++)
+        {   MatrixScratchScope scope ;
+            Matrix2D<double, allocator> m_sum(m + m) ;
+            Matrix2D<double, allocator> m_t(transpose(m_sum)) ;
+            CHECK(arena.owns(m_sum.get_data_ptr())) ;
+            CHECK(arena.owns(m_t.get_data_ptr())) ;
+            CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m_t.get_data_ptr()) % matrix_default_alignment) ;
+            CHECK_EQUAL(5, m_t.get_nrow()) ;
+            CHECK_EQUAL(2., m_t(4, 3)) ;
+            // each scope reuses the memory of the previous one
+            if(i == 0)
+            {   data = m_sum.get_data_ptr() ; }
+            CHECK_EQUAL(data, m_sum.get_data_ptr()) ;
+            {   MatrixScratchScope nested ;
+                Matrix2D<double, allocator> m_nested(100, 100, 3.) ;
+                CHECK_EQUAL(3., m_nested(99, 99)) ;
+            }
+            CHECK(arena.get_used_size() < used + 100*100*sizeof(double)) ;
+        }
+        CHECK_EQUAL(used, arena.get_used_size()) ;
+        CHECK_EQUAL(0, arena.get_scope_number()) ;
+    }
+
+    TEST(pool)
+    {   typedef MatrixPoolAllocator<double> allocator ;
+        MatrixBufferPool& pool = MatrixBufferPool::get() ;
+        pool.clear() ;
+        Matrix2D<double, allocator> m(6, 7, 1.) ;
+        const double* data = nullptr ;
+        // the temporaries of the same size reuse the same buffer
+        for(size_t i=0; i<3; i++)
+        {   Matrix2D<double, allocator> m_sum(m + m * 2.) ;
+            CHECK_EQUAL(3., m_sum(5, 6)) ;
+            CHECK_EQUAL(0, reinterpret_cast<uintptr_t>(m_sum.get_data_ptr()) % matrix_default_alignment) ;
+            if(i == 0)
+            {   data = m_sum.get_data_ptr() ; }
+            CHECK_EQUAL(data, m_sum.get_data_ptr()) ;
+        }
+        CHECK_EQUAL(6*7*sizeof(double), pool.get_size()) ;
+
+        // the pool keeps at most its maximal size
+        pool.set_max_size(100) ;
+        CHECK_EQUAL(0, pool.get_size()) ;
+        {   Matrix2D<double, allocator> m_small(2, 2, 0.) ;
+            Matrix2D<double, allocator> m_large(20, 20, 0.) ;
+        }
+        CHECK_EQUAL(2*2*sizeof(double), pool.get_size()) ;
+
+        // the buffers released the longest time ago are freed first
+        pool.clear() ;
+        pool.set_max_size(128 + 192 + 256) ;
+        void* p1 = pool.allocate(128) ;
+        void* p2 = pool.allocate(192) ;
+        void* p3 = pool.allocate(256) ;
+        void* p4 = pool.allocate(128) ;
+        pool.deallocate(p1, 128) ;
+        pool.deallocate(p2, 192) ;
+        pool.deallocate(p3, 256) ;
+        pool.deallocate(p4, 128) ;  // p1 is freed
+        CHECK_EQUAL(192 + 256 + 128, pool.get_size()) ;
+        CHECK_EQUAL(p4, pool.allocate(128)) ;
+        pool.deallocate(p4, 128) ;
+        pool.set_max_size(256 + 128) ;  // p2 is freed
+        CHECK_EQUAL(256 + 128, pool.get_size()) ;
+        CHECK_EQUAL(p3, pool.allocate(256)) ;
+        CHECK_EQUAL(p4, pool.allocate(128)) ;
+        CHECK_EQUAL(0, pool.get_size()) ;
+        pool.deallocate(p3, 256) ;
+        pool.deallocate(p4, 128) ;
+
+        pool.set_max_size(1 << 28) ;
+        pool.clear() ;
+        CHECK_EQUAL(0, pool.get_size()) ;
+    }
+}
+
+
+SUITE(SmallMatrix2D)
+{
+    TEST(message)
+    {   std::cout << "Starting SmallMatrix2D tests..." << std::endl ; }
+
+    TEST(constructor)
+    {   // the values are held by the object
+        CHECK((std::is_trivially_copyable<SmallMatrix2D<double,9>>::value)) ;
+        CHECK_EQUAL(2*sizeof(size_t) + 9*sizeof(double), sizeof(SmallMatrix2D<double,9>)) ;
+
+        SmallMatrix2D<double> m0 ;
+        CHECK_EQUAL(0, m0.get_nrow()) ;
+        CHECK_EQUAL(0, m0.get_data_size()) ;
+
+        SmallMatrix2D<int,9> m1(3, 3, 7) ;
+        CHECK_EQUAL(3, m1.get_nrow()) ;
+        CHECK_EQUAL(3, m1.get_ncol()) ;
+        CHECK_EQUAL(7, m1(2, 2)) ;
+
+        SmallMatrix2D<int,9> m2(2, 3, {1, 2, 3,
+                                      4, 5, 6}) ;
+        CHECK_EQUAL(6, m2.get(1, 2)) ;
+        CHECK_EQUAL(2, m2(0, 1)) ;
+        m2.set(1, 0, 10) ;
+        CHECK_EQUAL(10, m2(1, 0)) ;
+        CHECK_THROW(m2.get(2, 0), std::out_of_range) ;
+        CHECK_THROW(m2.set(0, 3, 1), std::out_of_range) ;
+
+        SmallMatrix2D<int,9> m2_copy(m2) ;
+        CHECK(m2 == m2_copy) ;
+        m2_copy(0, 0) = 0 ;
+        CHECK(m2 != m2_copy) ;
+
+        CHECK_THROW((SmallMatrix2D<int,9>(2, 5)), std::invalid_argument) ;
+        CHECK_THROW((SmallMatrix2D<int,9>(2, 2, {1, 2, 3})), std::invalid_argument) ;
+    }
+
+    TEST(convert)
+    {   Matrix2D<double> m(3, 4) ;
+        for(size_t i=0; i<m.get_data_size(); i++)
+        {   m.set(i, i*0.5) ; }
+        SmallMatrix2D<double> m_small(m) ;
+        CHECK_EQUAL(3, m_small.get_nrow()) ;
+        CHECK_EQUAL(4, m_small.get_ncol()) ;
+        for(size_t i=0; i<3; i++)
+        {   for(size_t j=0; j<4; j++)
+            {   CHECK_EQUAL(m(i,j), m_small(i,j)) ; }
+        }
+        CHECK_EQUAL(m, m_small.to_matrix2d()) ;
+        CHECK_THROW((SmallMatrix2D<double,9>(m)), std::invalid_argument) ;
+
+        std::ostringstream stream, stream_small ;
+        stream << m ;
+        stream_small << m_small ;
+        CHECK_EQUAL(stream.str(), stream_small.str()) ;
+    }
+
+    TEST(operators)
+    {   SmallMatrix2D<int,9> m1(2, 2, {1, 2,
+                                      3, 4}) ;
+        SmallMatrix2D<int,9> m2(2, 2, 2) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {3, 4, 5, 6})   == m1 + m2)) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {-1, 0, 1, 2})  == m1 - m2)) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {2, 4, 6, 8})   == m1 * m2)) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {0, 1, 1, 2})   == m1 / m2)) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {2, 3, 4, 5})   == m1 + 1)) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {0, 1, 2, 3})   == m1 - 1)) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {3, 6, 9, 12})  == m1 * 3)) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {0, 1, 1, 2})   == m1 / 2)) ;
+        m1 += m2 ;
+        m1 *= 2 ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {6, 8, 10, 12}) == m1)) ;
+        CHECK_THROW((m1 += SmallMatrix2D<int,9>(1, 2)), std::invalid_argument) ;
+        // division by 0
+        CHECK_THROW(m1 /= 0, std::invalid_argument) ;
+        CHECK_THROW(m1 / 0, std::invalid_argument) ;
+        SmallMatrix2D<int,9> m_zero(2, 2, {1, 2, 0, 4}) ;
+        CHECK_THROW(m1 /= m_zero, std::invalid_argument) ;
+        CHECK_THROW(m1 / m_zero, std::invalid_argument) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {6, 8, 10, 12}) == m1)) ;
+    }
+
+    TEST(multiply_transpose)
+    {   SmallMatrix2D<int,9> m1(2, 3, {1, 2, 3,
+                                      4, 5, 6}) ;
+        SmallMatrix2D<int,9> m1_t = transpose(m1) ;
+        CHECK((SmallMatrix2D<int,9>(3, 2, {1, 4,
+                                           2, 5,
+                                           3, 6}) == m1_t)) ;
+        SmallMatrix2D<int,9> m3 = multiply(m1, m1_t) ;
+        CHECK((SmallMatrix2D<int,9>(2, 2, {14, 32,
+                                           32, 77}) == m3)) ;
+        // the same product as Matrix2D
+        CHECK_EQUAL(multiply(m1.to_matrix2d(), m1_t.to_matrix2d()), m3.to_matrix2d()) ;
+        CHECK_THROW(multiply(m1, m1), std::invalid_argument) ;
+    }
+}
+
+
+SUITE(FixedMatrix)
+{
+    TEST(message)
+    {   std::cout << "Starting FixedMatrix tests..." << std::endl ; }
+
+    TEST(constructor)
+    {   // the dimensions are constant expressions and the values are
+        // held by the object
+        static_assert(FixedMatrix<double,3,4>::get_data_size() == 12, "wrong size") ;
+        static_assert(FixedMatrix<double,3,4>::get_stride(0) == 4, "wrong stride") ;
+        static_assert(FixedMatrix<double,2,3,4>::get_stride(2) == 6, "wrong stride") ;
+        static_assert(FixedMatrix<double,2,3,4,5>::get_stride(3) == 24, "wrong stride") ;
+        static_assert(FixedMatrix<double,2,3,4,5>::get_dim(3) == 5, "wrong dimension") ;
+        CHECK_EQUAL(9*sizeof(double), sizeof(FixedMatrix<double,3,3>)) ;
+        CHECK((std::is_trivially_copyable<FixedMatrix<double,3,3>>::value)) ;
+
+        FixedMatrix<int,2,3> m0 ;
+        CHECK((FixedMatrix<int,2,3>(0) == m0)) ;
+        FixedMatrix<int,2,3> m1 = {1, 2, 3,
+                                   4, 5, 6} ;
+        CHECK_EQUAL(2, m1(0, 1)) ;
+        CHECK_EQUAL(4, m1(1, 0)) ;
+        m1(1, 2) = 10 ;
+        CHECK_EQUAL(10, m1.get_data_ptr()[5]) ;
+        CHECK(m1 != m0) ;
+        CHECK_THROW((FixedMatrix<int,2,2>{1, 2, 3}), std::invalid_argument) ;
+
+        FixedMatrix<int,5> m_1d(3) ;
+        CHECK_EQUAL(3, m_1d(4)) ;
+    }
+
+    TEST(convert)
+    {   // the values are stored in the order of the other classes
+        Matrix2D<double> m2(3, 4) ;
+        Matrix3D<double> m3(2, 3, 4) ;
+        Matrix4D<double> m4(2, 3, 2, 2) ;
+        for(size_t i=0; i<m3.get_data_size(); i++)
+        {   m2.set(i % 12, i*0.5) ;
+            m3.set(i, i*0.5) ;
+            m4.set(i, i*0.5) ;
+        }
+        FixedMatrix<double,3,4> f2(m2) ;
+        FixedMatrix<double,2,3,4> f3(m3) ;
+        FixedMatrix<double,2,3,2,2> f4(m4) ;
+        CHECK_EQUAL(m2(2, 1), f2(2, 1)) ;
+        CHECK_EQUAL(m3(1, 2, 3), f3(1, 2, 3)) ;
+        CHECK_EQUAL(m3(0, 1, 2), f3(0, 1, 2)) ;
+        CHECK_EQUAL(m4(1, 2, 1, 0), f4(1, 2, 1, 0)) ;
+        CHECK_EQUAL(m4(0, 1, 0, 1), f4(0, 1, 0, 1)) ;
+        CHECK_EQUAL(m2, f2.to_matrix()) ;
+        CHECK_EQUAL(m3, f3.to_matrix()) ;
+        CHECK_EQUAL(m4, f4.to_matrix()) ;
+        Matrix<double> m1 = FixedMatrix<double,3>{1., 2., 3.}.to_matrix() ;
+        CHECK_EQUAL(std::vector<size_t>({3}), m1.get_dim()) ;
+        CHECK_THROW((FixedMatrix<double,4,3>(m2)), std::invalid_argument) ;
+        CHECK_THROW((FixedMatrix<double,3,4>(m3)), std::invalid_argument) ;
+
+        std::ostringstream stream, stream_fixed ;
+        stream << m2 ;
+        stream_fixed << f2 ;
+        CHECK_EQUAL(stream.str(), stream_fixed.str()) ;
+    }
+
+    TEST(operators)
+    {   FixedMatrix<double,2,2> m1 = {1., 2.,
+                                      3., 4.} ;
+        FixedMatrix<double,2,2> m2(2.) ;
+        CHECK((FixedMatrix<double,2,2>{3., 4., 5., 6.})   == m1 + m2) ;
+        CHECK((FixedMatrix<double,2,2>{-1., 0., 1., 2.})  == m1 - m2) ;
+        CHECK((FixedMatrix<double,2,2>{2., 4., 6., 8.})   == m1 * m2) ;
+        CHECK((FixedMatrix<double,2,2>{.5, 1., 1.5, 2.})  == m1 / m2) ;
+        CHECK((FixedMatrix<double,2,2>{2., 3., 4., 5.})   == m1 + 1) ;
+        CHECK((FixedMatrix<double,2,2>{0., 1., 2., 3.})   == m1 - 1) ;
+        CHECK((FixedMatrix<double,2,2>{3., 6., 9., 12.})  == m1 * 3) ;
+        CHECK((FixedMatrix<double,2,2>{.5, 1., 1.5, 2.})  == m1 / 2) ;
+        m1 += m2 ;
+        m1 *= 2. ;
+        CHECK((FixedMatrix<double,2,2>{6., 8., 10., 12.}) == m1) ;
+
+        // beyond the unrolled sizes
+        FixedMatrix<int,10,10> m_large(1) ;
+        m_large += m_large ;
+        CHECK_EQUAL(2, m_large(9, 9)) ;
+
+        // division by 0
+        CHECK_THROW(m_large /= 0, std::invalid_argument) ;
+        CHECK_THROW(m_large / 0, std::invalid_argument) ;
+        CHECK_THROW(m1 /= 0., std::invalid_argument) ;
+        FixedMatrix<int,10,10> m_zero(3) ;
+        m_zero(4, 7) = 0 ;
+        CHECK_THROW(m_large /= m_zero, std::invalid_argument) ;
+        CHECK_THROW(m_large / m_zero, std::invalid_argument) ;
+        FixedMatrix<int,2,2> m_small = {1, 2, 3, 4} ;
+        CHECK_THROW(m_small /= (FixedMatrix<int,2,2>{1, 0, 1, 1}), std::invalid_argument) ;
+        CHECK((FixedMatrix<int,2,2>{1, 2, 3, 4}) == m_small) ;
+        CHECK_EQUAL(2, m_large(9, 9)) ;
+        CHECK_EQUAL(2, m_large(0, 0)) ;
+    }
+
+    TEST(multiply_transpose)
+    {   FixedMatrix<int,2,3> m1 = {1, 2, 3,
+                                   4, 5, 6} ;
+        FixedMatrix<int,3,2> m1_t = transpose(m1) ;
+        CHECK((FixedMatrix<int,3,2>{1, 4,
+                                    2, 5,
+                                    3, 6}) == m1_t) ;
+        FixedMatrix<int,2,2> m2 = multiply(m1, m1_t) ;
+        CHECK((FixedMatrix<int,2,2>{14, 32,
+                                    32, 77}) == m2) ;
+        FixedMatrix<int,3,3> m3 = multiply(m1_t, m1) ;
+        // the same products as Matrix2D
+        CHECK_EQUAL(multiply(m1.to_matrix(), m1_t.to_matrix()), m2.to_matrix()) ;
+        CHECK_EQUAL(multiply(m1_t.to_matrix(), m1.to_matrix()), m3.to_matrix()) ;
+        FixedMatrix<double,9,9> m9(1.) ;
+        CHECK_EQUAL(9., (multiply(m9, m9)(8, 8))) ;
+    }
+
+    TEST(determinant_inverse)
+    {   CHECK_EQUAL(-2, determinant(FixedMatrix<int,2,2>{1, 2,
+                                                         3, 4})) ;
+        CHECK_EQUAL(-3, determinant(FixedMatrix<int,3,3>{1, 2, 3,
+                                                         4, 5, 6,
+                                                         7, 8, 10})) ;
+        CHECK_EQUAL(0, determinant(FixedMatrix<int,3,3>{1, 2, 3,
+                                                        4, 5, 6,
+                                                        7, 8, 9})) ;
+        FixedMatrix<double,4,4> m4 = {2., 1., 0., 0.,
+                                      1., 3., 1., 0.,
+                                      0., 1., 4., 1.,
+                                      1., 0., 1., 5.} ;
+        FixedMatrix<double,5,5> m5 ;
+        for(size_t i=0; i<5; i++)
+        {   for(size_t j=0; j<5; j++)
+            {   m5(i,j) = (i == j) ? 4. : 1. / (i + j + 1.) ; }
+        }
+        CHECK_CLOSE(84., determinant(m4), 1e-12) ;
+        CHECK_CLOSE(986.0610306138196, determinant(m5), 1e-9) ;
+
+        FixedMatrix<double,4,4> id4 = multiply(m4, inverse(m4)) ;
+        FixedMatrix<double,5,5> id5 = multiply(m5, inverse(m5)) ;
+        FixedMatrix<double,3,3> m3 = {2., 0., 1.,
+                                      1., 3., 0.,
+                                      0., 1., 4.} ;
+        FixedMatrix<double,3,3> id3 = multiply(inverse(m3), m3) ;
+        FixedMatrix<double,2,2> id2 = multiply(inverse(FixedMatrix<double,2,2>{4., 7., 2., 6.}),
+                                               FixedMatrix<double,2,2>{4., 7., 2., 6.}) ;
+        for(size_t i=0; i<5; i++)
+        {   for(size_t j=0; j<5; j++)
+            {   double expected = (i == j) ? 1. : 0. ;
+                CHECK_CLOSE(expected, id5(i,j), 1e-12) ;
+                if(i < 4 and j < 4)
+                {   CHECK_CLOSE(expected, id4(i,j), 1e-12) ; }
+                if(i < 3 and j < 3)
+                {   CHECK_CLOSE(expected, id3(i,j), 1e-12) ; }
+                if(i < 2 and j < 2)
+                {   CHECK_CLOSE(expected, id2(i,j), 1e-12) ; }
+            }
+        }
+        CHECK_CLOSE(.5, (inverse(FixedMatrix<double,1,1>{2.})(0, 0)), 1e-12) ;
+        CHECK_THROW(inverse(FixedMatrix<double,2,2>{1., 2., 2., 4.}), std::invalid_argument) ;
+        CHECK_THROW(inverse(FixedMatrix<double,5,5>()), std::invalid_argument) ;
+    }
+}
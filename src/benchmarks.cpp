@@ -0,0 +1,42 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>   // strtoul()
+
+#include "Benchmarks/benchmarks.hpp"
+
+// runs the benchmarks, the optional arguments are the name of the
+// benchmark to run (all of them by default) and the largest matrix
+// size (the element access benchmark uses a 3D matrix 16 times smaller
+// in each dimension, the text benchmark a matrix 4 times smaller and the
+// binary benchmark 64 slices 8 times smaller, the numa benchmark a matrix
+// of this size and the small matrix benchmark 256 times as many matrices)
+int main(int argc, char** argv)
+{   std::string name = "all" ;
+    size_t size = 4096 ;
+    if(argc > 1)
+    {   name = argv[1] ; }
+    if(argc > 2)
+    {   size = strtoul(argv[2], nullptr, 10) ; }
+    if(size == 0 or (name != "all" and name != "gemm" and name != "transpose" and name != "access" and
+                    name != "text" and name != "binary" and name != "numa" and name != "small"))
+    {   std::cerr << "usage : " << argv[0] << " [all|gemm|transpose|access|text|binary|numa|small] [size]" << std::endl ;
+        return 1 ;
+    }
+
+    if(name == "all" or name == "gemm")
+    {   benchmark_gemm(size) ; }
+    if(name == "all" or name == "transpose")
+    {   benchmark_transpose(size) ; }
+    if(name == "all" or name == "access")
+    {   benchmark_access(size / 16) ; }
+    if(name == "all" or name == "text")
+    {   benchmark_text(size / 4) ; }
+    if(name == "all" or name == "binary")
+    {   benchmark_binary(size / 8) ; }
+    if(name == "all" or name == "numa")
+    {   benchmark_numa(size) ; }
+    if(name == "all" or name == "small")
+    {   benchmark_small(size * 256) ; }
+
+    return 0 ;
+}